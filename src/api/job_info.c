@@ -1052,6 +1052,7 @@ _load_cluster_jobs(slurm_msg_t *req_msg, job_info_msg_t **job_info_msg_pptr,
 
 	switch (resp_msg.msg_type) {
 	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_INFO_DELTA:
 		*job_info_msg_pptr = (job_info_msg_t *)resp_msg.data;
 		resp_msg.data = NULL;
 		break;
@@ -1168,6 +1169,7 @@ static int _load_fed_jobs(slurm_msg_t *req_msg,
 						    new_msg->last_update);
 			new_rec_cnt = orig_msg->record_count +
 				      new_msg->record_count;
+			slurm_job_info_msg_xfer_strs(orig_msg, new_msg);
 			if (new_msg->record_count) {
 				orig_msg->job_array =
 					xrealloc(orig_msg->job_array,
@@ -1317,7 +1319,7 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	    cluster_in_federation(ptr, cluster_name)) {
 		/* In federation. Need full info from all clusters */
 		update_time = (time_t) 0;
-		show_flags &= (~SHOW_LOCAL);
+		show_flags &= (~(SHOW_LOCAL | SHOW_DELTA));
 	} else {
 		/* Report local cluster info only */
 		show_flags |= SHOW_LOCAL;
@@ -1346,6 +1348,91 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return rc;
 }
 
+static int _cmp_job_id(const void *a, const void *b)
+{
+	uint32_t id_a = *(uint32_t *) a, id_b = *(uint32_t *) b;
+
+	if (id_a < id_b)
+		return -1;
+	return (id_a > id_b);
+}
+
+/*
+ * slurm_merge_job_info_msg - apply a job information response loaded with
+ *	SHOW_DELTA to a previously loaded copy of the job table
+ * IN/OUT job_info_msg_ptr - job table to update
+ * IN delta_msg - response from slurm_load_jobs(), its records are moved into
+ *	job_info_msg_ptr and it is freed. If delta_msg holds a complete job
+ *	table it replaces the content of job_info_msg_ptr.
+ */
+extern void slurm_merge_job_info_msg(job_info_msg_t *job_info_msg_ptr,
+				     job_info_msg_t *delta_msg)
+{
+	uint32_t *remove_ids, remove_cnt, i, j = 0;
+	slurm_job_info_t *job_array;
+
+	xassert(job_info_msg_ptr);
+	xassert(delta_msg);
+
+	if (!delta_msg->delta) {
+		/* Complete job table, replace the old copy */
+		for (i = 0; i < job_info_msg_ptr->record_count; i++)
+			slurm_free_job_info_rec_members(
+				job_info_msg_ptr,
+				&job_info_msg_ptr->job_array[i]);
+		xfree(job_info_msg_ptr->job_array);
+		xfree(job_info_msg_ptr->purged_job_ids);
+		str_dict_destroy(job_info_msg_ptr->str_dict);
+		memcpy(job_info_msg_ptr, delta_msg, sizeof(job_info_msg_t));
+		xfree(delta_msg);
+		return;
+	}
+
+	/* Old records to drop: purged jobs and those replaced by the delta */
+	remove_cnt = delta_msg->purged_count + delta_msg->record_count;
+	remove_ids = xcalloc(remove_cnt + 1, sizeof(uint32_t));
+	for (i = 0; i < delta_msg->purged_count; i++)
+		remove_ids[i] = delta_msg->purged_job_ids[i];
+	for (i = 0; i < delta_msg->record_count; i++)
+		remove_ids[delta_msg->purged_count + i] =
+			delta_msg->job_array[i].job_id;
+	qsort(remove_ids, remove_cnt, sizeof(uint32_t), _cmp_job_id);
+
+	job_array = xcalloc(job_info_msg_ptr->record_count +
+			    delta_msg->record_count + 1,
+			    sizeof(slurm_job_info_t));
+	for (i = 0; i < job_info_msg_ptr->record_count; i++) {
+		if (bsearch(&job_info_msg_ptr->job_array[i].job_id,
+			    remove_ids, remove_cnt, sizeof(uint32_t),
+			    _cmp_job_id)) {
+			slurm_free_job_info_rec_members(
+				job_info_msg_ptr,
+				&job_info_msg_ptr->job_array[i]);
+			continue;
+		}
+		memcpy(&job_array[j++], &job_info_msg_ptr->job_array[i],
+		       sizeof(slurm_job_info_t));
+	}
+	slurm_job_info_msg_xfer_strs(job_info_msg_ptr, delta_msg);
+	for (i = 0; i < delta_msg->record_count; i++) {
+		memcpy(&job_array[j++], &delta_msg->job_array[i],
+		       sizeof(slurm_job_info_t));
+	}
+	xfree(remove_ids);
+
+	xfree(job_info_msg_ptr->job_array);
+	job_info_msg_ptr->job_array = job_array;
+	job_info_msg_ptr->record_count = j;
+	job_info_msg_ptr->last_update = delta_msg->last_update;
+	job_info_msg_ptr->delta = 0;
+	job_info_msg_ptr->purged_count = 0;
+	xfree(job_info_msg_ptr->purged_job_ids);
+
+	xfree(delta_msg->job_array);
+	delta_msg->record_count = 0;
+	slurm_free_job_info_msg(delta_msg);
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
@@ -643,6 +643,7 @@ static int _load_fed_nodes(slurm_msg_t *req_msg,
 						    new_msg->last_update);
 			new_rec_cnt = orig_msg->record_count +
 				      new_msg->record_count;
+			slurm_node_info_msg_xfer_strs(orig_msg, new_msg);
 			if (new_msg->record_count) {
 				orig_msg->node_array =
 					xrealloc(orig_msg->node_array,
@@ -45,6 +45,7 @@
 
 #include "slurm/slurm.h"
 
+#include "src/common/msg_compress.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/forward.h"
@@ -162,6 +163,8 @@ static int _send_message_controller(int dest, slurm_msg_t *req)
 		slurm_seterrno_ret(SLURMCTLD_COMMUNICATIONS_SEND_ERROR);
 	}
 	slurm_msg_t_init(&resp_msg);
+	if (req->protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		resp_msg.flags |= msg_compress_accept_flags();
 
 	if ((rc = slurm_receive_msg(fd, &resp_msg, 0)) != 0) {
 		slurm_free_msg_members(&resp_msg);
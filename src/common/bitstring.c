@@ -46,6 +46,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * SIMD kernels are built for x86_64 with compilers supporting per function
+ * target attributes and __builtin_cpu_supports(), and used only when the CPU
+ * running us has the instructions.
+ */
+#if defined(__x86_64__) && (defined(__clang__) || (__GNUC__ >= 6))
+#  define BITSTR_SIMD 1
+#  include <immintrin.h>
+#endif
+
 #include "src/common/bitstring.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
@@ -97,6 +107,42 @@
 	xassert((bit) <= 0x40000000); 	\
 } while (0)
 
+/* words in use past the header, including any partial last word */
+#define _bitstr_data_words(name) \
+	(_bitstr_words(_bitstr_bits(name)) - BITSTR_OVERHEAD)
+
+/* words in which every bit is valid */
+#define _bitstr_full_words(name) (_bitstr_bits(name) >> BITSTR_SHIFT)
+
+/*
+ * Kernels of the operations at the heart of node selection, working on
+ * arrays of n words. The portable versions handle a word at a time, the
+ * others as many as the widest vector registers the CPU supports.
+ */
+typedef struct {
+	char *name;
+	void (*and)(bitstr_t *b1, const bitstr_t *b2, int64_t n);
+	void (*or)(bitstr_t *b1, const bitstr_t *b2, int64_t n);
+	int64_t (*count)(const bitstr_t *b, int64_t n);
+	int64_t (*overlap)(const bitstr_t *b1, const bitstr_t *b2, int64_t n);
+	bool (*overlap_any)(const bitstr_t *b1, const bitstr_t *b2, int64_t n);
+	bool (*super_set)(const bitstr_t *b1, const bitstr_t *b2, int64_t n);
+	int64_t (*first_word)(const bitstr_t *b, int64_t n);
+} bit_ops_t;
+
+static const bit_ops_t bit_ops_word;
+static const bit_ops_t *bit_ops = NULL;
+
+static const bit_ops_t *_bit_ops_select(const char *name);
+
+/* Selected on first use, every caller selects the same kernels */
+#define _bit_ops() (bit_ops ? bit_ops : (bit_ops = _bit_ops_select(NULL)))
+
+/* Vectors only pay off once a bitmap fills at least one 512 bit register */
+#define BITSTR_SIMD_MIN_WORDS 8
+#define _bit_ops_for(n) \
+	(((n) < BITSTR_SIMD_MIN_WORDS) ? &bit_ops_word : _bit_ops())
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
@@ -464,31 +510,31 @@ bit_nffs(bitstr_t *b, int32_t n)
 bitoff_t
 bit_ffs(bitstr_t *b)
 {
-	bitoff_t bit = 0, value = -1;
+	bitoff_t bit, value = -1;
+	int64_t n, word;
 
 	_assert_bitstr_valid(b);
 
-	while (bit < _bitstr_bits(b) && value == -1) {
-		int32_t word = _bit_word(bit);
+	n = _bitstr_data_words(b);
+	word = _bit_ops_for(n)->first_word(b + BITSTR_OVERHEAD, n);
+	if (word == -1)
+		return -1;
+	bit = word * sizeof(bitstr_t) * 8;
+	word += BITSTR_OVERHEAD;
 
-		if (b[word] == 0) {
-			bit += sizeof(bitstr_t)*8;
-			continue;
-		}
 #if HAVE___BUILTIN_CLZLL && (defined SLURM_BIGENDIAN)
-		value = bit + __builtin_clzll(b[word]);
+	value = bit + __builtin_clzll(b[word]);
 #elif HAVE___BUILTIN_CTZLL && (!defined SLURM_BIGENDIAN)
-		value = bit + __builtin_ctzll(b[word]);
+	value = bit + __builtin_ctzll(b[word]);
 #else
-		while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
-			if (bit_test(b, bit)) {
-				value = bit;
-				break;
-			}
-			bit++;
+	while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
+		if (bit_test(b, bit)) {
+			value = bit;
+			break;
 		}
-#endif
+		bit++;
 	}
+#endif
 	if (value < _bitstr_bits(b))
 		return value;
 	else
@@ -571,19 +617,15 @@ bit_fill_gaps(bitstr_t *b)
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	int64_t n;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
-			return 0;
-	}
-
-	return 1;
+	n = _bitstr_data_words(b1);
+	return _bit_ops_for(n)->super_set(b1 + BITSTR_OVERHEAD,
+					  b2 + BITSTR_OVERHEAD, n);
 }
 
 /*
@@ -618,14 +660,14 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	int64_t n;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	n = _bitstr_data_words(b1);
+	_bit_ops_for(n)->and(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD, n);
 }
 
 /*
@@ -668,14 +710,14 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	int64_t n;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	n = _bitstr_data_words(b1);
+	_bit_ops_for(n)->or(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD, n);
 }
 
 /*
@@ -756,15 +798,15 @@ bit_set_count(bitstr_t *b)
 {
 	int32_t count = 0;
 	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int64_t full_words;
 
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
+	full_words = _bitstr_full_words(b);
+	count = _bit_ops_for(full_words)->count(b + BITSTR_OVERHEAD,
+						 full_words);
+	for (bit = full_words * sizeof(bitstr_t) * 8; bit < bit_cnt; bit++) {
 		if (bit_test(b, bit))
 			count++;
 	}
@@ -808,25 +850,24 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 {
 	int32_t count = 0;
-	int64_t anded;
 	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int64_t full_words;
+	const bit_ops_t *ops;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
-		if (count_it)
-			count += hweight(anded);
-		else if (anded)
-			return 1;
-	}
-	for ( ; bit < bit_cnt; bit++) {
+	full_words = _bitstr_full_words(b1);
+	ops = _bit_ops_for(full_words);
+	if (count_it)
+		count = ops->overlap(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD,
+				     full_words);
+	else if (ops->overlap_any(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD,
+				  full_words))
+		return 1;
+	for (bit = full_words * sizeof(bitstr_t) * 8; bit < bit_cnt; bit++) {
 		if (bit_test(b1, bit) && bit_test(b2, bit)) {
 			if (count_it)
 				count++;
@@ -1627,3 +1668,477 @@ bit_get_pos_num(bitstr_t *b, bitoff_t pos)
 
 	return cnt;
 }
+
+/*
+ * Return the name of the kernels used by bit_and(), bit_or(),
+ * bit_set_count(), bit_overlap(), bit_overlap_any(), bit_super_set() and
+ * bit_ffs(): "avx512", "avx2" or "word".
+ */
+char *bit_simd_name(void)
+{
+	return _bit_ops()->name;
+}
+
+/*
+ * Force the kernels named as by bit_simd_name(), or select the best ones the
+ * CPU supports if name is NULL. For testing and benchmarks, not thread safe.
+ * RET 0 on success, -1 if the kernels are not built or the CPU lacks them,
+ *	in which case the kernels in use are unchanged
+ */
+int bit_simd_set(const char *name)
+{
+	const bit_ops_t *ops = _bit_ops_select(name);
+
+	if (!ops)
+		return -1;
+	bit_ops = ops;
+	return 0;
+}
+
+static void _word_and(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	for (int64_t i = 0; i < n; i++)
+		b1[i] &= b2[i];
+}
+
+static void _word_or(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	for (int64_t i = 0; i < n; i++)
+		b1[i] |= b2[i];
+}
+
+static int64_t _word_count(const bitstr_t *b, int64_t n)
+{
+	int64_t count = 0;
+
+	for (int64_t i = 0; i < n; i++)
+		count += hweight(b[i]);
+
+	return count;
+}
+
+static int64_t _word_overlap(const bitstr_t *b1, const bitstr_t *b2,
+			     int64_t n)
+{
+	int64_t count = 0;
+
+	for (int64_t i = 0; i < n; i++)
+		count += hweight(b1[i] & b2[i]);
+
+	return count;
+}
+
+static bool _word_overlap_any(const bitstr_t *b1, const bitstr_t *b2,
+			      int64_t n)
+{
+	for (int64_t i = 0; i < n; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+
+	return false;
+}
+
+static bool _word_super_set(const bitstr_t *b1, const bitstr_t *b2,
+			    int64_t n)
+{
+	for (int64_t i = 0; i < n; i++) {
+		if (b1[i] & ~b2[i])
+			return false;
+	}
+
+	return true;
+}
+
+static int64_t _word_first_word(const bitstr_t *b, int64_t n)
+{
+	for (int64_t i = 0; i < n; i++) {
+		if (b[i])
+			return i;
+	}
+
+	return -1;
+}
+
+static const bit_ops_t bit_ops_word = {
+	.name = "word",
+	.and = _word_and,
+	.or = _word_or,
+	.count = _word_count,
+	.overlap = _word_overlap,
+	.overlap_any = _word_overlap_any,
+	.super_set = _word_super_set,
+	.first_word = _word_first_word,
+};
+
+#ifdef BITSTR_SIMD
+/*
+ * Population counts use the nibble lookup table method of W. Mula et al.,
+ * "Faster Population Counts Using AVX2 Instructions": vpshufb counts the bits
+ * of each nibble and vpsadbw sums the bytes of each 64 bit lane. Words past
+ * the last whole vector are handled one at a time.
+ */
+#define AVX2_TARGET "avx2,popcnt"
+#define AVX2_WORDS 4
+
+__attribute__((target(AVX2_TARGET)))
+static inline __m256i _avx2_popcount(__m256i v)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	__m256i lo, hi;
+
+	lo = _mm256_and_si256(v, low_mask);
+	hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+	lo = _mm256_shuffle_epi8(lookup, lo);
+	hi = _mm256_shuffle_epi8(lookup, hi);
+
+	return _mm256_sad_epu8(_mm256_add_epi8(lo, hi),
+			       _mm256_setzero_si256());
+}
+
+__attribute__((target(AVX2_TARGET)))
+static inline int64_t _avx2_sum(__m256i v)
+{
+	return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) +
+	       _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+
+__attribute__((target(AVX2_TARGET)))
+static void _avx2_and(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i v2 = _mm256_loadu_si256((__m256i *) (b2 + i));
+		_mm256_storeu_si256((__m256i *) (b1 + i),
+				    _mm256_and_si256(v1, v2));
+	}
+	for (; i < n; i++)
+		b1[i] &= b2[i];
+}
+
+__attribute__((target(AVX2_TARGET)))
+static void _avx2_or(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i v2 = _mm256_loadu_si256((__m256i *) (b2 + i));
+		_mm256_storeu_si256((__m256i *) (b1 + i),
+				    _mm256_or_si256(v1, v2));
+	}
+	for (; i < n; i++)
+		b1[i] |= b2[i];
+}
+
+__attribute__((target(AVX2_TARGET)))
+static int64_t _avx2_count(const bitstr_t *b, int64_t n)
+{
+	__m256i sum = _mm256_setzero_si256();
+	int64_t i, count;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v = _mm256_loadu_si256((__m256i *) (b + i));
+		sum = _mm256_add_epi64(sum, _avx2_popcount(v));
+	}
+	count = _avx2_sum(sum);
+	for (; i < n; i++)
+		count += __builtin_popcountll(b[i]);
+
+	return count;
+}
+
+__attribute__((target(AVX2_TARGET)))
+static int64_t _avx2_overlap(const bitstr_t *b1, const bitstr_t *b2,
+			     int64_t n)
+{
+	__m256i sum = _mm256_setzero_si256();
+	int64_t i, count;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i v2 = _mm256_loadu_si256((__m256i *) (b2 + i));
+		sum = _mm256_add_epi64(sum,
+				       _avx2_popcount(_mm256_and_si256(v1, v2)));
+	}
+	count = _avx2_sum(sum);
+	for (; i < n; i++)
+		count += __builtin_popcountll(b1[i] & b2[i]);
+
+	return count;
+}
+
+__attribute__((target(AVX2_TARGET)))
+static bool _avx2_overlap_any(const bitstr_t *b1, const bitstr_t *b2,
+			      int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i v2 = _mm256_loadu_si256((__m256i *) (b2 + i));
+		/* testz: (v1 & v2) == 0 */
+		if (!_mm256_testz_si256(v1, v2))
+			return true;
+	}
+	for (; i < n; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+
+	return false;
+}
+
+__attribute__((target(AVX2_TARGET)))
+static bool _avx2_super_set(const bitstr_t *b1, const bitstr_t *b2,
+			    int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i v2 = _mm256_loadu_si256((__m256i *) (b2 + i));
+		/* testc: (~v2 & v1) == 0 */
+		if (!_mm256_testc_si256(v2, v1))
+			return false;
+	}
+	for (; i < n; i++) {
+		if (b1[i] & ~b2[i])
+			return false;
+	}
+
+	return true;
+}
+
+__attribute__((target(AVX2_TARGET)))
+static int64_t _avx2_first_word(const bitstr_t *b, int64_t n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	int64_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= n; i += AVX2_WORDS) {
+		__m256i v = _mm256_loadu_si256((__m256i *) (b + i));
+		int zero_mask = _mm256_movemask_pd(
+			_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, zero)));
+
+		if (zero_mask != 0xf)
+			return i + __builtin_ctz(~zero_mask);
+	}
+	for (; i < n; i++) {
+		if (b[i])
+			return i;
+	}
+
+	return -1;
+}
+
+static const bit_ops_t bit_ops_avx2 = {
+	.name = "avx2",
+	.and = _avx2_and,
+	.or = _avx2_or,
+	.count = _avx2_count,
+	.overlap = _avx2_overlap,
+	.overlap_any = _avx2_overlap_any,
+	.super_set = _avx2_super_set,
+	.first_word = _avx2_first_word,
+};
+
+#define AVX512_TARGET "avx512f,avx512bw,popcnt"
+#define AVX512_WORDS 8
+
+__attribute__((target(AVX512_TARGET)))
+static inline __m512i _avx512_popcount(__m512i v)
+{
+	const __m512i lookup = _mm512_set4_epi32(
+		0x04030302, 0x03020201, 0x03020201, 0x02010100);
+	const __m512i low_mask = _mm512_set1_epi8(0x0f);
+	__m512i lo, hi;
+
+	lo = _mm512_and_si512(v, low_mask);
+	hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), low_mask);
+	lo = _mm512_shuffle_epi8(lookup, lo);
+	hi = _mm512_shuffle_epi8(lookup, hi);
+
+	return _mm512_sad_epu8(_mm512_add_epi8(lo, hi),
+			       _mm512_setzero_si512());
+}
+
+__attribute__((target(AVX512_TARGET)))
+static inline int64_t _avx512_sum(__m512i v)
+{
+	int64_t lanes[AVX512_WORDS], sum = 0;
+
+	_mm512_storeu_si512(lanes, v);
+	for (int i = 0; i < AVX512_WORDS; i++)
+		sum += lanes[i];
+
+	return sum;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void _avx512_and(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v1 = _mm512_loadu_si512(b1 + i);
+		__m512i v2 = _mm512_loadu_si512(b2 + i);
+		_mm512_storeu_si512(b1 + i, _mm512_and_si512(v1, v2));
+	}
+	for (; i < n; i++)
+		b1[i] &= b2[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void _avx512_or(bitstr_t *b1, const bitstr_t *b2, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v1 = _mm512_loadu_si512(b1 + i);
+		__m512i v2 = _mm512_loadu_si512(b2 + i);
+		_mm512_storeu_si512(b1 + i, _mm512_or_si512(v1, v2));
+	}
+	for (; i < n; i++)
+		b1[i] |= b2[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int64_t _avx512_count(const bitstr_t *b, int64_t n)
+{
+	__m512i sum = _mm512_setzero_si512();
+	int64_t i, count;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v = _mm512_loadu_si512(b + i);
+		sum = _mm512_add_epi64(sum, _avx512_popcount(v));
+	}
+	count = _avx512_sum(sum);
+	for (; i < n; i++)
+		count += __builtin_popcountll(b[i]);
+
+	return count;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int64_t _avx512_overlap(const bitstr_t *b1, const bitstr_t *b2,
+			       int64_t n)
+{
+	__m512i sum = _mm512_setzero_si512();
+	int64_t i, count;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v1 = _mm512_loadu_si512(b1 + i);
+		__m512i v2 = _mm512_loadu_si512(b2 + i);
+		sum = _mm512_add_epi64(
+			sum, _avx512_popcount(_mm512_and_si512(v1, v2)));
+	}
+	count = _avx512_sum(sum);
+	for (; i < n; i++)
+		count += __builtin_popcountll(b1[i] & b2[i]);
+
+	return count;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static bool _avx512_overlap_any(const bitstr_t *b1, const bitstr_t *b2,
+				int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v1 = _mm512_loadu_si512(b1 + i);
+		__m512i v2 = _mm512_loadu_si512(b2 + i);
+		if (_mm512_test_epi64_mask(v1, v2))
+			return true;
+	}
+	for (; i < n; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+
+	return false;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static bool _avx512_super_set(const bitstr_t *b1, const bitstr_t *b2,
+			      int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v1 = _mm512_loadu_si512(b1 + i);
+		__m512i v2 = _mm512_loadu_si512(b2 + i);
+		__m512i extra = _mm512_andnot_si512(v2, v1);
+		if (_mm512_test_epi64_mask(extra, extra))
+			return false;
+	}
+	for (; i < n; i++) {
+		if (b1[i] & ~b2[i])
+			return false;
+	}
+
+	return true;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int64_t _avx512_first_word(const bitstr_t *b, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= n; i += AVX512_WORDS) {
+		__m512i v = _mm512_loadu_si512(b + i);
+		__mmask8 set_mask = _mm512_test_epi64_mask(v, v);
+
+		if (set_mask)
+			return i + __builtin_ctz(set_mask);
+	}
+	for (; i < n; i++) {
+		if (b[i])
+			return i;
+	}
+
+	return -1;
+}
+
+static const bit_ops_t bit_ops_avx512 = {
+	.name = "avx512",
+	.and = _avx512_and,
+	.or = _avx512_or,
+	.count = _avx512_count,
+	.overlap = _avx512_overlap,
+	.overlap_any = _avx512_overlap_any,
+	.super_set = _avx512_super_set,
+	.first_word = _avx512_first_word,
+};
+#endif
+
+/*
+ * Return the kernels named, or the best ones the CPU supports if name is
+ * NULL. NULL if the named kernels are not available.
+ */
+static const bit_ops_t *_bit_ops_select(const char *name)
+{
+	if (name && !strcmp(name, bit_ops_word.name))
+		return &bit_ops_word;
+
+#ifdef BITSTR_SIMD
+	__builtin_cpu_init();
+	if ((!name || !strcmp(name, bit_ops_avx512.name)) &&
+	    __builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512bw") &&
+	    __builtin_cpu_supports("popcnt"))
+		return &bit_ops_avx512;
+	if ((!name || !strcmp(name, bit_ops_avx2.name)) &&
+	    __builtin_cpu_supports("avx2") &&
+	    __builtin_cpu_supports("popcnt"))
+		return &bit_ops_avx2;
+#endif
+
+	return name ? NULL : &bit_ops_word;
+}
@@ -58,6 +58,7 @@
 #define	_BITSTRING_H_
 
 #include <inttypes.h>
+#include <stdbool.h>
 
 #define BITSTR_SHIFT_WORD8	3
 #define BITSTR_SHIFT_WORD64	6
@@ -148,6 +149,8 @@ bitstr_t *bit_copy(bitstr_t *b);
 bitstr_t *bit_pick_cnt(bitstr_t *b, bitoff_t nbits);
 bitoff_t bit_get_bit_num(bitstr_t *b, int32_t pos);
 int32_t	bit_get_pos_num(bitstr_t *b, bitoff_t pos);
+char	*bit_simd_name(void);
+int	bit_simd_set(const char *name);
 
 #define FREE_NULL_BITMAP(_X)		\
 	do {				\
@@ -48,6 +48,7 @@
 
 #include "src/common/forward.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
@@ -543,7 +544,10 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 		       sizeof(slurm_addr_t));
 
 		fwd_msg->header.version = header->version;
-		fwd_msg->header.flags = header->flags;
+		/* Replies come back through us, which may decompress less */
+		fwd_msg->header.flags = header->flags &
+			(~(SLURM_MSG_ACCEPT_LZ4 | SLURM_MSG_ACCEPT_ZLIB) |
+			 msg_compress_accept_flags());
 		fwd_msg->header.msg_type = header->msg_type;
 		fwd_msg->header.body_length = header->body_length;
 		fwd_msg->header.ret_list = NULL;
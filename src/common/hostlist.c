@@ -2156,6 +2156,32 @@ int hostlist_pop_range_values(
 	return 1;
 }
 
+int hostlist_get_range_values(hostlist_t hl, int n, char **prefix,
+			      unsigned long *lo, unsigned long *hi, int *width)
+{
+	hostrange_t *hr;
+	int rc;
+
+	if (!hl || !prefix || !lo || !hi || !width)
+		return -1;
+
+	LOCK_HOSTLIST(hl);
+	if ((n < 0) || (n >= hl->nranges)) {
+		UNLOCK_HOSTLIST(hl);
+		return -1;
+	}
+
+	hr = hl->hr[n];
+	*prefix = hr->prefix;
+	*lo = hr->lo;
+	*hi = hr->hi;
+	*width = hr->width;
+	rc = hr->singlehost ? 0 : 1;
+	UNLOCK_HOSTLIST(hl);
+
+	return rc;
+}
+
 char *hostlist_shift_range(hostlist_t hl)
 {
 	int i;
@@ -244,6 +244,18 @@ char * hostlist_pop_range(hostlist_t hl);
 int hostlist_pop_range_values(
 	hostlist_t hl, unsigned long *lo, unsigned long *hi);
 
+/* hostlist_get_range_values():
+ *
+ * Get the prefix, numeric suffix bounds and suffix width of the n'th range
+ * of hostlist hl without expanding it into host names. Host names of the
+ * range are printed as "%s%0*lu" from prefix, width and lo through hi.
+ * *prefix points into hl and is only valid until hl is next modified.
+ * Returns 1 for a range, 0 for a single host named *prefix, or -1 if n is
+ * not a valid range index.
+ */
+int hostlist_get_range_values(hostlist_t hl, int n, char **prefix,
+			      unsigned long *lo, unsigned long *hi, int *width);
+
 /* hostlist_shift_range():
  *
  * Shift the first bracketed hostlist (improperly: range) off the
@@ -0,0 +1,191 @@
+/*****************************************************************************\
+ *  id_hash.c - open addressing hash table keyed by integer ids
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/id_hash.h"
+#include "src/common/macros.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+
+#define ID_HASH_MAGIC	0x1d4a5b6c
+#define ID_HASH_MIN_SIZE 64
+
+typedef struct {
+	uint64_t key;
+	void *item;		/* NULL if slot is empty */
+} id_hash_entry_t;
+
+struct id_hash {
+	int magic;		/* magic cookie, ID_HASH_MAGIC */
+	uint32_t count;		/* items stored */
+	id_hash_entry_t *entries;
+	uint32_t mask;		/* table size - 1, size is a power of 2 */
+	uint32_t shift;		/* 64 - log2(table size) */
+};
+
+/*
+ * Fibonacci hashing, spreads sequential ids and ids differing only in
+ * their high bits (e.g. array job id/task id pairs) across the table.
+ */
+static inline uint32_t _slot(id_hash_t *table, uint64_t key)
+{
+	return (uint32_t) ((key * 0x9e3779b97f4a7c15ULL) >> table->shift);
+}
+
+static void _alloc_entries(id_hash_t *table, uint32_t size)
+{
+	uint32_t bits = 0;
+
+	while ((1U << bits) < size)
+		bits++;
+	table->entries = xcalloc((1U << bits), sizeof(id_hash_entry_t));
+	table->mask = (1U << bits) - 1;
+	table->shift = 64 - bits;
+}
+
+static void _insert(id_hash_t *table, uint64_t key, void *item)
+{
+	uint32_t i = _slot(table, key);
+
+	while (table->entries[i].item)
+		i = (i + 1) & table->mask;
+	table->entries[i].key = key;
+	table->entries[i].item = item;
+}
+
+static void _grow(id_hash_t *table)
+{
+	id_hash_entry_t *old_entries = table->entries;
+	uint32_t i, old_size = table->mask + 1;
+
+	_alloc_entries(table, old_size * 2);
+	for (i = 0; i < old_size; i++) {
+		if (old_entries[i].item)
+			_insert(table, old_entries[i].key,
+				old_entries[i].item);
+	}
+	xfree(old_entries);
+}
+
+extern id_hash_t *id_hash_init(uint32_t size)
+{
+	id_hash_t *table = xmalloc(sizeof(*table));
+
+	table->magic = ID_HASH_MAGIC;
+	/* Keep the initial load factor at or below one half */
+	if (size > (UINT32_MAX / 4))
+		size = UINT32_MAX / 4;
+	_alloc_entries(table, MAX(ID_HASH_MIN_SIZE, size * 2));
+
+	return table;
+}
+
+extern void id_hash_free(id_hash_t *table)
+{
+	if (!table)
+		return;
+	xassert(table->magic == ID_HASH_MAGIC);
+	table->magic = ~ID_HASH_MAGIC;
+	xfree(table->entries);
+	xfree(table);
+}
+
+extern void id_hash_add(id_hash_t *table, uint64_t key, void *item)
+{
+	xassert(table->magic == ID_HASH_MAGIC);
+	xassert(item);
+
+	if ((table->count + 1) > ((table->mask + 1) / 4 * 3))
+		_grow(table);
+	_insert(table, key, item);
+	table->count++;
+}
+
+extern void *id_hash_find(id_hash_t *table, uint64_t key)
+{
+	uint32_t i;
+
+	xassert(table->magic == ID_HASH_MAGIC);
+
+	for (i = _slot(table, key); table->entries[i].item;
+	     i = (i + 1) & table->mask) {
+		if (table->entries[i].key == key)
+			return table->entries[i].item;
+	}
+
+	return NULL;
+}
+
+extern bool id_hash_remove(id_hash_t *table, uint64_t key, void *item)
+{
+	uint32_t i, j, home;
+
+	xassert(table->magic == ID_HASH_MAGIC);
+
+	for (i = _slot(table, key); table->entries[i].item;
+	     i = (i + 1) & table->mask) {
+		if ((table->entries[i].key == key) &&
+		    (table->entries[i].item == item))
+			break;
+	}
+	if (!table->entries[i].item)
+		return false;
+
+	/*
+	 * Shift back any following entry of this run whose home slot does
+	 * not lie cyclically within (i, j], so lookups never stop early at
+	 * the freed slot.
+	 */
+	for (j = (i + 1) & table->mask; table->entries[j].item;
+	     j = (j + 1) & table->mask) {
+		home = _slot(table, table->entries[j].key);
+		if ((i <= j) ? ((i < home) && (home <= j)) :
+			       ((i < home) || (home <= j)))
+			continue;
+		table->entries[i] = table->entries[j];
+		i = j;
+	}
+	table->entries[i].key = 0;
+	table->entries[i].item = NULL;
+	table->count--;
+
+	return true;
+}
+
+extern uint32_t id_hash_count(id_hash_t *table)
+{
+	xassert(table->magic == ID_HASH_MAGIC);
+
+	return table->count;
+}
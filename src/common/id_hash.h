@@ -0,0 +1,91 @@
+/*****************************************************************************\
+ *  id_hash.h - open addressing hash table keyed by integer ids
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _ID_HASH_H
+#define _ID_HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Hash table mapping 64-bit integer keys to item pointers, intended for
+ * large tables of records looked up by numeric id (e.g. job records).
+ *
+ * Entries are stored inline in a single array with linear probing, so a
+ * lookup usually touches one cache line and never dereferences the items.
+ * The table doubles in size whenever it becomes three quarters full, and
+ * removal shifts later entries back rather than leaving deleted markers.
+ * Several items may be added with the same key, id_hash_find() returns one
+ * of them.
+ *
+ * No locking is performed, callers must serialize access.
+ */
+typedef struct id_hash id_hash_t;
+
+/*
+ * id_hash_init - create a new table
+ * IN size - expected number of entries, the table grows past this as needed
+ * RET table, free with id_hash_free()
+ */
+extern id_hash_t *id_hash_init(uint32_t size);
+
+/* id_hash_free - free a table, the items themselves are not touched */
+extern void id_hash_free(id_hash_t *table);
+
+/*
+ * id_hash_add - add an item to the table
+ * IN key - key to store the item under
+ * IN item - item to add, must not be NULL
+ */
+extern void id_hash_add(id_hash_t *table, uint64_t key, void *item);
+
+/*
+ * id_hash_find - find an item by key
+ * RET item or NULL if none is stored under key
+ */
+extern void *id_hash_find(id_hash_t *table, uint64_t key);
+
+/*
+ * id_hash_remove - remove a specific item from the table
+ * IN key - key the item was added under
+ * IN item - item to remove
+ * RET true if the item was found and removed
+ */
+extern bool id_hash_remove(id_hash_t *table, uint64_t key, void *item);
+
+/* id_hash_count - return the number of items in the table */
+extern uint32_t id_hash_count(id_hash_t *table);
+
+#endif
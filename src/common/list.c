@@ -89,12 +89,29 @@ strong_alias(list_delete_item,	slurm_list_delete_item);
 #define LIST_MAGIC 0xDEADBEEF
 #define LIST_ITR_MAGIC 0xDEADBEFF
 
+/*
+ *  List nodes and iterators are taken from per-thread magazines of
+ *    LIST_MAG_SIZE free objects, which are exchanged as a whole with a
+ *    global depot of at most LIST_DEPOT_MAX magazines. Objects which do
+ *    not fit in the depot are returned to malloc.
+ *  Building with --enable-memory-leak-debug bypasses the caches.
+ */
+#define LIST_MAG_SIZE 64
+#define LIST_DEPOT_MAX 256
+
 #define list_alloc() xmalloc(sizeof(struct xlist))
 #define list_free(_l) xfree(l)
+#ifdef MEMORY_LEAK_DEBUG
 #define list_node_alloc() xmalloc(sizeof(struct listNode))
 #define list_node_free(_p) xfree(_p)
 #define list_iterator_alloc() xmalloc(sizeof(struct listIterator))
 #define list_iterator_free(_i) xfree(_i)
+#else
+#define list_node_alloc() _list_cache_alloc(LIST_CACHE_NODE)
+#define list_node_free(_p) _list_cache_free(LIST_CACHE_NODE, _p)
+#define list_iterator_alloc() _list_cache_alloc(LIST_CACHE_ITR)
+#define list_iterator_free(_i) _list_cache_free(LIST_CACHE_ITR, _i)
+#endif
 
 /****************
  *  Data Types  *
@@ -126,6 +143,33 @@ struct xlist {
 
 typedef struct listNode * ListNode;
 
+typedef enum {
+	LIST_CACHE_NODE,
+	LIST_CACHE_ITR,
+	LIST_CACHE_CNT
+} list_cache_type_t;
+
+typedef struct {
+	int                   cnt;          /* number of objects in objs         */
+	void                 *objs[LIST_MAG_SIZE];
+} list_mag_t;
+
+typedef struct {
+	size_t                obj_size;     /* size of the cached objects        */
+	pthread_mutex_t       mutex;        /* protects the depot and counters   */
+	int                   full_cnt;     /* magazines holding objects         */
+	list_mag_t           *full[LIST_DEPOT_MAX];
+	int                   empty_cnt;    /* magazines holding no objects      */
+	list_mag_t           *empty[LIST_DEPOT_MAX];
+	list_cache_stats_t    stats;        /* counters, see list.h              */
+} list_cache_t;
+
+typedef struct {
+	list_mag_t           *loaded;       /* magazine allocated from/freed to  */
+	list_mag_t           *prev;         /* either full or empty magazine     */
+	uint64_t              alloc_cnt;    /* not yet added to the cache stats  */
+} list_tcache_t;
+
 
 /****************
  *  Prototypes  *
@@ -135,11 +179,37 @@ static void *_list_node_create(List l, ListNode *pp, void *x);
 static void *_list_node_destroy(List l, ListNode *pp);
 static void *_list_pop_locked(List l);
 static void *_list_append_locked(List l, void *x);
+#ifndef MEMORY_LEAK_DEBUG
+static void *_list_cache_alloc(list_cache_type_t type);
+static void _list_cache_free(list_cache_type_t type, void *obj);
+#endif
 
 #ifndef NDEBUG
 static int _list_mutex_is_locked (pthread_mutex_t *mutex);
 #endif
 
+/***************
+ *  Variables  *
+ ***************/
+
+static list_cache_t list_caches[LIST_CACHE_CNT] = {
+	[LIST_CACHE_NODE] = {
+		.obj_size = sizeof(struct listNode),
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+	},
+	[LIST_CACHE_ITR] = {
+		.obj_size = sizeof(struct listIterator),
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+	},
+};
+
+#ifndef MEMORY_LEAK_DEBUG
+static pthread_once_t list_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t list_cache_key;
+static __thread bool list_tcache_init = false;
+static __thread list_tcache_t list_tcaches[LIST_CACHE_CNT];
+#endif
+
 /***************
  *  Functions  *
  ***************/
@@ -766,6 +836,40 @@ list_iterator_destroy (ListIterator i)
 	list_iterator_free(i);
 }
 
+/* list_cache_stats()
+ */
+void
+list_cache_stats (list_cache_stats_t *node_stats, list_cache_stats_t *itr_stats)
+{
+	list_cache_stats_t *stats[LIST_CACHE_CNT] = {
+		[LIST_CACHE_NODE] = node_stats,
+		[LIST_CACHE_ITR] = itr_stats,
+	};
+
+	for (int type = 0; type < LIST_CACHE_CNT; type++) {
+		slurm_mutex_lock(&list_caches[type].mutex);
+		*stats[type] = list_caches[type].stats;
+		slurm_mutex_unlock(&list_caches[type].mutex);
+	}
+}
+
+/* list_cache_clear_stats()
+ */
+void
+list_cache_clear_stats (void)
+{
+	for (int type = 0; type < LIST_CACHE_CNT; type++) {
+		list_cache_stats_t *stats = &list_caches[type].stats;
+
+		slurm_mutex_lock(&list_caches[type].mutex);
+		stats->alloc_cnt = 0;
+		stats->malloc_cnt = 0;
+		stats->free_cnt = 0;
+		stats->depot_cnt = 0;
+		slurm_mutex_unlock(&list_caches[type].mutex);
+	}
+}
+
 static void * _list_next_locked(ListIterator i)
 {
 	ListNode p;
@@ -1020,3 +1124,170 @@ _list_append_locked(List l, void *x)
 
 	return v;
 }
+
+#ifndef MEMORY_LEAK_DEBUG
+/*
+ * Return the magazine [mag] to the depot of [cache], freeing its objects
+ * if the depot holds LIST_DEPOT_MAX magazines with objects already.
+ * This routine assumes the cache is already locked upon entry.
+ */
+static void _list_depot_put(list_cache_t *cache, list_mag_t *mag)
+{
+	if (mag->cnt && (cache->full_cnt < LIST_DEPOT_MAX)) {
+		cache->full[cache->full_cnt++] = mag;
+		cache->stats.depot_cnt++;
+		cache->stats.cached_cnt += mag->cnt;
+		return;
+	}
+
+	cache->stats.free_cnt += mag->cnt;
+	for (int i = 0; i < mag->cnt; i++)
+		xfree(mag->objs[i]);
+	mag->cnt = 0;
+
+	if (cache->empty_cnt < LIST_DEPOT_MAX)
+		cache->empty[cache->empty_cnt++] = mag;
+	else
+		xfree(mag);
+}
+
+/*
+ * Return the magazines of the calling thread to the depots on thread exit.
+ */
+static void _list_tcache_flush(void *arg)
+{
+	for (int type = 0; type < LIST_CACHE_CNT; type++) {
+		list_cache_t *cache = &list_caches[type];
+		list_tcache_t *tc = &list_tcaches[type];
+
+		slurm_mutex_lock(&cache->mutex);
+		cache->stats.alloc_cnt += tc->alloc_cnt;
+		tc->alloc_cnt = 0;
+		if (tc->loaded)
+			_list_depot_put(cache, tc->loaded);
+		if (tc->prev)
+			_list_depot_put(cache, tc->prev);
+		tc->loaded = tc->prev = NULL;
+		slurm_mutex_unlock(&cache->mutex);
+	}
+
+	/* Register again if a later destructor uses a list */
+	list_tcache_init = false;
+}
+
+static void _list_cache_atfork_prep(void)
+{
+	for (int type = 0; type < LIST_CACHE_CNT; type++)
+		slurm_mutex_lock(&list_caches[type].mutex);
+}
+
+static void _list_cache_atfork_post(void)
+{
+	for (int type = LIST_CACHE_CNT - 1; type >= 0; type--)
+		slurm_mutex_unlock(&list_caches[type].mutex);
+}
+
+static void _list_cache_init(void)
+{
+	int err;
+
+	if ((err = pthread_key_create(&list_cache_key, _list_tcache_flush)))
+		fatal("%s: pthread_key_create: %s", __func__, strerror(err));
+	if ((err = pthread_atfork(_list_cache_atfork_prep,
+				  _list_cache_atfork_post,
+				  _list_cache_atfork_post)))
+		fatal("%s: pthread_atfork: %s", __func__, strerror(err));
+}
+
+/*
+ * Make sure the magazines of the calling thread are flushed when it exits.
+ */
+static void _list_tcache_init(void)
+{
+	if (list_tcache_init)
+		return;
+
+	pthread_once(&list_cache_once, _list_cache_init);
+	pthread_setspecific(list_cache_key, list_tcaches);
+	list_tcache_init = true;
+}
+
+/*
+ * Allocate an object from the magazines of the calling thread, reloading
+ * them from the depot or calling malloc when they are empty.
+ */
+static void *_list_cache_alloc(list_cache_type_t type)
+{
+	list_cache_t *cache = &list_caches[type];
+	list_tcache_t *tc = &list_tcaches[type];
+	list_mag_t *mag;
+
+	tc->alloc_cnt++;
+	if ((mag = tc->loaded) && mag->cnt)
+		return mag->objs[--mag->cnt];
+	if ((mag = tc->prev) && mag->cnt) {
+		tc->prev = tc->loaded;
+		tc->loaded = mag;
+		return mag->objs[--mag->cnt];
+	}
+
+	_list_tcache_init();
+	slurm_mutex_lock(&cache->mutex);
+	cache->stats.alloc_cnt += tc->alloc_cnt;
+	tc->alloc_cnt = 0;
+	if (cache->full_cnt) {
+		mag = cache->full[--cache->full_cnt];
+		cache->stats.depot_cnt++;
+		cache->stats.cached_cnt -= mag->cnt;
+		if (tc->loaded)
+			_list_depot_put(cache, tc->loaded);
+		tc->loaded = mag;
+		slurm_mutex_unlock(&cache->mutex);
+		return mag->objs[--mag->cnt];
+	}
+	cache->stats.malloc_cnt++;
+	slurm_mutex_unlock(&cache->mutex);
+
+	return xmalloc(cache->obj_size);
+}
+
+/*
+ * Free an object to the magazines of the calling thread, exchanging a full
+ * one for an empty one from the depot when needed.
+ */
+static void _list_cache_free(list_cache_type_t type, void *obj)
+{
+	list_cache_t *cache = &list_caches[type];
+	list_tcache_t *tc = &list_tcaches[type];
+	list_mag_t *mag;
+
+	if ((mag = tc->loaded) && (mag->cnt < LIST_MAG_SIZE)) {
+		mag->objs[mag->cnt++] = obj;
+		return;
+	}
+	if ((mag = tc->prev) && !mag->cnt) {
+		tc->prev = tc->loaded;
+		tc->loaded = mag;
+		mag->objs[mag->cnt++] = obj;
+		return;
+	}
+
+	_list_tcache_init();
+	mag = NULL;
+	slurm_mutex_lock(&cache->mutex);
+	cache->stats.alloc_cnt += tc->alloc_cnt;
+	tc->alloc_cnt = 0;
+	if (tc->loaded && !tc->prev)
+		tc->prev = tc->loaded;
+	else if (tc->loaded)
+		_list_depot_put(cache, tc->loaded);
+	if (cache->empty_cnt)
+		mag = cache->empty[--cache->empty_cnt];
+	slurm_mutex_unlock(&cache->mutex);
+
+	if (!mag)
+		mag = xmalloc(sizeof(*mag));
+	tc->loaded = mag;
+	mag->objs[mag->cnt++] = obj;
+}
+#endif /* !MEMORY_LEAK_DEBUG */
@@ -36,6 +36,8 @@
 #ifndef LSD_LIST_H
 #define LSD_LIST_H
 
+#include <stdint.h>
+
 #define FREE_NULL_LIST(_X)			\
 	do {					\
 		if (_X) list_destroy (_X);	\
@@ -367,4 +369,35 @@ void *list_remove(ListIterator i);
  */
 int list_delete_item(ListIterator i);
 
+
+/*******************************
+ *  Allocation Cache Counters  *
+ *******************************/
+
+/*
+ *  Counters of the caches of list nodes and iterators. Allocations are
+ *    counted per thread and added up when a thread exchanges a magazine
+ *    with the depot, so alloc_cnt may lag behind.
+ */
+typedef struct {
+	uint64_t alloc_cnt;	/* objects allocated */
+	uint64_t malloc_cnt;	/* of which not found cached, from malloc */
+	uint64_t free_cnt;	/* objects freed as the depot was full */
+	uint64_t depot_cnt;	/* magazines taken from or put to the depot */
+	uint32_t cached_cnt;	/* objects currently in the depot */
+} list_cache_stats_t;
+
+/*
+ *  Copies the counters of the list node and iterator caches into
+ *    [node_stats] and [itr_stats].
+ */
+void list_cache_stats(list_cache_stats_t *node_stats,
+		      list_cache_stats_t *itr_stats);
+
+/*
+ *  Resets the counters of the list node and iterator caches, except
+ *    for cached_cnt.
+ */
+void list_cache_clear_stats(void);
+
 #endif /* !LSD_LIST_H */
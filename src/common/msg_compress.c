@@ -0,0 +1,363 @@
+/*****************************************************************************\
+ *  msg_compress.c - Compression of large RPC messages
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if HAVE_LIBZ
+# include <zlib.h>
+#endif
+
+#if HAVE_LZ4
+# include <lz4.h>
+#endif
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/msg_compress.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_persist_conn.h"
+#include "src/common/slurm_protocol_common.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define DEFAULT_MIN_SIZE	(64 * 1024)
+
+/* Compression type and uncompressed length ahead of the compressed data */
+#define MSG_COMPRESS_HDR_SIZE	(sizeof(uint16_t) + sizeof(uint32_t))
+
+typedef struct {
+	uint32_t cnt;		/* messages (de)compressed */
+	uint64_t raw_bytes;	/* their uncompressed size */
+	uint64_t wire_bytes;	/* their size on the wire */
+	uint64_t time;		/* usec spent, including on messages which
+				 * did not compress */
+} compress_stats_t;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static compress_stats_t send_stats;
+static compress_stats_t recv_stats;
+
+/* From CommunicationParameters, see msg_compress_conf() */
+static uint16_t conf_type = MSG_COMPRESS_NONE;
+static uint32_t conf_min_size = DEFAULT_MIN_SIZE;
+
+static void _add_stats(compress_stats_t *stats, uint32_t raw_bytes,
+		       uint32_t wire_bytes, long time)
+{
+	slurm_mutex_lock(&stats_mutex);
+	if (wire_bytes) {
+		stats->cnt++;
+		stats->raw_bytes += raw_bytes;
+		stats->wire_bytes += wire_bytes;
+	}
+	stats->time += time;
+	slurm_mutex_unlock(&stats_mutex);
+}
+
+/* Return the compressed size, or 0 if it does not fit in out_size */
+static uint32_t _compress(uint16_t type, char *in, uint32_t in_size,
+			  char *out, uint32_t out_size)
+{
+	uint32_t size = 0;
+
+	switch (type) {
+#if HAVE_LZ4
+	case MSG_COMPRESS_LZ4:
+		size = LZ4_compress_default(in, out, in_size, out_size);
+		break;
+#endif
+#if HAVE_LIBZ
+	case MSG_COMPRESS_ZLIB:
+	{
+		z_stream strm;
+
+		memset(&strm, 0, sizeof(strm));
+		if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK)
+			break;
+		strm.next_in = (Bytef *) in;
+		strm.avail_in = in_size;
+		strm.next_out = (Bytef *) out;
+		strm.avail_out = out_size;
+		if (deflate(&strm, Z_FINISH) == Z_STREAM_END)
+			size = strm.total_out;
+		(void) deflateEnd(&strm);
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+
+	return size;
+}
+
+/* Return SLURM_SUCCESS if in decompressed to exactly out_size bytes */
+static int _decompress(uint16_t type, char *in, uint32_t in_size,
+		       char *out, uint32_t out_size)
+{
+	switch (type) {
+#if HAVE_LZ4
+	case MSG_COMPRESS_LZ4:
+		if (LZ4_decompress_safe(in, out, in_size, out_size) ==
+		    out_size)
+			return SLURM_SUCCESS;
+		break;
+#endif
+#if HAVE_LIBZ
+	case MSG_COMPRESS_ZLIB:
+	{
+		z_stream strm;
+		int rc;
+
+		memset(&strm, 0, sizeof(strm));
+		if (inflateInit(&strm) != Z_OK)
+			break;
+		strm.next_in = (Bytef *) in;
+		strm.avail_in = in_size;
+		strm.next_out = (Bytef *) out;
+		strm.avail_out = out_size;
+		rc = inflate(&strm, Z_FINISH);
+		(void) inflateEnd(&strm);
+		if ((rc == Z_STREAM_END) && (strm.total_out == out_size))
+			return SLURM_SUCCESS;
+		break;
+	}
+#endif
+	default:
+		error("%s: unsupported compression type %hu", __func__, type);
+		break;
+	}
+
+	return SLURM_ERROR;
+}
+
+extern void msg_compress_conf(char *comm_params)
+{
+	uint16_t type = MSG_COMPRESS_NONE;
+	char *tmp_ptr;
+
+	conf_min_size = DEFAULT_MIN_SIZE;
+	if ((tmp_ptr = xstrcasestr(comm_params, "MsgCompressMinSize=")))
+		conf_min_size = strtoul(tmp_ptr + strlen("MsgCompressMinSize="),
+					NULL, 10);
+
+	if (!(tmp_ptr = xstrcasestr(comm_params, "MsgCompress="))) {
+		conf_type = MSG_COMPRESS_NONE;
+		return;
+	}
+	tmp_ptr += strlen("MsgCompress=");
+#if HAVE_LZ4
+	if (!xstrncasecmp(tmp_ptr, "lz4", 3))
+		type = MSG_COMPRESS_LZ4;
+#endif
+#if HAVE_LIBZ
+	if (!xstrncasecmp(tmp_ptr, "zlib", 4))
+		type = MSG_COMPRESS_ZLIB;
+#endif
+	if (type == MSG_COMPRESS_NONE)
+		error("CommunicationParameters=MsgCompress=%s not supported, messages will not be compressed",
+		      tmp_ptr);
+	conf_type = type;
+}
+
+extern uint16_t msg_compress_accept_flags(void)
+{
+	uint16_t flags = 0;
+
+#if HAVE_LZ4
+	flags |= SLURM_MSG_ACCEPT_LZ4;
+#endif
+#if HAVE_LIBZ
+	flags |= SLURM_MSG_ACCEPT_ZLIB;
+#endif
+
+	return flags;
+}
+
+extern uint16_t msg_compress_type(uint16_t accept_flags)
+{
+	uint16_t type = conf_type;
+
+	if ((type == MSG_COMPRESS_LZ4) &&
+	    (accept_flags & SLURM_MSG_ACCEPT_LZ4))
+		return type;
+	if ((type == MSG_COMPRESS_ZLIB) &&
+	    (accept_flags & SLURM_MSG_ACCEPT_ZLIB))
+		return type;
+
+	return MSG_COMPRESS_NONE;
+}
+
+extern uint16_t msg_compress_accept2persist(uint16_t accept_flags)
+{
+	uint16_t flags = 0;
+
+	if (accept_flags & SLURM_MSG_ACCEPT_LZ4)
+		flags |= PERSIST_FLAG_ACCEPT_LZ4;
+	if (accept_flags & SLURM_MSG_ACCEPT_ZLIB)
+		flags |= PERSIST_FLAG_ACCEPT_ZLIB;
+
+	return flags;
+}
+
+extern uint16_t msg_compress_persist2accept(uint16_t persist_flags)
+{
+	uint16_t flags = 0;
+
+	if (persist_flags & PERSIST_FLAG_ACCEPT_LZ4)
+		flags |= SLURM_MSG_ACCEPT_LZ4;
+	if (persist_flags & PERSIST_FLAG_ACCEPT_ZLIB)
+		flags |= SLURM_MSG_ACCEPT_ZLIB;
+
+	return flags;
+}
+
+extern buf_t *msg_compress(buf_t *buffer, uint16_t type)
+{
+	uint32_t size = get_buf_len(buffer), out_size;
+	char *data;
+	buf_t *out;
+	DEF_TIMERS;
+
+	if ((type == MSG_COMPRESS_NONE) || (size < conf_min_size) ||
+	    (size <= MSG_COMPRESS_HDR_SIZE + 1))
+		return NULL;
+
+	START_TIMER;
+	data = flatten_buf(buffer);
+	out = init_buf(MSG_COMPRESS_HDR_SIZE + size);
+	pack16(type, out);
+	pack32(size, out);
+	/* Anything not smaller than the message is not worth sending */
+	out_size = _compress(type, data, size,
+			     get_buf_data(out) + get_buf_offset(out),
+			     size - MSG_COMPRESS_HDR_SIZE - 1);
+	if (data != get_buf_data(buffer))
+		xfree(data);
+	if (out_size) {
+		set_buf_offset(out, get_buf_offset(out) + out_size);
+	} else {
+		FREE_NULL_BUFFER(out);
+	}
+	END_TIMER;
+
+	_add_stats(&send_stats, size, out ? get_buf_offset(out) : 0,
+		   DELTA_TIMER);
+	if (out)
+		log_flag(NET, "%s: compressed %u byte message to %u bytes in %ld usec",
+			 __func__, size, get_buf_offset(out), DELTA_TIMER);
+
+	return out;
+}
+
+extern int msg_decompress(char **buf, uint32_t *size, uint16_t accept_flags,
+			  uint32_t max_size)
+{
+	buf_t *in = create_buf(*buf, *size);
+	uint16_t type;
+	uint32_t raw_size;
+	char *raw = NULL;
+	int rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+	DEF_TIMERS;
+
+	START_TIMER;
+	safe_unpack16(&type, in);
+	safe_unpack32(&raw_size, in);
+	if (!(((type == MSG_COMPRESS_LZ4) &&
+	       (accept_flags & SLURM_MSG_ACCEPT_LZ4)) ||
+	      ((type == MSG_COMPRESS_ZLIB) &&
+	       (accept_flags & SLURM_MSG_ACCEPT_ZLIB)))) {
+		error("%s: compression type %hu not accepted",
+		      __func__, type);
+		goto unpack_error;
+	}
+	if (raw_size > max_size) {
+		error("%s: insane uncompressed message length %u",
+		      __func__, raw_size);
+		rc = SLURM_PROTOCOL_INSANE_MSG_LENGTH;
+		goto unpack_error;
+	}
+
+	raw = xmalloc_nz(raw_size);
+	if (_decompress(type, get_buf_data(in) + get_buf_offset(in),
+			remaining_buf(in), raw, raw_size)) {
+		error("%s: failed to decompress %u byte message",
+		      __func__, *size);
+		xfree(raw);
+		goto unpack_error;
+	}
+	END_TIMER;
+
+	_add_stats(&recv_stats, raw_size, *size, DELTA_TIMER);
+	free_buf(in);
+	*buf = raw;
+	*size = raw_size;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	free_buf(in);
+	*buf = NULL;
+	*size = 0;
+	return rc;
+}
+
+extern void msg_compress_pack_stats(buf_t *buffer)
+{
+	slurm_mutex_lock(&stats_mutex);
+	pack32(send_stats.cnt, buffer);
+	pack64(send_stats.raw_bytes, buffer);
+	pack64(send_stats.wire_bytes, buffer);
+	pack64(send_stats.time, buffer);
+	pack32(recv_stats.cnt, buffer);
+	pack64(recv_stats.raw_bytes, buffer);
+	pack64(recv_stats.wire_bytes, buffer);
+	pack64(recv_stats.time, buffer);
+	slurm_mutex_unlock(&stats_mutex);
+}
+
+extern void msg_compress_clear_stats(void)
+{
+	slurm_mutex_lock(&stats_mutex);
+	memset(&send_stats, 0, sizeof(send_stats));
+	memset(&recv_stats, 0, sizeof(recv_stats));
+	slurm_mutex_unlock(&stats_mutex);
+}
@@ -0,0 +1,120 @@
+/*****************************************************************************\
+ *  msg_compress.h - Compression of large RPC messages
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _MSG_COMPRESS_H
+#define _MSG_COMPRESS_H
+
+#include <stdint.h>
+
+#include "src/common/pack.h"
+
+/*
+ * Messages at least CommunicationParameters=MsgCompressMinSize bytes long
+ * are compressed with the MsgCompress algorithm before being sent, if the
+ * peer has advertised that it can decompress it and compression makes them
+ * smaller.
+ *
+ * A compressed message has MSG_COMPRESS_FLAG set in its length prefix, the
+ * length of the data on the wire. That data is the compression type
+ * (uint16_t), the uncompressed length (uint32_t) and the compressed message.
+ * Everything from the message header on is compressed, so the receiver
+ * hands the decompressed message to the usual unpack functions.
+ *
+ * Peers advertise the types they can decompress with SLURM_MSG_ACCEPT_*
+ * flags in the header of their requests, which response_init() copies into
+ * the responses, and with PERSIST_FLAG_ACCEPT_* flags exchanged when a
+ * persistent connection is opened. Receivers only decompress messages where
+ * they advertised so: responses to their requests and messages on an
+ * opened persistent connection. A compressed request is rejected before
+ * its data is read, so unauthenticated peers can not make the receiver
+ * decompress anything.
+ */
+
+#define MSG_COMPRESS_FLAG	0x80000000
+
+#define MSG_COMPRESS_NONE	0
+#define MSG_COMPRESS_LZ4	1
+#define MSG_COMPRESS_ZLIB	2
+
+/*
+ * msg_compress_conf - set the MsgCompress type and MsgCompressMinSize to use
+ *	from CommunicationParameters, called whenever slurm.conf is read
+ */
+extern void msg_compress_conf(char *comm_params);
+
+/* Return the SLURM_MSG_ACCEPT_* flags of the types this build decompresses */
+extern uint16_t msg_compress_accept_flags(void);
+
+/*
+ * msg_compress_type - pick the type to compress messages to a peer with
+ * IN accept_flags - SLURM_MSG_ACCEPT_* flags the peer advertised
+ * RET configured MSG_COMPRESS_* type if the peer accepts it, else
+ *     MSG_COMPRESS_NONE
+ */
+extern uint16_t msg_compress_type(uint16_t accept_flags);
+
+/*
+ * Convert SLURM_MSG_ACCEPT_* header flags to the PERSIST_FLAG_ACCEPT_*
+ * flags of a persistent connection and back.
+ */
+extern uint16_t msg_compress_accept2persist(uint16_t accept_flags);
+extern uint16_t msg_compress_persist2accept(uint16_t persist_flags);
+
+/*
+ * msg_compress - compress the whole of a message, including its segments
+ * IN buffer - message to compress
+ * IN type - MSG_COMPRESS_* type to compress with
+ * RET new buffer holding the data to send with MSG_COMPRESS_FLAG, or NULL if
+ *     buffer is to be sent as is: too small, not compressible or on error
+ */
+extern buf_t *msg_compress(buf_t *buffer, uint16_t type);
+
+/*
+ * msg_decompress - decompress the data of a message received with
+ *	MSG_COMPRESS_FLAG
+ * IN/OUT buf - data received, xfree'd and replaced by the message
+ * IN/OUT size - size of buf
+ * IN accept_flags - SLURM_MSG_ACCEPT_* flags advertised to the sender
+ * IN max_size - largest message to accept
+ * RET SLURM_SUCCESS or error code
+ */
+extern int msg_decompress(char **buf, uint32_t *size, uint16_t accept_flags,
+			  uint32_t max_size);
+
+/* Pack or clear compression statistics, as reported by sdiag */
+extern void msg_compress_pack_stats(buf_t *buffer);
+extern void msg_compress_clear_stats(void);
+
+#endif
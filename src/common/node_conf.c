@@ -68,6 +68,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -89,6 +90,27 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/*
+ * Node names split into a prefix and a numeric suffix, grouped by prefix and
+ * sorted by suffix, so that the ranges of a hostlist can be mapped to node
+ * indexes without building each host name. Built by rehash_node().
+ */
+typedef struct {
+	unsigned long num;	/* numeric suffix */
+	int width;		/* digits in suffix, including leading zeros */
+	int node_inx;		/* index into node_record_table_ptr */
+} node_suffix_t;
+
+typedef struct {
+	char *prefix;
+	int suffix_cnt;
+	node_suffix_t *suffix;	/* points into node_suffix_array */
+} node_prefix_t;
+
+static node_prefix_t *node_prefix_array = NULL;
+static int node_prefix_cnt = 0;
+static node_suffix_t *node_suffix_array = NULL;
+
 /* Local function definitions */
 static int	_delete_config_record (void);
 #if _DEBUG
@@ -96,7 +118,9 @@ static void	_dump_hash (void);
 #endif
 static node_record_t *_find_node_record(char *name, bool test_alias,
 					bool log_missing);
+static void	_free_node_prefix_index(void);
 static void	_list_delete_config (void *config_entry);
+static void	_rehash_node_table(void);
 static void _node_record_hash_identity (void* item, const char** key,
 					uint32_t* key_len);
 
@@ -659,13 +683,14 @@ extern node_record_t *create_node_record(config_record_t *config_ptr,
 		 * You need to rehash the hash after we realloc or we will have
 		 * only bad memory references in the hash.
 		 */
-		rehash_node();
+		_rehash_node_table();
 	}
 	node_ptr = node_record_table_ptr + (node_record_count++);
 	node_ptr->name = xstrdup(node_name);
 	if (!node_hash_table)
 		node_hash_table = xhash_init(_node_record_hash_identity, NULL);
 	xhash_add(node_hash_table, node_ptr);
+	_free_node_prefix_index();
 
 	node_ptr->config_ptr = config_ptr;
 	/* these values will be overwritten when the node actually registers */
@@ -800,6 +825,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_free_node_prefix_index();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -824,6 +850,7 @@ extern void node_fini2 (void)
 	}
 
 	xhash_free(node_hash_table);
+	_free_node_prefix_index();
 	node_ptr = node_record_table_ptr;
 	for (i = 0; i < node_record_count; i++, node_ptr++)
 		purge_node_rec(node_ptr);
@@ -833,6 +860,247 @@ extern void node_fini2 (void)
 }
 
 
+static void _free_node_prefix_index(void)
+{
+	for (int i = 0; i < node_prefix_cnt; i++)
+		xfree(node_prefix_array[i].prefix);
+	xfree(node_prefix_array);
+	xfree(node_suffix_array);
+	node_prefix_cnt = 0;
+}
+
+typedef struct {
+	char *prefix;
+	node_suffix_t suffix;
+} node_name_split_t;
+
+static int _cmp_node_name_split(const void *x, const void *y)
+{
+	const node_name_split_t *a = x, *b = y;
+	int rc;
+
+	if ((rc = xstrcmp(a->prefix, b->prefix)))
+		return rc;
+	if (a->suffix.num != b->suffix.num)
+		return (a->suffix.num < b->suffix.num) ? -1 : 1;
+	return a->suffix.width - b->suffix.width;
+}
+
+/* Build node_prefix_array from the names in node_record_table_ptr */
+static void _build_node_prefix_index(void)
+{
+	node_record_t *node_ptr = node_record_table_ptr;
+	node_name_split_t *split;
+	int split_cnt = 0;
+
+	_free_node_prefix_index();
+
+	/* Ranges of multi-dimensional names are not decimal numbers */
+	if (slurmdb_setup_cluster_name_dims() > 1)
+		return;
+
+	split = xcalloc(node_record_count, sizeof(*split));
+	for (int i = 0; i < node_record_count; i++, node_ptr++) {
+		char *name = node_ptr->name;
+		int len, end;
+
+		if (!name || !name[0])
+			continue;	/* vestigial record */
+		len = end = strlen(name);
+		while ((end > 0) && isdigit((int) name[end - 1]))
+			end--;
+		/* Other names are only found through node_hash_table */
+		if ((end == len) || ((len - end) > 18))
+			continue;
+
+		split[split_cnt].prefix = xstrndup(name, end);
+		split[split_cnt].suffix.num = strtoul(name + end, NULL, 10);
+		split[split_cnt].suffix.width = len - end;
+		split[split_cnt].suffix.node_inx = i;
+		split_cnt++;
+	}
+	if (!split_cnt) {
+		xfree(split);
+		return;
+	}
+	qsort(split, split_cnt, sizeof(*split), _cmp_node_name_split);
+
+	node_prefix_array = xcalloc(split_cnt, sizeof(node_prefix_t));
+	node_suffix_array = xcalloc(split_cnt, sizeof(node_suffix_t));
+	for (int i = 0; i < split_cnt; i++) {
+		node_prefix_t *prefix_ptr;
+
+		node_suffix_array[i] = split[i].suffix;
+		if (node_prefix_cnt &&
+		    !xstrcmp(node_prefix_array[node_prefix_cnt - 1].prefix,
+			     split[i].prefix)) {
+			node_prefix_array[node_prefix_cnt - 1].suffix_cnt++;
+			xfree(split[i].prefix);
+			continue;
+		}
+		prefix_ptr = &node_prefix_array[node_prefix_cnt++];
+		prefix_ptr->prefix = split[i].prefix;
+		prefix_ptr->suffix = &node_suffix_array[i];
+		prefix_ptr->suffix_cnt = 1;
+	}
+	xfree(split);
+}
+
+static node_prefix_t *_find_node_prefix(char *prefix)
+{
+	int lo = 0, hi = node_prefix_cnt;
+
+	while (lo < hi) {
+		int mid = lo + ((hi - lo) / 2);
+		int rc = xstrcmp(node_prefix_array[mid].prefix, prefix);
+
+		if (!rc)
+			return &node_prefix_array[mid];
+		if (rc < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+/* Return the index of the first suffix of prefix_ptr not less than num */
+static int _find_node_suffix(node_prefix_t *prefix_ptr, unsigned long num)
+{
+	int lo = 0, hi = prefix_ptr->suffix_cnt;
+
+	while (lo < hi) {
+		int mid = lo + ((hi - lo) / 2);
+
+		if (prefix_ptr->suffix[mid].num < num)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static int _digits(unsigned long num)
+{
+	int digits = 1;
+
+	while (num >= 10) {
+		num /= 10;
+		digits++;
+	}
+
+	return digits;
+}
+
+/* Set the bit of one node found by name, or by its NodeHostName */
+static int _name2bitmap(char *name, bool best_effort, bitstr_t *bitmap,
+			const char *caller)
+{
+	node_record_t *node_ptr;
+
+	if ((node_ptr = _find_node_record(name, best_effort, true))) {
+		bit_set(bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+		return SLURM_SUCCESS;
+	}
+
+	error("%s: invalid node specified %s", caller, name);
+	return best_effort ? SLURM_SUCCESS : EINVAL;
+}
+
+/* Set the bits of hosts lo through hi of a range one name at a time */
+static int _range_names2bitmap(char *prefix, unsigned long lo,
+			       unsigned long hi, int width, bool best_effort,
+			       bitstr_t *bitmap, const char *caller)
+{
+	int rc = SLURM_SUCCESS;
+
+	for (unsigned long num = lo; num <= hi; num++) {
+		char *name = xstrdup_printf("%s%0*lu", prefix, width, num);
+
+		if (_name2bitmap(name, best_effort, bitmap, caller))
+			rc = EINVAL;
+		xfree(name);
+		if (num == hi)
+			break;
+	}
+
+	return rc;
+}
+
+/*
+ * Set the bits of the hosts in a hostlist range using node_prefix_array.
+ * Hosts not in it, e.g. aliases, are looked up by name.
+ */
+static int _range2bitmap(char *prefix, unsigned long lo, unsigned long hi,
+			 int width, bool best_effort, bitstr_t *bitmap,
+			 const char *caller)
+{
+	node_prefix_t *prefix_ptr;
+	unsigned long next = lo;
+	int rc = SLURM_SUCCESS;
+
+	if ((prefix_ptr = _find_node_prefix(prefix))) {
+		for (int i = _find_node_suffix(prefix_ptr, lo);
+		     (i < prefix_ptr->suffix_cnt) &&
+		     (prefix_ptr->suffix[i].num <= hi); i++) {
+			node_suffix_t *suffix = &prefix_ptr->suffix[i];
+
+			/* Zero padding must match, "n01" is not in "n[1-9]" */
+			if (suffix->width != MAX(width, _digits(suffix->num)))
+				continue;
+			if ((suffix->num > next) &&
+			    _range_names2bitmap(prefix, next, suffix->num - 1,
+						width, best_effort, bitmap,
+						caller))
+				rc = EINVAL;
+			bit_set(bitmap, suffix->node_inx);
+			next = suffix->num + 1;
+		}
+	}
+	if ((next <= hi) && (next >= lo) &&
+	    _range_names2bitmap(prefix, next, hi, width, best_effort, bitmap,
+				caller))
+		rc = EINVAL;
+
+	return rc;
+}
+
+static int _hostlist2bitmap(hostlist_t hl, bool best_effort, bitstr_t *bitmap,
+			    const char *caller)
+{
+	int rc = SLURM_SUCCESS, n, range, width;
+	unsigned long lo, hi;
+	char *prefix;
+
+	if (!node_prefix_cnt) {
+		hostlist_iterator_t itr = hostlist_iterator_create(hl);
+		char *name;
+
+		while ((name = hostlist_next(itr))) {
+			if (_name2bitmap(name, best_effort, bitmap, caller))
+				rc = EINVAL;
+			free(name);
+		}
+		hostlist_iterator_destroy(itr);
+		return rc;
+	}
+
+	for (n = 0; (range = hostlist_get_range_values(hl, n, &prefix, &lo,
+						       &hi, &width)) >= 0;
+	     n++) {
+		if (!range) {
+			if (_name2bitmap(prefix, best_effort, bitmap, caller))
+				rc = EINVAL;
+		} else if (_range2bitmap(prefix, lo, hi, width, best_effort,
+					 bitmap, caller))
+			rc = EINVAL;
+	}
+
+	return rc;
+}
+
 /*
  * node_name2bitmap - given a node name regular expression, build a bitmap
  *	representation
@@ -846,7 +1114,6 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
 
@@ -866,20 +1133,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(this_node_name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("node_name2bitmap: invalid node specified %s",
-			       this_node_name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (this_node_name);
-	}
+	rc = _hostlist2bitmap(host_list, best_effort, my_bitmap, __func__);
 	hostlist_destroy (host_list);
 
 	return rc;
@@ -894,34 +1148,10 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
  */
 extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 {
-	int rc = SLURM_SUCCESS;
-	bitstr_t *my_bitmap;
-	char *name;
-	hostlist_iterator_t hi;
-
 	FREE_NULL_BITMAP(*bitmap);
-	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
-	*bitmap = my_bitmap;
-
-	hi = hostlist_iterator_create(hl);
-	while ((name = hostlist_next(hi))) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("hostlist2bitmap: invalid node specified %s",
-			       name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (name);
-	}
-
-	hostlist_iterator_destroy(hi);
-	return rc;
+	*bitmap = (bitstr_t *) bit_alloc (node_record_count);
 
+	return _hostlist2bitmap(hl, best_effort, *bitmap, __func__);
 }
 
 /* Purge the contents of a node record */
@@ -950,11 +1180,7 @@ extern void purge_node_rec(node_record_t *node_ptr)
 	xfree(node_ptr->tres_cnt);
 }
 
-/*
- * rehash_node - build a hash table of the node_record entries.
- * NOTE: using xhash implementation
- */
-extern void rehash_node (void)
+static void _rehash_node_table(void)
 {
 	int i;
 	node_record_t *node_ptr = node_record_table_ptr;
@@ -971,7 +1197,17 @@ extern void rehash_node (void)
 #if _DEBUG
 	_dump_hash();
 #endif
-	return;
+}
+
+/*
+ * rehash_node - build a hash table of the node_record entries, and the
+ *	index of node name prefixes used to convert hostlist ranges.
+ * NOTE: using xhash implementation
+ */
+extern void rehash_node (void)
+{
+	_rehash_node_table();
+	_build_node_prefix_index();
 }
 
 /* Convert a node state string to it's equivalent enum value */
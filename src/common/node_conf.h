@@ -330,7 +330,8 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 extern void purge_node_rec(node_record_t *node_ptr);
 
 /*
- * rehash_node - build a hash table of the node_record entries.
+ * rehash_node - build a hash table of the node_record entries, and the
+ *	index of node name prefixes used by node_name2bitmap().
  * NOTE: manages memory for node_hash_table
  */
 extern void rehash_node (void);
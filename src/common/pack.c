@@ -60,12 +60,47 @@
 #include "src/common/pack.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xassert.h"
+#include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
 
 #define MAX_ARRAY_LEN_SMALL	10000
 #define MAX_ARRAY_LEN_MEDIUM	1000000
 #define MAX_ARRAY_LEN_LARGE	100000000
 
+/* Heads of segmented buffers kept for reuse */
+#define BUF_POOL_MAX		64
+/* Smaller data is copied into a segmented buffer's head by packmem_seg() */
+#define BUF_SEG_MIN_SIZE	BUF_SIZE
+
+#define STR_DICT_MAGIC		0x5d1c7e55
+/* Set in place of a string length to reference a dictionary entry */
+#define STR_DICT_REF		0x80000000
+#define STR_DICT_TABLE_MIN	256
+
+/* Where packstr_dict() packed a string, see str_dict_log_uses() */
+typedef struct {
+	uint32_t offset;	/* offset in the buffer */
+	uint32_t size;		/* bytes packed */
+	uint32_t inx;		/* index of the string in the dictionary */
+} str_dict_use_t;
+
+struct str_dict {
+	uint32_t magic;
+	uint32_t cnt;		/* strings in strs */
+	uint32_t size;		/* elements allocated in strs */
+	char **strs;		/* strings in the order added, owned by us */
+	uint32_t table_size;	/* slots in table, a power of 2 */
+	uint32_t *table;	/* index in strs + 1 by hash, 0 if empty */
+	bool log_uses;		/* from str_dict_log_uses() */
+	uint32_t use_cnt;	/* elements used in uses */
+	uint32_t use_size;	/* elements allocated in uses */
+	str_dict_use_t *uses;	/* strings packed, in buffer order */
+};
+
+static pthread_mutex_t buf_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *buf_pool[BUF_POOL_MAX];
+static int buf_pool_cnt = 0;
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
@@ -75,6 +110,8 @@ strong_alias(create_mmap_buf,	slurm_create_mmap_buf);
 strong_alias(free_buf,		slurm_free_buf);
 strong_alias(grow_buf,		slurm_grow_buf);
 strong_alias(init_buf,		slurm_init_buf);
+strong_alias(init_seg_buf,	slurm_init_seg_buf);
+strong_alias(flatten_buf,	slurm_flatten_buf);
 strong_alias(xfer_buf_data,	slurm_xfer_buf_data);
 strong_alias(pack_time,		slurm_pack_time);
 strong_alias(unpack_time,	slurm_unpack_time);
@@ -108,7 +145,26 @@ strong_alias(unpackstr_xmalloc_chooser, slurm_unpackstr_xmalloc_chooser);
 strong_alias(packstr_array,	slurm_packstr_array);
 strong_alias(unpackstr_array,	slurm_unpackstr_array);
 strong_alias(packmem_array,	slurm_packmem_array);
+strong_alias(packmem_seg,	slurm_packmem_seg);
 strong_alias(unpackmem_array,	slurm_unpackmem_array);
+strong_alias(str_dict_create,	slurm_str_dict_create);
+strong_alias(str_dict_destroy,	slurm_str_dict_destroy);
+strong_alias(str_dict_intern,	slurm_str_dict_intern);
+strong_alias(set_buf_str_dict,	slurm_set_buf_str_dict);
+strong_alias(packstr_dict,	slurm_packstr_dict);
+strong_alias(unpackstr_dict,	slurm_unpackstr_dict);
+strong_alias(str_dict_log_uses,	slurm_str_dict_log_uses);
+strong_alias(str_dict_use_cnt,	slurm_str_dict_use_cnt);
+strong_alias(packstr_dict_copy,	slurm_packstr_dict_copy);
+strong_alias(set_buf_arena,	slurm_set_buf_arena);
+
+/*
+ * Memory for unpacked data, from the arena of the buffer if it has one.
+ * Like xmalloc_nz(), the memory is not necessarily zeroed.
+ */
+#define _unpack_xmalloc(_buffer, _size)				\
+	((_buffer)->arena ? xarena_alloc((_buffer)->arena, _size) :	\
+	 xmalloc_nz(_size))
 
 /* Basic buffer management routines */
 /* create_buf - create a buffer with the supplied contents, contents must
@@ -129,6 +185,12 @@ Buf create_buf(char *data, uint32_t size)
 	my_buf->processed = 0;
 	my_buf->head = data;
 	my_buf->mmaped = false;
+	my_buf->segmented = false;
+	my_buf->seg_cnt = 0;
+	my_buf->seg_bytes = 0;
+	my_buf->segs = NULL;
+	my_buf->str_dict = NULL;
+	my_buf->arena = NULL;
 
 	return my_buf;
 }
@@ -168,6 +230,12 @@ Buf create_mmap_buf(char *file)
 	my_buf->processed = 0;
 	my_buf->head = data;
 	my_buf->mmaped = true;
+	my_buf->segmented = false;
+	my_buf->seg_cnt = 0;
+	my_buf->seg_bytes = 0;
+	my_buf->segs = NULL;
+	my_buf->str_dict = NULL;
+	my_buf->arena = NULL;
 
 	debug3("%s: loaded file `%s` as Buf", __func__, file);
 
@@ -183,9 +251,19 @@ void free_buf(Buf my_buf)
 	xassert(my_buf->magic == BUF_MAGIC);
 	if (my_buf->mmaped)
 		munmap(my_buf->head, my_buf->size);
-	else
+	else if (my_buf->segmented && (my_buf->size == BUF_SIZE)) {
+		/* Return heads which did not grow to the pool */
+		slurm_mutex_lock(&buf_pool_lock);
+		if (buf_pool_cnt < BUF_POOL_MAX) {
+			buf_pool[buf_pool_cnt++] = my_buf->head;
+			my_buf->head = NULL;
+		}
+		slurm_mutex_unlock(&buf_pool_lock);
+		xfree(my_buf->head);
+	} else
 		xfree(my_buf->head);
 
+	xfree(my_buf->segs);
 	xfree(my_buf);
 }
 
@@ -222,9 +300,62 @@ Buf init_buf(uint32_t size)
 	my_buf->processed = 0;
 	my_buf->head = xmalloc(size);
 	my_buf->mmaped = false;
+	my_buf->segmented = false;
+	my_buf->seg_cnt = 0;
+	my_buf->seg_bytes = 0;
+	my_buf->segs = NULL;
+	my_buf->str_dict = NULL;
+	my_buf->arena = NULL;
 	return my_buf;
 }
 
+/*
+ * init_seg_buf - create an empty segmented buffer of BUF_SIZE
+ *
+ * The head is taken from a pool of BUF_SIZE allocations and is not zeroed.
+ * Large data packed with packmem_seg() is kept by reference, so it is not
+ * copied and the head does not have to grow to hold it. Such buffers are
+ * only for sending with slurm_msg_sendto_buf(), which writes the head and
+ * the segments in order, so the receiver unpacks them as usual.
+ */
+Buf init_seg_buf(void)
+{
+	Buf my_buf = xmalloc_nz(sizeof(struct slurm_buf));
+
+	my_buf->magic = BUF_MAGIC;
+	my_buf->size = BUF_SIZE;
+	my_buf->processed = 0;
+	my_buf->head = NULL;
+	slurm_mutex_lock(&buf_pool_lock);
+	if (buf_pool_cnt)
+		my_buf->head = buf_pool[--buf_pool_cnt];
+	slurm_mutex_unlock(&buf_pool_lock);
+	if (!my_buf->head)
+		my_buf->head = xmalloc_nz(BUF_SIZE);
+	my_buf->mmaped = false;
+	my_buf->segmented = true;
+	my_buf->seg_cnt = 0;
+	my_buf->seg_bytes = 0;
+	my_buf->segs = NULL;
+	my_buf->str_dict = NULL;
+	my_buf->arena = NULL;
+
+	return my_buf;
+}
+
+/*
+ * set_buf_arena - allocate the data unpacked from buffer with unpack*_xmalloc()
+ *	and unpack*_array() from arena, or from the heap if arena is NULL
+ * NOTE: the buffer does not take the arena, the caller destroys it once the
+ *	unpacked data is no longer used
+ */
+void set_buf_arena(Buf buffer, xarena_t *arena)
+{
+	xassert(buffer->magic == BUF_MAGIC);
+
+	buffer->arena = arena;
+}
+
 /* xfer_buf_data - return a pointer to the buffer's data and release the
  * buffer's structure */
 void *xfer_buf_data(Buf my_buf)
@@ -235,12 +366,47 @@ void *xfer_buf_data(Buf my_buf)
 
 	if (my_buf->mmaped)
 		fatal_abort("attempt to grow mmap()'d buffer not supported");
+	if (my_buf->seg_cnt)
+		fatal_abort("attempt to transfer segmented buffer data not supported");
 
 	data_ptr = (void *) my_buf->head;
 	xfree(my_buf);
 	return data_ptr;
 }
 
+/*
+ * flatten_buf - return the data packed in a buffer in one piece, with the
+ *	segments of one created by init_seg_buf() in place, as it is sent
+ * RET get_buf_data(my_buf) if it has no segments, otherwise a copy of
+ *	get_buf_len(my_buf) bytes which must be xfreed by the caller
+ */
+char *flatten_buf(Buf my_buf)
+{
+	char *data;
+	uint32_t offset = 0, pos = 0;
+
+	xassert(my_buf->magic == BUF_MAGIC);
+
+	if (!my_buf->seg_cnt)
+		return get_buf_data(my_buf);
+
+	data = xmalloc_nz(get_buf_len(my_buf));
+	for (int i = 0; i < my_buf->seg_cnt; i++) {
+		buf_seg_t *seg = &my_buf->segs[i];
+
+		memcpy(data + pos, get_buf_data(my_buf) + offset,
+		       seg->offset - offset);
+		pos += seg->offset - offset;
+		offset = seg->offset;
+		memcpy(data + pos, seg->data, seg->size);
+		pos += seg->size;
+	}
+	memcpy(data + pos, get_buf_data(my_buf) + offset,
+	       get_buf_offset(my_buf) - offset);
+
+	return data;
+}
+
 /*
  * Given a time_t in host byte order, promote it to int64_t, convert to
  * network byte order, store in buffer and adjust buffer acc'd'ngly
@@ -522,7 +688,7 @@ int unpack16_array(uint16_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_MEDIUM)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint16_t));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(uint16_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack16((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -558,7 +724,7 @@ int unpack32_array(uint32_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_LARGE)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint32_t));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(uint32_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -610,7 +776,7 @@ int unpack64_array(uint64_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_MEDIUM)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint64_t));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(uint64_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack64((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -631,7 +797,7 @@ int unpack64_array_from_32(uint64_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_MEDIUM)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint64_t));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(uint64_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32(&val32, buffer))
 			return SLURM_ERROR;
@@ -662,7 +828,7 @@ int unpackdouble_array(double **valp, uint32_t* size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_SMALL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(double));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(double));
 	for (i = 0; i < *size_val; i++) {
 		if (unpackdouble((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -692,7 +858,7 @@ int unpacklongdouble_array(long double **valp, uint32_t* size_val, Buf buffer)
 	if ((*size_val) > MAX_ARRAY_LEN_SMALL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(long double));
+	*valp = _unpack_xmalloc(buffer, (*size_val) * sizeof(long double));
 	for (i = 0; i < *size_val; i++) {
 		if (unpacklongdouble((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -940,7 +1106,7 @@ int unpackmem_xmalloc(char **valp, uint32_t * size_valp, Buf buffer)
 	else if (*size_valp > 0) {
 		if (remaining_buf(buffer) < *size_valp)
 			return SLURM_ERROR;
-		*valp = xmalloc_nz(*size_valp);
+		*valp = _unpack_xmalloc(buffer, *size_valp);
 		memcpy(*valp, &buffer->head[buffer->processed],
 		       *size_valp);
 		buffer->processed += *size_valp;
@@ -1025,7 +1191,7 @@ int unpackstr_xmalloc_escaped(char **valp, uint32_t *size_valp, Buf buffer)
 			return SLURM_ERROR;
 
 		/* make a buffer 2 times the size just to be safe */
-		*valp = xmalloc_nz((cnt * 2) + 1);
+		*valp = _unpack_xmalloc(buffer, (cnt * 2) + 1);
 		if (*valp) {
 			char *copy = NULL, *str, tmp;
 			uint32_t i;
@@ -1042,7 +1208,7 @@ int unpackstr_xmalloc_escaped(char **valp, uint32_t *size_valp, Buf buffer)
 				*copy++ = tmp;
 			}
 
-			/* Since we used xmalloc_nz, terminate the string. */
+			/* The memory may not be zeroed, terminate string. */
 			*copy++ = '\0';
 		}
 
@@ -1119,7 +1285,8 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
 		return SLURM_ERROR;
 	}
 	else if (*size_valp > 0) {
-		*valp = xmalloc_nz(sizeof(char *) * (*size_valp + 1));
+		*valp = _unpack_xmalloc(buffer,
+					sizeof(char *) * (*size_valp + 1));
 		for (i = 0; i < *size_valp; i++) {
 			if (unpackmem_xmalloc(&(*valp)[i], &uint32_tmp, buffer))
 				return SLURM_ERROR;
@@ -1154,6 +1321,35 @@ void packmem_array(char *valp, uint32_t size_val, Buf buffer)
 	buffer->processed += size_val;
 }
 
+/*
+ * As packmem_array(), but if buffer is segmented and size_val is large,
+ * keep a reference to valp rather than copying it. valp must not be
+ * modified or freed until buffer is freed.
+ */
+void packmem_seg(char *valp, uint32_t size_val, Buf buffer)
+{
+	buf_seg_t *seg;
+
+	if (!buffer->segmented || (size_val < BUF_SEG_MIN_SIZE)) {
+		packmem_array(valp, size_val, buffer);
+		return;
+	}
+
+	if (((uint64_t) get_buf_len(buffer) + size_val) > MAX_BUF_SIZE) {
+		error("%s: Buffer size limit exceeded (%"PRIu64" > %u)",
+		      __func__, ((uint64_t) get_buf_len(buffer) + size_val),
+		      MAX_BUF_SIZE);
+		return;
+	}
+
+	xrecalloc(buffer->segs, buffer->seg_cnt + 1, sizeof(buf_seg_t));
+	seg = &buffer->segs[buffer->seg_cnt++];
+	seg->data = valp;
+	seg->offset = buffer->processed;
+	seg->size = size_val;
+	buffer->seg_bytes += size_val;
+}
+
 /*
  * Given a pointer to memory (valp), size (size_val), and buffer,
  * store the buffer contents into memory
@@ -1169,3 +1365,283 @@ int unpackmem_array(char *valp, uint32_t size_valp, Buf buffer)
 		return SLURM_ERROR;
 	}
 }
+
+/*
+ * str_dict_create - create an empty string dictionary
+ *
+ * A buffer given a dictionary with set_buf_str_dict() packs each distinct
+ * string passed to packstr_dict() once, and later occurrences as a
+ * reference to it. The receiver unpacks with unpackstr_dict() from a buffer
+ * given a dictionary of its own, which then holds the strings. Those are
+ * shared by all the records unpacked, so they must not be freed or
+ * modified, and the dictionary must be kept as long as the records are.
+ */
+str_dict_t *str_dict_create(void)
+{
+	str_dict_t *dict = xmalloc(sizeof(*dict));
+
+	dict->magic = STR_DICT_MAGIC;
+
+	return dict;
+}
+
+/* str_dict_destroy - free a string dictionary and all of its strings */
+void str_dict_destroy(str_dict_t *dict)
+{
+	if (!dict)
+		return;
+	xassert(dict->magic == STR_DICT_MAGIC);
+
+	for (uint32_t i = 0; i < dict->cnt; i++)
+		xfree(dict->strs[i]);
+	xfree(dict->strs);
+	xfree(dict->table);
+	xfree(dict->uses);
+	dict->magic = ~STR_DICT_MAGIC;
+	xfree(dict);
+}
+
+/* FNV-1a */
+static uint32_t _str_hash(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *str; str++) {
+		hash ^= (unsigned char) *str;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+/* Return the index of str in dict or NO_VAL, slot set to its table slot */
+static uint32_t _str_dict_find(str_dict_t *dict, const char *str,
+			       uint32_t hash, uint32_t *slot)
+{
+	uint32_t mask = dict->table_size - 1, inx;
+
+	for (*slot = hash & mask; (inx = dict->table[*slot]);
+	     *slot = (*slot + 1) & mask) {
+		if (!strcmp(dict->strs[inx - 1], str))
+			return inx - 1;
+	}
+
+	return NO_VAL;
+}
+
+static void _str_dict_grow(str_dict_t *dict)
+{
+	uint32_t *old_table = dict->table, old_size = dict->table_size;
+	uint32_t slot;
+
+	dict->table_size = MAX(old_size * 2, STR_DICT_TABLE_MIN);
+	dict->table = xcalloc(dict->table_size, sizeof(uint32_t));
+	for (uint32_t i = 0; i < old_size; i++) {
+		if (!old_table[i])
+			continue;
+		(void) _str_dict_find(dict, dict->strs[old_table[i] - 1],
+				      _str_hash(dict->strs[old_table[i] - 1]),
+				      &slot);
+		dict->table[slot] = old_table[i];
+	}
+	xfree(old_table);
+}
+
+/*
+ * Append str, which the dictionary takes, and return its index. A string
+ * added twice keeps its first index in the table, as the sender only ever
+ * references that one.
+ */
+static uint32_t _str_dict_add(str_dict_t *dict, char *str, uint32_t hash)
+{
+	uint32_t slot;
+
+	if ((dict->cnt + 1) * 2 > dict->table_size)
+		_str_dict_grow(dict);
+	if (dict->cnt >= dict->size) {
+		dict->size = MAX(dict->size * 2, STR_DICT_TABLE_MIN);
+		xrecalloc(dict->strs, dict->size, sizeof(char *));
+	}
+
+	dict->strs[dict->cnt] = str;
+	if (_str_dict_find(dict, str, hash, &slot) == NO_VAL)
+		dict->table[slot] = dict->cnt + 1;
+
+	return dict->cnt++;
+}
+
+/*
+ * str_dict_intern - return the dictionary's copy of str, adding one if
+ *	needed, or NULL if str is NULL
+ */
+char *str_dict_intern(str_dict_t *dict, char *str)
+{
+	uint32_t hash, inx, slot;
+
+	xassert(dict->magic == STR_DICT_MAGIC);
+
+	if (!str)
+		return NULL;
+
+	hash = _str_hash(str);
+	if (!dict->table ||
+	    ((inx = _str_dict_find(dict, str, hash, &slot)) == NO_VAL))
+		inx = _str_dict_add(dict, xstrdup(str), hash);
+
+	return dict->strs[inx];
+}
+
+/*
+ * set_buf_str_dict - set the dictionary used by packstr_dict() and
+ *	unpackstr_dict() on buffer, or stop using one if dict is NULL
+ * NOTE: the buffer does not take the dictionary, the caller frees it after
+ *	the buffer is done with it
+ */
+void set_buf_str_dict(Buf buffer, str_dict_t *dict)
+{
+	xassert(buffer->magic == BUF_MAGIC);
+	xassert(!dict || (dict->magic == STR_DICT_MAGIC));
+
+	buffer->str_dict = dict;
+}
+
+/*
+ * str_dict_log_uses - make packstr_dict() log where it packs each string
+ *	in buffers given dict, so that packstr_dict_copy() can copy the data
+ */
+void str_dict_log_uses(str_dict_t *dict)
+{
+	xassert(dict->magic == STR_DICT_MAGIC);
+
+	dict->log_uses = true;
+}
+
+/* str_dict_use_cnt - return the number of strings logged as packed so far */
+uint32_t str_dict_use_cnt(str_dict_t *dict)
+{
+	if (!dict)
+		return 0;
+	xassert(dict->magic == STR_DICT_MAGIC);
+
+	return dict->use_cnt;
+}
+
+static void _str_dict_log_use(str_dict_t *dict, uint32_t offset,
+			      uint32_t size, uint32_t inx)
+{
+	str_dict_use_t *use;
+
+	if (dict->use_cnt >= dict->use_size) {
+		dict->use_size = MAX(dict->use_size * 2, STR_DICT_TABLE_MIN);
+		xrecalloc(dict->uses, dict->use_size, sizeof(str_dict_use_t));
+	}
+	use = &dict->uses[dict->use_cnt++];
+	use->offset = offset;
+	use->size = size;
+	use->inx = inx;
+}
+
+/*
+ * As packstr(), but if buffer has a dictionary and str was packed in it
+ * before, pack a reference to that instead.
+ */
+void packstr_dict(char *str, Buf buffer)
+{
+	str_dict_t *dict = buffer->str_dict;
+	uint32_t hash, inx, slot, offset = get_buf_offset(buffer);
+
+	if (!dict || !str) {
+		packstr(str, buffer);
+		return;
+	}
+
+	hash = _str_hash(str);
+	if (dict->table &&
+	    ((inx = _str_dict_find(dict, str, hash, &slot)) != NO_VAL)) {
+		pack32(STR_DICT_REF | inx, buffer);
+	} else {
+		packstr(str, buffer);
+		inx = _str_dict_add(dict, xstrdup(str), hash);
+	}
+
+	if (dict->log_uses)
+		_str_dict_log_use(dict, offset, get_buf_offset(buffer) - offset,
+				  inx);
+}
+
+/*
+ * packstr_dict_copy - append size bytes from offset of data to buffer.
+ *	data was packed with dictionary src logging its uses, so each string
+ *	packed there with packstr_dict() is packed again for buffer, keeping
+ *	the copy valid at its new place in the message.
+ * IN data - packed data, whole from its start as offsets are logged so
+ * IN offset - offset of the bytes to copy in data
+ * IN size - count of bytes to copy
+ * IN src - dictionary data was packed with, NULL for plain data
+ * IN first_use - str_dict_use_cnt(src) when the bytes at offset were packed
+ * IN/OUT buffer - buffer to append to
+ */
+void packstr_dict_copy(char *data, uint32_t offset, uint32_t size,
+		       str_dict_t *src, uint32_t first_use, Buf buffer)
+{
+	uint32_t end = offset + size;
+
+	xassert(!src || ((src->magic == STR_DICT_MAGIC) && src->log_uses));
+
+	for (uint32_t i = first_use; src && (i < src->use_cnt); i++) {
+		str_dict_use_t *use = &src->uses[i];
+
+		if (use->offset >= end)
+			break;
+		xassert(use->offset >= offset);
+		packmem_array(data + offset, use->offset - offset, buffer);
+		packstr_dict(src->strs[use->inx], buffer);
+		offset = use->offset + use->size;
+	}
+	packmem_array(data + offset, end - offset, buffer);
+}
+
+/*
+ * Unpack a string packed with packstr_dict()
+ * NOTE: If buffer has a dictionary *valp is set to a string owned by it,
+ *	which must not be freed. Otherwise the caller must xfree() *valp.
+ */
+int unpackstr_dict(char **valp, Buf buffer)
+{
+	str_dict_t *dict = buffer->str_dict;
+	uint32_t ns, size_val;
+
+	*valp = NULL;
+
+	if (remaining_buf(buffer) < sizeof(ns))
+		return SLURM_ERROR;
+	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
+	ns = ntohl(ns);
+
+	if (ns & STR_DICT_REF) {
+		if (!dict || ((ns & ~STR_DICT_REF) >= dict->cnt)) {
+			error("%s: Invalid string reference %u",
+			      __func__, (ns & ~STR_DICT_REF));
+			return SLURM_ERROR;
+		}
+		*valp = dict->strs[ns & ~STR_DICT_REF];
+		buffer->processed += sizeof(ns);
+		return SLURM_SUCCESS;
+	}
+
+	if (unpackstr_xmalloc_chooser(valp, &size_val, buffer))
+		return SLURM_ERROR;
+	if (!dict || !*valp)
+		return SLURM_SUCCESS;
+	/* The dictionary may outlive the arena */
+	xkeep(*valp);
+
+	/* Strings are hashed and compared, so must be terminated */
+	if ((*valp)[size_val - 1] != '\0') {
+		xfree(*valp);
+		return SLURM_ERROR;
+	}
+	(void) _str_dict_add(dict, *valp, _str_hash(*valp));
+
+	return SLURM_SUCCESS;
+}
@@ -48,6 +48,7 @@
 
 #include "src/common/bitstring.h"
 #include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
 
 #define BUF_MAGIC 0x42554545
 #define BUF_SIZE (16 * 1024)
@@ -60,12 +61,31 @@
 #define MAX_PACK_ARRAY_LEN	(128 * 1024)
 #define MAX_PACK_MEM_LEN	(1024 * 1024 * 1024)
 
+/*
+ * Data sent by reference after the first offset bytes of a segmented
+ * buffer's head, see packmem_seg().
+ */
+typedef struct {
+	char *data;
+	uint32_t offset;
+	uint32_t size;
+} buf_seg_t;
+
+/* Strings sent once per buffer by packstr_dict(), see str_dict_create() */
+typedef struct str_dict str_dict_t;
+
 typedef struct slurm_buf {
 	uint32_t magic;
 	char *head;
 	uint32_t size;
 	uint32_t processed;
 	bool mmaped;
+	bool segmented;		/* from init_seg_buf() */
+	uint32_t seg_cnt;	/* elements in segs */
+	uint32_t seg_bytes;	/* sum of segs[].size */
+	buf_seg_t *segs;
+	str_dict_t *str_dict;	/* from set_buf_str_dict() */
+	xarena_t *arena;	/* from set_buf_arena() */
 } buf_t;
 
 typedef struct slurm_buf * Buf;
@@ -75,13 +95,18 @@ typedef struct slurm_buf * Buf;
 #define set_buf_offset(__buf,__val)	(__buf->processed = __val)
 #define remaining_buf(__buf)		(__buf->size - __buf->processed)
 #define size_buf(__buf)			(__buf->size)
+/* Bytes packed, including segments not copied into head */
+#define get_buf_len(__buf)		(__buf->processed + __buf->seg_bytes)
 
 Buf	create_buf (char *data, uint32_t size);
 Buf	create_mmap_buf(char *file);
 void	free_buf(Buf my_buf);
 Buf	init_buf(uint32_t size);
+Buf	init_seg_buf(void);
 void    grow_buf (Buf my_buf, uint32_t size);
 void	*xfer_buf_data(Buf my_buf);
+char	*flatten_buf(Buf my_buf);
+void	set_buf_arena(Buf buffer, xarena_t *arena);
 
 void	pack_time(time_t val, Buf buffer);
 int	unpack_time(time_t *valp, Buf buffer);
@@ -142,8 +167,20 @@ void	packstr_array(char **valp, uint32_t size_val, Buf buffer);
 int	unpackstr_array(char ***valp, uint32_t* size_val, Buf buffer);
 
 void	packmem_array(char *valp, uint32_t size_val, Buf buffer);
+void	packmem_seg(char *valp, uint32_t size_val, Buf buffer);
 int	unpackmem_array(char *valp, uint32_t size_valp, Buf buffer);
 
+str_dict_t *str_dict_create(void);
+void	str_dict_destroy(str_dict_t *dict);
+char	*str_dict_intern(str_dict_t *dict, char *str);
+void	set_buf_str_dict(Buf buffer, str_dict_t *dict);
+void	str_dict_log_uses(str_dict_t *dict);
+uint32_t str_dict_use_cnt(str_dict_t *dict);
+void	packstr_dict(char *str, Buf buffer);
+void	packstr_dict_copy(char *data, uint32_t offset, uint32_t size,
+			  str_dict_t *src, uint32_t first_use, Buf buffer);
+int	unpackstr_dict(char **valp, Buf buffer);
+
 #define safe_unpack_time(valp,buf) do {			\
 	xassert(sizeof(*valp) == sizeof(time_t));	\
 	xassert(buf->magic == BUF_MAGIC);		\
@@ -348,6 +385,12 @@ int	unpackmem_array(char *valp, uint32_t size_valp, Buf buffer);
 		goto unpack_error;		       		\
 } while (0)
 
+#define safe_unpackstr_dict(valp, buf) do {			\
+	xassert(buf->magic == BUF_MAGIC);			\
+	if (unpackstr_dict(valp, buf))				\
+		goto unpack_error;				\
+} while (0)
+
 #define safe_unpackstr_array(valp,size_valp,buf) do {	\
 	xassert(sizeof(*size_valp) == sizeof(uint32_t)); \
 	xassert(buf->magic == BUF_MAGIC);		\
@@ -70,6 +70,7 @@
 #include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/node_conf.h"
 #include "src/common/node_features.h"
 #include "src/common/parse_config.h"
@@ -3103,6 +3104,7 @@ static int _init_slurm_conf(const char *file_name)
 	no_addr_cache = false;
 	if (xstrcasestr("NoAddrCache", conf_ptr->comm_params))
 		no_addr_cache = true;
+	msg_compress_conf(conf_ptr->comm_params);
 
 	conf_initialized = true;
 
@@ -47,6 +47,7 @@
 #include "slurm/slurm_errno.h"
 #include "src/common/fd.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurmdbd_defs.h"
@@ -223,7 +224,7 @@ static int _process_service_connection(
 	uint32_t nw_size = 0, msg_size = 0, uid = NO_VAL;
 	char *msg_char = NULL;
 	ssize_t msg_read = 0, offset = 0;
-	bool first = true, fini = false;
+	bool first = true, fini = false, compressed;
 	Buf buffer = NULL;
 	int rc = SLURM_SUCCESS;
 
@@ -249,6 +250,8 @@ static int _process_service_connection(
 			break;
 		}
 		msg_size = ntohl(nw_size);
+		compressed = (msg_size & MSG_COMPRESS_FLAG);
+		msg_size &= ~MSG_COMPRESS_FLAG;
 		if ((msg_size < 2) || (msg_size > MAX_MSG_SIZE)) {
 			error("Invalid msg_size (%u) from "
 			      "connection %d(%s) uid(%d)",
@@ -256,6 +259,14 @@ static int _process_service_connection(
 			      persist_conn->rem_host, uid);
 			break;
 		}
+		/* Only after telling an authenticated peer we accept them */
+		if (compressed &&
+		    !(persist_conn->flags & PERSIST_FLAG_DECOMPRESS)) {
+			error("Unexpected compressed message from "
+			      "connection %d(%s) uid(%d)",
+			      persist_conn->fd, persist_conn->rem_host, uid);
+			break;
+		}
 
 		msg_char = xmalloc(msg_size);
 		offset = 0;
@@ -270,6 +281,14 @@ static int _process_service_connection(
 			}
 			offset += msg_read;
 		}
+		if ((msg_size == offset) && compressed) {
+			if (msg_decompress(&msg_char, &msg_size,
+					   msg_compress_accept_flags(),
+					   MAX_MSG_SIZE))
+				offset = -1;	/* fail as a short read */
+			else
+				offset = msg_size;
+		}
 		if (msg_size == offset) {
 			persist_msg_t msg;
 
@@ -645,6 +664,9 @@ extern int slurm_persist_conn_open(slurm_persist_conn_t *persist_conn)
 		if (resp && (rc == SLURM_SUCCESS)) {
 			rc = resp->rc;
 			persist_conn->version = resp->ret_info;
+			/* The peer may have been restarted with another build */
+			persist_conn->flags &= ~(PERSIST_FLAG_ACCEPT_LZ4 |
+						 PERSIST_FLAG_ACCEPT_ZLIB);
 			persist_conn->flags |= resp->flags;
 		}
 
@@ -847,6 +869,8 @@ extern int slurm_persist_send_msg(
 	char *msg;
 	ssize_t msg_wrote;
 	int rc, retry_cnt = 0;
+	uint16_t compress;
+	Buf compressed = NULL;
 
 	xassert(persist_conn);
 
@@ -856,47 +880,72 @@ extern int slurm_persist_send_msg(
 	if (!buffer)
 		return SLURM_ERROR;
 
+	compress = msg_compress_type(
+		msg_compress_persist2accept(persist_conn->flags));
+	if (compress && (compressed = msg_compress(buffer, compress)))
+		buffer = compressed;
+
 	rc = slurm_persist_conn_writeable(persist_conn);
 	if (rc == -1) {
 	re_open:
 		/* if errno is ACCESS_DENIED do not try to reopen to
 		   connection just return that */
-		if (errno == ESLURM_ACCESS_DENIED)
-			return ESLURM_ACCESS_DENIED;
+		if (errno == ESLURM_ACCESS_DENIED) {
+			rc = ESLURM_ACCESS_DENIED;
+			goto end_it;
+		}
 
-		if (retry_cnt++ > 3)
-			return SLURM_COMMUNICATIONS_SEND_ERROR;
+		if (retry_cnt++ > 3) {
+			rc = SLURM_COMMUNICATIONS_SEND_ERROR;
+			goto end_it;
+		}
 
 		if (persist_conn->flags & PERSIST_FLAG_RECONNECT) {
 			slurm_persist_conn_reopen(persist_conn, true);
 			rc = slurm_persist_conn_writeable(persist_conn);
-		} else
-			return SLURM_ERROR;
+		} else {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+	}
+	if (rc < 1) {
+		rc = EAGAIN;
+		goto end_it;
 	}
-	if (rc < 1)
-		return EAGAIN;
 
 	msg_size = get_buf_offset(buffer);
-	nw_size = htonl(msg_size);
+	if (compressed)
+		nw_size = htonl(msg_size | MSG_COMPRESS_FLAG);
+	else
+		nw_size = htonl(msg_size);
 	msg_wrote = write(persist_conn->fd, &nw_size, sizeof(nw_size));
-	if (msg_wrote != sizeof(nw_size))
-		return EAGAIN;
+	if (msg_wrote != sizeof(nw_size)) {
+		rc = EAGAIN;
+		goto end_it;
+	}
 
 	msg = get_buf_data(buffer);
 	while (msg_size > 0) {
 		rc = slurm_persist_conn_writeable(persist_conn);
 		if (rc == -1)
 			goto re_open;
-		if (rc < 1)
-			return EAGAIN;
+		if (rc < 1) {
+			rc = EAGAIN;
+			goto end_it;
+		}
 		msg_wrote = write(persist_conn->fd, msg, msg_size);
-		if (msg_wrote <= 0)
-			return EAGAIN;
+		if (msg_wrote <= 0) {
+			rc = EAGAIN;
+			goto end_it;
+		}
 		msg += msg_wrote;
 		msg_size -= msg_wrote;
 	}
+	rc = SLURM_SUCCESS;
 
-	return SLURM_SUCCESS;
+end_it:
+	FREE_NULL_BUFFER(compressed);
+	return rc;
 }
 
 extern Buf slurm_persist_recv_msg(slurm_persist_conn_t *persist_conn)
@@ -905,6 +954,7 @@ extern Buf slurm_persist_recv_msg(slurm_persist_conn_t *persist_conn)
 	char *msg;
 	ssize_t msg_read, offset;
 	Buf buffer;
+	bool compressed;
 
 	xassert(persist_conn);
 
@@ -930,6 +980,8 @@ extern Buf slurm_persist_recv_msg(slurm_persist_conn_t *persist_conn)
 		goto endit;
 	}
 	msg_size = ntohl(nw_size);
+	compressed = (msg_size & MSG_COMPRESS_FLAG);
+	msg_size &= ~MSG_COMPRESS_FLAG;
 	/* Sanity check size is not too small or the max possible */
 	if ((msg_size == INFINITE) || (msg_size == NO_VAL) || (msg_size < 2)) {
 		error("%s: Invalid msg_size: %u bytes",
@@ -966,6 +1018,11 @@ extern Buf slurm_persist_recv_msg(slurm_persist_conn_t *persist_conn)
 		goto endit;
 	}
 
+	if (compressed &&
+	    msg_decompress(&msg, &msg_size, msg_compress_accept_flags(),
+			   (NO_VAL - 1)))
+		goto endit;
+
 	buffer = create_buf(msg, msg_size);
 	return buffer;
 
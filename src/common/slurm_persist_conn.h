@@ -45,6 +45,10 @@
 #define PERSIST_FLAG_ALREADY_INITED 0x0004
 #define PERSIST_FLAG_P_USER_CASE    0x0008
 #define PERSIST_FLAG_SUPPRESS_ERR   0x0010
+#define PERSIST_FLAG_ACCEPT_LZ4     0x0020 /* peer decompresses lz4 */
+#define PERSIST_FLAG_ACCEPT_ZLIB    0x0040 /* peer decompresses zlib */
+#define PERSIST_FLAG_DECOMPRESS     0x0080 /* we told the peer what we
+					    * decompress */
 
 typedef enum {
 	PERSIST_TYPE_NONE = 0,
@@ -62,6 +62,7 @@
 #include "src/common/forward.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/pack.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
@@ -913,6 +914,7 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
+	bool use_arena = (msg->flags & SLURM_MSG_ARENA);
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
@@ -984,12 +986,20 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 
 	msg->body_offset =  get_buf_offset(buffer);
 
+	/* Released with the message by slurm_free_msg() */
+	if (use_arena && slurm_msg_arena_type(msg->msg_type)) {
+		msg->arena = xarena_create();
+		set_buf_arena(buffer, msg->arena);
+	}
+
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
+		set_buf_arena(buffer, NULL);
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		(void) g_slurm_auth_destroy(auth_cred);
 		goto total_return;
 	}
+	set_buf_arena(buffer, NULL);
 
 	msg->auth_cred = (void *)auth_cred;
 
@@ -1018,7 +1028,9 @@ total_return:
  * NOTE: memory is allocated for the returned msg must be freed at
  *       some point using the slurm_free_functions.
  * IN fd	- file descriptor to receive msg on
- * OUT msg	- a slurm_msg struct to be filled in by the function
+ * OUT msg	- a slurm_msg struct to be filled in by the function, a
+ *		  compressed response is only taken if its flags are set to
+ *		  the SLURM_MSG_ACCEPT_* flags of the request
  * IN timeout	- how long to wait in milliseconds
  * RET int	- returns 0 on success, -1 on failure and sets errno
  */
@@ -1085,7 +1097,10 @@ int slurm_receive_msg(int fd, slurm_msg_t *msg, int timeout)
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
+	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen,
+				       msg->flags & (SLURM_MSG_ACCEPT_LZ4 |
+						     SLURM_MSG_ACCEPT_ZLIB),
+				       timeout) < 0) {
 		rc = errno;
 		goto endit;
 	}
@@ -1120,20 +1135,11 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 {
 	char *buf = NULL;
 	size_t buflen = 0;
-	header_t header;
 	int rc;
-	void *auth_cred = NULL;
-	slurm_msg_t msg;
-	Buf buffer;
-	ret_data_info_t *ret_data_info = NULL;
-	List ret_list = NULL;
 	int orig_timeout = timeout;
 
 	xassert(fd >= 0);
 
-	slurm_msg_t_init(&msg);
-	msg.conn_fd = fd;
-
 	if (timeout <= 0) {
 		/* convert secs to msec */
 		timeout = slurm_conf.msg_timeout * 1000;
@@ -1167,12 +1173,42 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
-		forward_init(&header.forward);
+	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen,
+				       msg_compress_accept_flags(),
+				       timeout) < 0) {
 		rc = errno;
-		goto total_return;
+		error("slurm_receive_msgs: %s", slurm_strerror(rc));
+		usleep(10000);	/* Discourage brute force attack */
+		errno = rc;
+		return NULL;
 	}
 
+	return slurm_unpack_received_msgs(buf, buflen, fd);
+}
+
+/*
+ * NOTE: memory is allocated for the returned list
+ *       and must be freed at some point using the list_destroy function.
+ * IN buf	- message read from fd, without its length, xfree'd here
+ * IN buflen	- size of buf
+ * IN fd	- file descriptor buf was read from, only used for logging
+ * RET List	- List containing the responses of the children (if any) we
+ *		  forwarded the message to. List containing type
+ *		  (ret_data_info_t).
+ */
+extern List slurm_unpack_received_msgs(char *buf, size_t buflen, int fd)
+{
+	header_t header;
+	int rc;
+	void *auth_cred = NULL;
+	slurm_msg_t msg;
+	Buf buffer;
+	ret_data_info_t *ret_data_info = NULL;
+	List ret_list = NULL;
+
+	slurm_msg_t_init(&msg);
+	msg.conn_fd = fd;
+
 	log_flag_hex(NET_RAW, buf, buflen, "%s: read", __func__);
 	buffer = create_buf(buf, buflen);
 
@@ -1269,7 +1305,7 @@ total_return:
 			ret_data_info->data = NULL;
 			list_push(ret_list, ret_data_info);
 		}
-		error("slurm_receive_msgs: %s", slurm_strerror(rc));
+		error("%s: %s", __func__, slurm_strerror(rc));
 		usleep(10000);	/* Discourage brute force attack */
 	} else {
 		if (!ret_list)
@@ -1507,9 +1543,9 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 {
 	unsigned int tmplen, msglen;
 
-	tmplen = get_buf_offset(buffer);
+	tmplen = get_buf_len(buffer);
 	pack_msg(msg, buffer);
-	msglen = get_buf_offset(buffer) - tmplen;
+	msglen = get_buf_len(buffer) - tmplen;
 
 	/* update header with correct cred and msg lengths */
 	update_header(hdr, msglen);
@@ -1521,17 +1557,96 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+/*
+ *  Pack the header, auth credential and body of msg into a new buffer,
+ *    which is segmented if requested. auth_cred is destroyed.
+ *    Returns NULL and sets errno on failure.
+ */
+static Buf _pack_node_msg(slurm_msg_t *msg, void *auth_cred, bool segmented)
+{
+	header_t header;
+	Buf buffer;
+	int rc;
+
+	init_header(&header, msg, msg->flags);
+	/* Tell the peer which compressed responses we can take */
+	if (header.version >= SLURM_20_11_PROTOCOL_VERSION)
+		header.flags |= msg_compress_accept_flags();
+
+	/*
+	 * Pack header into buffer for transmission
+	 */
+	buffer = segmented ? init_seg_buf() : init_buf(BUF_SIZE);
+	pack_header(&header, buffer);
+
+	/*
+	 * Pack auth credential
+	 */
+	rc = g_slurm_auth_pack(auth_cred, buffer, header.version);
+	(void) g_slurm_auth_destroy(auth_cred);
+	if (rc) {
+		error("%s: g_slurm_auth_pack: %s has  authentication error: %m",
+		      __func__, rpc_num2string(header.msg_type));
+		free_buf(buffer);
+		slurm_seterrno(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		return NULL;
+	}
+
+	/*
+	 * Pack message into buffer
+	 */
+	_pack_msg(msg, &header, buffer);
+	log_flag_hex(NET_RAW, get_buf_data(buffer), get_buf_offset(buffer),
+		     "%s: packed", __func__);
+
+	return buffer;
+}
+
+/*
+ *  Pack msg as slurm_send_node_msg() would send it, for callers doing their
+ *    own I/O. The message length is not included.
+ *    Returns NULL and sets errno on failure.
+ */
+extern Buf slurm_pack_node_msg(slurm_msg_t *msg)
+{
+	void *auth_cred;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+		auth_cred = g_slurm_auth_create(msg->auth_index,
+						_global_auth_key());
+	} else {
+		auth_cred = g_slurm_auth_create(msg->auth_index,
+						slurm_conf.authinfo);
+	}
+	if (auth_cred == NULL) {
+		error("%s: g_slurm_auth_create: %s has authentication error: %m",
+		      __func__, rpc_num2string(msg->msg_type));
+		slurm_seterrno(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		return NULL;
+	}
+
+	if (msg->forward.init != FORWARD_INIT) {
+		forward_init(&msg->forward);
+		msg->ret_list = NULL;
+	}
+
+	if (!msg->forward.tree_width)
+		msg->forward.tree_width = slurm_conf.tree_width;
+
+	return _pack_node_msg(msg, auth_cred, false);
+}
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
  */
 int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 {
-	header_t header;
 	Buf      buffer;
 	int      rc;
 	void *   auth_cred;
 	time_t   start_time = time(NULL);
+	uint16_t compress = MSG_COMPRESS_NONE;
 
 	if (msg->conn) {
 		persist_msg_t persist_msg;
@@ -1605,38 +1720,15 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	init_header(&header, msg, msg->flags);
-
-	/*
-	 * Pack header into buffer for transmission
-	 */
-	buffer = init_buf(BUF_SIZE);
-	pack_header(&header, buffer);
-
-	/*
-	 * Pack auth credential
-	 */
-	rc = g_slurm_auth_pack(auth_cred, buffer, header.version);
-	(void) g_slurm_auth_destroy(auth_cred);
-	if (rc) {
-		error("%s: g_slurm_auth_pack: %s has  authentication error: %m",
-		      __func__, rpc_num2string(header.msg_type));
-		free_buf(buffer);
-		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
-	}
-
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
-	log_flag_hex(NET_RAW, get_buf_data(buffer), get_buf_offset(buffer),
-		     "%s: packed", __func__);
+	if (!(buffer = _pack_node_msg(msg, auth_cred, true)))
+		return SLURM_ERROR;
 
 	/*
 	 * Send message
 	 */
-	rc = slurm_msg_sendto(fd, get_buf_data(buffer),
-			      get_buf_offset(buffer));
+	if (msg->protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		compress = msg_compress_type(msg->flags);
+	rc = slurm_msg_sendto_buf(fd, buffer, compress);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		log_flag(NET, "%s: peer has disappeared for msg_type=%u",
@@ -2023,6 +2115,8 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 		   forwarding or expecting anything other than 1 message
 		   and the regular timeout will be altered in
 		   slurm_receive_msg if it is 0 */
+		if (req->protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+			resp->flags |= msg_compress_accept_flags();
 		rc = slurm_receive_msg(fd, resp, timeout);
 	}
 
@@ -2064,38 +2158,44 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 	List ret_list = NULL;
 	int steps = 0;
 
+	timeout = slurm_msg_recv_timeout(req, timeout, &steps);
+	if (slurm_send_node_msg(fd, req) >= 0)
+		ret_list = slurm_receive_msgs(fd, steps, timeout);
+
+	(void) close(fd);
+
+	return ret_list;
+}
+
+extern int slurm_msg_recv_timeout(slurm_msg_t *req, int timeout, int *steps)
+{
+	*steps = 0;
+
 	if (!req->forward.timeout) {
 		if (!timeout)
 			timeout = slurm_conf.msg_timeout * 1000;
 		req->forward.timeout = timeout;
 	}
-	if (slurm_send_node_msg(fd, req) >= 0) {
-		if (req->forward.cnt > 0) {
-			/* figure out where we are in the tree and set
-			 * the timeout for to wait for our children
-			 * correctly
-			 * (timeout+message_timeout sec per step)
-			 * to let the child timeout */
-			if (message_timeout < 0)
-				message_timeout =
-					slurm_conf.msg_timeout * 1000;
-			steps = req->forward.cnt + 1;
-			if (!req->forward.tree_width)
-				req->forward.tree_width =
-					slurm_conf.tree_width;
-			if (req->forward.tree_width)
-				steps /= req->forward.tree_width;
-			timeout = (message_timeout * steps);
-			steps++;
-
-			timeout += (req->forward.timeout*steps);
-		}
-		ret_list = slurm_receive_msgs(fd, steps, timeout);
-	}
+	if (req->forward.cnt > 0) {
+		/* figure out where we are in the tree and set
+		 * the timeout for to wait for our children
+		 * correctly
+		 * (timeout+message_timeout sec per step)
+		 * to let the child timeout */
+		if (message_timeout < 0)
+			message_timeout = slurm_conf.msg_timeout * 1000;
+		*steps = req->forward.cnt + 1;
+		if (!req->forward.tree_width)
+			req->forward.tree_width = slurm_conf.tree_width;
+		if (req->forward.tree_width)
+			*steps /= req->forward.tree_width;
+		timeout = (message_timeout * *steps);
+		(*steps)++;
 
-	(void) close(fd);
+		timeout += (req->forward.timeout * *steps);
+	}
 
-	return ret_list;
+	return timeout;
 }
 
 /*
@@ -2121,6 +2221,7 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	slurm_addr_t ctrl_addr;
 	static bool use_backup = false;
 	slurmdb_cluster_rec_t *save_comm_cluster_rec = comm_cluster_rec;
+	int backoff = 1;
 
 	/*
 	 * Just in case the caller didn't initialize his slurm_msg_t, and
@@ -2179,6 +2280,26 @@ tryagain:
 			} else {
 				retry = 1;
 			}
+		} else if ((rc == 0)
+			   && (response_msg->msg_type == RESPONSE_SLURM_RC)
+			   && ((((return_code_msg_t *)response_msg->data)->return_code)
+			       == SLURMCTLD_COMMUNICATIONS_BACKOFF)
+			   && (difftime(time(NULL), start_time)
+			       < slurmctld_timeout)) {
+			/* Over our RPC rate limit, back off exponentially */
+			log_flag(NET, "%s: RPC rate limit exceeded. Sleeping %d seconds and retry.",
+				 __func__, backoff);
+			slurm_free_return_code_msg(response_msg->data);
+			sleep(backoff);
+			backoff = MIN(backoff * 2, 16);
+			if ((fd = slurm_open_controller_conn(&ctrl_addr,
+							     &use_backup,
+							     comm_cluster_rec))
+			    < 0) {
+				rc = -1;
+			} else {
+				retry = 1;
+			}
 		}
 
 		if (rc == -1)
@@ -2613,6 +2734,8 @@ extern void slurm_free_msg_members(slurm_msg_t *msg)
 			(void) g_slurm_auth_destroy(msg->auth_cred);
 		free_buf(msg->buffer);
 		slurm_free_msg_data(msg->msg_type, msg->data);
+		xarena_destroy(msg->arena);
+		msg->arena = NULL;
 		FREE_NULL_LIST(msg->ret_list);
 	}
 }
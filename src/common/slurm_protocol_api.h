@@ -264,7 +264,9 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer);
  *    freed with g_slurm_auth_destroy() if it exists.
  *
  * IN open_fd	- file descriptor to receive msg on
- * OUT msg	- a slurm_msg struct to be filled in by the function
+ * OUT msg	- a slurm_msg struct to be filled in by the function, a
+ *		  compressed response is only taken if its flags are set to
+ *		  the SLURM_MSG_ACCEPT_* flags of the request
  * IN timeout	- how long to wait in milliseconds
  * RET int	- returns 0 on success, -1 on failure and sets errno
  */
@@ -287,6 +289,19 @@ int slurm_receive_msg(int fd, slurm_msg_t *msg, int timeout);
  */
 List slurm_receive_msgs(int fd, int steps, int timeout);
 
+/*
+ * Unpack a message read by the caller from a connection, as
+ * slurm_receive_msgs() would after reading it.
+ * IN buf	- message read, without its length, xfree'd here
+ * IN buflen	- size of buf
+ * IN fd	- file descriptor buf was read from, only used for logging
+ * RET List	- List containing the responses of the children (if any) we
+ *                forwarded the message to. List containing type
+ *                (ret_data_info_t). NULL is returned on failure. and
+ *                errno set.
+ */
+extern List slurm_unpack_received_msgs(char *buf, size_t buflen, int fd);
+
 /*
  *  Receive a slurm message on the open slurm descriptor "fd". This will also
  *  forward the message to the nodes contained in the forward_t structure
@@ -315,6 +330,26 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
  */
 int slurm_send_node_msg(int open_fd, slurm_msg_t *msg);
 
+/*
+ * Pack the header, auth credential and body of a message into a new buffer,
+ * as slurm_send_node_msg() would send it but without the message length.
+ *
+ * IN msg		- a slurm msg struct to be packed
+ * RET Buf		- packed message, NULL on failure with errno set
+ */
+extern Buf slurm_pack_node_msg(slurm_msg_t *msg);
+
+/*
+ * Set the forward timeout of a message if not already set and return how
+ * long to wait for its response and those of the nodes it is forwarded to.
+ *
+ * IN/OUT req		- message to be sent
+ * IN timeout		- forward timeout in milliseconds, 0 for MessageTimeout
+ * OUT steps		- depth of the forwarding tree
+ * RET milliseconds to wait for the responses
+ */
+extern int slurm_msg_recv_timeout(slurm_msg_t *req, int timeout, int *steps);
+
 /**********************************************************************\
  * msg connection establishment functions used by msg clients
 \**********************************************************************/
@@ -107,5 +107,8 @@
 #define SLURM_DROP_PRIV		0x0008
 #define USE_BCAST_NETWORK	0x0010
 #define CTLD_QUEUE_PROCESSING	0x0020
+#define SLURM_MSG_ACCEPT_LZ4	0x0040	/* sender decompresses lz4 messages */
+#define SLURM_MSG_ACCEPT_ZLIB	0x0080	/* sender decompresses zlib messages */
+#define SLURM_MSG_ARENA		0x0100	/* receiver unpacks into an arena */
 
 #endif
@@ -1216,8 +1216,10 @@ extern void slurm_free_job_info_members(job_info_t * job)
 	if (job) {
 		xfree(job->account);
 		xfree(job->alloc_node);
-		if (job->array_bitmap)
+		if (job->array_bitmap) {
 			bit_free((bitstr_t *) job->array_bitmap);
+			job->array_bitmap = NULL;
+		}
 		xfree(job->array_task_str);
 		xfree(job->batch_features);
 		xfree(job->batch_host);
@@ -1737,12 +1739,15 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 {
 	int i;
 	if (msg) {
+		xfree(msg->bf_eval_jobs);
+		xfree(msg->bf_eval_time);
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
 		xfree(msg->rpc_type_time);
 		xfree(msg->rpc_user_id);
 		xfree(msg->rpc_user_cnt);
 		xfree(msg->rpc_user_time);
+		xfree(msg->rpc_user_rejected);
 		xfree(msg->rpc_queue_type_id);
 		xfree(msg->rpc_queue_count);
 		xfree(msg->rpc_dump_types);
@@ -1750,6 +1755,13 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		xfree(msg->rpc_pool_type_id);
+		xfree(msg->rpc_pool_threads);
+		xfree(msg->rpc_pool_depth);
+		xfree(msg->rpc_pool_depth_max);
+		xfree(msg->rpc_pool_cnt);
+		xfree(msg->rpc_pool_batch_cnt);
+		xfree(msg->rpc_pool_wait_time);
 		xfree(msg);
 	}
 }
@@ -4185,6 +4197,8 @@ extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr)
 			_free_all_job_info(job_buffer_ptr);
 			xfree(job_buffer_ptr->job_array);
 		}
+		xfree(job_buffer_ptr->purged_job_ids);
+		str_dict_destroy(job_buffer_ptr->str_dict);
 		xfree(job_buffer_ptr);
 	}
 }
@@ -4198,7 +4212,66 @@ static void _free_all_job_info(job_info_msg_t *msg)
 		return;
 
 	for (i = 0; i < msg->record_count; i++)
-		slurm_free_job_info_members (&msg->job_array[i]);
+		slurm_free_job_info_rec_members(msg, &msg->job_array[i]);
+}
+
+/*
+ * slurm_free_job_info_rec_members - free the members of job, a record of
+ *	msg, other than the strings it shares through msg's string dictionary
+ */
+extern void slurm_free_job_info_rec_members(job_info_msg_t *msg,
+					    job_info_t *job)
+{
+	if (msg->str_dict) {
+		char **strs[] = JOB_INFO_DICT_STRS(job);
+
+		for (int i = 0; i < ARRAY_SIZE(strs); i++)
+			*strs[i] = NULL;
+	}
+	slurm_free_job_info_members(job);
+}
+
+/*
+ * Make the strings of a record moved from a message with dictionary from to
+ * one with dictionary to shared through to, or owned by the record if to is
+ * NULL
+ */
+static void _xfer_dict_strs(char **strs[], int cnt, str_dict_t *from,
+			    str_dict_t *to)
+{
+	char *str;
+
+	if (from == to)
+		return;
+
+	for (int i = 0; i < cnt; i++) {
+		if (!(str = *strs[i]))
+			continue;
+		if (to)
+			*strs[i] = str_dict_intern(to, str);
+		else
+			*strs[i] = xstrdup(str);
+		if (!from)
+			xfree(str);
+	}
+}
+
+/*
+ * slurm_job_info_msg_xfer_strs - prepare the job records of src to be moved
+ *	into dst, making their strings shared through dst's string dictionary
+ *	or owned by the records as dst's are. src's dictionary is freed.
+ */
+extern void slurm_job_info_msg_xfer_strs(job_info_msg_t *dst,
+					 job_info_msg_t *src)
+{
+	for (int i = 0; i < src->record_count; i++) {
+		char **strs[] = JOB_INFO_DICT_STRS(&src->job_array[i]);
+
+		_xfer_dict_strs(strs, ARRAY_SIZE(strs), src->str_dict,
+				dst->str_dict);
+	}
+	str_dict_destroy(src->str_dict);
+	src->str_dict = NULL;
 }
 
 /*
@@ -4318,6 +4391,7 @@ extern void slurm_free_node_info_msg(node_info_msg_t * msg)
 			_free_all_node_info(msg);
 			xfree(msg->node_array);
 		}
+		str_dict_destroy(msg->str_dict);
 		xfree(msg);
 	}
 }
@@ -4329,8 +4403,35 @@ static void _free_all_node_info(node_info_msg_t *msg)
 	if ((msg == NULL) || (msg->node_array == NULL))
 		return;
 
-	for (i = 0; i < msg->record_count; i++)
+	for (i = 0; i < msg->record_count; i++) {
+		if (msg->str_dict) {
+			char **strs[] = NODE_INFO_DICT_STRS(
+						&msg->node_array[i]);
+
+			for (int j = 0; j < ARRAY_SIZE(strs); j++)
+				*strs[j] = NULL;
+		}
 		slurm_free_node_info_members(&msg->node_array[i]);
+	}
+}
+
+/*
+ * slurm_node_info_msg_xfer_strs - prepare the node records of src to be
+ *	moved into dst, making their strings shared through dst's string
+ *	dictionary or owned by the records as dst's are. src's dictionary is
+ *	freed.
+ */
+extern void slurm_node_info_msg_xfer_strs(node_info_msg_t *dst,
+					  node_info_msg_t *src)
+{
+	for (int i = 0; i < src->record_count; i++) {
+		char **strs[] = NODE_INFO_DICT_STRS(&src->node_array[i]);
+
+		_xfer_dict_strs(strs, ARRAY_SIZE(strs), src->str_dict,
+				dst->str_dict);
+	}
+	str_dict_destroy(src->str_dict);
+	src->str_dict = NULL;
 }
 
 extern void slurm_free_node_info_members(node_info_t * node)
@@ -4340,8 +4441,11 @@ extern void slurm_free_node_info_members(node_info_t * node)
 		xfree(node->cluster_name);
 		xfree(node->cpu_spec_list);
 		acct_gather_energy_destroy(node->energy);
+		node->energy = NULL;
 		ext_sensors_destroy(node->ext_sensors);
+		node->ext_sensors = NULL;
 		power_mgmt_data_free(node->power);
+		node->power = NULL;
 		xfree(node->features);
 		xfree(node->features_act);
 		xfree(node->gres);
@@ -4991,6 +5095,10 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_KILL_TIMELIMIT:
 		slurm_free_timelimit_msg(data);
 		break;
+	case REQUEST_SLURMD_MULT_MSG:
+	case RESPONSE_SLURMD_MULT_MSG:
+		slurm_free_composite_msg(data);
+		break;
 	case REQUEST_REATTACH_TASKS:
 		slurm_free_reattach_tasks_request_msg(data);
 		break;
@@ -5144,6 +5252,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_JOB_INFO:
 		slurm_free_job_info(data);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		slurm_free_job_info_msg(data);
+		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
 	case RESPONSE_HET_JOB_ALLOCATION:
@@ -5425,6 +5536,8 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_BURST_BUFFER_STATUS";
 	case RESPONSE_BURST_BUFFER_STATUS:
 		return "RESPONSE_BURST_BUFFER_STATUS";
+	case RESPONSE_JOB_INFO_DELTA:
+		return "RESPONSE_JOB_INFO_DELTA";
 
 	case REQUEST_UPDATE_JOB:				/* 3001 */
 		return "REQUEST_UPDATE_JOB";
@@ -5601,6 +5714,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:				/* 6019 */
 		return "RESPONSE_PROLOG_EXECUTING";
+	case REQUEST_SLURMD_MULT_MSG:
+		return "REQUEST_SLURMD_MULT_MSG";
+	case RESPONSE_SLURMD_MULT_MSG:
+		return "RESPONSE_SLURMD_MULT_MSG";
 
 	case SRUN_PING:						/* 7001 */
 		return "SRUN_PING";
@@ -5863,6 +5980,16 @@ extern void print_multi_line_string(char *user_msg, int inx,
 	xfree(buf);
 }
 
+extern bool slurm_msg_arena_type(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_SUBMIT_BATCH_JOB:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /*
  * Given a numeric suffix, return the equivalent multiplier for the numeric
  * portion. For example: "k" returns 1024, "KB" returns 1000, etc.
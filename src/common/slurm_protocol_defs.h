@@ -296,6 +296,7 @@ typedef enum {
 	RESPONSE_CONTROL_STATUS,
 	REQUEST_BURST_BUFFER_STATUS,
 	RESPONSE_BURST_BUFFER_STATUS,
+	RESPONSE_JOB_INFO_DELTA,
 
 	REQUEST_UPDATE_JOB = 3001,
 	REQUEST_UPDATE_NODE,
@@ -410,6 +411,9 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,	/* 6019 */
+	REQUEST_SLURMD_MULT_MSG,	/* requests for one node merged in a
+					 * composite_msg_t */
+	RESPONSE_SLURMD_MULT_MSG,
 
 	REQUEST_PERSIST_INIT = 6500,
 
@@ -514,6 +518,8 @@ typedef struct slurm_msg {
 	uint32_t body_offset; /* DON'T PACK: offset in buffer where body part of
 				 buffer starts. */
 	Buf buffer; /* DON't PACK! ptr to buffer that msg was unpacked from. */
+	xarena_t *arena; /* DON'T PACK! arena data was unpacked into, see
+			  * SLURM_MSG_ARENA. Destroyed by slurm_free_msg(). */
 	slurm_persist_conn_t *conn; /* DON'T PACK OR FREE! this is here to
 				     * distinguish a persistent connection from
 				     * a normal connection it should be filled
@@ -931,8 +937,9 @@ typedef struct network_callerid_resp {
 } network_callerid_resp_t;
 
 typedef struct composite_msg {
-	slurm_addr_t sender;	/* address of sending node/port */
-	List	 msg_list;
+	slurm_addr_t sender;	/* address of sending node/port, not packed */
+	List	 msg_list;	/* list of slurm_msg_t, each with its own
+				 * msg_type, msg_index and data */
 } composite_msg_t;
 
 typedef struct set_fs_dampening_factor_msg {
@@ -1421,8 +1428,28 @@ slurm_free_node_registration_status_msg(slurm_node_registration_status_msg_t *
 extern void slurm_free_node_reg_resp_msg(
 	slurm_node_reg_resp_msg_t *msg);
 
+/*
+ * Pointers to the job_info_t strings unpacked with unpackstr_dict(), which
+ * are owned by the message's dictionary if it has one
+ */
+#define JOB_INFO_DICT_STRS(_job) {					\
+	&(_job)->account, &(_job)->alloc_node, &(_job)->batch_host,	\
+	&(_job)->cluster, &(_job)->nodes, &(_job)->partition,		\
+	&(_job)->qos, &(_job)->tres_alloc_str, &(_job)->tres_per_node,	\
+	&(_job)->tres_req_str, &(_job)->user_name, &(_job)->wckey }
+
+/* The same for node_info_t */
+#define NODE_INFO_DICT_STRS(_node) {					\
+	&(_node)->arch, &(_node)->features, &(_node)->features_act,	\
+	&(_node)->gres, &(_node)->mcs_label, &(_node)->os,		\
+	&(_node)->reason, &(_node)->tres_fmt_str, &(_node)->version }
+
 extern void slurm_free_job_info(job_info_t * job);
 extern void slurm_free_job_info_members(job_info_t * job);
+extern void slurm_free_job_info_rec_members(job_info_msg_t *msg,
+					    job_info_t *job);
+extern void slurm_job_info_msg_xfer_strs(job_info_msg_t *dst,
+					 job_info_msg_t *src);
 
 extern void slurm_free_batch_script_msg(char *msg);
 extern void slurm_free_job_id_msg(job_id_msg_t * msg);
@@ -1503,6 +1530,8 @@ extern void slurm_free_front_end_info_members(front_end_info_t * front_end);
 extern void slurm_free_node_info_msg(node_info_msg_t * msg);
 extern void slurm_init_node_info_t(node_info_t * msg, bool clear);
 extern void slurm_free_node_info_members(node_info_t * node);
+extern void slurm_node_info_msg_xfer_strs(node_info_msg_t *dst,
+					  node_info_msg_t *src);
 extern void slurm_free_partition_info_msg(partition_info_msg_t * msg);
 extern void slurm_free_partition_info_members(partition_info_t * part);
 extern void slurm_free_reservation_info_msg(reserve_info_msg_t * msg);
@@ -1622,6 +1651,13 @@ extern void print_multi_line_string(char *user_msg, int inx,
  */
 extern char *rpc_num2string(uint16_t opcode);
 
+/*
+ * Return true if messages of msg_type are unpacked into an arena when
+ * received with SLURM_MSG_ARENA. The handlers of these messages must xkeep()
+ * any unpacked memory they keep after the message is freed.
+ */
+extern bool slurm_msg_arena_type(uint16_t msg_type);
+
 /*
  * Given a numeric suffix, return the equivalent multiplier for the numeric
  * portion. For example: "k" returns 1024, "KB" returns 1000, etc.
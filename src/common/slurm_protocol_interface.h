@@ -73,7 +73,9 @@
 
 /* slurm_msg_recvfrom_timeout reads len bytes from file descriptor fd
  * timing out after `timeout' milliseconds.
- *
+ * A compressed message is decompressed if flags has the SLURM_MSG_ACCEPT_*
+ * flag of its type, which this side advertised to the sender, and is
+ * rejected unread otherwise.
  */
 extern ssize_t slurm_msg_recvfrom_timeout(int fd, char **buf,
 		size_t *len, uint32_t flags, int timeout);
@@ -95,6 +97,17 @@ extern ssize_t slurm_msg_sendto_timeout(int open_fd,
 					size_t size,
 					int timeout);
 
+/* slurm_msg_sendto_buf
+ * Send the contents of a buffer, including the segments of one created by
+ * init_seg_buf(), over the given connection, default timeout value
+ * IN open_fd - an open file descriptor
+ * IN buffer - data to transmit
+ * IN compress - MSG_COMPRESS_* type the peer accepts, see msg_compress()
+ * RET number of bytes of buffer written
+ */
+extern ssize_t slurm_msg_sendto_buf(int open_fd, buf_t *buffer,
+				    uint16_t compress);
+
 /********************/
 /* stream functions */
 /********************/
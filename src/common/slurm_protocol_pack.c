@@ -1755,6 +1755,11 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, Buf buffer,
 		safe_xcalloc(tmp_ptr->node_array, tmp_ptr->record_count,
 			     sizeof(node_info_t));
 
+		/* strings repeated across the nodes are sent once */
+		if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+			tmp_ptr->str_dict = str_dict_create();
+			set_buf_str_dict(buffer, tmp_ptr->str_dict);
+		}
 		/* load individual job info */
 		for (i = 0; i < tmp_ptr->record_count; i++) {
 			if (_unpack_node_info_members(&tmp_ptr->node_array[i],
@@ -1762,6 +1767,7 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, Buf buffer,
 						      protocol_version))
 				goto unpack_error;
 		}
+		set_buf_str_dict(buffer, NULL);
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -1770,6 +1776,7 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, Buf buffer,
 	return SLURM_SUCCESS;
 
 unpack_error:
+	set_buf_str_dict(buffer, NULL);
 	slurm_free_node_info_msg(tmp_ptr);
 	*msg = NULL;
 	return SLURM_ERROR;
@@ -1794,7 +1801,7 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 		safe_unpack16(&node->port, buffer);
 		safe_unpack32(&node->next_state, buffer);
 		safe_unpack32(&node->node_state, buffer);
-		safe_unpackstr_xmalloc(&node->version, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&node->version, buffer);
 
 		safe_unpack16(&node->cpus, buffer);
 		safe_unpack16(&node->boards, buffer);
@@ -1805,7 +1812,7 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 		safe_unpack64(&node->real_memory, buffer);
 		safe_unpack32(&node->tmp_disk, buffer);
 
-		safe_unpackstr_xmalloc(&node->mcs_label, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&node->mcs_label, buffer);
 		safe_unpack32(&node->owner, buffer);
 		safe_unpack16(&node->core_spec_cnt, buffer);
 		safe_unpack32(&node->cpu_bind, buffer);
@@ -1827,16 +1834,19 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 		    != SLURM_SUCCESS)
 			goto unpack_error;
 
-		safe_unpackstr_xmalloc(&node->arch, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->features, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->features_act, &uint32_tmp, buffer);
-		if (!node->features_act)
+		safe_unpackstr_dict(&node->arch, buffer);
+		safe_unpackstr_dict(&node->features, buffer);
+		safe_unpackstr_dict(&node->features_act, buffer);
+		if (!node->features_act && buffer->str_dict)
+			node->features_act = str_dict_intern(buffer->str_dict,
+							     node->features);
+		else if (!node->features_act)
 			node->features_act = xstrdup(node->features);
-		safe_unpackstr_xmalloc(&node->gres, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&node->gres, buffer);
 		safe_unpackstr_xmalloc(&node->gres_drain, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&node->gres_used, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->os, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->reason, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&node->os, buffer);
+		safe_unpackstr_dict(&node->reason, buffer);
 		if (acct_gather_energy_unpack(&node->energy, buffer,
 					      protocol_version, 1)
 		    != SLURM_SUCCESS)
@@ -1849,8 +1859,7 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 					   protocol_version) != SLURM_SUCCESS)
 			goto unpack_error;
 
-		safe_unpackstr_xmalloc(&node->tres_fmt_str, &uint32_tmp,
-				       buffer);
+		safe_unpackstr_dict(&node->tres_fmt_str, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&node->name, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&node->node_hostname, &uint32_tmp,
@@ -1924,6 +1933,13 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 	return SLURM_SUCCESS;
 
 unpack_error:
+	/* Strings from the dictionary are freed with it */
+	if (buffer->str_dict) {
+		char **strs[] = NODE_INFO_DICT_STRS(node);
+
+		for (int i = 0; i < ARRAY_SIZE(strs); i++)
+			*strs[i] = NULL;
+	}
 	slurm_free_node_info_members(node);
 	return SLURM_ERROR;
 }
@@ -3505,7 +3521,7 @@ static void
 _pack_buffer_msg(slurm_msg_t * msg, Buf buffer)
 {
 	xassert(msg);
-	packmem_array(msg->data, msg->data_size, buffer);
+	packmem_seg(msg->data, msg->data_size, buffer);
 }
 
 static void _pack_job_script_msg(Buf msg, Buf buffer,
@@ -3550,12 +3566,18 @@ _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 				     sizeof(job_info_t));
 			job = (*msg)->job_array;
 		}
+		/* strings repeated across the jobs are sent once */
+		if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+			(*msg)->str_dict = str_dict_create();
+			set_buf_str_dict(buffer, (*msg)->str_dict);
+		}
 		/* load individual job info */
 		for (i = 0; i < (*msg)->record_count; i++) {
 			if (_unpack_job_info_members(&job[i], buffer,
 						     protocol_version))
 				goto unpack_error;
 		}
+		set_buf_str_dict(buffer, NULL);
 	} else {
 		error("_unpack_job_info_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -3563,6 +3585,31 @@ _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 	}
 	return SLURM_SUCCESS;
 
+unpack_error:
+	set_buf_str_dict(buffer, NULL);
+	slurm_free_job_info_msg(*msg);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
+static int
+_unpack_job_info_delta_msg(job_info_msg_t **msg, Buf buffer,
+			   uint16_t protocol_version)
+{
+	if (_unpack_job_info_msg(msg, buffer, protocol_version))
+		return SLURM_ERROR;
+
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+		safe_unpack16(&((*msg)->delta), buffer);
+		safe_unpack32_array(&((*msg)->purged_job_ids),
+				    &((*msg)->purged_count), buffer);
+	} else {
+		error("_unpack_job_info_delta_msg: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
 unpack_error:
 	slurm_free_job_info_msg(*msg);
 	*msg = NULL;
@@ -3714,24 +3761,24 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 		safe_unpack_time(&job->preempt_time, buffer);
 		safe_unpack32(&job->priority, buffer);
 		safe_unpackdouble(&job->billable_tres, buffer);
-		safe_unpackstr_xmalloc(&job->cluster, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->nodes, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->cluster, buffer);
+		safe_unpackstr_dict(&job->nodes, buffer);
 		safe_unpackstr_xmalloc(&job->sched_nodes, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->partition, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->account, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->partition, buffer);
+		safe_unpackstr_dict(&job->account, buffer);
 		safe_unpackstr_xmalloc(&job->admin_comment, &uint32_tmp,buffer);
 		safe_unpack32(&job->site_factor, buffer);
 		safe_unpackstr_xmalloc(&job->network, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->comment, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->batch_features, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->batch_host, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->batch_host, buffer);
 		safe_unpackstr_xmalloc(&job->burst_buffer, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->burst_buffer_state, &uint32_tmp,
 				       buffer);
 		safe_unpackstr_xmalloc(&job->system_comment,
 				       &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->qos, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->qos, buffer);
 		safe_unpack_time(&job->preemptable_time, buffer);
 		safe_unpackstr_xmalloc(&job->licenses, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->state_desc, &uint32_tmp, buffer);
@@ -3748,12 +3795,12 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 				     &job->gres_detail_cnt, buffer);
 
 		safe_unpackstr_xmalloc(&job->name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->user_name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->wckey, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->user_name, buffer);
+		safe_unpackstr_dict(&job->wckey, buffer);
 		safe_unpack32(&job->req_switch, buffer);
 		safe_unpack32(&job->wait4switch, buffer);
 
-		safe_unpackstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->alloc_node, buffer);
 
 		unpack_bit_str_hex_as_inx(&job->node_inx, buffer);
 
@@ -3816,10 +3863,8 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 			xfree(mc_ptr);
 		}
 		safe_unpack32(&job->bitflags, buffer);
-		safe_unpackstr_xmalloc(&job->tres_alloc_str,
-				       &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->tres_req_str,
-				       &uint32_tmp, buffer);
+		safe_unpackstr_dict(&job->tres_alloc_str, buffer);
+		safe_unpackstr_dict(&job->tres_req_str, buffer);
 		safe_unpack16(&job->start_protocol_ver, buffer);
 
 		safe_unpackstr_xmalloc(&job->fed_origin_str, &uint32_tmp,
@@ -3841,8 +3886,7 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 				       buffer);
 		safe_unpackstr_xmalloc(&job->tres_per_job, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_per_node, &uint32_tmp,
-				       buffer);
+		safe_unpackstr_dict(&job->tres_per_node, buffer);
 		safe_unpackstr_xmalloc(&job->tres_per_socket, &uint32_tmp,
 				       buffer);
 		safe_unpackstr_xmalloc(&job->tres_per_task, &uint32_tmp,
@@ -4040,6 +4084,13 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 	return SLURM_SUCCESS;
 
 unpack_error:
+	/* Strings from the dictionary are freed with it */
+	if (buffer->str_dict) {
+		char **strs[] = JOB_INFO_DICT_STRS(job);
+
+		for (int i = 0; i < ARRAY_SIZE(strs); i++)
+			*strs[i] = NULL;
+	}
 	slurm_free_job_info_members(job);
 	return SLURM_ERROR;
 }
@@ -9358,6 +9409,79 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * REQUEST_SLURMD_MULT_MSG and RESPONSE_SLURMD_MULT_MSG carry a list of complete messages,
+ * each packed with the protocol version of the enclosing message.
+ */
+static void
+_pack_composite_msg(composite_msg_t *msg, Buf buffer,
+		    uint16_t protocol_version)
+{
+	ListIterator itr;
+	slurm_msg_t *sub_msg;
+	uint32_t count = 0;
+
+	xassert(msg);
+
+	if (msg->msg_list)
+		count = list_count(msg->msg_list);
+	pack32(count, buffer);
+	if (!count)
+		return;
+
+	itr = list_iterator_create(msg->msg_list);
+	while ((sub_msg = list_next(itr))) {
+		sub_msg->protocol_version = protocol_version;
+		pack16(sub_msg->msg_type, buffer);
+		pack16(sub_msg->msg_index, buffer);
+		pack_msg(sub_msg, buffer);
+	}
+	list_iterator_destroy(itr);
+}
+
+static int
+_unpack_composite_msg(composite_msg_t **msg, Buf buffer,
+		      uint16_t protocol_version)
+{
+	composite_msg_t *object_ptr;
+	slurm_msg_t *sub_msg;
+	uint32_t count;
+
+	object_ptr = xmalloc(sizeof(composite_msg_t));
+	*msg = object_ptr;
+	object_ptr->msg_list = list_create(slurm_free_comp_msg_list);
+
+	safe_unpack32(&count, buffer);
+	/* every message takes at least its type and index */
+	if (count > (remaining_buf(buffer) / 4))
+		goto unpack_error;
+
+	for (int i = 0; i < count; i++) {
+		sub_msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(sub_msg);
+		sub_msg->protocol_version = protocol_version;
+		list_append(object_ptr->msg_list, sub_msg);
+
+		safe_unpack16(&sub_msg->msg_type, buffer);
+		safe_unpack16(&sub_msg->msg_index, buffer);
+		if ((sub_msg->msg_type == REQUEST_SLURMD_MULT_MSG) ||
+		    (sub_msg->msg_type == RESPONSE_SLURMD_MULT_MSG)) {
+			error("%s: nested %s", __func__,
+			      rpc_num2string(sub_msg->msg_type));
+			goto unpack_error;
+		}
+		if (unpack_msg(sub_msg, buffer) != SLURM_SUCCESS)
+			goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_composite_msg(object_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_batch_job_launch_msg(batch_job_launch_msg_t * msg, Buf buffer,
 			   uint16_t protocol_version)
@@ -10849,7 +10973,7 @@ unpack_multi_core_data (multi_core_data_t **mc_ptr, Buf buffer,
 			uint16_t protocol_version)
 {
 	uint8_t flag;
-	multi_core_data_t *multi_core;
+	multi_core_data_t *multi_core = NULL;
 
 	*mc_ptr = NULL;
 	safe_unpack8(&flag, buffer);
@@ -11294,7 +11418,144 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 	msg = xmalloc ( sizeof (stats_info_response_msg_t) );
 	*msg_ptr = msg ;
 
-	if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->parts_packed,	buffer);
+		if (msg->parts_packed) {
+			safe_unpack_time(&msg->req_time,	buffer);
+			safe_unpack_time(&msg->req_time_start,	buffer);
+			safe_unpack32(&msg->server_thread_count,buffer);
+			safe_unpack32(&msg->agent_queue_size,	buffer);
+			safe_unpack32(&msg->agent_count,	buffer);
+			safe_unpack32(&msg->agent_thread_count,	buffer);
+			safe_unpack32(&msg->dbd_agent_queue_size, buffer);
+			safe_unpack32(&msg->gettimeofday_latency, buffer);
+			safe_unpack32(&msg->jobs_submitted,	buffer);
+			safe_unpack32(&msg->jobs_started,	buffer);
+			safe_unpack32(&msg->jobs_completed,	buffer);
+			safe_unpack32(&msg->jobs_canceled,	buffer);
+			safe_unpack32(&msg->jobs_failed,	buffer);
+
+			safe_unpack32(&msg->jobs_pending,	buffer);
+			safe_unpack32(&msg->jobs_running,	buffer);
+			safe_unpack_time(&msg->job_states_ts,	buffer);
+
+			safe_unpack32(&msg->schedule_cycle_max,	buffer);
+			safe_unpack32(&msg->schedule_cycle_last,buffer);
+			safe_unpack32(&msg->schedule_cycle_sum,	buffer);
+			safe_unpack32(&msg->schedule_cycle_counter, buffer);
+			safe_unpack32(&msg->schedule_cycle_depth, buffer);
+			safe_unpack32(&msg->schedule_queue_len,	buffer);
+
+			safe_unpack32(&msg->bf_backfilled_jobs,	buffer);
+			safe_unpack32(&msg->bf_last_backfilled_jobs, buffer);
+			safe_unpack32(&msg->bf_cycle_counter,	buffer);
+			safe_unpack64(&msg->bf_cycle_sum,	buffer);
+			safe_unpack32(&msg->bf_cycle_last,	buffer);
+			safe_unpack32(&msg->bf_last_depth,	buffer);
+			safe_unpack32(&msg->bf_last_depth_try,	buffer);
+
+			safe_unpack32(&msg->bf_queue_len,	buffer);
+			safe_unpack32(&msg->bf_cycle_max,	buffer);
+			safe_unpack_time(&msg->bf_when_last_cycle, buffer);
+			safe_unpack32(&msg->bf_depth_sum,	buffer);
+			safe_unpack32(&msg->bf_depth_try_sum,	buffer);
+			safe_unpack32(&msg->bf_queue_len_sum,	buffer);
+			safe_unpack32(&msg->bf_table_size,	buffer);
+			safe_unpack32(&msg->bf_table_size_sum,	buffer);
+
+			safe_unpack32(&msg->bf_active,		buffer);
+			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			safe_unpack32(&msg->job_info_cache_hits, buffer);
+			safe_unpack32(&msg->job_info_cache_misses, buffer);
+			safe_unpack32(&msg->node_info_cache_hits, buffer);
+			safe_unpack32(&msg->node_info_cache_misses, buffer);
+
+			safe_unpack32_array(&msg->bf_eval_jobs,
+					    &msg->bf_eval_thread_cnt, buffer);
+			safe_unpack64_array(&msg->bf_eval_time, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->bf_eval_thread_cnt)
+				goto unpack_error;
+			safe_unpack32(&msg->bf_eval_skipped,	buffer);
+		}
+
+		safe_unpack32(&msg->rpc_type_size,		buffer);
+		safe_unpack16_array(&msg->rpc_type_id,   &uint32_tmp, buffer);
+		safe_unpack32_array(&msg->rpc_type_cnt,  &uint32_tmp, buffer);
+		safe_unpack64_array(&msg->rpc_type_time, &uint32_tmp, buffer);
+
+		safe_unpack32(&msg->rpc_user_size,		buffer);
+		safe_unpack32_array(&msg->rpc_user_id,   &uint32_tmp, buffer);
+		safe_unpack32_array(&msg->rpc_user_cnt,  &uint32_tmp, buffer);
+		safe_unpack64_array(&msg->rpc_user_time, &uint32_tmp, buffer);
+
+		safe_unpack32_array(&msg->rpc_queue_type_id,
+				    &msg->rpc_queue_type_count,
+				    buffer);
+		safe_unpack32_array(&msg->rpc_queue_count,
+				    &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_queue_type_count)
+			goto unpack_error;
+
+		safe_unpack32_array(&msg->rpc_dump_types,
+				    &msg->rpc_dump_count,
+				    buffer);
+		safe_unpackstr_array(&msg->rpc_dump_hostlist,
+				     &uint32_tmp,
+				     buffer);
+		if (uint32_tmp != msg->rpc_dump_count)
+			goto unpack_error;
+
+		safe_unpack16_array(&msg->rpc_pool_type_id,
+				    &msg->rpc_pool_size, buffer);
+		safe_unpack32_array(&msg->rpc_pool_threads, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_pool_depth, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_pool_depth_max, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_pool_cnt, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_pool_batch_cnt, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+		safe_unpack64_array(&msg->rpc_pool_wait_time, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_pool_size)
+			goto unpack_error;
+
+		safe_unpack32_array(&msg->rpc_user_rejected, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_user_size)
+			goto unpack_error;
+
+		safe_unpack32(&msg->msg_compress_cnt, buffer);
+		safe_unpack64(&msg->msg_compress_raw_bytes, buffer);
+		safe_unpack64(&msg->msg_compress_wire_bytes, buffer);
+		safe_unpack64(&msg->msg_compress_time, buffer);
+		safe_unpack32(&msg->msg_decompress_cnt, buffer);
+		safe_unpack64(&msg->msg_decompress_raw_bytes, buffer);
+		safe_unpack64(&msg->msg_decompress_wire_bytes, buffer);
+		safe_unpack64(&msg->msg_decompress_time, buffer);
+
+		safe_unpack64(&msg->list_node_alloc_cnt, buffer);
+		safe_unpack64(&msg->list_node_malloc_cnt, buffer);
+		safe_unpack64(&msg->list_node_free_cnt, buffer);
+		safe_unpack64(&msg->list_node_depot_cnt, buffer);
+		safe_unpack32(&msg->list_node_cached_cnt, buffer);
+		safe_unpack64(&msg->list_itr_alloc_cnt, buffer);
+		safe_unpack64(&msg->list_itr_malloc_cnt, buffer);
+		safe_unpack64(&msg->list_itr_free_cnt, buffer);
+		safe_unpack64(&msg->list_itr_depot_cnt, buffer);
+		safe_unpack32(&msg->list_itr_cached_cnt, buffer);
+	} else if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->parts_packed,	buffer);
 		if (msg->parts_packed) {
 			safe_unpack_time(&msg->req_time,	buffer);
@@ -11989,6 +12250,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					 msg->protocol_version);
 		break;
 	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_INFO_DELTA:
 		_pack_job_info_msg((slurm_msg_t *) msg, buffer);
 		break;
 	case RESPONSE_BATCH_SCRIPT:
@@ -12275,6 +12537,11 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		_pack_prolog_launch_msg((prolog_launch_msg_t *)
 					msg->data, buffer, msg->protocol_version);
 		break;
+	case REQUEST_SLURMD_MULT_MSG:
+	case RESPONSE_SLURMD_MULT_MSG:
+		_pack_composite_msg((composite_msg_t *) msg->data, buffer,
+				    msg->protocol_version);
+		break;
 	case RESPONSE_PROLOG_EXECUTING:
 	case RESPONSE_JOB_READY:
 	case RESPONSE_SLURM_RC:
@@ -12623,6 +12890,11 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					  buffer,
 					  msg->protocol_version);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		rc = _unpack_job_info_delta_msg((job_info_msg_t **)
+						&(msg->data), buffer,
+						msg->protocol_version);
+		break;
 	case RESPONSE_BATCH_SCRIPT:
 		rc = _unpack_job_script_msg((char **) &(msg->data),
 					    buffer,
@@ -12930,6 +13202,11 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					       & (msg->data),
 					       buffer, msg->protocol_version);
 		break;
+	case REQUEST_SLURMD_MULT_MSG:
+	case RESPONSE_SLURMD_MULT_MSG:
+		rc = _unpack_composite_msg((composite_msg_t **) &(msg->data),
+					   buffer, msg->protocol_version);
+		break;
 	case RESPONSE_PROLOG_EXECUTING:
 	case RESPONSE_JOB_READY:
 	case RESPONSE_SLURM_RC:
@@ -51,6 +51,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "slurm/slurm_errno.h"
@@ -60,6 +61,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/log.h"
 #include "src/common/fd.h"
+#include "src/common/msg_compress.h"
 #include "src/common/strlcpy.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
@@ -134,6 +136,7 @@ extern ssize_t slurm_msg_recvfrom_timeout(int fd, char **pbuf, size_t *lenp,
 {
 	ssize_t  len;
 	uint32_t msglen;
+	bool compressed;
 
 	len = slurm_recv_timeout( fd, (char *)&msglen,
 				  sizeof(msglen), 0, tmout );
@@ -143,9 +146,19 @@ extern ssize_t slurm_msg_recvfrom_timeout(int fd, char **pbuf, size_t *lenp,
 
 	msglen = ntohl(msglen);
 
+	compressed = (msglen & MSG_COMPRESS_FLAG);
+	msglen &= ~MSG_COMPRESS_FLAG;
+
 	if (msglen > MAX_MSG_SIZE)
 		slurm_seterrno_ret(SLURM_PROTOCOL_INSANE_MSG_LENGTH);
 
+	/* Only responses to requests advertising it may be compressed */
+	if (compressed &&
+	    !(flags & (SLURM_MSG_ACCEPT_LZ4 | SLURM_MSG_ACCEPT_ZLIB))) {
+		error("%s: unexpected compressed message", __func__);
+		slurm_seterrno_ret(SLURM_COMMUNICATIONS_RECEIVE_ERROR);
+	}
+
 	/*
 	 *  Allocate memory on heap for message
 	 */
@@ -157,6 +170,13 @@ extern ssize_t slurm_msg_recvfrom_timeout(int fd, char **pbuf, size_t *lenp,
 		return SLURM_ERROR;
 	}
 
+	if (compressed) {
+		int rc = msg_decompress(pbuf, &msglen, flags, MAX_MSG_SIZE);
+
+		if (rc)
+			slurm_seterrno_ret(rc);
+	}
+
 	*lenp = msglen;
 
 	return (ssize_t) msglen;
@@ -197,10 +217,12 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer,
 	return len;
 }
 
-/* Send slurm message with timeout
- * RET message size (as specified in argument) or SLURM_ERROR on error */
-extern int slurm_send_timeout(int fd, char *buf, size_t size,
-			      uint32_t flags, int timeout)
+/*
+ * Send a message made of iovcnt pieces, see slurm_send_timeout().
+ * iov is modified.
+ */
+static int _send_iov_timeout(int fd, struct iovec *iov, int iovcnt,
+			     size_t size, uint32_t flags, int timeout)
 {
 	int rc;
 	int sent = 0;
@@ -209,6 +231,7 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 	struct timeval tstart;
 	int timeleft = timeout;
 	char temp[2];
+	struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
 
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
@@ -266,7 +289,7 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = send(fd, &buf[sent], (size - sent), flags);
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -290,6 +313,18 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+
+		/* Skip the pieces sent, and the sent part of the next one */
+		while (msg.msg_iovlen && (rc >= msg.msg_iov->iov_len)) {
+			rc -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+		if (rc) {
+			msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base +
+						rc;
+			msg.msg_iov->iov_len -= rc;
+		}
 	}
 
     done:
@@ -305,6 +340,78 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 
 }
 
+/*
+ * Send the contents of buffer, including its segments, preceded by their
+ * length as slurm_msg_sendto() does, with a single writev() where possible.
+ * If compress is set and the message compresses, the compressed message is
+ * sent instead, flagged in its length.
+ * RET bytes of buffer sent, or SLURM_ERROR on error
+ */
+extern ssize_t slurm_msg_sendto_buf(int fd, buf_t *buffer, uint16_t compress)
+{
+	int len, iovcnt = 0;
+	uint32_t usize, offset = 0, size = get_buf_len(buffer);
+	struct iovec *iov;
+	SigFunc *ohandler;
+	buf_t *compressed = NULL;
+
+	if (compress && (compressed = msg_compress(buffer, compress)))
+		buffer = compressed;
+
+	iov = xcalloc((2 * buffer->seg_cnt) + 2, sizeof(*iov));
+	if (compressed)
+		usize = htonl(get_buf_len(buffer) | MSG_COMPRESS_FLAG);
+	else
+		usize = htonl(get_buf_len(buffer));
+	iov[iovcnt].iov_base = &usize;
+	iov[iovcnt++].iov_len = sizeof(usize);
+	for (int i = 0; i < buffer->seg_cnt; i++) {
+		buf_seg_t *seg = &buffer->segs[i];
+
+		xassert(seg->offset >= offset);
+		xassert(seg->offset <= get_buf_offset(buffer));
+		if (seg->offset > offset) {
+			iov[iovcnt].iov_base = get_buf_data(buffer) + offset;
+			iov[iovcnt++].iov_len = seg->offset - offset;
+			offset = seg->offset;
+		}
+		iov[iovcnt].iov_base = seg->data;
+		iov[iovcnt++].iov_len = seg->size;
+	}
+	if (get_buf_offset(buffer) > offset) {
+		iov[iovcnt].iov_base = get_buf_data(buffer) + offset;
+		iov[iovcnt++].iov_len = get_buf_offset(buffer) - offset;
+	}
+
+	/*
+	 *  Ignore SIGPIPE so that send can return a error code if the
+	 *    other side closes the socket
+	 */
+	ohandler = xsignal(SIGPIPE, SIG_IGN);
+
+	len = _send_iov_timeout(fd, iov, iovcnt,
+				sizeof(usize) + get_buf_len(buffer), 0,
+				(slurm_conf.msg_timeout * 1000));
+	if (len >= 0)
+		len = size;
+
+	xsignal(SIGPIPE, ohandler);
+	xfree(iov);
+	FREE_NULL_BUFFER(compressed);
+
+	return len;
+}
+
+/* Send slurm message with timeout
+ * RET message size (as specified in argument) or SLURM_ERROR on error */
+extern int slurm_send_timeout(int fd, char *buf, size_t size,
+			      uint32_t flags, int timeout)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = size };
+
+	return _send_iov_timeout(fd, &iov, 1, size, flags, timeout);
+}
+
 /* Get slurm message with timeout
  * RET message size (as specified in argument) or SLURM_ERROR on error */
 extern int slurm_recv_timeout(int fd, char *buffer, size_t size,
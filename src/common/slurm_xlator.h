@@ -240,7 +240,9 @@
 #define	free_buf		slurm_free_buf
 #define grow_buf		slurm_grow_buf
 #define	init_buf		slurm_init_buf
+#define	init_seg_buf		slurm_init_seg_buf
 #define	xfer_buf_data		slurm_xfer_buf_data
+#define	flatten_buf		slurm_flatten_buf
 #define	pack_time		slurm_pack_time
 #define	unpack_time		slurm_unpack_time
 #define	packdouble		slurm_packdouble
@@ -267,6 +269,7 @@
 #define	packstr_array		slurm_packstr_array
 #define	unpackstr_array		slurm_unpackstr_array
 #define	packmem_array		slurm_packmem_array
+#define	packmem_seg		slurm_packmem_seg
 #define	unpackmem_array		slurm_unpackmem_array
 
 /* parse_time.[ch] functions */
@@ -57,6 +57,26 @@ strong_alias(xfree_ptr, slurm_xfree_ptr);
 strong_alias(xsize, slurm_xsize);
 
 #define XMALLOC_MAGIC 0x42
+#define XMALLOC_ARENA_MAGIC 0x43	/* from xarena_alloc() */
+
+/* Size of the first chunk of an arena, doubled for each new one up to max */
+#define XARENA_CHUNK_SIZE (32 * 1024)
+#define XARENA_CHUNK_MAX (1024 * 1024)
+/* Alignment of the blocks handed out, as malloc() gives */
+#define XARENA_ALIGN(_sz) (((_sz) + 15) & ~((size_t) 15))
+
+typedef struct xarena_chunk {
+	struct xarena_chunk *next;
+	size_t size;		/* bytes usable after the header */
+	size_t used;
+} xarena_chunk_t;
+
+#define XARENA_CHUNK_HDR XARENA_ALIGN(sizeof(xarena_chunk_t))
+
+struct xarena {
+	xarena_chunk_t *chunks;	/* chunk allocated from first */
+	size_t next_size;	/* size of the next chunk */
+};
 
 /*
  * "Safe" version of malloc().
@@ -146,7 +166,19 @@ extern void * slurm_xrecalloc(void **item, size_t count, size_t size,
 	count_size = count * size;
 	total_size = count_size + 2 * sizeof(size_t);
 
-	if (*item != NULL) {
+	if ((*item != NULL) &&
+	    (((size_t *)*item - 2)[0] == XMALLOC_ARENA_MAGIC)) {
+		/* Arena memory cannot grow, move it to the heap */
+		size_t old_size = ((size_t *)*item - 2)[1];
+		void *new = slurm_xcalloc(1, count_size, clear, try, file, line,
+					  func);
+
+		if (!new)
+			return NULL;
+		memcpy(new, *item, MIN(old_size, count_size));
+		*item = new;
+		return new;
+	} else if (*item != NULL) {
 		size_t old_size;
 		p = (size_t *)*item - 2;
 
@@ -194,7 +226,8 @@ size_t xsize(void *item)
 {
 	size_t *p = (size_t *)item - 2;
 	xassert(item != NULL);
-	xassert(p[0] == XMALLOC_MAGIC); /* CLANG false positive here */
+	xassert((p[0] == XMALLOC_MAGIC) || /* CLANG false positive here */
+		(p[0] == XMALLOC_ARENA_MAGIC));
 	return p[1];
 }
 
@@ -207,11 +240,14 @@ void slurm_xfree(void **item)
 {
 	if (*item != NULL) {
 		size_t *p = (size_t *)*item - 2;
+		*item = NULL;
+		/* released with its arena */
+		if (p[0] == XMALLOC_ARENA_MAGIC)
+			return;
 		/* magic cookie still there? */
 		xassert(p[0] == XMALLOC_MAGIC);
 		p[0] = 0;	/* make sure xfree isn't called twice */
 		free(p);
-		*item = NULL;
 	}
 }
 
@@ -224,3 +260,126 @@ void xfree_ptr(void *ptr)
 {
 	slurm_xfree(&ptr);
 }
+
+static xarena_chunk_t *_xarena_chunk_create(size_t size, const char *file,
+					    int line, const char *func)
+{
+	xarena_chunk_t *chunk = malloc(XARENA_CHUNK_HDR + size);
+
+	if (!chunk) {
+		log_oom(file, line, func);
+		abort();
+	}
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+/*
+ * Create an arena, which is kept in its first chunk.
+ */
+xarena_t *xarena_create(void)
+{
+	xarena_chunk_t *chunk = _xarena_chunk_create(XARENA_CHUNK_SIZE,
+						     __FILE__, __LINE__,
+						     __func__);
+	xarena_t *arena = (xarena_t *) ((char *) chunk + XARENA_CHUNK_HDR);
+
+	chunk->used = XARENA_ALIGN(sizeof(*arena));
+	arena->chunks = chunk;
+	arena->next_size = XARENA_CHUNK_SIZE * 2;
+
+	return arena;
+}
+
+/*
+ * Release all the memory allocated from arena, and arena itself.
+ */
+void xarena_destroy(xarena_t *arena)
+{
+	xarena_chunk_t *chunk, *next;
+
+	if (!arena)
+		return;
+
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+}
+
+/*
+ * Allocate zeroed memory from an arena, with the header of xmalloc().
+ *   arena (IN)	arena from xarena_create()
+ *   size (IN)	number of bytes to allocate
+ *   RETURN	pointer to the memory, valid until xarena_destroy()
+ */
+void *slurm_xarena_alloc(xarena_t *arena, size_t size, const char *file,
+			 int line, const char *func)
+{
+	xarena_chunk_t *chunk = arena->chunks;
+	size_t total_size;
+	size_t *p;
+
+	if (!size)
+		return NULL;
+
+	/* See slurm_xcalloc() */
+	if (size > SIZE_MAX / 4) {
+		log_oom(file, line, func);
+		abort();
+	}
+
+	total_size = XARENA_ALIGN(size + 2 * sizeof(size_t));
+	if (total_size > (chunk->size - chunk->used)) {
+		if (total_size > (XARENA_CHUNK_MAX / 4)) {
+			/*
+			 * A large block gets a chunk of its own, put after the
+			 * current one to keep allocating from that.
+			 */
+			chunk = _xarena_chunk_create(total_size, file, line,
+						     func);
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		} else {
+			chunk = _xarena_chunk_create(arena->next_size, file,
+						     line, func);
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+			arena->next_size = MIN(arena->next_size * 2,
+					       XARENA_CHUNK_MAX);
+		}
+	}
+
+	p = (size_t *) ((char *) chunk + XARENA_CHUNK_HDR + chunk->used);
+	chunk->used += total_size;
+	p[0] = XMALLOC_ARENA_MAGIC;
+	p[1] = size;
+	memset(&p[2], 0, size);
+
+	return &p[2];
+}
+
+/*
+ * Move memory allocated from an arena to the heap, so that it outlives the
+ * arena. Memory from xmalloc() is left alone.
+ *   item (IN/OUT)	double-pointer to allocated space
+ */
+void slurm_xkeep(void **item, const char *file, int line, const char *func)
+{
+	size_t *p;
+	void *new;
+
+	if (!*item)
+		return;
+
+	p = (size_t *)*item - 2;
+	if (p[0] != XMALLOC_ARENA_MAGIC)
+		return;
+
+	new = slurm_xcalloc(1, p[1], false, false, file, line, func);
+	memcpy(new, *item, p[1]);
+	*item = new;
+}
@@ -63,6 +63,13 @@
  * p. The memory must have been allocated with [try_]xmalloc() or
  * [try_]xrealloc().
  *
+ * xarena_alloc(arena, size) allocates size zeroed bytes from an arena made
+ * by xarena_create(). All the memory of an arena is released at once by
+ * xarena_destroy(). Until then the memory can be used as if it came from
+ * xmalloc(): xfree() does nothing on it, and xrealloc() moves it to the
+ * heap. xkeep(p) also moves p to the heap if it came from an arena, which
+ * must be done for memory kept after the arena is destroyed.
+ *
 \*****************************************************************************/
 
 #ifndef _XMALLOC_H
@@ -103,6 +110,13 @@
 #define xrealloc_nz(__p, __sz) \
         slurm_xrecalloc((void **)&(__p), 1, __sz, false, false, __FILE__, __LINE__, __func__)
 
+#define xarena_alloc(__a, __sz) \
+	slurm_xarena_alloc(__a, __sz, __FILE__, __LINE__, __func__)
+
+#define xkeep(__p) slurm_xkeep((void **)&(__p), __FILE__, __LINE__, __func__)
+
+typedef struct xarena xarena_t;
+
 void *slurm_xcalloc(size_t, size_t, bool, bool, const char *, int, const char *);
 void slurm_xfree(void **);
 void *slurm_xrecalloc(void **, size_t, size_t, bool, bool, const char *, int, const char *);
@@ -111,4 +125,9 @@ size_t xsize(void *item);
 
 void xfree_ptr(void *);
 
+xarena_t *xarena_create(void);
+void xarena_destroy(xarena_t *arena);
+void *slurm_xarena_alloc(xarena_t *, size_t, const char *, int, const char *);
+void slurm_xkeep(void **, const char *, int, const char *);
+
 #endif /* !_XMALLOC_H */
@@ -2044,7 +2044,7 @@ static void *_start_stage_out(void *x)
 		} else {
 			job_ptr->job_state &= (~JOB_STAGE_OUT);
 			xfree(job_ptr->state_desc);
-			last_job_update = time(NULL);
+			job_info_changed(job_ptr, time(NULL));
 		}
 		slurm_mutex_lock(&bb_state.bb_mutex);
 		bb_job = _get_bb_job(job_ptr);
@@ -4116,7 +4116,7 @@ fini:
 /* Kill job from CONFIGURING state */
 static void _kill_job(job_record_t *job_ptr, bool hold_job)
 {
-	last_job_update = time(NULL);
+	job_info_changed(job_ptr, time(NULL));
 	job_ptr->end_time = last_job_update;
 	if (hold_job)
 		job_ptr->priority = 0;
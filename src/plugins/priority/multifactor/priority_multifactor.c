@@ -2023,7 +2023,7 @@ extern int decay_apply_weighted_factors(job_record_t *job_ptr,
 	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
 	    (job_ptr->priority < new_prio)) {
 		job_ptr->priority = new_prio;
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 	}
 
 	debug2("priority for job %u is now %u",
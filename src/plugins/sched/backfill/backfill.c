@@ -69,6 +69,7 @@
 
 #include "src/common/assoc_mgr.h"
 #include "src/common/gres.h"
+#include "src/common/id_hash.h"
 #include "src/common/list.h"
 #include "src/common/macros.h"
 #include "src/common/node_features.h"
@@ -95,11 +96,15 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 #include "backfill.h"
+#include "node_space.h"
 
 #define BACKFILL_INTERVAL	30
 #define BACKFILL_RESOLUTION	60
 #define BACKFILL_WINDOW		(24 * 60 * 60)
 #define BF_MAX_JOB_ARRAY_RESV	20
+#define BF_EVAL_BATCH		16	/* jobs per evaluation thread and batch */
+#define BF_PLAN_DIGEST_INIT	0xcbf29ce484222325ULL /* FNV-1a 64 basis */
+#define BF_PLAN_MAX_AGE		300	/* Rebuild bf_incremental plan this often */
 
 #define SLURMCTLD_THREAD_LIMIT	5
 #define YIELD_INTERVAL		2000000	/* time in micro-seconds */
@@ -124,13 +129,6 @@
 #define MAX_BF_MAX_JOB_USER_PART       MAX_BF_MAX_JOB_TEST
 #define MAX_BF_MAX_JOB_PART            MAX_BF_MAX_JOB_TEST
 
-typedef struct node_space_map {
-	time_t begin_time;
-	time_t end_time;
-	bitstr_t *avail_bitmap;
-	int next;	/* next record, by time, zero termination */
-} node_space_map_t;
-
 typedef struct node_space_handler {
 	node_space_map_t *node_space;
 	int *node_space_recs;
@@ -165,6 +163,71 @@ typedef struct deadlock_part_struct {
 	part_record_t *part_ptr;
 } deadlock_part_struct_t;
 
+/*
+ * Earliest time slot of the node_space table in which a pending job may fit,
+ * determined by the bf_threads evaluation threads
+ */
+typedef struct bf_eval_rec {
+	job_record_t *job_ptr;
+	part_record_t *part_ptr;
+	uint32_t min_nodes;	/* Lower bound of job's node count */
+	uint32_t time_limit;	/* Lower bound of job's time limit, minutes */
+	bool skip;		/* OUT: Job can not fit in backfill window */
+	time_t start_time;	/* OUT: Earliest possible start time, zero if
+				 * it might fit in the first time slot */
+} bf_eval_rec_t;
+
+/*
+ * Result of testing one (job, partition) pair in a backfill cycle. With
+ * bf_incremental these are kept in queue order so that the next cycle can
+ * reuse a result rather than test the job again, as long as neither the job
+ * nor the resources it could use have changed.
+ */
+typedef struct bf_plan_rec {
+	uint32_t job_id;
+	uint32_t array_task_id;
+	part_record_t *part_ptr;	/* compared only, never dereferenced */
+	uint64_t digest;		/* hash of the job's test inputs */
+	bool cacheable;			/* result may be reused */
+	bool tested;			/* start time and nodes were found */
+	bool reserved;			/* node_space reservation was added */
+	bool used;			/* matched by the following cycle */
+	uint32_t boot_time;
+	time_t test_start;		/* start time found by the test */
+	bitstr_t *test_bitmap;		/* nodes found by the test */
+	uint32_t resv_start;		/* node_space reservation */
+	uint32_t resv_end;
+	time_t start_time;		/* job's start_time once done */
+	struct bf_plan_rec *key_next;	/* next record with same hash key */
+} bf_plan_rec_t;
+
+typedef struct bf_plan_run {
+	uint32_t job_id;
+	time_t end_time;
+} bf_plan_run_t;
+
+typedef struct bf_plan {
+	bf_plan_rec_t *recs;		/* tested jobs in queue order */
+	uint32_t rec_cnt;
+	uint32_t rec_size;
+	bf_plan_run_t *runs;		/* running jobs, sorted by job_id */
+	uint32_t run_cnt;
+	uint32_t run_size;
+	bitstr_t *avail_bitmap;		/* nodes available to node_space */
+	bitstr_t *up_bitmap;
+	time_t build_time;		/* when the plan was last rebuilt */
+	time_t conf_update;		/* slurm_conf.last_update */
+	time_t part_update;		/* last_part_update */
+	time_t resv_update;		/* last_resv_update */
+} bf_plan_t;
+
+/* Resources in use which were free when the previous plan was made */
+typedef struct bf_plan_busy {
+	bitstr_t *node_bitmap;
+	time_t start_time;
+	time_t end_time;
+} bf_plan_busy_t;
+
 /* Diagnostic  statistics */
 extern diag_stats_t slurmctld_diag_stats;
 uint32_t bf_sleep_usec = 0;
@@ -189,10 +252,13 @@ static int bf_job_part_count_reserve = 0;
 static int bf_max_job_array_resv = BF_MAX_JOB_ARRAY_RESV;
 static int bf_min_age_reserve = 0;
 static bool bf_running_job_reserve = false;
+static int bf_threads = 0;
+static bool bf_incremental = false;
 static uint32_t bf_min_prio_reserve = 0;
 static List deadlock_global_list;
 static bool bf_hetjob_immediate = false;
 static uint16_t bf_hetjob_prio = 0;
+static job_queue_order_t *bf_queue_order = NULL;
 static bool bf_one_resv_per_job = false;
 static uint32_t job_start_cnt = 0;
 static int max_backfill_job_cnt = 100;
@@ -209,6 +275,35 @@ static int yield_sleep   = YIELD_SLEEP;
 static List het_job_list = NULL;
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
 
+/* bf_threads evaluation thread pool and its current batch of jobs */
+static pthread_mutex_t bf_eval_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  bf_eval_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  bf_eval_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *bf_eval_tids = NULL;
+static int bf_eval_thread_cnt = 0;
+static bool bf_eval_shutdown = false;
+static node_space_map_t *bf_eval_node_space = NULL;
+static bf_eval_rec_t *bf_eval_recs = NULL;
+static int bf_eval_batch_size = 0;	/* Records in next batch */
+static uint32_t bf_eval_gen = 0;	/* bf_table_gen of current batch */
+static uint32_t bf_table_gen = 0;	/* Incremented on node_space change */
+static int bf_eval_rec_cnt = 0;		/* Records in current batch */
+static int bf_eval_next = 0;		/* Next record to evaluate */
+static int bf_eval_done = 0;		/* Count of records evaluated */
+static int bf_eval_pos = 0;		/* Last record used by backfill */
+
+/* bf_incremental plans of the previous and of the current backfill cycle */
+static bf_plan_t *bf_plan_prev = NULL;
+static bf_plan_t *bf_plan = NULL;
+static bool bf_plan_reuse = false;	/* bf_plan_prev records may be reused */
+static id_hash_t *bf_plan_hash = NULL;	/* bf_plan_prev records by key */
+static uint32_t bf_plan_pos = 0;	/* Next bf_plan_prev record in order */
+static bitstr_t *bf_plan_free_bitmap = NULL; /* Nodes freed since then */
+static List bf_plan_busy_list = NULL;	/* bf_plan_busy_t, used since then */
+static int bf_plan_inx = -1;		/* bf_plan record of tested job */
+static bf_plan_rec_t *bf_plan_match = NULL; /* Its bf_plan_prev record */
+static uint32_t bf_plan_reused = 0;	/* Results reused in this cycle */
+
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     bitstr_t *res_bitmap,
@@ -216,6 +311,26 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     int *node_space_recs);
 static void _adjust_hetjob_prio(uint32_t *prio, uint32_t val);
 static int  _attempt_backfill(void);
+static void _bf_eval_batch(job_record_t *job_ptr, part_record_t *part_ptr,
+			   List job_queue, node_space_map_t *node_space);
+static void _bf_eval_fini(void);
+static bf_eval_rec_t *_bf_eval_get(job_record_t *job_ptr,
+				   part_record_t *part_ptr, List job_queue,
+				   node_space_map_t *node_space);
+static void _bf_eval_init(void);
+static void _bf_eval_reset(void);
+static void _bf_plan_begin(bitstr_t *avail_bitmap, time_t now);
+static void _bf_plan_done(job_record_t *job_ptr);
+static void _bf_plan_end(void);
+static void _bf_plan_free(bf_plan_t **plan_pptr);
+static void _bf_plan_nocache(void);
+static void _bf_plan_reserved(uint32_t start_time, uint32_t end_reserve);
+static bf_plan_rec_t *_bf_plan_start(job_record_t *job_ptr,
+				     part_record_t *part_ptr,
+				     uint32_t *vals, int val_cnt, time_t now);
+static void _bf_plan_stop(void);
+static void _bf_plan_tested(job_record_t *job_ptr, bitstr_t *avail_bitmap,
+			    uint32_t boot_time);
 static int  _clear_job_estimates(void *x, void *arg);
 static int  _clear_qos_blocked_times(void *x, void *arg);
 static void _do_diag_stats(struct timeval *tv1, struct timeval *tv2,
@@ -940,6 +1055,22 @@ static void _load_config(void)
 	else
 		bf_running_job_reserve = false;
 
+	if (xstrcasestr(sched_params, "bf_incremental"))
+		bf_incremental = true;
+	else
+		bf_incremental = false;
+
+	if ((tmp_ptr = xstrcasestr(sched_params, "bf_threads="))) {
+		bf_threads = atoi(tmp_ptr + 11);
+		if ((bf_threads < 0) || (bf_threads > MAX_BF_THREADS)) {
+			error("Invalid SchedulerParameters bf_threads: %d",
+			      bf_threads);
+			bf_threads = 0;
+		}
+	} else {
+		bf_threads = 0;
+	}
+
 	if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_cnt=")))
 		max_rpc_cnt = atoi(tmp_ptr + 12);
 	else if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_count=")))
@@ -994,6 +1125,733 @@ static void _do_diag_stats(struct timeval *tv1, struct timeval *tv2,
 	slurmctld_diag_stats.bf_table_size_sum += node_space_recs;
 }
 
+/* Return true if the bitmap has enough nodes to satisfy the job */
+static bool _bf_eval_fit(bf_eval_rec_t *rec, bitstr_t *node_bitmap)
+{
+	bitstr_t *req_node_bitmap = rec->job_ptr->details->req_node_bitmap;
+
+	if (bit_set_count(node_bitmap) < rec->min_nodes)
+		return false;
+	if (req_node_bitmap && !bit_super_set(req_node_bitmap, node_bitmap))
+		return false;
+	return true;
+}
+
+/*
+ * Find the first time slot in the node_space table where the job might fit.
+ * Only node counts are considered and the tested nodes are a superset of those
+ * _attempt_backfill() will use, so the job can not start in any earlier slot.
+ * Adding more reservations to the table can only delay that further.
+ */
+static void _bf_eval_job(bf_eval_rec_t *rec, node_space_map_t *node_space)
+{
+	job_record_t *job_ptr = rec->job_ptr;
+	bitstr_t *base_bitmap, *tmp_bitmap;
+	time_t end_time;
+	int j;
+
+	rec->skip = false;
+	rec->start_time = 0;
+	if (!job_ptr->details || !rec->part_ptr->node_bitmap)
+		return;
+
+	base_bitmap = bit_copy(rec->part_ptr->node_bitmap);
+	bit_and(base_bitmap, up_node_bitmap);
+	bit_and_not(base_bitmap, bf_ignore_node_bitmap);
+	if (job_ptr->details->exc_node_bitmap)
+		bit_and_not(base_bitmap, job_ptr->details->exc_node_bitmap);
+	if (!_bf_eval_fit(rec, base_bitmap)) {
+		rec->skip = true;
+		FREE_NULL_BITMAP(base_bitmap);
+		return;
+	}
+
+	tmp_bitmap = bit_alloc(bit_size(base_bitmap));
+	for (j = 0; ; j = node_space[j].next) {
+		end_time = node_space[j].begin_time + (rec->time_limit * 60);
+		bit_copybits(tmp_bitmap, base_bitmap);
+		node_space_and(node_space, node_space[j].begin_time, end_time,
+			       tmp_bitmap);
+		if (_bf_eval_fit(rec, tmp_bitmap)) {
+			if (j != 0)
+				rec->start_time = node_space[j].begin_time;
+			break;
+		}
+		if (node_space[j].next == 0) {
+			rec->skip = true;
+			break;
+		}
+	}
+	FREE_NULL_BITMAP(base_bitmap);
+	FREE_NULL_BITMAP(tmp_bitmap);
+}
+
+/* bf_threads evaluation thread, evaluates jobs of the current batch */
+static void *_bf_eval_thread(void *arg)
+{
+	int inx = *(int *) arg;
+	bf_eval_rec_t *rec;
+	struct timeval tv;
+
+	xfree(arg);
+	slurm_mutex_lock(&bf_eval_mutex);
+	while (!bf_eval_shutdown) {
+		if (bf_eval_next >= bf_eval_rec_cnt) {
+			slurm_cond_wait(&bf_eval_cond, &bf_eval_mutex);
+			continue;
+		}
+		rec = &bf_eval_recs[bf_eval_next++];
+		slurm_mutex_unlock(&bf_eval_mutex);
+
+		gettimeofday(&tv, NULL);
+		_bf_eval_job(rec, bf_eval_node_space);
+		slurmctld_diag_stats.bf_eval_time[inx] += slurm_delta_tv(&tv);
+		slurmctld_diag_stats.bf_eval_jobs[inx]++;
+
+		slurm_mutex_lock(&bf_eval_mutex);
+		if (++bf_eval_done == bf_eval_rec_cnt)
+			slurm_cond_signal(&bf_eval_done_cond);
+	}
+	slurm_mutex_unlock(&bf_eval_mutex);
+
+	return NULL;
+}
+
+/* Start or resize the evaluation thread pool to match bf_threads */
+static void _bf_eval_init(void)
+{
+	int i, *inx;
+
+	if (bf_eval_thread_cnt == bf_threads)
+		return;
+
+	_bf_eval_fini();
+	slurmctld_diag_stats.bf_eval_thread_cnt = bf_threads;
+	if (!bf_threads)
+		return;
+
+	bf_eval_recs = xcalloc(bf_threads * BF_EVAL_BATCH,
+			       sizeof(bf_eval_rec_t));
+	bf_eval_batch_size = bf_threads;
+	bf_eval_tids = xcalloc(bf_threads, sizeof(pthread_t));
+	for (i = 0; i < bf_threads; i++) {
+		inx = xmalloc(sizeof(int));
+		*inx = i;
+		slurm_thread_create(&bf_eval_tids[i], _bf_eval_thread, inx);
+	}
+	bf_eval_thread_cnt = bf_threads;
+	debug("started %d evaluation threads", bf_eval_thread_cnt);
+}
+
+/* Terminate the evaluation thread pool */
+static void _bf_eval_fini(void)
+{
+	int i;
+
+	if (!bf_eval_thread_cnt)
+		return;
+
+	slurm_mutex_lock(&bf_eval_mutex);
+	bf_eval_shutdown = true;
+	slurm_cond_broadcast(&bf_eval_cond);
+	slurm_mutex_unlock(&bf_eval_mutex);
+	for (i = 0; i < bf_eval_thread_cnt; i++)
+		pthread_join(bf_eval_tids[i], NULL);
+	xfree(bf_eval_tids);
+	xfree(bf_eval_recs);
+	bf_eval_thread_cnt = 0;
+	bf_eval_rec_cnt = 0;
+	bf_eval_shutdown = false;
+}
+
+/* Discard evaluation results, job and node state may have changed */
+static void _bf_eval_reset(void)
+{
+	slurm_mutex_lock(&bf_eval_mutex);
+	bf_eval_rec_cnt = 0;
+	bf_eval_next = 0;
+	bf_eval_done = 0;
+	bf_eval_pos = 0;
+	slurm_mutex_unlock(&bf_eval_mutex);
+}
+
+/* Set lower bounds of a job's node count and time limit */
+static void _bf_eval_set_limits(bf_eval_rec_t *rec)
+{
+	job_record_t *job_ptr = rec->job_ptr;
+	part_record_t *part_ptr = rec->part_ptr;
+	uint32_t time_limit;
+
+	if (job_ptr->details)
+		rec->min_nodes = job_ptr->details->min_nodes;
+	else
+		rec->min_nodes = 0;
+
+	if (part_ptr->max_time == INFINITE)
+		time_limit = YEAR_MINUTES;
+	else
+		time_limit = part_ptr->max_time;
+	if ((job_ptr->time_limit != NO_VAL) &&
+	    (job_ptr->time_limit != INFINITE))
+		time_limit = MIN(time_limit, job_ptr->time_limit);
+	if (job_ptr->time_min)
+		time_limit = MIN(time_limit, job_ptr->time_min);
+	if (job_ptr->qos_ptr &&
+	    (job_ptr->qos_ptr->flags & QOS_FLAG_NO_RESERVE) &&
+	    slurm_conf.preempt_mode)
+		time_limit = 1;
+	rec->time_limit = time_limit;
+}
+
+/*
+ * Evaluate a batch of jobs using the evaluation threads: job_ptr, which was
+ * just removed from the job queue, followed by the jobs at the head of the
+ * queue. The node_space table is not modified until the batch completes.
+ */
+static void _bf_eval_batch(job_record_t *job_ptr, part_record_t *part_ptr,
+			   List job_queue, node_space_map_t *node_space)
+{
+	int i, rec_cnt = 0;
+	job_queue_rec_t *job_queue_rec;
+	ListIterator job_iterator;
+	assoc_mgr_lock_t qos_read_lock =
+		{ NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+		  NO_LOCK, NO_LOCK, NO_LOCK };
+
+	_bf_eval_reset();
+
+	bf_eval_recs[rec_cnt].job_ptr = job_ptr;
+	bf_eval_recs[rec_cnt++].part_ptr = part_ptr;
+	job_iterator = list_iterator_create(job_queue);
+	while ((rec_cnt < bf_eval_batch_size) &&
+	       (job_queue_rec = list_next(job_iterator))) {
+		if (!job_queue_rec->part_ptr)
+			continue;
+		bf_eval_recs[rec_cnt].job_ptr = job_queue_rec->job_ptr;
+		bf_eval_recs[rec_cnt++].part_ptr = job_queue_rec->part_ptr;
+	}
+	list_iterator_destroy(job_iterator);
+
+	assoc_mgr_lock(&qos_read_lock);
+	for (i = 0; i < rec_cnt; i++)
+		_bf_eval_set_limits(&bf_eval_recs[i]);
+	assoc_mgr_unlock(&qos_read_lock);
+
+	slurm_mutex_lock(&bf_eval_mutex);
+	bf_eval_node_space = node_space;
+	bf_eval_gen = bf_table_gen;
+	bf_eval_rec_cnt = rec_cnt;
+	slurm_cond_broadcast(&bf_eval_cond);
+	while (bf_eval_done < bf_eval_rec_cnt)
+		slurm_cond_wait(&bf_eval_done_cond, &bf_eval_mutex);
+	slurm_mutex_unlock(&bf_eval_mutex);
+}
+
+/*
+ * Return the evaluation of a job, evaluating a new batch of jobs if it is not
+ * part of the current batch.
+ * Reservations added since the batch was evaluated only delay jobs further,
+ * so earlier results remain correct but may be improved upon. Re-evaluate
+ * those with small batches, and grow batches while the table is unchanged.
+ */
+static bf_eval_rec_t *_bf_eval_get(job_record_t *job_ptr,
+				   part_record_t *part_ptr, List job_queue,
+				   node_space_map_t *node_space)
+{
+	int i, max_recs = bf_eval_thread_cnt * BF_EVAL_BATCH;
+
+	for (i = bf_eval_pos; i < bf_eval_rec_cnt; i++) {
+		if ((bf_eval_recs[i].job_ptr != job_ptr) ||
+		    (bf_eval_recs[i].part_ptr != part_ptr))
+			continue;
+		bf_eval_pos = i;
+		if (bf_eval_recs[i].skip || (bf_eval_gen == bf_table_gen))
+			return &bf_eval_recs[i];
+		bf_eval_batch_size = bf_eval_thread_cnt;
+		break;
+	}
+	if ((i >= bf_eval_rec_cnt) && bf_eval_rec_cnt)
+		bf_eval_batch_size = MIN(bf_eval_batch_size * 2, max_recs);
+
+	_bf_eval_batch(job_ptr, part_ptr, job_queue, node_space);
+	return &bf_eval_recs[0];
+}
+
+/* FNV-1a 64 hash of size bytes at buf, continuing from digest */
+static uint64_t _bf_plan_hash(uint64_t digest, const void *buf, size_t size)
+{
+	const unsigned char *data = buf;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		digest ^= data[i];
+		digest *= 0x100000001b3ULL;
+	}
+
+	return digest;
+}
+
+static uint64_t _bf_plan_hash_str(uint64_t digest, const char *str)
+{
+	if (!str)
+		return _bf_plan_hash(digest, "", 1);
+	return _bf_plan_hash(digest, str, strlen(str) + 1);
+}
+
+/*
+ * Hash the job's own inputs to a backfill test, plus the values derived from
+ * them and from the rest of the queue by _attempt_backfill() for this test
+ */
+static uint64_t _bf_plan_digest(job_record_t *job_ptr, uint32_t *vals,
+				int val_cnt)
+{
+	struct job_details *details = job_ptr->details;
+	uint64_t digest = BF_PLAN_DIGEST_INIT;
+	uint32_t job_vals[] = {
+		job_ptr->job_id, job_ptr->array_task_id, job_ptr->priority,
+		job_ptr->time_limit, job_ptr->time_min, job_ptr->qos_id,
+		job_ptr->resv_id, details->min_nodes, details->max_nodes,
+		details->min_cpus, details->max_cpus, details->pn_min_cpus,
+		details->pn_min_tmp_disk, details->cpus_per_task,
+		details->ntasks_per_node, details->num_tasks,
+		details->share_res, details->whole_node, details->contiguous,
+		details->core_spec
+	};
+
+	digest = _bf_plan_hash(digest, job_vals, sizeof(job_vals));
+	digest = _bf_plan_hash(digest, vals, sizeof(uint32_t) * val_cnt);
+	digest = _bf_plan_hash(digest, &details->pn_min_memory,
+			       sizeof(details->pn_min_memory));
+	digest = _bf_plan_hash(digest, &details->begin_time,
+			       sizeof(details->begin_time));
+	if (details->mc_ptr)
+		digest = _bf_plan_hash(digest, details->mc_ptr,
+				       sizeof(multi_core_data_t));
+	digest = _bf_plan_hash_str(digest, details->features);
+	digest = _bf_plan_hash_str(digest, details->req_nodes);
+	digest = _bf_plan_hash_str(digest, details->exc_nodes);
+	digest = _bf_plan_hash_str(digest, job_ptr->cpus_per_tres);
+	digest = _bf_plan_hash_str(digest, job_ptr->mem_per_tres);
+	digest = _bf_plan_hash_str(digest, job_ptr->tres_per_job);
+	digest = _bf_plan_hash_str(digest, job_ptr->tres_per_node);
+	digest = _bf_plan_hash_str(digest, job_ptr->tres_per_socket);
+	digest = _bf_plan_hash_str(digest, job_ptr->tres_per_task);
+	digest = _bf_plan_hash_str(digest, job_ptr->licenses);
+	digest = _bf_plan_hash_str(digest, job_ptr->network);
+	digest = _bf_plan_hash_str(digest, job_ptr->mcs_label);
+
+	return digest;
+}
+
+static uint64_t _bf_plan_key(uint32_t job_id, uint32_t array_task_id,
+			     part_record_t *part_ptr)
+{
+	return ((uint64_t) job_id << 32) ^ array_task_id ^
+	       (((uintptr_t) part_ptr >> 4) & 0xffffffff);
+}
+
+static void _bf_plan_busy_del(void *x)
+{
+	bf_plan_busy_t *busy = (bf_plan_busy_t *) x;
+
+	FREE_NULL_BITMAP(busy->node_bitmap);
+	xfree(busy);
+}
+
+/* Record nodes in use from start_time to end_time unknown to bf_plan_prev */
+static void _bf_plan_busy_add(bitstr_t *node_bitmap, time_t start_time,
+			      time_t end_time)
+{
+	bf_plan_busy_t *busy = xmalloc(sizeof(bf_plan_busy_t));
+
+	busy->node_bitmap = bit_copy(node_bitmap);
+	busy->start_time = start_time;
+	busy->end_time = end_time;
+	list_append(bf_plan_busy_list, busy);
+}
+
+static int _bf_plan_busy_overlap(void *x, void *arg)
+{
+	bf_plan_busy_t *busy = (bf_plan_busy_t *) x;
+	bf_plan_rec_t *rec = (bf_plan_rec_t *) arg;
+	time_t end_time = rec->reserved ? rec->resv_end : INFINITE;
+
+	if ((busy->start_time < end_time) &&
+	    (busy->end_time > rec->test_start) &&
+	    bit_overlap_any(busy->node_bitmap, rec->test_bitmap))
+		return 1;
+	return 0;
+}
+
+static void _bf_plan_free(bf_plan_t **plan_pptr)
+{
+	bf_plan_t *plan = *plan_pptr;
+	uint32_t i;
+
+	if (!plan)
+		return;
+	for (i = 0; i < plan->rec_cnt; i++)
+		FREE_NULL_BITMAP(plan->recs[i].test_bitmap);
+	xfree(plan->recs);
+	xfree(plan->runs);
+	FREE_NULL_BITMAP(plan->avail_bitmap);
+	FREE_NULL_BITMAP(plan->up_bitmap);
+	xfree(plan);
+	*plan_pptr = NULL;
+}
+
+static int _bf_plan_run_cmp(const void *x, const void *y)
+{
+	const bf_plan_run_t *run1 = x, *run2 = y;
+
+	if (run1->job_id < run2->job_id)
+		return -1;
+	if (run1->job_id > run2->job_id)
+		return 1;
+	return 0;
+}
+
+static int _bf_plan_add_run(void *x, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) x;
+	bf_plan_t *plan = (bf_plan_t *) arg;
+
+	if ((!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr)) ||
+	    !job_ptr->node_bitmap)
+		return 0;
+	if (plan->run_cnt >= plan->run_size) {
+		plan->run_size = MAX(plan->run_size * 2, 64);
+		xrecalloc(plan->runs, plan->run_size, sizeof(bf_plan_run_t));
+	}
+	plan->runs[plan->run_cnt].job_id = job_ptr->job_id;
+	plan->runs[plan->run_cnt].end_time = job_ptr->end_time;
+	plan->run_cnt++;
+	return 0;
+}
+
+/*
+ * Compare the running jobs and available nodes of bf_plan with those of
+ * bf_plan_prev. Nodes on which resources were released are added to
+ * bf_plan_free_bitmap and resources newly in use are added to
+ * bf_plan_busy_list.
+ * RET false if the changes can not be determined
+ */
+static bool _bf_plan_diff(time_t now)
+{
+	bf_plan_run_t *old_run = bf_plan_prev->runs;
+	bf_plan_run_t *old_end = old_run + bf_plan_prev->run_cnt;
+	bf_plan_run_t *run = bf_plan->runs;
+	bf_plan_run_t *end = run + bf_plan->run_cnt;
+	job_record_t *job_ptr;
+	bitstr_t *tmp_bitmap;
+
+	while ((run < end) || (old_run < old_end)) {
+		if ((old_run < old_end) && (run < end) &&
+		    (old_run->job_id == run->job_id)) {
+			if (old_run->end_time == run->end_time) {
+				old_run++;
+				run++;
+				continue;
+			}
+			job_ptr = find_job_record(run->job_id);
+			if (!job_ptr || !job_ptr->node_bitmap)
+				return false;
+			if (run->end_time > old_run->end_time)
+				_bf_plan_busy_add(job_ptr->node_bitmap,
+						  old_run->end_time,
+						  run->end_time);
+			else
+				bit_or(bf_plan_free_bitmap,
+				       job_ptr->node_bitmap);
+			old_run++;
+			run++;
+		} else if ((run < end) &&
+			   ((old_run >= old_end) ||
+			    (run->job_id < old_run->job_id))) {
+			/* Job started */
+			job_ptr = find_job_record(run->job_id);
+			if (!job_ptr || !job_ptr->node_bitmap)
+				return false;
+			_bf_plan_busy_add(job_ptr->node_bitmap,
+					  job_ptr->start_time, run->end_time);
+			run++;
+		} else {
+			/* Job ended, early if its end time is still ahead */
+			if (old_run->end_time > now) {
+				job_ptr = find_job_record(old_run->job_id);
+				if (!job_ptr || !job_ptr->node_bitmap)
+					return false;
+				bit_or(bf_plan_free_bitmap,
+				       job_ptr->node_bitmap);
+			}
+			old_run++;
+		}
+	}
+
+	tmp_bitmap = bit_copy(bf_plan->avail_bitmap);
+	bit_and_not(tmp_bitmap, bf_plan_prev->avail_bitmap);
+	bit_or(bf_plan_free_bitmap, tmp_bitmap);
+	bit_copybits(tmp_bitmap, bf_plan_prev->avail_bitmap);
+	bit_and_not(tmp_bitmap, bf_plan->avail_bitmap);
+	if (bit_ffs(tmp_bitmap) != -1)
+		_bf_plan_busy_add(tmp_bitmap, 0, INFINITE);
+	bit_copybits(tmp_bitmap, bf_plan->up_bitmap);
+	bit_and_not(tmp_bitmap, bf_plan_prev->up_bitmap);
+	bit_or(bf_plan_free_bitmap, tmp_bitmap);
+	bit_copybits(tmp_bitmap, bf_plan_prev->up_bitmap);
+	bit_and_not(tmp_bitmap, bf_plan->up_bitmap);
+	bit_or(bf_plan_free_bitmap, tmp_bitmap);
+	FREE_NULL_BITMAP(tmp_bitmap);
+
+	return true;
+}
+
+/*
+ * Start a new bf_incremental plan for a backfill cycle, keeping the plan of
+ * the previous cycle for reuse if the cluster's configuration, partitions and
+ * advance reservations are unchanged and the plan is not too old.
+ * IN avail_bitmap - nodes available to the new plan
+ */
+static void _bf_plan_begin(bitstr_t *avail_bitmap, time_t now)
+{
+	uint32_t i;
+	uint64_t key;
+	bf_plan_rec_t *rec;
+
+	if (!bf_incremental) {
+		_bf_plan_free(&bf_plan);
+		return;
+	}
+
+	_bf_plan_free(&bf_plan_prev);
+	bf_plan_prev = bf_plan;
+	bf_plan = xmalloc(sizeof(bf_plan_t));
+	bf_plan->avail_bitmap = bit_copy(avail_bitmap);
+	bf_plan->up_bitmap = bit_copy(up_node_bitmap);
+	bf_plan->conf_update = slurm_conf.last_update;
+	bf_plan->part_update = last_part_update;
+	bf_plan->resv_update = last_resv_update;
+	bf_plan->build_time = now;
+	list_for_each(job_list, _bf_plan_add_run, bf_plan);
+	qsort(bf_plan->runs, bf_plan->run_cnt, sizeof(bf_plan_run_t),
+	      _bf_plan_run_cmp);
+
+	bf_plan_inx = -1;
+	bf_plan_match = NULL;
+	bf_plan_pos = 0;
+	bf_plan_reused = 0;
+	bf_plan_reuse = false;
+	if (!bf_plan_prev || !bf_plan_prev->rec_cnt ||
+	    (bf_plan_prev->conf_update != bf_plan->conf_update) ||
+	    (bf_plan_prev->part_update != bf_plan->part_update) ||
+	    (bf_plan_prev->resv_update != bf_plan->resv_update) ||
+	    (bit_size(bf_plan_prev->avail_bitmap) !=
+	     bit_size(bf_plan->avail_bitmap)) ||
+	    (difftime(now, bf_plan_prev->build_time) >= BF_PLAN_MAX_AGE))
+		return;
+
+	bf_plan_free_bitmap = bit_alloc(bit_size(bf_plan->avail_bitmap));
+	bf_plan_busy_list = list_create(_bf_plan_busy_del);
+	if (!_bf_plan_diff(now)) {
+		FREE_NULL_BITMAP(bf_plan_free_bitmap);
+		FREE_NULL_LIST(bf_plan_busy_list);
+		return;
+	}
+
+	/* Chain records with the same key in queue order */
+	bf_plan_hash = id_hash_init(bf_plan_prev->rec_cnt);
+	for (i = bf_plan_prev->rec_cnt; i-- > 0; ) {
+		rec = &bf_plan_prev->recs[i];
+		key = _bf_plan_key(rec->job_id, rec->array_task_id,
+				   rec->part_ptr);
+		rec->key_next = id_hash_find(bf_plan_hash, key);
+		if (rec->key_next)
+			id_hash_remove(bf_plan_hash, key, rec->key_next);
+		id_hash_add(bf_plan_hash, key, rec);
+	}
+	bf_plan->build_time = bf_plan_prev->build_time;
+	bf_plan_reuse = true;
+}
+
+/* Stop reusing bf_plan_prev for the rest of the cycle */
+static void _bf_plan_stop(void)
+{
+	bf_plan_reuse = false;
+	bf_plan_match = NULL;
+	id_hash_free(bf_plan_hash);
+	bf_plan_hash = NULL;
+	FREE_NULL_BITMAP(bf_plan_free_bitmap);
+	FREE_NULL_LIST(bf_plan_busy_list);
+}
+
+/* Finish the backfill cycle's plan, bf_plan is kept for the next cycle */
+static void _bf_plan_end(void)
+{
+	if (!bf_plan)
+		return;
+	_bf_plan_done(NULL);
+	log_flag(BACKFILL, "reused plan for %u of %u tested jobs",
+		 bf_plan_reused, bf_plan->rec_cnt);
+	_bf_plan_stop();
+	_bf_plan_free(&bf_plan_prev);
+}
+
+/*
+ * Find the bf_plan_prev record of a (job, partition) pair. Records passed
+ * over belong to jobs no longer tested or tested in a different order, the
+ * nodes they reserved are now free for the jobs which follow.
+ */
+static bf_plan_rec_t *_bf_plan_find(job_record_t *job_ptr,
+				    part_record_t *part_ptr)
+{
+	bf_plan_rec_t *rec;
+	uint32_t inx;
+
+	rec = id_hash_find(bf_plan_hash, _bf_plan_key(job_ptr->job_id,
+						      job_ptr->array_task_id,
+						      part_ptr));
+	for ( ; rec; rec = rec->key_next) {
+		inx = rec - bf_plan_prev->recs;
+		if (rec->used || (inx < bf_plan_pos) ||
+		    (rec->job_id != job_ptr->job_id) ||
+		    (rec->array_task_id != job_ptr->array_task_id) ||
+		    (rec->part_ptr != part_ptr))
+			continue;
+		for ( ; bf_plan_pos < inx; bf_plan_pos++) {
+			bf_plan_rec_t *skip = &bf_plan_prev->recs[bf_plan_pos];
+			if (!skip->used && skip->reserved)
+				bit_or(bf_plan_free_bitmap, skip->test_bitmap);
+		}
+		bf_plan_pos++;
+		rec->used = true;
+		return rec;
+	}
+
+	return NULL;
+}
+
+/*
+ * Add a bf_plan record for the job about to be tested.
+ * IN vals - values used by the test which are derived from the queue
+ * RET the bf_plan_prev record whose result may be reused without testing the
+ *	job again, or NULL if the job must be tested
+ */
+static bf_plan_rec_t *_bf_plan_start(job_record_t *job_ptr,
+				     part_record_t *part_ptr,
+				     uint32_t *vals, int val_cnt, time_t now)
+{
+	bf_plan_rec_t *rec, *old_rec;
+
+	_bf_plan_done(NULL);
+	if (!bf_plan)
+		return NULL;
+
+	if (bf_plan->rec_cnt >= bf_plan->rec_size) {
+		bf_plan->rec_size = MAX(bf_plan->rec_size * 2, 64);
+		xrecalloc(bf_plan->recs, bf_plan->rec_size,
+			  sizeof(bf_plan_rec_t));
+	}
+	bf_plan_inx = bf_plan->rec_cnt++;
+	rec = &bf_plan->recs[bf_plan_inx];
+	memset(rec, 0, sizeof(bf_plan_rec_t));
+	rec->job_id = job_ptr->job_id;
+	rec->array_task_id = job_ptr->array_task_id;
+	rec->part_ptr = part_ptr;
+	rec->digest = _bf_plan_digest(job_ptr, vals, val_cnt);
+	rec->cacheable = !job_ptr->het_job_id && !job_ptr->time_min &&
+			 (!job_ptr->deadline || (job_ptr->deadline == NO_VAL));
+
+	if (!bf_plan_reuse ||
+	    !(old_rec = _bf_plan_find(job_ptr, part_ptr)))
+		return NULL;
+	bf_plan_match = old_rec;
+	/*
+	 * Only reuse a start time and nodes which were found. Jobs rejected
+	 * for limits, licenses or GRES are tested again as those can change
+	 * without any update which this plan tracks.
+	 */
+	if (!old_rec->cacheable || !rec->cacheable || !old_rec->tested ||
+	    (old_rec->digest != rec->digest) ||
+	    (old_rec->test_start <= now) ||
+	    bit_overlap_any(part_ptr->node_bitmap, bf_plan_free_bitmap) ||
+	    list_find_first(bf_plan_busy_list, _bf_plan_busy_overlap, old_rec))
+		return NULL;
+
+	bf_plan_reused++;
+	return old_rec;
+}
+
+/* Record the start time and nodes found for the job being tested */
+static void _bf_plan_tested(job_record_t *job_ptr, bitstr_t *avail_bitmap,
+			    uint32_t boot_time)
+{
+	bf_plan_rec_t *rec;
+
+	if (bf_plan_inx < 0)
+		return;
+	rec = &bf_plan->recs[bf_plan_inx];
+	rec->tested = true;
+	rec->test_start = job_ptr->start_time;
+	rec->boot_time = boot_time;
+	FREE_NULL_BITMAP(rec->test_bitmap);
+	rec->test_bitmap = bit_copy(avail_bitmap);
+	if (job_ptr->start_time <= time(NULL))
+		rec->cacheable = false;
+}
+
+/* Record the node_space reservation made for the job being tested */
+static void _bf_plan_reserved(uint32_t start_time, uint32_t end_reserve)
+{
+	bf_plan_rec_t *rec;
+
+	if (bf_plan_inx < 0)
+		return;
+	rec = &bf_plan->recs[bf_plan_inx];
+	rec->reserved = true;
+	rec->resv_start = start_time;
+	rec->resv_end = end_reserve;
+}
+
+/* The result for the job being tested must not be reused */
+static void _bf_plan_nocache(void)
+{
+	if (bf_plan_inx >= 0)
+		bf_plan->recs[bf_plan_inx].cacheable = false;
+}
+
+/*
+ * Finish the record of the job tested last. If its reservation differs from
+ * that of the previous plan, jobs which follow in the queue and could use the
+ * nodes involved must be tested again.
+ * IN job_ptr - job tested last or NULL if its start_time is already recorded
+ */
+static void _bf_plan_done(job_record_t *job_ptr)
+{
+	bf_plan_rec_t *rec, *old_rec = bf_plan_match;
+
+	if (bf_plan_inx < 0)
+		return;
+	rec = &bf_plan->recs[bf_plan_inx];
+	if (job_ptr)
+		rec->start_time = job_ptr->start_time;
+	bf_plan_inx = -1;
+	bf_plan_match = NULL;
+	if (!bf_plan_reuse)
+		return;
+
+	if (old_rec && (old_rec->reserved == rec->reserved) &&
+	    (!rec->reserved ||
+	     ((old_rec->resv_start == rec->resv_start) &&
+	      (old_rec->resv_end == rec->resv_end) &&
+	      bit_equal(old_rec->test_bitmap, rec->test_bitmap))))
+		return;
+	if (old_rec && old_rec->reserved)
+		bit_or(bf_plan_free_bitmap, old_rec->test_bitmap);
+	if (rec->reserved)
+		_bf_plan_busy_add(rec->test_bitmap, rec->resv_start,
+				  rec->resv_end);
+}
+
 /* backfill_agent - detached thread periodically attempts to backfill jobs */
 extern void *backfill_agent(void *args)
 {
@@ -1054,6 +1912,7 @@ extern void *backfill_agent(void *args)
 		if ((backfill_cnt++ % 2) == 0)
 			_het_job_start_clear();
 		(void) _attempt_backfill();
+		job_info_sweep();
 		last_backfill_time = time(NULL);
 		(void) bb_g_job_try_stage_in();
 		unlock_slurmctld(all_locks);
@@ -1066,6 +1925,10 @@ extern void *backfill_agent(void *args)
 	}
 	FREE_NULL_LIST(het_job_list);
 	xhash_free(user_usage_map); /* May have been init'ed if used */
+	job_queue_order_free(&bf_queue_order);
+	_bf_eval_fini();
+	_bf_plan_free(&bf_plan);
+	_bf_plan_free(&bf_plan_prev);
 
 	return NULL;
 }
@@ -1116,6 +1979,8 @@ static int _yield_locks(int64_t usec)
 		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 	}
 	lock_slurmctld(all_locks);
+	/* Nodes may have been returned to service, evaluate jobs again */
+	_bf_eval_reset();
 	slurm_mutex_lock(&config_lock);
 	if (config_flag)
 		load_config = true;
@@ -1559,7 +2424,7 @@ static int _attempt_backfill(void)
 	DEF_TIMERS;
 	List job_queue;
 	job_queue_rec_t *job_queue_rec;
-	int bb, i, j, node_space_recs, mcs_select = 0;
+	int bb, j, node_space_recs, mcs_select = 0;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
@@ -1655,6 +2520,7 @@ static int _attempt_backfill(void)
 	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
 
 	node_space[0].next = 0;
+	node_space_init(node_space);
 	node_space_recs = 1;
 
 	if (bf_running_job_reserve) {
@@ -1669,6 +2535,8 @@ static int _attempt_backfill(void)
 	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 		_dump_node_space_table(node_space);
 
+	_bf_plan_begin(node_space[0].avail_bitmap, now);
+
 	if (assoc_limit_stop) {
 		assoc_mgr_lock(&qos_read_lock);
 		list_for_each(assoc_mgr_qos_list,
@@ -1676,11 +2544,14 @@ static int _attempt_backfill(void)
 		assoc_mgr_unlock(&qos_read_lock);
 	}
 
-	sort_job_queue(job_queue);
+	sort_job_queue_incr(job_queue, &bf_queue_order);
 
 	/* Ignore nodes that have been set as available during this cycle. */
 	bit_clear_all(bf_ignore_node_bitmap);
 
+	_bf_eval_init();
+	_bf_eval_reset();
+
 	while (1) {
 		uint32_t bf_array_task_id, bf_job_priority,
 			prio_reserve;
@@ -1688,6 +2559,7 @@ static int _attempt_backfill(void)
 
 		/* Run some final guaranteed logic after each job iteration */
 		if (job_ptr) {
+			_bf_plan_done(job_ptr);
 			job_resv_clear_magnetic_flag(job_ptr);
 			fill_array_reasons(job_ptr, reject_array_job);
 
@@ -1742,6 +2614,8 @@ static int _attempt_backfill(void)
 			}
 			if (stop_backfill)
 				break;
+			/* Changes made while unlocked are not tracked */
+			_bf_plan_stop();
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
 			gettimeofday(&start_tv, NULL);
@@ -1769,6 +2643,7 @@ static int _attempt_backfill(void)
 		    (job_ptr->state_reason == WAIT_NO_REASON)) {
 			xfree(job_ptr->state_desc);
 			job_ptr->state_reason = WAIT_RESOURCES;
+			job_info_refreshed(job_ptr, now);
 		}
 
 		if (!_job_runnable_now(job_ptr))
@@ -1779,6 +2654,7 @@ static int _attempt_backfill(void)
 		job_ptr->last_sched_eval = now;
 		job_ptr->part_ptr = part_ptr;
 		job_ptr->priority = bf_job_priority;
+		job_info_refreshed(job_ptr, now);
 		mcs_select = slurm_mcs_get_select(job_ptr);
 		het_job_time = _het_job_start_find(job_ptr);
 		if (het_job_time > (now + backfill_window))
@@ -1802,12 +2678,12 @@ static int _attempt_backfill(void)
 				      job_ptr);
 				assoc_mgr_unlock(&locks);
 				job_fail_qos(job_ptr, __func__);
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -1900,6 +2776,7 @@ static int _attempt_backfill(void)
 			is_job_array_head = false;
 
 next_task:
+		_bf_plan_done(job_ptr);
 		/*
 		 * Save the current preemption state. Reset preemption state
 		 * in the job_ptr so a job array can preempt multiple jobs.
@@ -2036,6 +2913,48 @@ next_task:
 			}
 		}
 
+		if (bf_plan) {
+			uint32_t plan_vals[] = {
+				min_nodes, req_nodes, max_nodes, time_limit,
+				comp_time_limit, job_no_reserve, qos_flags,
+				mcs_select, orig_start_time, later_start - now
+			};
+			bf_plan_rec_t *plan_rec = _bf_plan_start(
+				job_ptr, part_ptr, plan_vals,
+				ARRAY_SIZE(plan_vals), now);
+
+			if (plan_rec) {
+				log_flag(BACKFILL, "%pJ reusing start time and nodes from previous plan",
+					 job_ptr);
+				FREE_NULL_BITMAP(avail_bitmap);
+				avail_bitmap = bit_copy(plan_rec->test_bitmap);
+				job_ptr->start_time = plan_rec->test_start;
+				boot_time = plan_rec->boot_time;
+				goto plan_reuse;
+			}
+		}
+
+		if (bf_eval_thread_cnt) {
+			bf_eval_rec_t *eval = _bf_eval_get(job_ptr, part_ptr,
+							   job_queue,
+							   node_space);
+			if (eval->skip ||
+			    (eval->start_time && job_no_reserve)) {
+				log_flag(BACKFILL, "%pJ does not fit in backfill table",
+					 job_ptr);
+				slurmctld_diag_stats.bf_eval_skipped++;
+				_set_job_time_limit(job_ptr, orig_time_limit);
+				job_ptr->start_time = orig_start_time;
+				continue;
+			}
+			if (eval->start_time > later_start) {
+				log_flag(BACKFILL, "%pJ evaluation move start_res to %ld",
+					 job_ptr, eval->start_time);
+				slurmctld_diag_stats.bf_eval_skipped++;
+				later_start = eval->start_time;
+			}
+		}
+
  TRY_LATER:
 		if (slurmctld_config.shutdown_time ||
 		    (difftime(time(NULL), orig_sched_start) >=
@@ -2073,6 +2992,7 @@ next_task:
 			}
 			if (stop_backfill)
 				break;
+			_bf_plan_stop();
 
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
@@ -2129,9 +3049,8 @@ next_task:
 		filter_by_node_owner(job_ptr, avail_bitmap);
 		filter_by_node_mcs(job_ptr, mcs_select, avail_bitmap);
 		tmp_bitmap = bit_copy(avail_bitmap);
-		for (j = 0; ; ) {
-			if ((node_space[j].end_time > start_res) &&
-			     node_space[j].next && (later_start == 0)) {
+		for (j = node_space_first(node_space, start_res); j >= 0; ) {
+			if (node_space[j].next && (later_start == 0)) {
 				int tmp = node_space[j].next;
 				bitstr_t *next_bitmap = bit_copy(tmp_bitmap);
 				bitstr_t *current_bitmap =
@@ -2156,13 +3075,16 @@ next_task:
 				FREE_NULL_BITMAP(next_bitmap);
 				FREE_NULL_BITMAP(current_bitmap);
 			}
-			if (node_space[j].end_time <= start_res)
-				;
-			else if (node_space[j].begin_time <= end_time) {
-				bit_and(avail_bitmap,
-					node_space[j].avail_bitmap);
-			} else
+			if (node_space[j].begin_time > end_time)
+				break;
+			if (later_start) {
+				/* Use search tree for remaining records */
+				node_space_and(node_space,
+					       node_space[j].begin_time,
+					       end_time, avail_bitmap);
 				break;
+			}
+			bit_and(avail_bitmap, node_space[j].avail_bitmap);
 			if ((j = node_space[j].next) == 0)
 				break;
 		}
@@ -2277,19 +3199,8 @@ next_task:
 			orig_end_time = end_time;
 			end_time += boot_time;
 
-			for (j = 0; ; ) {
-				if (node_space[j].end_time <= start_res)
-					;
-				else if (node_space[j].begin_time <= end_time) {
-					if (node_space[j].begin_time >
-					    orig_end_time)
-						bit_and(avail_bitmap,
-						node_space[j].avail_bitmap);
-				} else
-					break;
-				if ((j = node_space[j].next) == 0)
-					break;
-			}
+			node_space_and(node_space, orig_end_time + 1,
+				       end_time, avail_bitmap);
 		}
 		if (test_fini != 1) {
 			/* Either active_bitmap was NULL or not usable by the
@@ -2318,8 +3229,10 @@ next_task:
 
 		if (start_res > job_ptr->start_time) {
 			job_ptr->start_time = start_res;
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		}
+		if (job_ptr->start_time <= now)
+			_bf_plan_nocache();	/* May start before next cycle */
 		/*
 		 * avail_bitmap at this point contains a bitmap of nodes
 		 * selected for this job to be allocated
@@ -2351,7 +3264,7 @@ next_task:
 				     job_state_string(job_ptr->job_state),
 				     job_reason_string(job_ptr->state_reason),
 				     job_ptr->priority);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			_set_job_time_limit(job_ptr, orig_time_limit);
 			later_start = 0;
 			if (bb == -1)
@@ -2462,6 +3375,7 @@ skip_start:
 					job_ptr->start_time = later_start;
 				else
 					job_ptr->start_time = now + 500;
+				job_info_refreshed(job_ptr, now);
 				if (job_ptr->qos_blocking_ptr &&
 				    job_state_qos_grp_limit(
 					    job_ptr->state_reason)) {
@@ -2553,6 +3467,8 @@ skip_start:
 			goto TRY_LATER;
 		}
 
+plan_reuse:
+		_bf_plan_tested(job_ptr, avail_bitmap, boot_time);
 		start_time  = job_ptr->start_time;
 		end_reserve = job_ptr->start_time + boot_time +
 			      (time_limit * 60);
@@ -2707,6 +3623,7 @@ skip_start:
 		    !(job_ptr->bit_flags & JOB_MAGNETIC)) {
 			_add_reservation(start_time, end_reserve, avail_bitmap,
 					 node_space, &node_space_recs);
+			_bf_plan_reserved(start_time, end_reserve);
 		}
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 			_dump_node_space_table(node_space);
@@ -2741,11 +3658,13 @@ skip_start:
 	}
 
 	if (job_ptr) {
+		_bf_plan_done(job_ptr);
 		/* Restore preemption state if needed. */
 		_restore_preempt_state(job_ptr, &tmp_preempt_start_time,
 				       &tmp_preempt_in_progress);
 		job_resv_clear_magnetic_flag(job_ptr);
 	}
+	_bf_plan_end();
 
 	_het_job_deadlock_fini();
 	if (!bf_hetjob_immediate &&
@@ -2757,11 +3676,8 @@ skip_start:
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
 
-	for (i = 0; ; ) {
-		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
-		if ((i = node_space[i].next) == 0)
-			break;
-	}
+	node_space_fini(node_space);
+	_bf_eval_reset();
 	xfree(node_space);
 	FREE_NULL_LIST(job_queue);
 
@@ -2821,7 +3737,7 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 		FREE_NULL_BITMAP(orig_exc_nodes);
 	if (rc == SLURM_SUCCESS) {
 		/* job initiated */
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 		info("Started %pJ in %s on %s",
 		     job_ptr, job_ptr->part_ptr->name, job_ptr->nodes);
 		power_g_job_start(job_ptr);
@@ -2952,9 +3868,10 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     node_space_map_t *node_space,
 			     int *node_space_recs)
 {
-	bool placed = false;
 	int i, j;
 
+	bf_table_gen++;
+
 #if 0	
 	info("add job start:%u end:%u", start_time, end_reserve);
 	for (j = 0; ; ) {
@@ -2967,74 +3884,28 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 #endif
 
 	start_time = MAX(start_time, node_space[0].begin_time);
-	for (j = 0; ; ) {
-		if (node_space[j].end_time > start_time) {
-			/* insert start entry record */
-			i = *node_space_recs;
-			node_space[i].begin_time = start_time;
-			node_space[i].end_time = node_space[j].end_time;
-			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
-			node_space[i].next = node_space[j].next;
-			node_space[j].next = i;
-			(*node_space_recs)++;
-			placed = true;
-		}
-		if (node_space[j].end_time == start_time) {
-			/* no need to insert new start entry record */
-			placed = true;
-		}
-		if (placed == true) {
-			while ((j = node_space[j].next)) {
-				if (end_reserve < node_space[j].end_time) {
-					/* insert end entry record */
-					i = *node_space_recs;
-					node_space[i].begin_time = end_reserve;
-					node_space[i].end_time = node_space[j].
-								 end_time;
-					node_space[j].end_time = end_reserve;
-					node_space[i].avail_bitmap =
-						bit_copy(node_space[j].
-							 avail_bitmap);
-					node_space[i].next = node_space[j].next;
-					node_space[j].next = i;
-					(*node_space_recs)++;
-					break;
-				}
-				if (end_reserve == node_space[j].end_time) {
-					break;
-				}
-			}
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
-			break;
-	}
+	if (end_reserve <= start_time)
+		return;
 
-	for (j = 0; ; ) {
-		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
-		if ((node_space[j].begin_time >= end_reserve) ||
-		    ((j = node_space[j].next) == 0))
-			break;
-	}
+	node_space_split(node_space, node_space_recs, start_time);
+	node_space_split(node_space, node_space_recs, end_reserve);
+	node_space_reserve(node_space, start_time, end_reserve - 1, res_bitmap);
 
-	/* Drop records with identical bitmaps (up to one record).
+	/* Drop records with identical bitmaps around the reservation.
 	 * This can significantly improve performance of the backfill tests. */
-	for (i = 0; ; ) {
-		if ((j = node_space[i].next) == 0)
-			break;
+	if ((i = node_space_find(node_space, start_time - 1)) < 0)
+		i = 0;
+	while ((j = node_space[i].next) &&
+	       (node_space[j].begin_time <= end_reserve)) {
 		if (!bit_equal(node_space[i].avail_bitmap,
 			       node_space[j].avail_bitmap)) {
 			i = j;
 			continue;
 		}
+		node_space_remove(node_space, j);
 		node_space[i].end_time = node_space[j].end_time;
 		node_space[i].next = node_space[j].next;
 		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
-		break;
 	}
 }
 
@@ -3051,18 +3922,19 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 			       uint32_t end_reserve)
 {
 	bool overlap = false;
+	bitstr_t *tmp_bitmap;
 	int j;
 
-	for (j=0; ; ) {
-		if ((node_space[j].end_time   > start_time) &&
-		    (node_space[j].begin_time < end_reserve) &&
-		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
-			overlap = true;
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
-			break;
-	}
+	if ((j = node_space_first(node_space, start_time)) < 0)
+		return false;
+
+	tmp_bitmap = bit_copy(use_bitmap);
+	node_space_and(node_space, node_space[j].begin_time, end_reserve - 1,
+		       tmp_bitmap);
+	if (!bit_equal(tmp_bitmap, use_bitmap))
+		overlap = true;
+	FREE_NULL_BITMAP(tmp_bitmap);
+
 	return overlap;
 }
 
@@ -3509,7 +4381,7 @@ static void _het_job_kill_now(het_job_map_t *map)
 		job_ptr->details->begin_time = now + cred_lifetime + 1;
 		job_ptr->end_time   = now;
 		job_ptr->job_state  = JOB_PENDING | JOB_COMPLETING;
-		last_job_update     = now;
+		job_info_changed(job_ptr, now);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, false, false, false);
@@ -0,0 +1,396 @@
+/*****************************************************************************\
+ *  node_space.c - backfill scheduler's table of resources available over time
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <stdbool.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/macros.h"
+#include "src/plugins/sched/backfill/node_space.h"
+
+/* Search tree nodes above the subtree being searched */
+typedef struct node_space_path {
+	bitstr_t *mask;		/* tree_mask of the node */
+	bool applied;		/* mask and those above ANDed into result */
+	struct node_space_path *up;
+} node_space_path_t;
+
+static int node_space_root = -1;	/* node_space search tree root */
+
+static int _node_space_height(node_space_map_t *node_space, int i)
+{
+	if (i < 0)
+		return 0;
+	return node_space[i].height;
+}
+
+/* Recompute the subtree fields of a search tree node from its children */
+static void _node_space_update(node_space_map_t *node_space, int i)
+{
+	int left = node_space[i].left, right = node_space[i].right;
+
+	node_space[i].height = MAX(_node_space_height(node_space, left),
+				   _node_space_height(node_space, right)) + 1;
+	if (left >= 0)
+		node_space[i].tree_begin = node_space[left].tree_begin;
+	else
+		node_space[i].tree_begin = node_space[i].begin_time;
+	if (right >= 0)
+		node_space[i].tree_last = node_space[right].tree_last;
+	else
+		node_space[i].tree_last = node_space[i].begin_time;
+
+	if (!node_space[i].tree_bitmap)
+		node_space[i].tree_bitmap =
+			bit_copy(node_space[i].avail_bitmap);
+	else
+		bit_copybits(node_space[i].tree_bitmap,
+			     node_space[i].avail_bitmap);
+	if (left >= 0)
+		bit_and(node_space[i].tree_bitmap,
+			node_space[left].tree_bitmap);
+	if (right >= 0)
+		bit_and(node_space[i].tree_bitmap,
+			node_space[right].tree_bitmap);
+}
+
+/* AND mask into a subtree's tree_bitmap, deferring it for descendants */
+static void _node_space_mask(node_space_map_t *node_space, int i,
+			     bitstr_t *mask)
+{
+	bit_and(node_space[i].tree_bitmap, mask);
+	if ((node_space[i].left < 0) && (node_space[i].right < 0))
+		return;
+	if (node_space[i].tree_mask)
+		bit_and(node_space[i].tree_mask, mask);
+	else
+		node_space[i].tree_mask = bit_copy(mask);
+}
+
+/* Apply a search tree node's deferred mask to its children */
+static void _node_space_push(node_space_map_t *node_space, int i)
+{
+	if (!node_space[i].tree_mask)
+		return;
+	if (node_space[i].left >= 0)
+		_node_space_mask(node_space, node_space[i].left,
+				 node_space[i].tree_mask);
+	if (node_space[i].right >= 0)
+		_node_space_mask(node_space, node_space[i].right,
+				 node_space[i].tree_mask);
+	FREE_NULL_BITMAP(node_space[i].tree_mask);
+}
+
+static int _node_space_rotate_left(node_space_map_t *node_space, int i)
+{
+	int right = node_space[i].right;
+
+	_node_space_push(node_space, i);
+	_node_space_push(node_space, right);
+	node_space[i].right = node_space[right].left;
+	node_space[right].left = i;
+	_node_space_update(node_space, i);
+	_node_space_update(node_space, right);
+	return right;
+}
+
+static int _node_space_rotate_right(node_space_map_t *node_space, int i)
+{
+	int left = node_space[i].left;
+
+	_node_space_push(node_space, i);
+	_node_space_push(node_space, left);
+	node_space[i].left = node_space[left].right;
+	node_space[left].right = i;
+	_node_space_update(node_space, i);
+	_node_space_update(node_space, left);
+	return left;
+}
+
+/* Update a search tree node and rebalance its subtree, return new root */
+static int _node_space_balance(node_space_map_t *node_space, int i)
+{
+	int left = node_space[i].left, right = node_space[i].right;
+	int balance;
+
+	_node_space_push(node_space, i);
+	_node_space_update(node_space, i);
+	balance = _node_space_height(node_space, left) -
+		  _node_space_height(node_space, right);
+	if (balance > 1) {
+		if (_node_space_height(node_space, node_space[left].left) <
+		    _node_space_height(node_space, node_space[left].right))
+			node_space[i].left =
+				_node_space_rotate_left(node_space, left);
+		return _node_space_rotate_right(node_space, i);
+	}
+	if (balance < -1) {
+		if (_node_space_height(node_space, node_space[right].right) <
+		    _node_space_height(node_space, node_space[right].left))
+			node_space[i].right =
+				_node_space_rotate_right(node_space, right);
+		return _node_space_rotate_left(node_space, i);
+	}
+	return i;
+}
+
+/* Add record i to the search tree at root, return new root */
+static int _node_space_insert(node_space_map_t *node_space, int root, int i)
+{
+	if (root < 0) {
+		node_space[i].left = -1;
+		node_space[i].right = -1;
+		node_space[i].tree_mask = NULL;
+		_node_space_update(node_space, i);
+		return i;
+	}
+	_node_space_push(node_space, root);
+	if (node_space[i].begin_time < node_space[root].begin_time)
+		node_space[root].left =
+			_node_space_insert(node_space, node_space[root].left, i);
+	else
+		node_space[root].right =
+			_node_space_insert(node_space, node_space[root].right,
+					   i);
+	return _node_space_balance(node_space, root);
+}
+
+/* Remove the first record of the subtree at root, return new root */
+static int _node_space_remove_first(node_space_map_t *node_space, int root,
+				    int *first)
+{
+	_node_space_push(node_space, root);
+	if (node_space[root].left < 0) {
+		*first = root;
+		return node_space[root].right;
+	}
+	node_space[root].left =
+		_node_space_remove_first(node_space, node_space[root].left,
+					 first);
+	return _node_space_balance(node_space, root);
+}
+
+/* Remove record i from the search tree at root, return new root */
+static int _node_space_remove(node_space_map_t *node_space, int root, int i)
+{
+	int first;
+
+	_node_space_push(node_space, root);
+	if (root == i) {
+		if (node_space[i].left < 0)
+			return node_space[i].right;
+		if (node_space[i].right < 0)
+			return node_space[i].left;
+		node_space[i].right =
+			_node_space_remove_first(node_space,
+						 node_space[i].right, &first);
+		node_space[first].left = node_space[i].left;
+		node_space[first].right = node_space[i].right;
+		return _node_space_balance(node_space, first);
+	}
+	if (node_space[i].begin_time < node_space[root].begin_time)
+		node_space[root].left =
+			_node_space_remove(node_space, node_space[root].left, i);
+	else
+		node_space[root].right =
+			_node_space_remove(node_space, node_space[root].right,
+					   i);
+	return _node_space_balance(node_space, root);
+}
+
+/* AND into bitmap the deferred masks of the search path not yet applied */
+static void _node_space_apply(node_space_path_t *path, bitstr_t *bitmap)
+{
+	for ( ; path && !path->applied; path = path->up) {
+		if (path->mask)
+			bit_and(bitmap, path->mask);
+		path->applied = true;
+	}
+}
+
+static void _node_space_and_tree(node_space_map_t *node_space, int i,
+				 time_t first, time_t last, bitstr_t *bitmap,
+				 node_space_path_t *up)
+{
+	node_space_path_t path;
+
+	if ((i < 0) ||
+	    (node_space[i].tree_last < first) ||
+	    (node_space[i].tree_begin > last))
+		return;
+	if ((node_space[i].tree_begin >= first) &&
+	    (node_space[i].tree_last <= last)) {
+		bit_and(bitmap, node_space[i].tree_bitmap);
+		_node_space_apply(up, bitmap);
+		return;
+	}
+	if ((node_space[i].begin_time >= first) &&
+	    (node_space[i].begin_time <= last))
+		bit_and(bitmap, node_space[i].avail_bitmap);
+
+	path.mask = node_space[i].tree_mask;
+	path.applied = false;
+	path.up = up;
+	if (node_space[i].begin_time > first)
+		_node_space_and_tree(node_space, node_space[i].left, first,
+				     last, bitmap, &path);
+	if (node_space[i].begin_time < last)
+		_node_space_and_tree(node_space, node_space[i].right, first,
+				     last, bitmap, &path);
+}
+
+/* AND res_bitmap into the search tree's records between first and last */
+static void _node_space_reserve_tree(node_space_map_t *node_space, int i,
+				     time_t first, time_t last,
+				     bitstr_t *res_bitmap)
+{
+	if ((i < 0) ||
+	    (node_space[i].tree_last < first) ||
+	    (node_space[i].tree_begin > last))
+		return;
+	if ((node_space[i].tree_begin >= first) &&
+	    (node_space[i].tree_last <= last)) {
+		_node_space_mask(node_space, i, res_bitmap);
+		return;
+	}
+
+	_node_space_push(node_space, i);
+	_node_space_reserve_tree(node_space, node_space[i].left, first, last,
+				 res_bitmap);
+	_node_space_reserve_tree(node_space, node_space[i].right, first, last,
+				 res_bitmap);
+	_node_space_update(node_space, i);
+}
+
+extern void node_space_init(node_space_map_t *node_space)
+{
+	node_space[0].tree_bitmap = NULL;
+	node_space_root = _node_space_insert(node_space, -1, 0);
+}
+
+extern void node_space_fini(node_space_map_t *node_space)
+{
+	int i;
+
+	for (i = 0; ; ) {
+		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
+		FREE_NULL_BITMAP(node_space[i].tree_bitmap);
+		FREE_NULL_BITMAP(node_space[i].tree_mask);
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+	node_space_root = -1;
+}
+
+extern void node_space_and(node_space_map_t *node_space, time_t first,
+			   time_t last, bitstr_t *bitmap)
+{
+	_node_space_and_tree(node_space, node_space_root, first, last, bitmap,
+			     NULL);
+}
+
+extern int node_space_find(node_space_map_t *node_space, time_t when)
+{
+	int i = node_space_root, found = -1;
+
+	while (i >= 0) {
+		if (node_space[i].begin_time <= when) {
+			found = i;
+			i = node_space[i].right;
+		} else {
+			i = node_space[i].left;
+		}
+	}
+	return found;
+}
+
+extern int node_space_first(node_space_map_t *node_space, time_t when)
+{
+	int i = node_space_find(node_space, when);
+
+	if (i < 0)
+		return 0;
+	if (node_space[i].end_time <= when)
+		return -1;
+	return i;
+}
+
+extern void node_space_remove(node_space_map_t *node_space, int i)
+{
+	node_space_root = _node_space_remove(node_space, node_space_root, i);
+	FREE_NULL_BITMAP(node_space[i].tree_bitmap);
+	FREE_NULL_BITMAP(node_space[i].tree_mask);
+}
+
+extern void node_space_reserve(node_space_map_t *node_space, time_t first,
+			       time_t last, bitstr_t *res_bitmap)
+{
+	int j;
+
+	/*
+	 * The records are walked in time order, the search tree only updates
+	 * the O(log n) nodes along the edges of the period
+	 */
+	if ((j = node_space_find(node_space, first)) < 0)
+		j = 0;
+	while (node_space[j].begin_time <= last) {
+		if (node_space[j].begin_time >= first)
+			bit_and(node_space[j].avail_bitmap, res_bitmap);
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+	_node_space_reserve_tree(node_space, node_space_root, first, last,
+				 res_bitmap);
+}
+
+extern void node_space_split(node_space_map_t *node_space,
+			     int *node_space_recs, time_t when)
+{
+	int i, j = node_space_find(node_space, when);
+
+	if ((j < 0) || (node_space[j].begin_time == when) ||
+	    (node_space[j].end_time <= when))
+		return;
+
+	i = *node_space_recs;
+	node_space[i].begin_time = when;
+	node_space[i].end_time = node_space[j].end_time;
+	node_space[j].end_time = when;
+	node_space[i].avail_bitmap = bit_copy(node_space[j].avail_bitmap);
+	node_space[i].tree_bitmap = NULL;
+	node_space[i].next = node_space[j].next;
+	node_space[j].next = i;
+	node_space_root = _node_space_insert(node_space, node_space_root, i);
+	(*node_space_recs)++;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************\
+ *  node_space.h - backfill scheduler's table of resources available over time
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _BACKFILL_NODE_SPACE_H
+#define _BACKFILL_NODE_SPACE_H
+
+#include <time.h>
+
+#include "src/common/bitstring.h"
+
+/*
+ * Records are kept both in a list ordered by time and in a balanced (AVL)
+ * search tree keyed by begin_time. Each tree node also holds the AND of the
+ * avail_bitmap of all records in its subtree, so nodes available throughout
+ * a time period are found in O(log n) bitmap operations.
+ *
+ * avail_bitmap is always current. Reservations covering a whole subtree only
+ * update the subtree's root, tree_mask holds the nodes reserved since which
+ * are still to be removed from tree_bitmap of the descendants. Searches apply
+ * the masks of the nodes above without modifying the tree, so several
+ * threads may search it at once.
+ */
+typedef struct node_space_map {
+	time_t begin_time;
+	time_t end_time;
+	bitstr_t *avail_bitmap;
+	int next;	/* next record, by time, zero termination */
+	int left;	/* search tree children, -1 if none */
+	int right;
+	int height;	/* height of subtree */
+	time_t tree_begin;	/* first begin_time in subtree */
+	time_t tree_last;	/* last begin_time in subtree */
+	bitstr_t *tree_bitmap;	/* AND of avail_bitmap in subtree */
+	bitstr_t *tree_mask;	/* Not yet ANDed into descendants' tree_bitmap,
+				 * NULL if none */
+} node_space_map_t;
+
+/*
+ * Start a new search tree holding record zero of node_space, which must have
+ * its begin_time, end_time and avail_bitmap set
+ */
+extern void node_space_init(node_space_map_t *node_space);
+
+/* Free the bitmaps of all records and the search tree */
+extern void node_space_fini(node_space_map_t *node_space);
+
+/*
+ * AND into bitmap the available nodes of every record beginning between
+ * first and last (inclusive)
+ */
+extern void node_space_and(node_space_map_t *node_space, time_t first,
+			   time_t last, bitstr_t *bitmap);
+
+/* Return the last record beginning at or before a time, -1 if none */
+extern int node_space_find(node_space_map_t *node_space, time_t when);
+
+/* Return the first record ending after a time, -1 if none */
+extern int node_space_first(node_space_map_t *node_space, time_t when);
+
+/* Remove record i, which must not be record zero, from the search tree */
+extern void node_space_remove(node_space_map_t *node_space, int i);
+
+/* AND res_bitmap into every record beginning between first and last */
+extern void node_space_reserve(node_space_map_t *node_space, time_t first,
+			       time_t last, bitstr_t *res_bitmap);
+
+/*
+ * Split the record containing a time so that a record begins at that time.
+ * The new record is node_space[*node_space_recs], which is incremented.
+ */
+extern void node_space_split(node_space_map_t *node_space,
+			     int *node_space_recs, time_t when);
+
+#endif	/* _BACKFILL_NODE_SPACE_H */
@@ -78,6 +78,7 @@ static bool config_flag = false;
 static int builtin_interval = BACKFILL_INTERVAL;
 static int max_sched_job_cnt = 50;
 static int sched_timeout = 0;
+static job_queue_order_t *queue_order = NULL;
 
 /*********************** local functions *********************/
 static void _compute_start_times(void);
@@ -153,7 +154,7 @@ static void _compute_start_times(void)
 	last_job_alloc = now - 1;
 	alloc_bitmap = bit_alloc(node_record_count);
 	job_queue = build_job_queue(true, false);
-	sort_job_queue(job_queue);
+	sort_job_queue_incr(job_queue, &queue_order);
 	while ((job_queue_rec = (job_queue_rec_t *) list_pop(job_queue))) {
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
@@ -205,7 +206,7 @@ static void _compute_start_times(void)
 				       NULL, NULL,
 				       exc_core_bitmap);
 		if (rc == SLURM_SUCCESS) {
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			if (job_ptr->time_limit == INFINITE)
 				time_limit = 365 * 24 * 60 * 60;
 			else if (job_ptr->time_limit != NO_VAL)
@@ -272,5 +273,6 @@ extern void *builtin_agent(void *args)
 		(void) bb_g_job_try_stage_in();
 		unlock_slurmctld(all_locks);
 	}
+	job_queue_order_free(&queue_order);
 	return NULL;
 }
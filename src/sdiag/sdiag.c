@@ -192,6 +192,21 @@ static int _print_stats(void)
 		printf("\tMean table size: %u\n",
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
+	if (buf->bf_eval_thread_cnt) {
+		printf("\tEvaluation threads: %u\n", buf->bf_eval_thread_cnt);
+		printf("\tEvaluation skipped ahead: %u\n",
+		       buf->bf_eval_skipped);
+		for (i = 0; i < buf->bf_eval_thread_cnt; i++) {
+			printf("\t\tThread %-3d jobs:%-8u total_time:%"PRIu64"\n",
+			       i, buf->bf_eval_jobs[i], buf->bf_eval_time[i]);
+		}
+	}
+
+	printf("\nInformation cache statistics\n");
+	printf("\tJob info hits:    %u\n", buf->job_info_cache_hits);
+	printf("\tJob info misses:  %u\n", buf->job_info_cache_misses);
+	printf("\tNode info hits:   %u\n", buf->node_info_cache_hits);
+	printf("\tNode info misses: %u\n", buf->node_info_cache_misses);
 
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
@@ -212,9 +227,12 @@ static int _print_stats(void)
 			xstrfmtcat(user, "%u", buf->rpc_user_id[i]);
 
 		printf("\t%-16s(%8u) count:%-6u "
-		       "ave_time:%-6u total_time:%"PRIu64"\n",
+		       "ave_time:%-6u total_time:%"PRIu64,
 		       user, buf->rpc_user_id[i], buf->rpc_user_cnt[i],
 		       rpc_user_ave_time[i], buf->rpc_user_time[i]);
+		if (buf->rpc_user_rejected && buf->rpc_user_rejected[i])
+			printf(" rejected:%u", buf->rpc_user_rejected[i]);
+		printf("\n");
 
 		xfree(user);
 	}
@@ -240,9 +258,67 @@ static int _print_stats(void)
 		       buf->rpc_dump_hostlist[i]);
 	}
 
+	if (buf->rpc_pool_size > 0)
+		printf("\nQueued RPC statistics by message type\n");
+	for (i = 0; i < buf->rpc_pool_size; i++) {
+		uint64_t ave_wait = 0;
+
+		if (buf->rpc_pool_cnt[i])
+			ave_wait = buf->rpc_pool_wait_time[i] /
+				   buf->rpc_pool_cnt[i];
+		printf("\t%-40s(%5u) threads:%-3u depth:%-4u max_depth:%-4u "
+		       "count:%-6u batches:%-6u ave_wait:%"PRIu64"\n",
+		       rpc_num2string(buf->rpc_pool_type_id[i]),
+		       buf->rpc_pool_type_id[i], buf->rpc_pool_threads[i],
+		       buf->rpc_pool_depth[i], buf->rpc_pool_depth_max[i],
+		       buf->rpc_pool_cnt[i], buf->rpc_pool_batch_cnt[i],
+		       ave_wait);
+	}
+
+	if (buf->msg_compress_time || buf->msg_decompress_time) {
+		printf("\nCompressed messages\n");
+		printf("\tSent:     count:%-6u raw_bytes:%-10"PRIu64" wire_bytes:%-10"PRIu64" ratio:%-6.2f total_time:%"PRIu64"\n",
+		       buf->msg_compress_cnt, buf->msg_compress_raw_bytes,
+		       buf->msg_compress_wire_bytes,
+		       buf->msg_compress_wire_bytes ?
+		       ((double) buf->msg_compress_raw_bytes /
+			buf->msg_compress_wire_bytes) : 0.0,
+		       buf->msg_compress_time);
+		printf("\tReceived: count:%-6u raw_bytes:%-10"PRIu64" wire_bytes:%-10"PRIu64" ratio:%-6.2f total_time:%"PRIu64"\n",
+		       buf->msg_decompress_cnt, buf->msg_decompress_raw_bytes,
+		       buf->msg_decompress_wire_bytes,
+		       buf->msg_decompress_wire_bytes ?
+		       ((double) buf->msg_decompress_raw_bytes /
+			buf->msg_decompress_wire_bytes) : 0.0,
+		       buf->msg_decompress_time);
+	}
+
+	if (buf->list_node_alloc_cnt || buf->list_itr_alloc_cnt) {
+		printf("\nList allocation caches\n");
+		printf("\tNodes:     allocs:%-10"PRIu64" mallocs:%-8"PRIu64" frees:%-8"PRIu64" depot_exchanges:%-8"PRIu64" cached:%u\n",
+		       buf->list_node_alloc_cnt, buf->list_node_malloc_cnt,
+		       buf->list_node_free_cnt, buf->list_node_depot_cnt,
+		       buf->list_node_cached_cnt);
+		printf("\tIterators: allocs:%-10"PRIu64" mallocs:%-8"PRIu64" frees:%-8"PRIu64" depot_exchanges:%-8"PRIu64" cached:%u\n",
+		       buf->list_itr_alloc_cnt, buf->list_itr_malloc_cnt,
+		       buf->list_itr_free_cnt, buf->list_itr_depot_cnt,
+		       buf->list_itr_cached_cnt);
+	}
+
 	return 0;
 }
 
+static void _swap_user_rejected(int i, int j)
+{
+	uint32_t rejected;
+
+	if (!buf->rpc_user_rejected)
+		return;
+	rejected = buf->rpc_user_rejected[i];
+	buf->rpc_user_rejected[i] = buf->rpc_user_rejected[j];
+	buf->rpc_user_rejected[j] = rejected;
+}
+
 static void _sort_rpc(void)
 {
 	int i, j;
@@ -286,6 +362,7 @@ static void _sort_rpc(void)
 				buf->rpc_user_id[j]   = user_id;
 				buf->rpc_user_cnt[j]  = user_cnt;
 				buf->rpc_user_time[j] = user_time;
+				_swap_user_rejected(i, j);
 			}
 			if (buf->rpc_user_cnt[i]) {
 				rpc_user_ave_time[i] = buf->rpc_user_time[i] /
@@ -325,6 +402,7 @@ static void _sort_rpc(void)
 				buf->rpc_user_id[j]   = user_id;
 				buf->rpc_user_cnt[j]  = user_cnt;
 				buf->rpc_user_time[j] = user_time;
+				_swap_user_rejected(i, j);
 			}
 			if (buf->rpc_user_cnt[i]) {
 				rpc_user_ave_time[i] = buf->rpc_user_time[i] /
@@ -378,6 +456,7 @@ static void _sort_rpc(void)
 				buf->rpc_user_id[j]   = user_id;
 				buf->rpc_user_cnt[j]  = user_cnt;
 				buf->rpc_user_time[j] = user_time;
+				_swap_user_rejected(i, j);
 			}
 		}
 	} else { /* sort by count */
@@ -413,6 +492,7 @@ static void _sort_rpc(void)
 				buf->rpc_user_id[j]   = user_id;
 				buf->rpc_user_cnt[j]  = user_cnt;
 				buf->rpc_user_time[j] = user_time;
+				_swap_user_rejected(i, j);
 			}
 			if (buf->rpc_user_cnt[i]) {
 				rpc_user_ave_time[i] = buf->rpc_user_time[i] /
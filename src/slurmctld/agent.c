@@ -86,12 +86,15 @@
 #include "src/common/parse_time.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/slurm_route.h"
 #include "src/common/uid.h"
 #include "src/common/xsignal.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/agent_io.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/locks.h"
@@ -105,6 +108,8 @@
 #define RPC_PACK_MAX_AGE	30	/* Rebuild data over 30 seconds old */
 #define DUMP_RPC_COUNT 		25
 #define HOSTLIST_MAX_SIZE 	80
+#define MULTI_MSG_MAX_CNT	64	/* Requests merged in one RPC, as bits
+					 * of a uint64_t */
 
 typedef enum {
 	DSH_NEW,        /* Request not yet started */
@@ -162,6 +167,13 @@ typedef struct task_info {
 	uint16_t protocol_version;	/* if set, use this version */
 } task_info_t;
 
+typedef struct agent_io_msg {
+	thd_t *thread_ptr;		/* group the message is sent for */
+	char *name;			/* node the message is sent to */
+	slurm_addr_t addr;		/* address of name */
+	hostlist_t fwd_hl;		/* nodes name is to forward it to */
+} agent_io_msg_t;
+
 typedef struct queued_request {
 	agent_arg_t* agent_arg_ptr;	/* The queued request */
 	time_t       first_attempt;	/* Time of first check for batch
@@ -169,12 +181,20 @@ typedef struct queued_request {
 	time_t       last_attempt;	/* Time of last xmit attempt */
 } queued_request_t;
 
+typedef struct multi_msg_node {
+	uint64_t mask;		/* Merged requests to send to the node */
+	int node_inx;		/* Index in node_record_table_ptr */
+} multi_msg_node_t;
+
 typedef struct mail_info {
 	char *user_name;
 	char *message;
 } mail_info_t;
 
+static void _agent_complete(agent_info_t *agent_ptr,
+			    thd_complete_t *thd_comp);
 static void _agent_defer(void);
+static void _agent_io_rpc(agent_info_t *agent_info_ptr);
 static void _agent_retry(int min_wait, bool wait_too);
 static int  _batch_launch_defer(queued_request_t *queued_req_ptr);
 static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr);
@@ -186,11 +206,21 @@ static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx);
 static void _notify_slurmctld_jobs(agent_info_t *agent_ptr);
 static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 		int no_resp_cnt, int retry_cnt);
+static List _multi_msg_find(ListIterator retry_iter,
+			    agent_arg_t *agent_arg_ptr);
+static bool _multi_msg_ok(agent_arg_t *agent_arg_ptr);
+static void _multi_msg_spawn(List arg_list);
+static state_t _process_multi_ret_list(composite_msg_t *multi_msg,
+				       List ret_list);
+static state_t _process_ret_list(slurm_msg_type_t msg_type,
+				 void *msg_args_ptr, List ret_list);
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr);
 static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
 static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			   int *count, int *spot);
 static void _sig_handler(int dummy);
+static bool _srun_agent_msg(slurm_msg_type_t msg_type);
+static void _tally_threads(agent_info_t *agent_ptr, thd_complete_t *thd_comp);
 static void *_thread_per_group_rpc(void *args);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
@@ -224,6 +254,7 @@ static bool pending_mail = false;
 static bool pending_thread_running = false;
 
 static bool run_scheduler    = false;
+static bool multi_msg_enabled = false;
 
 static uint32_t *rpc_stat_counts = NULL, *rpc_stat_types = NULL;
 static uint32_t stat_type_count = 0;
@@ -250,6 +281,7 @@ void *agent(void *args)
 	task_info_t *task_specific_ptr;
 	time_t begin_time;
 	bool spawn_retry_agent = false;
+	bool use_agent_io = agent_io_enabled();
 	int rpc_thread_cnt;
 	static time_t sched_update = 0;
 	static bool reboot_from_ctld = false;
@@ -279,7 +311,11 @@ void *agent(void *args)
 		sched_update = slurm_conf.last_update;
 	}
 
-	rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count, AGENT_THREAD_COUNT);
+	if (use_agent_io)
+		rpc_thread_cnt = 1;
+	else
+		rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count,
+					 AGENT_THREAD_COUNT);
 	while (1) {
 		if (slurmctld_config.shutdown_time ||
 		    ((agent_thread_cnt+rpc_thread_cnt) <= MAX_SERVER_THREADS)) {
@@ -309,6 +345,12 @@ void *agent(void *args)
 	agent_info_ptr = _make_agent_info(agent_arg_ptr);
 	thread_ptr = agent_info_ptr->thread_struct;
 
+	if (use_agent_io) {
+		/* connections are all handled by the agent I/O threads */
+		_agent_io_rpc(agent_info_ptr);
+		goto agent_done;
+	}
+
 	/* start the watchdog thread */
 	slurm_thread_create(&thread_wdog, _wdog, agent_info_ptr);
 
@@ -345,6 +387,7 @@ void *agent(void *args)
 
 	/* Wait for termination of remaining threads */
 	pthread_join(thread_wdog, NULL);
+agent_done:
 	delay = (int) difftime(time(NULL), begin_time);
 	if (delay > (slurm_conf.msg_timeout * 2)) {
 		info("agent msg_type=%u ran for %d seconds",
@@ -561,22 +604,47 @@ static void _update_wdog_state(thd_t *thread_ptr,
 	}
 }
 
+/* Tally the state of every request, call with thread_mutex locked */
+static void _tally_threads(agent_info_t *agent_ptr, thd_complete_t *thd_comp)
+{
+	thd_t *thread_ptr = agent_ptr->thread_struct;
+	ListIterator itr;
+	ret_data_info_t *ret_data_info = NULL;
+	int i;
+
+	thd_comp->work_done   = true;/* assume all threads complete */
+	thd_comp->fail_cnt    = 0;   /* assume no threads failures */
+	thd_comp->no_resp_cnt = 0;   /* assume all threads respond */
+	thd_comp->retry_cnt   = 0;   /* assume no required retries */
+	thd_comp->now         = time(NULL);
+
+	for (i = 0; i < agent_ptr->thread_count; i++) {
+		//info("thread name %s",thread_ptr[i].node_name);
+		if (!thread_ptr[i].ret_list) {
+			_update_wdog_state(&thread_ptr[i],
+					   &thread_ptr[i].state,
+					   thd_comp);
+		} else {
+			itr = list_iterator_create(thread_ptr[i].ret_list);
+			while ((ret_data_info = list_next(itr))) {
+				_update_wdog_state(&thread_ptr[i],
+						   &ret_data_info->err,
+						   thd_comp);
+			}
+			list_iterator_destroy(itr);
+		}
+	}
+}
+
 /*
- * _wdog - Watchdog thread. Send SIGUSR1 to threads which have been active
- *	for too long.
- * IN args - pointer to agent_info_t with info on threads to watch
- * Sleep between polls with exponential times (from 0.005 to 1.0 second)
+ * Notify slurmctld of the results of all requests and free them,
+ * call with thread_mutex locked
  */
-static void *_wdog(void *args)
+static void _agent_complete(agent_info_t *agent_ptr, thd_complete_t *thd_comp)
 {
 	bool srun_agent = false;
-	int i;
-	agent_info_t *agent_ptr = (agent_info_t *) args;
 	thd_t *thread_ptr = agent_ptr->thread_struct;
-	unsigned long usec = 5000;
-	ListIterator itr;
-	thd_complete_t thd_comp;
-	ret_data_info_t *ret_data_info = NULL;
+	int i;
 
 	if ( (agent_ptr->msg_type == SRUN_JOB_COMPLETE)			||
 	     (agent_ptr->msg_type == SRUN_REQUEST_SUSPEND)		||
@@ -591,58 +659,51 @@ static void *_wdog(void *args)
 	     (agent_ptr->msg_type == RESPONSE_HET_JOB_ALLOCATION) )
 		srun_agent = true;
 
+	if (srun_agent) {
+		_notify_slurmctld_jobs(agent_ptr);
+	} else {
+		_notify_slurmctld_nodes(agent_ptr,
+					thd_comp->no_resp_cnt,
+					thd_comp->retry_cnt);
+	}
+
+	for (i = 0; i < agent_ptr->thread_count; i++) {
+		FREE_NULL_LIST(thread_ptr[i].ret_list);
+		xfree(thread_ptr[i].nodelist);
+	}
+
+	if (thd_comp->max_delay)
+		log_flag(AGENT, "%s: agent maximum delay %d seconds",
+			 __func__, thd_comp->max_delay);
+}
+
+/*
+ * _wdog - Watchdog thread. Send SIGUSR1 to threads which have been active
+ *	for too long.
+ * IN args - pointer to agent_info_t with info on threads to watch
+ * Sleep between polls with exponential times (from 0.005 to 1.0 second)
+ */
+static void *_wdog(void *args)
+{
+	agent_info_t *agent_ptr = (agent_info_t *) args;
+	unsigned long usec = 5000;
+	thd_complete_t thd_comp;
+
 	thd_comp.max_delay = 0;
 
 	while (1) {
-		thd_comp.work_done   = true;/* assume all threads complete */
-		thd_comp.fail_cnt    = 0;   /* assume no threads failures */
-		thd_comp.no_resp_cnt = 0;   /* assume all threads respond */
-		thd_comp.retry_cnt   = 0;   /* assume no required retries */
-		thd_comp.now         = time(NULL);
-
 		usleep(usec);
 		usec = MIN((usec * 2), 1000000);
 
 		slurm_mutex_lock(&agent_ptr->thread_mutex);
-		for (i = 0; i < agent_ptr->thread_count; i++) {
-			//info("thread name %s",thread_ptr[i].node_name);
-			if (!thread_ptr[i].ret_list) {
-				_update_wdog_state(&thread_ptr[i],
-						   &thread_ptr[i].state,
-						   &thd_comp);
-			} else {
-				itr = list_iterator_create(
-					thread_ptr[i].ret_list);
-				while ((ret_data_info = list_next(itr))) {
-					_update_wdog_state(&thread_ptr[i],
-							   &ret_data_info->err,
-							   &thd_comp);
-				}
-				list_iterator_destroy(itr);
-			}
-		}
+		_tally_threads(agent_ptr, &thd_comp);
 		if (thd_comp.work_done)
 			break;
 
 		slurm_mutex_unlock(&agent_ptr->thread_mutex);
 	}
 
-	if (srun_agent) {
-		_notify_slurmctld_jobs(agent_ptr);
-	} else {
-		_notify_slurmctld_nodes(agent_ptr,
-					thd_comp.no_resp_cnt,
-					thd_comp.retry_cnt);
-	}
-
-	for (i = 0; i < agent_ptr->thread_count; i++) {
-		FREE_NULL_LIST(thread_ptr[i].ret_list);
-		xfree(thread_ptr[i].nodelist);
-	}
-
-	if (thd_comp.max_delay)
-		log_flag(AGENT, "%s: agent maximum delay %d seconds",
-			 __func__, thd_comp.max_delay);
+	_agent_complete(agent_ptr, &thd_comp);
 
 	slurm_mutex_unlock(&agent_ptr->thread_mutex);
 	return (void *) NULL;
@@ -847,33 +908,33 @@ static int _wif_status(void)
 	return rc;
 }
 
+/* Return true if msg_type is sent to srun rather than slurmd */
+static bool _srun_agent_msg(slurm_msg_type_t msg_type)
+{
+	return ((msg_type == SRUN_PING)			||
+		(msg_type == SRUN_EXEC)			||
+		(msg_type == SRUN_JOB_COMPLETE)		||
+		(msg_type == SRUN_STEP_MISSING)		||
+		(msg_type == SRUN_STEP_SIGNAL)		||
+		(msg_type == SRUN_TIMEOUT)		||
+		(msg_type == SRUN_USER_MSG)		||
+		(msg_type == RESPONSE_RESOURCE_ALLOCATION) ||
+		(msg_type == SRUN_NODE_FAIL));
+}
+
 /*
- * _thread_per_group_rpc - thread to issue an RPC for a group of nodes
- *                         sending message out to one and forwarding it to
- *                         others if necessary.
- * IN/OUT args - pointer to task_info_t, xfree'd on completion
+ * _process_ret_list - handle the responses to an RPC sent to a group of
+ *	nodes, setting the err of each ret_list record to its state_t
+ * RET state of the last response processed
  */
-static void *_thread_per_group_rpc(void *args)
+static state_t _process_ret_list(slurm_msg_type_t msg_type,
+				 void *msg_args_ptr, List ret_list)
 {
 	int rc = SLURM_SUCCESS;
-	slurm_msg_t msg;
-	task_info_t *task_ptr = (task_info_t *) args;
-	/* we cache some pointers from task_info_t because we need
-	 * to xfree args before being finished with their use. xfree
-	 * is required for timely termination of this pthread because
-	 * xfree could lock it at the end, preventing a timely
-	 * thread_exit */
-	pthread_mutex_t *thread_mutex_ptr   = task_ptr->thread_mutex_ptr;
-	pthread_cond_t  *thread_cond_ptr    = task_ptr->thread_cond_ptr;
-	uint32_t        *threads_active_ptr = task_ptr->threads_active_ptr;
-	thd_t           *thread_ptr         = task_ptr->thread_struct_ptr;
 	state_t thread_state = DSH_NO_RESP;
-	slurm_msg_type_t msg_type = task_ptr->msg_type;
 	bool is_kill_msg, srun_agent;
-	List ret_list = NULL;
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
-	int sig_array[2] = {SIGUSR1, 0};
 	/* Locks: Write job, write node */
 	slurmctld_lock_t job_write_lock = {
 		NO_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
@@ -885,100 +946,14 @@ static void *_thread_per_group_rpc(void *args)
 		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 	uint32_t job_id;
 
-	xassert(args != NULL);
-	xsignal(SIGUSR1, _sig_handler);
-	xsignal_unblock(sig_array);
+	if (msg_type == REQUEST_SLURMD_MULT_MSG)
+		return _process_multi_ret_list(msg_args_ptr, ret_list);
+
 	is_kill_msg = (	(msg_type == REQUEST_KILL_TIMELIMIT)	||
 			(msg_type == REQUEST_KILL_PREEMPTED)	||
 			(msg_type == REQUEST_TERMINATE_JOB) );
-	srun_agent = (	(msg_type == SRUN_PING)			||
-			(msg_type == SRUN_EXEC)			||
-			(msg_type == SRUN_JOB_COMPLETE)		||
-			(msg_type == SRUN_STEP_MISSING)		||
-			(msg_type == SRUN_STEP_SIGNAL)		||
-			(msg_type == SRUN_TIMEOUT)		||
-			(msg_type == SRUN_USER_MSG)		||
-			(msg_type == RESPONSE_RESOURCE_ALLOCATION) ||
-			(msg_type == SRUN_NODE_FAIL) );
-
-	thread_ptr->start_time = time(NULL);
-
-	slurm_mutex_lock(thread_mutex_ptr);
-	thread_ptr->state = DSH_ACTIVE;
-	thread_ptr->end_time = thread_ptr->start_time + message_timeout;
-	slurm_mutex_unlock(thread_mutex_ptr);
-
-	/* send request message */
-	slurm_msg_t_init(&msg);
-
-	if (task_ptr->protocol_version)
-		msg.protocol_version = task_ptr->protocol_version;
-
-	msg.msg_type = msg_type;
-	msg.data     = task_ptr->msg_args_ptr;
-
-	log_flag(AGENT, "%s: sending %s to %s",
-		 __func__, rpc_num2string(msg_type), thread_ptr->nodelist);
-
-	if (task_ptr->get_reply) {
-		if (thread_ptr->addr) {
-			msg.address = *thread_ptr->addr;
-
-			if (!(ret_list = slurm_send_addr_recv_msgs(
-				     &msg, thread_ptr->nodelist, 0))) {
-				error("%s: no ret_list given", __func__);
-				goto cleanup;
-			}
-		} else {
-			if (!(ret_list = slurm_send_recv_msgs(
-				     thread_ptr->nodelist, &msg, 0))) {
-				error("%s: no ret_list given", __func__);
-				goto cleanup;
-			}
-		}
-	} else {
-		if (thread_ptr->addr) {
-			//info("got the address");
-			msg.address = *thread_ptr->addr;
-		} else {
-			//info("no address given");
-			if (slurm_conf_get_addr(thread_ptr->nodelist,
-					        &msg.address, msg.flags)
-			    == SLURM_ERROR) {
-				error("%s: can't find address for host %s, check slurm.conf",
-				      __func__, thread_ptr->nodelist);
-				goto cleanup;
-			}
-		}
-		//info("sending %u to %s", msg_type, thread_ptr->nodelist);
-		if (msg_type == SRUN_JOB_COMPLETE) {
-			/*
-			 * The srun runs as a single thread, while the kernel
-			 * listen() may be queuing messages for further
-			 * processing. If we get our SYN in the listen queue
-			 * at the same time the last MESSAGE_TASK_EXIT is being
-			 * processed, srun may exit meaning this message is
-			 * never received, leading to a series of error
-			 * messages from slurm_send_only_node_msg().
-			 * So, we use this different function that blindly
-			 * flings the message out and disregards any
-			 * communication problems that may arise.
-			 */
-			slurm_send_msg_maybe(&msg);
-			thread_state = DSH_DONE;
-		} else if (slurm_send_only_node_msg(&msg) == SLURM_SUCCESS) {
-			thread_state = DSH_DONE;
-		} else {
-			if (!srun_agent) {
-				lock_slurmctld(node_read_lock);
-				_comm_err(thread_ptr->nodelist, msg_type);
-				unlock_slurmctld(node_read_lock);
-			}
-		}
-		goto cleanup;
-	}
+	srun_agent = _srun_agent_msg(msg_type);
 
-	//info("got %d messages back", list_count(ret_list));
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr))) {
 		rc = slurm_get_return_code(ret_data_info->type,
@@ -999,8 +974,7 @@ static void *_thread_per_group_rpc(void *args)
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
 			kill_job_msg_t *kill_job;
-			kill_job = (kill_job_msg_t *)
-				task_ptr->msg_args_ptr;
+			kill_job = (kill_job_msg_t *) msg_args_ptr;
 			rc = SLURM_SUCCESS;
 			lock_slurmctld(job_write_lock);
 			if (job_epilog_complete(kill_job->step_id.job_id,
@@ -1023,8 +997,7 @@ static void *_thread_per_group_rpc(void *args)
 		    (rc != SLURM_SUCCESS) && (rc != ESLURMD_PROLOG_FAILED) &&
 		    (rc != ESLURM_DUPLICATE_JOB_ID) &&
 		    (ret_data_info->type != RESPONSE_FORWARD_FAILED)) {
-			batch_job_launch_msg_t *launch_msg_ptr =
-				task_ptr->msg_args_ptr;
+			batch_job_launch_msg_t *launch_msg_ptr = msg_args_ptr;
 			job_id = launch_msg_ptr->job_id;
 			info("Killing non-startable batch JobId=%u: %s",
 			     job_id, slurm_strerror(rc));
@@ -1041,7 +1014,7 @@ static void *_thread_per_group_rpc(void *args)
 			 * Cancel rather than leave a stray-but-empty job
 			 * behind on the allocated nodes. */
 			resource_allocation_response_msg_t *msg_ptr =
-				task_ptr->msg_args_ptr;
+				msg_args_ptr;
 			job_id = msg_ptr->job_id;
 			info("Killing interactive JobId=%u: %s",
 			     job_id, slurm_strerror(rc));
@@ -1056,7 +1029,7 @@ static void *_thread_per_group_rpc(void *args)
 			/* Communication issue to srun that launched the job
 			 * Cancel rather than leave a stray-but-empty job
 			 * behind on the allocated nodes. */
-			List het_alloc_list = task_ptr->msg_args_ptr;
+			List het_alloc_list = msg_args_ptr;
 			resource_allocation_response_msg_t *msg_ptr;
 			if (!het_alloc_list ||
 			    (list_count(het_alloc_list) == 0))
@@ -1075,8 +1048,7 @@ static void *_thread_per_group_rpc(void *args)
 
 		if (msg_type == REQUEST_SIGNAL_TASKS) {
 			job_record_t *job_ptr;
-			signal_tasks_msg_t *msg_ptr =
-				task_ptr->msg_args_ptr;
+			signal_tasks_msg_t *msg_ptr = msg_args_ptr;
 
 			if ((msg_ptr->signal == SIGCONT) ||
 			    (msg_ptr->signal == SIGSTOP)) {
@@ -1173,77 +1145,567 @@ static void *_thread_per_group_rpc(void *args)
 	}
 	list_iterator_destroy(itr);
 
-cleanup:
-	xfree(args);
-	if (!ret_list && (msg_type == REQUEST_SIGNAL_TASKS)) {
-		job_record_t *job_ptr;
-		signal_tasks_msg_t *msg_ptr =
-			task_ptr->msg_args_ptr;
-		if ((msg_ptr->signal == SIGCONT) ||
-		    (msg_ptr->signal == SIGSTOP)) {
-			job_id = msg_ptr->step_id.job_id;
-			lock_slurmctld(job_write_lock);
-			job_ptr = find_job_record(job_id);
-			if (job_ptr)
-				job_ptr->job_state &= ~JOB_SIGNALING;
-			unlock_slurmctld(job_write_lock);
-		}
-	}
-	/* handled at end of thread just in case resend is needed */
-	destroy_forward(&msg.forward);
-	slurm_mutex_lock(thread_mutex_ptr);
-	thread_ptr->ret_list = ret_list;
-	thread_ptr->state = thread_state;
-	thread_ptr->end_time = (time_t) difftime(time(NULL),
-						 thread_ptr->start_time);
-	/* Signal completion so another thread can replace us */
-	(*threads_active_ptr)--;
-	slurm_cond_signal(thread_cond_ptr);
-	slurm_mutex_unlock(thread_mutex_ptr);
-	return (void *) NULL;
+	return thread_state;
 }
 
-/*
- * Signal handler.  We are really interested in interrupting hung communictions
- * and causing them to return EINTR. Multiple interrupts might be required.
- */
-static void _sig_handler(int dummy)
+static int _find_msg_index(void *x, void *key)
 {
+	slurm_msg_t *msg = x;
+	uint16_t *msg_index = key;
+
+	return (msg->msg_index == *msg_index);
 }
 
-static int _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
-			  int *count, int *spot)
+/*
+ * _process_multi_ret_list - handle the responses to a REQUEST_SLURMD_MULT_MSG
+ *	by processing the responses to each merged request as if it had been
+ *	sent on its own. The state of a node is the worst of its states for
+ *	every request.
+ * RET state of the last node processed
+ */
+static state_t _process_multi_ret_list(composite_msg_t *multi_msg,
+				       List ret_list)
 {
-#ifdef HAVE_FRONT_END
-	front_end_record_t *node_ptr;
-#else
-	node_record_t *node_ptr;
-#endif
-	ret_data_info_t *ret_data_info = NULL;
-	ListIterator itr;
-	int rc = 0;
+	int sub_cnt = list_count(multi_msg->msg_list);
+	int node_cnt = list_count(ret_list);
+	ret_data_info_t *sub_info, *info, *ret_data_info;
+	state_t thread_state = DSH_NO_RESP;
+	composite_msg_t *resp;
+	slurm_msg_t *sub_msg, *resp_msg;
+	ListIterator itr, sub_itr;
+	List sub_list;
+	uint16_t msg_index;
+	int i, j;
 
-	itr = list_iterator_create(thread_ptr->ret_list);
+	/* Responses of node j to request i, pointing into ret_list data */
+	sub_info = xcalloc(sub_cnt * node_cnt, sizeof(ret_data_info_t));
+	j = 0;
+	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr))) {
-		log_flag(AGENT, "%s: got err of %d",
-			 __func__, ret_data_info->err);
-		if (ret_data_info->err != DSH_NO_RESP)
-			continue;
-
-#ifdef HAVE_FRONT_END
-		node_ptr = find_front_end_record(ret_data_info->node_name);
-#else
-		node_ptr = find_node_record(ret_data_info->node_name);
-#endif
-		if (node_ptr &&
-		    (IS_NODE_DOWN(node_ptr) || IS_NODE_POWER_SAVE(node_ptr))) {
-			--(*count);
-		} else if (agent_arg_ptr) {
-			debug("%s: got the name %s to resend out of %d",
-			      __func__, ret_data_info->node_name, *count);
-			hostlist_push_host(agent_arg_ptr->hostlist,
-				      ret_data_info->node_name);
-			++(*spot);
+		resp = NULL;
+		if (ret_data_info->type == RESPONSE_SLURMD_MULT_MSG)
+			resp = ret_data_info->data;
+		for (i = 0; i < sub_cnt; i++) {
+			info = &sub_info[(i * node_cnt) + j];
+			info->node_name = ret_data_info->node_name;
+			msg_index = i + 1;
+			if (!resp) {
+				/* failed as a whole, e.g. not forwarded */
+				info->type = ret_data_info->type;
+				info->data = ret_data_info->data;
+				info->err = ret_data_info->err;
+			} else if ((resp_msg = list_find_first(resp->msg_list,
+							       _find_msg_index,
+							       &msg_index))) {
+				info->type = resp_msg->msg_type;
+				info->data = resp_msg->data;
+			} else {
+				info->type = RESPONSE_FORWARD_FAILED;
+				info->err = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+			}
+		}
+		j++;
+	}
+
+	i = 0;
+	sub_itr = list_iterator_create(multi_msg->msg_list);
+	while ((sub_msg = list_next(sub_itr))) {
+		sub_list = list_create(NULL);
+		for (j = 0; j < node_cnt; j++)
+			list_append(sub_list, &sub_info[(i * node_cnt) + j]);
+		(void) _process_ret_list(sub_msg->msg_type, sub_msg->data,
+					 sub_list);
+		FREE_NULL_LIST(sub_list);
+		i++;
+	}
+	list_iterator_destroy(sub_itr);
+
+	/* DSH_DONE < DSH_NO_RESP < DSH_FAILED < DSH_DUP_JOBID */
+	j = 0;
+	list_iterator_reset(itr);
+	while ((ret_data_info = list_next(itr))) {
+		thread_state = DSH_DONE;
+		for (i = 0; i < sub_cnt; i++)
+			thread_state = MAX(thread_state,
+					   sub_info[(i * node_cnt) + j].err);
+		ret_data_info->err = thread_state;
+		j++;
+	}
+	list_iterator_destroy(itr);
+	xfree(sub_info);
+
+	return thread_state;
+}
+
+/*
+ * _thread_per_group_rpc - thread to issue an RPC for a group of nodes
+ *                         sending message out to one and forwarding it to
+ *                         others if necessary.
+ * IN/OUT args - pointer to task_info_t, xfree'd on completion
+ */
+static void *_thread_per_group_rpc(void *args)
+{
+	slurm_msg_t msg;
+	task_info_t *task_ptr = (task_info_t *) args;
+	/* we cache some pointers from task_info_t because we need
+	 * to xfree args before being finished with their use. xfree
+	 * is required for timely termination of this pthread because
+	 * xfree could lock it at the end, preventing a timely
+	 * thread_exit */
+	pthread_mutex_t *thread_mutex_ptr   = task_ptr->thread_mutex_ptr;
+	pthread_cond_t  *thread_cond_ptr    = task_ptr->thread_cond_ptr;
+	uint32_t        *threads_active_ptr = task_ptr->threads_active_ptr;
+	thd_t           *thread_ptr         = task_ptr->thread_struct_ptr;
+	state_t thread_state = DSH_NO_RESP;
+	slurm_msg_type_t msg_type = task_ptr->msg_type;
+	List ret_list = NULL;
+	int sig_array[2] = {SIGUSR1, 0};
+	/* Locks: Write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		NO_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+	/* Lock: Read node */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
+	uint32_t job_id;
+
+	xassert(args != NULL);
+	xsignal(SIGUSR1, _sig_handler);
+	xsignal_unblock(sig_array);
+
+	thread_ptr->start_time = time(NULL);
+
+	slurm_mutex_lock(thread_mutex_ptr);
+	thread_ptr->state = DSH_ACTIVE;
+	thread_ptr->end_time = thread_ptr->start_time + message_timeout;
+	slurm_mutex_unlock(thread_mutex_ptr);
+
+	/* send request message */
+	slurm_msg_t_init(&msg);
+
+	if (task_ptr->protocol_version)
+		msg.protocol_version = task_ptr->protocol_version;
+
+	msg.msg_type = msg_type;
+	msg.data     = task_ptr->msg_args_ptr;
+
+	log_flag(AGENT, "%s: sending %s to %s",
+		 __func__, rpc_num2string(msg_type), thread_ptr->nodelist);
+
+	if (task_ptr->get_reply) {
+		if (thread_ptr->addr) {
+			msg.address = *thread_ptr->addr;
+
+			if (!(ret_list = slurm_send_addr_recv_msgs(
+				     &msg, thread_ptr->nodelist, 0))) {
+				error("%s: no ret_list given", __func__);
+				goto cleanup;
+			}
+		} else {
+			if (!(ret_list = slurm_send_recv_msgs(
+				     thread_ptr->nodelist, &msg, 0))) {
+				error("%s: no ret_list given", __func__);
+				goto cleanup;
+			}
+		}
+	} else {
+		if (thread_ptr->addr) {
+			//info("got the address");
+			msg.address = *thread_ptr->addr;
+		} else {
+			//info("no address given");
+			if (slurm_conf_get_addr(thread_ptr->nodelist,
+					        &msg.address, msg.flags)
+			    == SLURM_ERROR) {
+				error("%s: can't find address for host %s, check slurm.conf",
+				      __func__, thread_ptr->nodelist);
+				goto cleanup;
+			}
+		}
+		//info("sending %u to %s", msg_type, thread_ptr->nodelist);
+		if (msg_type == SRUN_JOB_COMPLETE) {
+			/*
+			 * The srun runs as a single thread, while the kernel
+			 * listen() may be queuing messages for further
+			 * processing. If we get our SYN in the listen queue
+			 * at the same time the last MESSAGE_TASK_EXIT is being
+			 * processed, srun may exit meaning this message is
+			 * never received, leading to a series of error
+			 * messages from slurm_send_only_node_msg().
+			 * So, we use this different function that blindly
+			 * flings the message out and disregards any
+			 * communication problems that may arise.
+			 */
+			slurm_send_msg_maybe(&msg);
+			thread_state = DSH_DONE;
+		} else if (slurm_send_only_node_msg(&msg) == SLURM_SUCCESS) {
+			thread_state = DSH_DONE;
+		} else {
+			if (!_srun_agent_msg(msg_type)) {
+				lock_slurmctld(node_read_lock);
+				_comm_err(thread_ptr->nodelist, msg_type);
+				unlock_slurmctld(node_read_lock);
+			}
+		}
+		goto cleanup;
+	}
+
+	//info("got %d messages back", list_count(ret_list));
+	thread_state = _process_ret_list(msg_type, task_ptr->msg_args_ptr,
+					 ret_list);
+
+cleanup:
+	xfree(args);
+	if (!ret_list && (msg_type == REQUEST_SIGNAL_TASKS)) {
+		job_record_t *job_ptr;
+		signal_tasks_msg_t *msg_ptr =
+			task_ptr->msg_args_ptr;
+		if ((msg_ptr->signal == SIGCONT) ||
+		    (msg_ptr->signal == SIGSTOP)) {
+			job_id = msg_ptr->step_id.job_id;
+			lock_slurmctld(job_write_lock);
+			job_ptr = find_job_record(job_id);
+			if (job_ptr)
+				job_ptr->job_state &= ~JOB_SIGNALING;
+			unlock_slurmctld(job_write_lock);
+		}
+	}
+	/* handled at end of thread just in case resend is needed */
+	destroy_forward(&msg.forward);
+	slurm_mutex_lock(thread_mutex_ptr);
+	thread_ptr->ret_list = ret_list;
+	thread_ptr->state = thread_state;
+	thread_ptr->end_time = (time_t) difftime(time(NULL),
+						 thread_ptr->start_time);
+	/* Signal completion so another thread can replace us */
+	(*threads_active_ptr)--;
+	slurm_cond_signal(thread_cond_ptr);
+	slurm_mutex_unlock(thread_mutex_ptr);
+	return (void *) NULL;
+}
+
+/*
+ * Signal handler.  We are really interested in interrupting hung communictions
+ * and causing them to return EINTR. Multiple interrupts might be required.
+ */
+static void _sig_handler(int dummy)
+{
+}
+
+static void _agent_io_msg_free(void *x)
+{
+	agent_io_msg_t *io_msg = x;
+
+	if (io_msg->fwd_hl)
+		hostlist_destroy(io_msg->fwd_hl);
+	xfree(io_msg->name);
+	xfree(io_msg);
+}
+
+/*
+ * Queue the RPC of a group for the first node of hl with a known address,
+ * to be forwarded by it to the rest of hl as start_msg_tree() would.
+ * hl is consumed.
+ */
+static void _agent_io_queue(List msg_list, thd_t *thread_ptr, hostlist_t hl)
+{
+	agent_io_msg_t *io_msg;
+	slurm_addr_t addr;
+	char *name;
+
+	while ((name = hostlist_shift(hl))) {
+		if (slurm_conf_get_addr(name, &addr, 0) != SLURM_ERROR)
+			break;
+		error("%s: can't find address for host %s, check slurm.conf",
+		      __func__, name);
+		mark_as_failed_forward(&thread_ptr->ret_list, name,
+				       SLURM_UNKNOWN_FORWARD_ADDR);
+		free(name);
+	}
+	if (!name) {
+		hostlist_destroy(hl);
+		return;
+	}
+
+	io_msg = xmalloc(sizeof(*io_msg));
+	io_msg->thread_ptr = thread_ptr;
+	io_msg->name = xstrdup(name);
+	io_msg->addr = addr;
+	io_msg->fwd_hl = hl;
+	list_append(msg_list, io_msg);
+	free(name);
+}
+
+/*
+ * Record the result of an RPC sent through agent_io. If the node failed to
+ * forward it, queue it to be sent directly to each node it did not reach as
+ * _fwd_tree_thread() would.
+ */
+static void _agent_io_result(agent_info_t *agent_info_ptr,
+			     agent_io_msg_t *io_msg, agent_io_req_t *req,
+			     List next_list)
+{
+	thd_t *thread_ptr = io_msg->thread_ptr;
+	List ret_list = NULL;
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	bool conn_err = false;
+	int fwd_cnt = 0, ret_cnt;
+	char *name;
+	/* Lock: Read node */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!agent_info_ptr->get_reply) {
+		/* see slurm_send_msg_maybe() use in _thread_per_group_rpc() */
+		if ((req->rc == SLURM_SUCCESS) ||
+		    (agent_info_ptr->msg_type == SRUN_JOB_COMPLETE)) {
+			thread_ptr->state = DSH_DONE;
+		} else if (!_srun_agent_msg(agent_info_ptr->msg_type)) {
+			errno = req->rc;
+			lock_slurmctld(node_read_lock);
+			_comm_err(thread_ptr->nodelist,
+				  agent_info_ptr->msg_type);
+			unlock_slurmctld(node_read_lock);
+		}
+		return;
+	}
+
+	if (io_msg->fwd_hl)
+		fwd_cnt = hostlist_count(io_msg->fwd_hl);
+
+	if (req->rc != SLURM_SUCCESS) {
+		mark_as_failed_forward(&ret_list, io_msg->name, req->rc);
+		conn_err = true;
+	} else if (!(ret_list = slurm_unpack_received_msgs(req->reply,
+							    req->reply_size,
+							    -1))) {
+		mark_as_failed_forward(&ret_list, io_msg->name, errno);
+		conn_err = true;
+	} else {
+		itr = list_iterator_create(ret_list);
+		while ((ret_data_info = list_next(itr))) {
+			if (!ret_data_info->node_name)
+				ret_data_info->node_name =
+					xstrdup(io_msg->name);
+		}
+		list_iterator_destroy(itr);
+	}
+	req->reply = NULL;	/* xfree'd by slurm_unpack_received_msgs() */
+
+	ret_cnt = list_count(ret_list);
+	if ((ret_cnt <= fwd_cnt) && !conn_err) {
+		error("%s: %s failed to forward the message, expecting %d ret got only %d",
+		      __func__, io_msg->name, fwd_cnt + 1, ret_cnt);
+		if (ret_cnt > 1) { /* not likely */
+			itr = list_iterator_create(ret_list);
+			while ((ret_data_info = list_next(itr))) {
+				if (xstrcmp(ret_data_info->node_name,
+					    io_msg->name))
+					hostlist_delete_host(
+						io_msg->fwd_hl,
+						ret_data_info->node_name);
+			}
+			list_iterator_destroy(itr);
+		}
+	}
+
+	if (!thread_ptr->ret_list)
+		thread_ptr->ret_list = list_create(destroy_data_info);
+	list_transfer(thread_ptr->ret_list, ret_list);
+	FREE_NULL_LIST(ret_list);
+
+	if (ret_cnt <= fwd_cnt) {
+		/*
+		 * Abandon tree. This way if all the nodes in the branch are
+		 * down we don't have to time out for each node serially.
+		 */
+		while ((name = hostlist_shift(io_msg->fwd_hl))) {
+			_agent_io_queue(next_list, thread_ptr,
+					hostlist_create(name));
+			free(name);
+		}
+	}
+}
+
+/*
+ * Send one round of RPCs through agent_io and record their results
+ * RET list of agent_io_msg_t to send in the next round
+ */
+static List _agent_io_send(agent_info_t *agent_info_ptr, List msg_list)
+{
+	int cnt = list_count(msg_list), req_cnt = 0, steps = 0;
+	agent_io_req_t *reqs = xcalloc(cnt, sizeof(*reqs));
+	agent_io_msg_t **io_msgs = xcalloc(cnt, sizeof(*io_msgs));
+	Buf *buffers = xcalloc(cnt, sizeof(*buffers));
+	List next_list = list_create(_agent_io_msg_free);
+	agent_io_msg_t *io_msg;
+	agent_io_req_t fail_req;
+	slurm_msg_t msg;
+
+	while ((io_msg = list_pop(msg_list))) {
+		slurm_msg_t_init(&msg);
+		if (agent_info_ptr->protocol_version)
+			msg.protocol_version = agent_info_ptr->protocol_version;
+		msg.msg_type = agent_info_ptr->msg_type;
+		msg.data = *agent_info_ptr->msg_args_pptr;
+		if (io_msg->fwd_hl &&
+		    (msg.forward.cnt = hostlist_count(io_msg->fwd_hl))) {
+			msg.forward.nodelist =
+				hostlist_ranged_string_xmalloc(io_msg->fwd_hl);
+			debug3("Tree sending to %s along with %s",
+			       io_msg->name, msg.forward.nodelist);
+		}
+
+		reqs[req_cnt].timeout = slurm_msg_recv_timeout(&msg, 0, &steps);
+		buffers[req_cnt] = slurm_pack_node_msg(&msg);
+		xfree(msg.forward.nodelist);
+		if (!buffers[req_cnt]) {
+			memset(&fail_req, 0, sizeof(fail_req));
+			fail_req.rc = errno;
+			_agent_io_result(agent_info_ptr, io_msg, &fail_req,
+					 next_list);
+			_agent_io_msg_free(io_msg);
+			continue;
+		}
+
+		reqs[req_cnt].addr = io_msg->addr;
+		reqs[req_cnt].data = get_buf_data(buffers[req_cnt]);
+		reqs[req_cnt].size = get_buf_offset(buffers[req_cnt]);
+		reqs[req_cnt].get_reply = agent_info_ptr->get_reply;
+		io_msgs[req_cnt++] = io_msg;
+	}
+
+	agent_io_run(reqs, req_cnt);
+
+	for (int i = 0; i < req_cnt; i++) {
+		_agent_io_result(agent_info_ptr, io_msgs[i], &reqs[i],
+				 next_list);
+		xfree(reqs[i].reply);
+		free_buf(buffers[i]);
+		_agent_io_msg_free(io_msgs[i]);
+	}
+	xfree(buffers);
+	xfree(io_msgs);
+	xfree(reqs);
+
+	return next_list;
+}
+
+/*
+ * _agent_io_rpc - issue the RPC of an agent to every group of nodes through
+ *	the agent I/O threads, then notify slurmctld of the results as _wdog()
+ *	does for _thread_per_group_rpc(). Runs in the agent's own thread.
+ */
+static void _agent_io_rpc(agent_info_t *agent_info_ptr)
+{
+	thd_t *thread_ptr = agent_info_ptr->thread_struct;
+	List msg_list = list_create(_agent_io_msg_free), next_list;
+	thd_complete_t thd_comp;
+	agent_io_msg_t *io_msg;
+	hostlist_t hl, *sp_hl;
+	int i, j, hl_count = 0;
+
+	for (i = 0; i < agent_info_ptr->thread_count; i++) {
+		thread_ptr[i].start_time = time(NULL);
+		thread_ptr[i].state = DSH_NO_RESP;
+
+		log_flag(AGENT, "%s: sending %s to %s",
+			 __func__, rpc_num2string(agent_info_ptr->msg_type),
+			 thread_ptr[i].nodelist);
+
+		if (thread_ptr[i].addr || !agent_info_ptr->get_reply) {
+			/* one node per group, no forwarding */
+			io_msg = xmalloc(sizeof(*io_msg));
+			io_msg->thread_ptr = &thread_ptr[i];
+			io_msg->name = xstrdup(thread_ptr[i].nodelist);
+			if (thread_ptr[i].addr) {
+				io_msg->addr = *thread_ptr[i].addr;
+			} else if (slurm_conf_get_addr(thread_ptr[i].nodelist,
+						       &io_msg->addr, 0) ==
+				   SLURM_ERROR) {
+				error("%s: can't find address for host %s, check slurm.conf",
+				      __func__, thread_ptr[i].nodelist);
+				_agent_io_msg_free(io_msg);
+				continue;
+			}
+			list_append(msg_list, io_msg);
+			continue;
+		}
+
+		hl = hostlist_create(thread_ptr[i].nodelist);
+		hostlist_uniq(hl);
+		if (route_g_split_hostlist(hl, &sp_hl, &hl_count, 0)) {
+			error("unable to split forward hostlist");
+			hostlist_destroy(hl);
+			continue;
+		}
+		for (j = 0; j < hl_count; j++)
+			_agent_io_queue(msg_list, &thread_ptr[i], sp_hl[j]);
+		xfree(sp_hl);
+		hostlist_destroy(hl);
+	}
+
+	while (list_count(msg_list)) {
+		next_list = _agent_io_send(agent_info_ptr, msg_list);
+		FREE_NULL_LIST(msg_list);
+		msg_list = next_list;
+	}
+	FREE_NULL_LIST(msg_list);
+
+	for (i = 0; i < agent_info_ptr->thread_count; i++) {
+		if (agent_info_ptr->get_reply) {
+			if (!thread_ptr[i].ret_list)
+				error("%s: no ret_list given", __func__);
+			else
+				thread_ptr[i].state = _process_ret_list(
+					agent_info_ptr->msg_type,
+					*agent_info_ptr->msg_args_pptr,
+					thread_ptr[i].ret_list);
+		}
+		thread_ptr[i].end_time =
+			(time_t) difftime(time(NULL), thread_ptr[i].start_time);
+	}
+
+	slurm_mutex_lock(&agent_info_ptr->thread_mutex);
+	thd_comp.max_delay = 0;
+	_tally_threads(agent_info_ptr, &thd_comp);
+	_agent_complete(agent_info_ptr, &thd_comp);
+	slurm_mutex_unlock(&agent_info_ptr->thread_mutex);
+}
+
+static int _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
+			  int *count, int *spot)
+{
+#ifdef HAVE_FRONT_END
+	front_end_record_t *node_ptr;
+#else
+	node_record_t *node_ptr;
+#endif
+	ret_data_info_t *ret_data_info = NULL;
+	ListIterator itr;
+	int rc = 0;
+
+	itr = list_iterator_create(thread_ptr->ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		log_flag(AGENT, "%s: got err of %d",
+			 __func__, ret_data_info->err);
+		if (ret_data_info->err != DSH_NO_RESP)
+			continue;
+
+#ifdef HAVE_FRONT_END
+		node_ptr = find_front_end_record(ret_data_info->node_name);
+#else
+		node_ptr = find_node_record(ret_data_info->node_name);
+#endif
+		if (node_ptr &&
+		    (IS_NODE_DOWN(node_ptr) || IS_NODE_POWER_SAVE(node_ptr))) {
+			--(*count);
+		} else if (agent_arg_ptr) {
+			debug("%s: got the name %s to resend out of %d",
+			      __func__, ret_data_info->node_name, *count);
+			hostlist_push_host(agent_arg_ptr->hostlist,
+				      ret_data_info->node_name);
+			++(*spot);
 		}
 
 		if (*spot == *count) {
@@ -1403,6 +1865,8 @@ static void *_agent_init(void *arg)
 
 extern void agent_init(void)
 {
+	agent_io_init();
+
 	slurm_mutex_lock(&pending_mutex);
 	if (pending_thread_running) {
 		error("%s: thread already running", __func__);
@@ -1568,6 +2032,286 @@ static void _agent_defer(void)
 	return;
 }
 
+/*
+ * Return true if a queued request can be merged with others for the same
+ * nodes into a REQUEST_SLURMD_MULT_MSG
+ */
+static bool _multi_msg_ok(agent_arg_t *agent_arg_ptr)
+{
+#ifdef HAVE_FRONT_END
+	return false;
+#else
+	signal_tasks_msg_t *signal_msg_ptr;
+
+	if (!agent_arg_ptr || agent_arg_ptr->addr || !agent_arg_ptr->msg_args)
+		return false;
+	/* Nodes of unknown or older versions may not unpack it */
+	if (agent_arg_ptr->protocol_version < SLURM_20_11_PROTOCOL_VERSION)
+		return false;
+
+	switch (agent_arg_ptr->msg_type) {
+	case REQUEST_ABORT_JOB:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+	case REQUEST_TERMINATE_JOB:
+		return true;
+	case REQUEST_SIGNAL_TASKS:
+		/* job state is updated when these fail to be sent at all */
+		signal_msg_ptr = agent_arg_ptr->msg_args;
+		return ((signal_msg_ptr->signal != SIGCONT) &&
+			(signal_msg_ptr->signal != SIGSTOP));
+	default:
+		return false;
+	}
+#endif
+}
+
+/*
+ * Remove from retry_list the new requests following the position of
+ * retry_iter that can be merged with agent_arg_ptr.
+ * Call with retry_mutex locked.
+ * RET list of agent_arg_t, NULL if none found
+ */
+static List _multi_msg_find(ListIterator retry_iter,
+			    agent_arg_t *agent_arg_ptr)
+{
+	queued_request_t *queued_req_ptr;
+	agent_arg_t *next_arg_ptr;
+	List arg_list = NULL;
+	int cnt = 1;
+
+	while ((cnt < MULTI_MSG_MAX_CNT) &&
+	       (queued_req_ptr = list_next(retry_iter))) {
+		next_arg_ptr = queued_req_ptr->agent_arg_ptr;
+		if (queued_req_ptr->last_attempt ||
+		    !_multi_msg_ok(next_arg_ptr) ||
+		    (next_arg_ptr->retry != agent_arg_ptr->retry) ||
+		    (next_arg_ptr->protocol_version !=
+		     agent_arg_ptr->protocol_version))
+			continue;
+		list_remove(retry_iter);
+		xfree(queued_req_ptr);
+		if (!arg_list)
+			arg_list = list_create(NULL);
+		list_append(arg_list, next_arg_ptr);
+		cnt++;
+	}
+
+	return arg_list;
+}
+
+/* Copy the arguments of an RPC by packing and unpacking them */
+static void *_dup_msg_args(slurm_msg_type_t msg_type, void *msg_args)
+{
+	slurm_msg_t msg;
+	Buf buffer = init_buf(BUF_SIZE);
+	void *dup_args = NULL;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = msg_type;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data = msg_args;
+	if (pack_msg(&msg, buffer) == SLURM_SUCCESS) {
+		set_buf_offset(buffer, 0);
+		if (unpack_msg(&msg, buffer) == SLURM_SUCCESS)
+			dup_args = msg.data;
+	}
+	free_buf(buffer);
+
+	if (!dup_args)
+		error("%s: unable to copy %s", __func__,
+		      rpc_num2string(msg_type));
+	return dup_args;
+}
+
+/*
+ * Return the arguments of a merged request for one more set of nodes. The
+ * last set to use them gets the original.
+ */
+static void *_multi_msg_args(agent_arg_t *agent_arg_ptr, int *uses)
+{
+	void *msg_args;
+
+	if (--(*uses) > 0)
+		return _dup_msg_args(agent_arg_ptr->msg_type,
+				     agent_arg_ptr->msg_args);
+
+	msg_args = agent_arg_ptr->msg_args;
+	agent_arg_ptr->msg_args = NULL;
+	return msg_args;
+}
+
+static int _cmp_multi_msg_node(const void *x, const void *y)
+{
+	const multi_msg_node_t *node1 = x, *node2 = y;
+
+	if (node1->mask < node2->mask)
+		return -1;
+	if (node1->mask > node2->mask)
+		return 1;
+	return node1->node_inx - node2->node_inx;
+}
+
+/*
+ * Build the agent request for a set of nodes receiving the merged requests
+ * in mask. A single request is sent as is, more are sent as one
+ * REQUEST_SLURMD_MULT_MSG so every slurmd gets one connection and one
+ * credential for all of them.
+ */
+static agent_arg_t *_multi_msg_build(agent_arg_t **args, int *uses,
+				     uint64_t mask, hostlist_t hl)
+{
+	agent_arg_t *set_arg_ptr = xmalloc(sizeof(agent_arg_t));
+	composite_msg_t *multi_msg = NULL;
+	slurm_msg_t *sub_msg;
+	int i;
+
+	set_arg_ptr->hostlist = hl;
+	set_arg_ptr->node_count = hostlist_count(hl);
+
+	for (i = 0; i < MULTI_MSG_MAX_CNT; i++) {
+		if (!(mask & ((uint64_t) 1 << i)))
+			continue;
+		set_arg_ptr->retry = args[i]->retry;
+		set_arg_ptr->protocol_version = args[i]->protocol_version;
+		if (mask == ((uint64_t) 1 << i)) {
+			set_arg_ptr->msg_type = args[i]->msg_type;
+			set_arg_ptr->msg_args = _multi_msg_args(args[i],
+								&uses[i]);
+			break;
+		}
+		if (!multi_msg) {
+			multi_msg = xmalloc(sizeof(composite_msg_t));
+			multi_msg->msg_list =
+				list_create(slurm_free_comp_msg_list);
+			set_arg_ptr->msg_type = REQUEST_SLURMD_MULT_MSG;
+			set_arg_ptr->msg_args = multi_msg;
+		}
+		sub_msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(sub_msg);
+		sub_msg->msg_type = args[i]->msg_type;
+		if (!(sub_msg->data = _multi_msg_args(args[i], &uses[i]))) {
+			xfree(sub_msg);
+			continue;
+		}
+		list_append(multi_msg->msg_list, sub_msg);
+		sub_msg->msg_index = list_count(multi_msg->msg_list);
+	}
+
+	if (!set_arg_ptr->msg_args ||
+	    (multi_msg && !list_count(multi_msg->msg_list))) {
+		_purge_agent_args(set_arg_ptr);
+		return NULL;
+	}
+	return set_arg_ptr;
+}
+
+/*
+ * Split the requests of arg_list per node, then spawn one agent for each set
+ * of nodes to receive the same requests. Forwarding still works among the
+ * nodes of a set. The requests are consumed and arg_list emptied.
+ */
+static void _multi_msg_spawn(List arg_list)
+{
+	int arg_cnt = list_count(arg_list), node_cnt = 0, set_cnt = 0;
+	agent_arg_t **args = xcalloc(MULTI_MSG_MAX_CNT, sizeof(agent_arg_t *));
+	int *uses = xcalloc(MULTI_MSG_MAX_CNT, sizeof(int));
+	uint64_t *node_mask = xcalloc(node_record_count, sizeof(uint64_t));
+	multi_msg_node_t *nodes;
+	List spawn_list = list_create(NULL);
+	agent_arg_t *agent_arg_ptr;
+	hostlist_iterator_t hl_itr;
+	hostlist_t hl = NULL;
+	node_record_t *node_ptr;
+	char *name;
+	int i, j;
+	/* Locks: Read node */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
+
+	xassert(arg_cnt <= MULTI_MSG_MAX_CNT);
+
+	lock_slurmctld(node_read_lock);
+	for (i = 0; i < arg_cnt; i++) {
+		args[i] = list_pop(arg_list);
+		hl_itr = hostlist_iterator_create(args[i]->hostlist);
+		while ((name = hostlist_next(hl_itr))) {
+			node_ptr = find_node_record(name);
+			free(name);
+			if (!node_ptr)
+				break;
+		}
+		hostlist_iterator_destroy(hl_itr);
+		if (name) {
+			/* let agent() report the invalid node name */
+			list_append(spawn_list, args[i]);
+			args[i] = NULL;
+			continue;
+		}
+
+		hl_itr = hostlist_iterator_create(args[i]->hostlist);
+		while ((name = hostlist_next(hl_itr))) {
+			node_ptr = find_node_record(name);
+			node_mask[node_ptr - node_record_table_ptr] |=
+				((uint64_t) 1 << i);
+			free(name);
+		}
+		hostlist_iterator_destroy(hl_itr);
+	}
+
+	nodes = xcalloc(node_record_count, sizeof(multi_msg_node_t));
+	for (i = 0; i < node_record_count; i++) {
+		if (!node_mask[i])
+			continue;
+		nodes[node_cnt].mask = node_mask[i];
+		nodes[node_cnt].node_inx = i;
+		node_cnt++;
+	}
+	qsort(nodes, node_cnt, sizeof(multi_msg_node_t), _cmp_multi_msg_node);
+
+	/* Count how many sets of nodes use each request */
+	for (i = 0; i < node_cnt; i++) {
+		if (i && (nodes[i].mask == nodes[i - 1].mask))
+			continue;
+		for (j = 0; j < arg_cnt; j++) {
+			if (nodes[i].mask & ((uint64_t) 1 << j))
+				uses[j]++;
+		}
+	}
+
+	for (i = 0; i < node_cnt; i++) {
+		if (!hl)
+			hl = hostlist_create(NULL);
+		hostlist_push_host(hl,
+				   node_record_table_ptr[nodes[i].node_inx].name);
+		if (((i + 1) < node_cnt) &&
+		    (nodes[i + 1].mask == nodes[i].mask))
+			continue;
+		if ((agent_arg_ptr = _multi_msg_build(args, uses,
+						      nodes[i].mask, hl)))
+			list_append(spawn_list, agent_arg_ptr);
+		hl = NULL;
+		set_cnt++;
+	}
+	unlock_slurmctld(node_read_lock);
+
+	log_flag(AGENT, "%s: sending %d requests to %d nodes in %d sets",
+		 __func__, arg_cnt, node_cnt, set_cnt);
+
+	for (i = 0; i < arg_cnt; i++)
+		_purge_agent_args(args[i]);
+	while ((agent_arg_ptr = list_pop(spawn_list))) {
+		debug2("Spawning RPC agent for msg_type %s",
+		       rpc_num2string(agent_arg_ptr->msg_type));
+		slurm_thread_create_detached(NULL, agent, agent_arg_ptr);
+	}
+	FREE_NULL_LIST(spawn_list);
+	xfree(nodes);
+	xfree(node_mask);
+	xfree(uses);
+	xfree(args);
+}
+
 /* Do the work requested by agent_retry (retry pending RPCs).
  * This is a separate thread so the job records can be locked */
 static void _agent_retry(int min_wait, bool mail_too)
@@ -1577,6 +2321,14 @@ static void _agent_retry(int min_wait, bool mail_too)
 	agent_arg_t *agent_arg_ptr = NULL;
 	ListIterator retry_iter;
 	mail_info_t *mi = NULL;
+	List multi_list = NULL;
+	static time_t multi_msg_update = 0;
+
+	if (multi_msg_update != slurm_conf.last_update) {
+		multi_msg_enabled = xstrcasestr(slurm_conf.slurmctld_params,
+						"agent_multi_msg");
+		multi_msg_update = slurm_conf.last_update;
+	}
 
 	slurm_mutex_lock(&retry_mutex);
 	if (retry_list) {
@@ -1624,6 +2376,10 @@ static void _agent_retry(int min_wait, bool mail_too)
 				break;		/* Process this request now */
 			}
 		}
+		if (queued_req_ptr && multi_msg_enabled &&
+		    _multi_msg_ok(queued_req_ptr->agent_arg_ptr))
+			multi_list = _multi_msg_find(
+				retry_iter, queued_req_ptr->agent_arg_ptr);
 		list_iterator_destroy(retry_iter);
 	}
 
@@ -1648,7 +2404,11 @@ static void _agent_retry(int min_wait, bool mail_too)
 	if (queued_req_ptr) {
 		agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
 		xfree(queued_req_ptr);
-		if (agent_arg_ptr) {
+		if (agent_arg_ptr && multi_list) {
+			list_prepend(multi_list, agent_arg_ptr);
+			_multi_msg_spawn(multi_list);
+			FREE_NULL_LIST(multi_list);
+		} else if (agent_arg_ptr) {
 			debug2("Spawning RPC agent for msg_type %s",
 			       rpc_num2string(agent_arg_ptr->msg_type));
 			slurm_thread_create_detached(NULL, agent, agent_arg_ptr);
@@ -1822,6 +2582,8 @@ static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 			slurm_free_suspend_int_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == REQUEST_LAUNCH_PROLOG)
 			slurm_free_prolog_launch_msg(agent_arg_ptr->msg_args);
+		else if (agent_arg_ptr->msg_type == REQUEST_SLURMD_MULT_MSG)
+			slurm_free_composite_msg(agent_arg_ptr->msg_args);
 		else
 			xfree(agent_arg_ptr->msg_args);
 	}
@@ -0,0 +1,625 @@
+/*****************************************************************************\
+ *  agent_io.c - event driven network I/O for the agent
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#if HAVE_SYS_PRCTL_H
+#include <sys/prctl.h>
+#endif
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/common/fd.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/msg_compress.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_util.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/agent_io.h"
+#include "src/slurmctld/slurmctld.h"
+
+#define AGENT_IO_MAX_THREADS	64
+#define AGENT_IO_MAX_CONNS	256	/* open connections per I/O thread */
+#define AGENT_IO_MAX_EVENTS	64
+#define AGENT_IO_MAX_MSG_SIZE	(1024*1024*1024)
+#define AGENT_IO_RETRY_DELAY	1000	/* msec between refused connects */
+
+typedef enum {
+	CONN_CONNECT,		/* Waiting for connect() to complete */
+	CONN_SEND,		/* Writing message length and message */
+	CONN_RECV,		/* Reading response length and response */
+	CONN_WAIT_CLOSE		/* Waiting for remote to read and close */
+} conn_state_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int pending;		/* requests not yet complete */
+} io_batch_t;
+
+typedef struct {
+	agent_io_req_t *req;
+	io_batch_t *batch;
+	int fd;
+	int slot;		/* index in io_thread_t.conns */
+	conn_state_t state;
+	int connect_cnt;	/* connect() attempts so far */
+	int64_t deadline;	/* msec, connect retry time if not open */
+	uint32_t msg_len;	/* message length in network byte order */
+	uint32_t offset;	/* bytes sent or received, including length */
+} io_conn_t;
+
+typedef struct {
+	pthread_t thread;
+	int epoll_fd;
+	int wake_fd[2];
+	pthread_mutex_t mutex;
+	List incoming;		/* io_conn_t added by agent_io_run() */
+	List waiting;		/* io_conn_t waiting to (re)connect */
+	io_conn_t *conns[AGENT_IO_MAX_CONNS];
+	int conn_cnt;
+} io_thread_t;
+
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static io_thread_t *io_threads = NULL;
+static int io_thread_cnt = 0;
+static int io_next_thread = 0;
+static bool io_shutdown = false;
+static int connect_retries = 0;
+
+static int64_t _now_msec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/* Record the result of a request and wake its caller if the last one */
+static void _conn_done(io_thread_t *io, io_conn_t *conn, int rc)
+{
+	io_batch_t *batch = conn->batch;
+
+	if (conn->fd >= 0) {
+		(void) epoll_ctl(io->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+		(void) close(conn->fd);
+		io->conn_cnt--;
+		io->conns[conn->slot] = io->conns[io->conn_cnt];
+		io->conns[conn->slot]->slot = conn->slot;
+		io->conns[io->conn_cnt] = NULL;
+	}
+
+	if (rc != SLURM_SUCCESS) {
+		log_flag(AGENT, "%s: request to %pA failed: %s",
+			 __func__, &conn->req->addr, slurm_strerror(rc));
+		xfree(conn->req->reply);
+		conn->req->reply_size = 0;
+	}
+	conn->req->rc = rc;
+	xfree(conn);
+
+	slurm_mutex_lock(&batch->mutex);
+	if (--batch->pending == 0)
+		slurm_cond_signal(&batch->cond);
+	slurm_mutex_unlock(&batch->mutex);
+}
+
+/* Close a connection refused by the remote and queue it to try again */
+static void _conn_retry(io_thread_t *io, io_conn_t *conn, int64_t now)
+{
+	if (conn->fd >= 0) {
+		(void) epoll_ctl(io->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+		(void) close(conn->fd);
+		conn->fd = -1;
+		io->conn_cnt--;
+		io->conns[conn->slot] = io->conns[io->conn_cnt];
+		io->conns[conn->slot]->slot = conn->slot;
+		io->conns[io->conn_cnt] = NULL;
+	}
+	if (conn->connect_cnt == 1)
+		log_flag(NET, "%s: connect to %pA refused, retrying",
+			 __func__, &conn->req->addr);
+	conn->deadline = now + AGENT_IO_RETRY_DELAY;
+	list_append(io->waiting, conn);
+}
+
+static void _conn_set_events(io_thread_t *io, io_conn_t *conn,
+			     uint32_t events)
+{
+	struct epoll_event ev = {
+		.events = events,
+		.data.ptr = conn,
+	};
+
+	if (epoll_ctl(io->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev) < 0) {
+		error("%s: epoll_ctl: %m", __func__);
+		_conn_done(io, conn, SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+	}
+}
+
+/* Start a non-blocking connect() for a request */
+static void _conn_start(io_thread_t *io, io_conn_t *conn, int64_t now)
+{
+	agent_io_req_t *req = conn->req;
+	struct epoll_event ev = {
+		.events = EPOLLOUT,
+		.data.ptr = conn,
+	};
+
+	if ((req->addr.ss_family == AF_UNSPEC) ||
+	    (slurm_get_port(&req->addr) == 0)) {
+		error("%s: Error connecting, bad data: family = %u, port = %u",
+		      __func__, req->addr.ss_family,
+		      slurm_get_port(&req->addr));
+		_conn_done(io, conn, SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+		return;
+	}
+
+	conn->connect_cnt++;
+	conn->fd = socket(req->addr.ss_family,
+			  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			  IPPROTO_TCP);
+	if (conn->fd < 0) {
+		error("%s: Error creating slurm stream socket: %m", __func__);
+		_conn_done(io, conn, SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+		return;
+	}
+	conn->slot = io->conn_cnt;
+	io->conns[io->conn_cnt++] = conn;
+
+	if ((connect(conn->fd, (struct sockaddr *) &req->addr,
+		     sizeof(req->addr)) < 0) && (errno != EINPROGRESS)) {
+		if ((errno == ECONNREFUSED) && req->get_reply &&
+		    (conn->connect_cnt <= connect_retries)) {
+			_conn_retry(io, conn, now);
+		} else {
+			debug2("%s: connect to %pA failed: %m",
+			       __func__, &req->addr);
+			_conn_done(io, conn,
+				   SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+		}
+		return;
+	}
+
+	conn->state = CONN_CONNECT;
+	conn->deadline = now + (slurm_conf.tcp_timeout * 1000);
+	if (epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, conn->fd, &ev) < 0) {
+		error("%s: epoll_ctl: %m", __func__);
+		_conn_done(io, conn, SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+	}
+}
+
+/* Write as much of the message length and message as the socket takes */
+static void _conn_send(io_thread_t *io, io_conn_t *conn, int64_t now)
+{
+	agent_io_req_t *req = conn->req;
+	struct iovec iov[2];
+	struct msghdr mh = { .msg_iov = iov };
+	ssize_t sent;
+
+	while (conn->offset < (req->size + sizeof(conn->msg_len))) {
+		if (conn->offset < sizeof(conn->msg_len)) {
+			iov[0].iov_base = ((char *) &conn->msg_len) +
+					  conn->offset;
+			iov[0].iov_len = sizeof(conn->msg_len) - conn->offset;
+			iov[1].iov_base = req->data;
+			iov[1].iov_len = req->size;
+			mh.msg_iovlen = 2;
+		} else {
+			uint32_t data_offset =
+				conn->offset - sizeof(conn->msg_len);
+			iov[0].iov_base = req->data + data_offset;
+			iov[0].iov_len = req->size - data_offset;
+			mh.msg_iovlen = 1;
+		}
+
+		sent = sendmsg(conn->fd, &mh, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return;
+			log_flag(NET, "%s: send to %pA failed: %m",
+				 __func__, &req->addr);
+			_conn_done(io, conn, SLURM_COMMUNICATIONS_SEND_ERROR);
+			return;
+		}
+		conn->offset += sent;
+	}
+
+	conn->offset = 0;
+	if (req->get_reply) {
+		conn->state = CONN_RECV;
+		conn->deadline = now + req->timeout;
+		_conn_set_events(io, conn, EPOLLIN);
+	} else {
+		/* See slurm_send_only_node_msg() */
+		if (shutdown(conn->fd, SHUT_WR))
+			log_flag(NET, "%s: shutdown call failed: %m",
+				 __func__);
+		conn->state = CONN_WAIT_CLOSE;
+		conn->deadline = now + (slurm_conf.msg_timeout * 1000);
+		_conn_set_events(io, conn, EPOLLIN | EPOLLRDHUP);
+	}
+}
+
+/* Read as much of the response length and response as is available */
+static void _conn_recv(io_thread_t *io, io_conn_t *conn)
+{
+	agent_io_req_t *req = conn->req;
+	ssize_t got;
+	char *ptr;
+	size_t len;
+
+	while (1) {
+		if (conn->offset < sizeof(conn->msg_len)) {
+			ptr = ((char *) &conn->msg_len) + conn->offset;
+			len = sizeof(conn->msg_len) - conn->offset;
+		} else {
+			uint32_t data_offset =
+				conn->offset - sizeof(conn->msg_len);
+			if (data_offset == req->reply_size) {
+				int rc = SLURM_SUCCESS;
+
+				if (ntohl(conn->msg_len) & MSG_COMPRESS_FLAG)
+					rc = msg_decompress(
+						&req->reply, &req->reply_size,
+						msg_compress_accept_flags(),
+						AGENT_IO_MAX_MSG_SIZE);
+				_conn_done(io, conn, rc);
+				return;
+			}
+			ptr = req->reply + data_offset;
+			len = req->reply_size - data_offset;
+		}
+
+		got = read(conn->fd, ptr, len);
+		if (got < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return;
+			log_flag(NET, "%s: read from %pA failed: %m",
+				 __func__, &req->addr);
+			_conn_done(io, conn, SLURM_COMMUNICATIONS_RECEIVE_ERROR);
+			return;
+		} else if (got == 0) {
+			_conn_done(io, conn,
+				   SLURM_PROTOCOL_SOCKET_ZERO_BYTES_SENT);
+			return;
+		}
+
+		conn->offset += got;
+		if (conn->offset == sizeof(conn->msg_len)) {
+			req->reply_size = ntohl(conn->msg_len) &
+					  ~MSG_COMPRESS_FLAG;
+			if (req->reply_size > AGENT_IO_MAX_MSG_SIZE) {
+				error("%s: Invalid message length %u from %pA",
+				      __func__, req->reply_size, &req->addr);
+				_conn_done(io, conn,
+					   SLURM_PROTOCOL_INSANE_MSG_LENGTH);
+				return;
+			}
+			req->reply = xmalloc_nz(req->reply_size);
+		}
+	}
+}
+
+static void _conn_event(io_thread_t *io, io_conn_t *conn, uint32_t events,
+			int64_t now)
+{
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	switch (conn->state) {
+	case CONN_CONNECT:
+		if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+			err = errno;
+		if (!err) {
+			conn->state = CONN_SEND;
+			conn->offset = 0;
+			conn->msg_len = htonl(conn->req->size);
+			conn->deadline = now + (slurm_conf.msg_timeout * 1000);
+			_conn_send(io, conn, now);
+		} else if ((err == ECONNREFUSED) && conn->req->get_reply &&
+			   (conn->connect_cnt <= connect_retries)) {
+			_conn_retry(io, conn, now);
+		} else {
+			errno = err;
+			debug2("%s: connect to %pA failed: %m",
+			       __func__, &conn->req->addr);
+			_conn_done(io, conn,
+				   SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+		}
+		break;
+	case CONN_SEND:
+		if (events & (EPOLLERR | EPOLLHUP))
+			_conn_done(io, conn, SLURM_COMMUNICATIONS_SEND_ERROR);
+		else
+			_conn_send(io, conn, now);
+		break;
+	case CONN_RECV:
+		_conn_recv(io, conn);
+		break;
+	case CONN_WAIT_CLOSE:
+		if (events & EPOLLERR) {
+			if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR,
+				       &err, &len) < 0)
+				err = errno;
+			errno = err;
+			log_flag(NET, "%s: poll error from %pA: %m",
+				 __func__, &conn->req->addr);
+			_conn_done(io, conn, err ? err :
+				   SLURM_COMMUNICATIONS_SEND_ERROR);
+		} else {
+			_conn_done(io, conn, SLURM_SUCCESS);
+		}
+		break;
+	}
+}
+
+/*
+ * Fail connections past their deadline and start waiting ones that are due.
+ * RET msec until the next deadline, -1 if none
+ */
+static int _check_conns(io_thread_t *io, int64_t now)
+{
+	int64_t next = -1;
+	io_conn_t *conn;
+	ListIterator itr;
+
+	for (int i = 0; i < io->conn_cnt; ) {
+		conn = io->conns[i];
+		if (conn->deadline > now) {
+			if ((next < 0) || (conn->deadline < next))
+				next = conn->deadline;
+			i++;
+			continue;
+		}
+		log_flag(NET, "%s: request to %pA timed out in state %d",
+			 __func__, &conn->req->addr, conn->state);
+		/* moves the last connection into slot i */
+		_conn_done(io, conn, SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT);
+	}
+
+	itr = list_iterator_create(io->waiting);
+	while ((conn = list_next(itr))) {
+		if (conn->deadline > now) {
+			if ((next < 0) || (conn->deadline < next))
+				next = conn->deadline;
+			continue;
+		}
+		if (io->conn_cnt >= AGENT_IO_MAX_CONNS)
+			break;	/* retried once a connection completes */
+		list_remove(itr);
+		_conn_start(io, conn, now);
+	}
+	list_iterator_destroy(itr);
+
+	if (next < 0)
+		return -1;
+	return MIN(next - now, 1000);
+}
+
+static void *_io_thread(void *arg)
+{
+	io_thread_t *io = arg;
+	struct epoll_event events[AGENT_IO_MAX_EVENTS];
+	int timeout = -1, cnt;
+	int64_t now;
+	char junk[64];
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "agent_io", NULL, NULL, NULL) < 0)
+		error("%s: cannot set my name to %s %m", __func__, "agent_io");
+#endif
+
+	while (!io_shutdown) {
+		cnt = epoll_wait(io->epoll_fd, events, AGENT_IO_MAX_EVENTS,
+				 timeout);
+		if ((cnt < 0) && (errno != EINTR)) {
+			error("%s: epoll_wait: %m", __func__);
+			sleep(1);
+		}
+		now = _now_msec();
+
+		for (int i = 0; i < cnt; i++) {
+			if (!events[i].data.ptr) {
+				while (read(io->wake_fd[0], junk,
+					    sizeof(junk)) > 0)
+					;
+				continue;
+			}
+			_conn_event(io, events[i].data.ptr, events[i].events,
+				    now);
+		}
+
+		slurm_mutex_lock(&io->mutex);
+		list_transfer(io->waiting, io->incoming);
+		slurm_mutex_unlock(&io->mutex);
+
+		timeout = _check_conns(io, now);
+	}
+
+	return NULL;
+}
+
+extern void agent_io_init(void)
+{
+	char *tmp_ptr;
+	int cnt = 0;
+
+	slurm_mutex_lock(&io_mutex);
+	if (io_threads) {
+		slurm_mutex_unlock(&io_mutex);
+		return;
+	}
+
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "agent_io_threads=")))
+		cnt = strtol(tmp_ptr + strlen("agent_io_threads="), NULL, 10);
+	if ((cnt < 0) || (cnt > AGENT_IO_MAX_THREADS)) {
+		error("SlurmctldParameters=agent_io_threads=%d invalid, using %d",
+		      cnt, AGENT_IO_MAX_THREADS);
+		cnt = AGENT_IO_MAX_THREADS;
+	}
+	if (!cnt) {
+		slurm_mutex_unlock(&io_mutex);
+		return;
+	}
+
+	connect_retries = MIN(slurm_conf.msg_timeout, 10);
+	io_shutdown = false;
+	io_threads = xcalloc(cnt, sizeof(io_thread_t));
+	for (int i = 0; i < cnt; i++) {
+		io_thread_t *io = &io_threads[i];
+		struct epoll_event ev = {
+			.events = EPOLLIN,
+			.data.ptr = NULL,
+		};
+
+		if ((io->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+			fatal("%s: epoll_create1: %m", __func__);
+		if (pipe(io->wake_fd))
+			fatal("%s: pipe: %m", __func__);
+		fd_set_close_on_exec(io->wake_fd[0]);
+		fd_set_close_on_exec(io->wake_fd[1]);
+		fd_set_nonblocking(io->wake_fd[0]);
+		fd_set_nonblocking(io->wake_fd[1]);
+		if (epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, io->wake_fd[0],
+			      &ev) < 0)
+			fatal("%s: epoll_ctl: %m", __func__);
+		slurm_mutex_init(&io->mutex);
+		io->incoming = list_create(NULL);
+		io->waiting = list_create(NULL);
+		slurm_thread_create(&io->thread, _io_thread, io);
+	}
+	io_thread_cnt = cnt;
+	slurm_mutex_unlock(&io_mutex);
+
+	verbose("%s: started %d agent I/O threads", __func__, cnt);
+}
+
+extern void agent_io_fini(void)
+{
+	slurm_mutex_lock(&io_mutex);
+	if (!io_threads) {
+		slurm_mutex_unlock(&io_mutex);
+		return;
+	}
+
+	io_shutdown = true;
+	for (int i = 0; i < io_thread_cnt; i++) {
+		if (write(io_threads[i].wake_fd[1], "", 1) < 0)
+			debug2("%s: wake up write: %m", __func__);
+	}
+	for (int i = 0; i < io_thread_cnt; i++) {
+		io_thread_t *io = &io_threads[i];
+
+		pthread_join(io->thread, NULL);
+		(void) close(io->epoll_fd);
+		(void) close(io->wake_fd[0]);
+		(void) close(io->wake_fd[1]);
+		slurm_mutex_destroy(&io->mutex);
+		FREE_NULL_LIST(io->incoming);
+		FREE_NULL_LIST(io->waiting);
+	}
+	xfree(io_threads);
+	io_thread_cnt = 0;
+	slurm_mutex_unlock(&io_mutex);
+}
+
+extern bool agent_io_enabled(void)
+{
+	return (io_threads != NULL);
+}
+
+extern void agent_io_run(agent_io_req_t *reqs, int cnt)
+{
+	io_batch_t batch;
+	int first;
+
+	if (!cnt)
+		return;
+
+	slurm_mutex_init(&batch.mutex);
+	slurm_cond_init(&batch.cond, NULL);
+	batch.pending = cnt;
+
+	slurm_mutex_lock(&io_mutex);
+	xassert(io_threads);
+	first = io_next_thread;
+	io_next_thread = (io_next_thread + cnt) % io_thread_cnt;
+
+	/* Spread the connections evenly over the I/O threads */
+	for (int t = 0; (t < io_thread_cnt) && (t < cnt); t++) {
+		io_thread_t *io = &io_threads[(first + t) % io_thread_cnt];
+
+		slurm_mutex_lock(&io->mutex);
+		for (int i = t; i < cnt; i += io_thread_cnt) {
+			io_conn_t *conn = xmalloc(sizeof(*conn));
+
+			reqs[i].reply = NULL;
+			reqs[i].reply_size = 0;
+			conn->req = &reqs[i];
+			conn->batch = &batch;
+			conn->fd = -1;
+			list_append(io->incoming, conn);
+		}
+		slurm_mutex_unlock(&io->mutex);
+		if (write(io->wake_fd[1], "", 1) < 0)
+			debug2("%s: wake up write: %m", __func__);
+	}
+	slurm_mutex_unlock(&io_mutex);
+
+	slurm_mutex_lock(&batch.mutex);
+	while (batch.pending)
+		slurm_cond_wait(&batch.cond, &batch.mutex);
+	slurm_mutex_unlock(&batch.mutex);
+
+	slurm_mutex_destroy(&batch.mutex);
+	slurm_cond_destroy(&batch.cond);
+}
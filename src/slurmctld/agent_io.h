@@ -0,0 +1,77 @@
+/*****************************************************************************\
+ *  agent_io.h - event driven network I/O for the agent
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _AGENT_IO_H_
+#define _AGENT_IO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "src/common/slurm_protocol_defs.h"
+
+typedef struct {
+	slurm_addr_t addr;	/* IN: destination */
+	char *data;		/* IN: packed message, without its length */
+	uint32_t size;		/* IN: size of data */
+	bool get_reply;		/* IN: read a response message */
+	int timeout;		/* IN: milliseconds to wait for the response */
+	char *reply;		/* OUT: response message, caller must xfree */
+	uint32_t reply_size;	/* OUT: size of reply */
+	int rc;			/* OUT: SLURM_SUCCESS or error code */
+} agent_io_req_t;
+
+/*
+ * agent_io_init - start the I/O threads if SlurmctldParameters includes
+ *	agent_io_threads=#. Nothing is done if they are already running.
+ */
+extern void agent_io_init(void);
+
+/* agent_io_fini - stop the I/O threads */
+extern void agent_io_fini(void);
+
+/* agent_io_enabled - RET true if agent_io_run() may be used */
+extern bool agent_io_enabled(void);
+
+/*
+ * agent_io_run - send each message and wait for its response if get_reply
+ *	is set, otherwise wait for the remote end to close the connection as
+ *	slurm_send_only_node_msg() does. All of the connections are handled by
+ *	the I/O threads, the caller blocks until every request is complete.
+ * IN/OUT reqs - requests to process, rc and reply set on return
+ * IN cnt - number of requests
+ */
+extern void agent_io_run(agent_io_req_t *reqs, int cnt);
+
+#endif
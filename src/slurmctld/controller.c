@@ -96,11 +96,13 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/agent_io.h"
 #include "src/slurmctld/burst_buffer.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/heartbeat.h"
+#include "src/slurmctld/info_snapshot.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
 #include "src/slurmctld/licenses.h"
@@ -110,8 +112,10 @@
 #include "src/slurmctld/power_save.h"
 #include "src/slurmctld/preempt.h"
 #include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rate_limit.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
@@ -740,6 +744,8 @@ int main(int argc, char **argv)
 		/*
 		 * create attached thread to process RPCs
 		 */
+		rate_limit_init();
+		rpc_queue_init();
 		server_thread_incr();
 		slurm_thread_create(&slurmctld_config.thread_id_rpc,
 				    _slurmctld_rpc_mgr, NULL);
@@ -788,6 +794,7 @@ int main(int argc, char **argv)
 		slurmctld_config.thread_id_sig  = (pthread_t) 0;
 		slurmctld_config.thread_id_rpc  = (pthread_t) 0;
 		slurmctld_config.thread_id_save = (pthread_t) 0;
+		rate_limit_shutdown();
 
 		/* kill all scripts running by the slurmctld */
 		track_script_flush();
@@ -876,6 +883,8 @@ int main(int argc, char **argv)
 	}
 	if (cnt)
 		error("Left %d agent threads active", cnt);
+	else
+		agent_io_fini();
 
 	slurm_sched_fini();	/* Stop all scheduling */
 
@@ -883,6 +892,7 @@ int main(int argc, char **argv)
 	configless_clear();
 	xcgroup_fini_slurm_cgroup_conf();
 	power_save_fini();
+	info_snapshot_fini();
 	job_fini();
 	part_fini();	/* part_fini() must precede node_fini() */
 	node_fini();
@@ -1024,6 +1034,7 @@ static void _reconfigure_slurm(void)
 	}
 
 	gs_reconfig();
+	rate_limit_init();
 	unlock_slurmctld(config_write_lock);
 	xcgroup_reconfig_slurm_cgroup_conf();
 	assoc_mgr_set_missing_uids();
@@ -1242,7 +1253,7 @@ static void *_service_connection(void *arg)
 	}
 #endif
 	slurm_msg_t_init(msg);
-	msg->flags |= SLURM_MSG_KEEP_BUFFER;
+	msg->flags |= SLURM_MSG_KEEP_BUFFER | SLURM_MSG_ARENA;
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
@@ -1256,8 +1267,19 @@ static void *_service_connection(void *arg)
 		goto cleanup;
 	}
 
-	/* process the request */
-	slurmctld_req(msg);
+	if (rate_limit_exceeded(msg)) {
+		slurm_send_rc_msg(msg, SLURMCTLD_COMMUNICATIONS_BACKOFF);
+	} else if (rpc_enqueue(msg) == SLURM_SUCCESS) {
+		/*
+		 * Queued RPCs are processed by the worker threads of their
+		 * message type, which also close the connection and free msg
+		 */
+		server_thread_decr();
+		return NULL;
+	} else {
+		/* process the request */
+		slurmctld_req(msg);
+	}
 
 	if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
 		error("close(%d): %m", msg->conn_fd);
@@ -1979,6 +2001,7 @@ static void *_slurmctld_background(void *no_data)
 			ts.tv_sec = now.tv_sec + CONTROL_TIMEOUT;
 			ts.tv_nsec = now.tv_usec * 1000;
 
+			rpc_queue_shutdown();
 			slurm_mutex_lock(&slurmctld_config.thread_count_lock);
 			while (slurmctld_config.server_thread_count >
 			       exp_thread_cnt) {
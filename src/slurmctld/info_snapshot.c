@@ -0,0 +1,432 @@
+/*****************************************************************************\
+ *  info_snapshot.c - Immutable packed snapshots of job and node information
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <pthread.h>
+#include <time.h>
+
+#include "src/common/list.h"
+#include "src/common/node_select.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/info_snapshot.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* Which users a cached view of the records applies to */
+enum {
+	SNAP_VIEW_ALL,		/* every record, as seen by root */
+	SNAP_VIEW_PUBLIC,	/* records visible to any unprivileged user */
+	SNAP_VIEW_USER		/* records visible to one specific user */
+};
+
+/* Maximum number of per-user snapshots of each type kept */
+#define MAX_USER_SNAPSHOTS 64
+
+/*
+ * Seconds a stale snapshot is kept after its last use, so that its job
+ * records can be copied when it is rebuilt
+ */
+#define SNAPSHOT_IDLE_TIME 60
+
+/* Update times and write counts of the records, see _get_state() */
+typedef struct {
+	time_t update_time;		/* last_job_update or last_node_update */
+	time_t part_update_time;	/* last_part_update */
+	uint64_t write_cnt;		/* job or node write locks taken */
+	uint64_t part_write_cnt;	/* partition write locks taken */
+} snap_state_t;
+
+typedef struct {
+	snap_state_t *state;
+	time_t now;
+} purge_args_t;
+
+static pthread_mutex_t snap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List snap_list[INFO_SNAPSHOT_TYPES] = { NULL };
+
+/* Set if any partition is hidden or limited by AllowGroups */
+static bool parts_restricted = true;
+static time_t parts_restricted_time = 0;
+
+static void _snapshot_free(info_snapshot_t *snap)
+{
+	job_pack_cache_free(snap->job_cache);
+	xfree(snap->data);
+	xfree(snap);
+}
+
+static void _snapshot_unref(info_snapshot_t *snap)
+{
+	xassert(snap->ref_cnt > 0);
+	if (--snap->ref_cnt == 0)
+		_snapshot_free(snap);
+}
+
+static int _part_restricted(void *x, void *arg)
+{
+	part_record_t *part_ptr = (part_record_t *) x;
+
+	if ((part_ptr->flags & PART_FLAG_HIDDEN) || part_ptr->allow_groups)
+		return -1;
+	return 0;
+}
+
+/* Refresh parts_restricted if partitions changed since part_update_time */
+static bool _get_parts_restricted(time_t part_update_time)
+{
+	slurmctld_lock_t part_read_lock = {
+		NO_LOCK, NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK };
+	bool restricted;
+	time_t update_time;
+
+	slurm_mutex_lock(&snap_mutex);
+	restricted = parts_restricted;
+	update_time = parts_restricted_time;
+	slurm_mutex_unlock(&snap_mutex);
+
+	if (update_time && (update_time == part_update_time))
+		return restricted;
+
+	lock_slurmctld(part_read_lock);
+	restricted = (list_for_each(part_list, _part_restricted, NULL) < 0);
+	update_time = last_part_update;
+	unlock_slurmctld(part_read_lock);
+
+	slurm_mutex_lock(&snap_mutex);
+	parts_restricted = restricted;
+	parts_restricted_time = update_time;
+	slurm_mutex_unlock(&snap_mutex);
+
+	return restricted;
+}
+
+/* Find which view of the records uid would see */
+static uint16_t _get_view(info_snapshot_type_t type, uint16_t show_flags,
+			  uid_t uid, snap_state_t *state)
+{
+	uint16_t private_flag = (type == INFO_SNAPSHOT_JOBS) ?
+		PRIVATE_DATA_JOBS : PRIVATE_DATA_NODES;
+
+	if ((type == INFO_SNAPSHOT_JOBS) &&
+	    (slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    !validate_operator(uid))
+		return SNAP_VIEW_USER;
+
+	if ((uid == 0) || (show_flags & SHOW_ALL))
+		return SNAP_VIEW_ALL;
+
+	if (slurm_conf.private_data & private_flag)
+		return SNAP_VIEW_USER;
+
+	if (_get_parts_restricted(state->part_update_time))
+		return SNAP_VIEW_USER;
+
+	return SNAP_VIEW_PUBLIC;
+}
+
+/*
+ * Read the update times and write counts of the records. These are only
+ * stable while holding their read locks, so take them here rather than
+ * under snap_mutex.
+ */
+static void _get_state(info_snapshot_type_t type, snap_state_t *state)
+{
+	/* Locks: Read job, part */
+	slurmctld_lock_t job_read_lock = {
+		NO_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, NO_LOCK };
+	/* Locks: Read node, part */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+
+	if (type == INFO_SNAPSHOT_JOBS) {
+		lock_slurmctld(job_read_lock);
+		state->update_time = last_job_update;
+		state->write_cnt = lock_write_count(JOB_LOCK);
+	} else {
+		lock_slurmctld(node_read_lock);
+		state->update_time = last_node_update;
+		state->write_cnt = lock_write_count(NODE_LOCK);
+	}
+	state->part_update_time = last_part_update;
+	state->part_write_cnt = lock_write_count(PART_LOCK);
+	if (type == INFO_SNAPSHOT_JOBS)
+		unlock_slurmctld(job_read_lock);
+	else
+		unlock_slurmctld(node_read_lock);
+}
+
+static bool _is_current(info_snapshot_t *snap, snap_state_t *state)
+{
+	if ((snap->update_time != state->update_time) ||
+	    (snap->part_update_time != state->part_update_time))
+		return false;
+
+	if (snap->build_time > MAX(state->update_time,
+				   state->part_update_time))
+		return true;
+
+	/*
+	 * Update times have a resolution of one second, so a change made
+	 * later within the second the snapshot was built would go unnoticed.
+	 * Within that second, require that no write lock was taken since.
+	 */
+	return ((snap->write_cnt == state->write_cnt) &&
+		(snap->part_write_cnt == state->part_write_cnt));
+}
+
+/*
+ * Build a snapshot without holding snap_mutex. Job records unchanged since
+ * prev, a snapshot of the same records, are copied from it.
+ */
+static info_snapshot_t *_build(info_snapshot_type_t type, uint16_t view,
+			       uint16_t show_flags, uid_t uid,
+			       uint16_t protocol_version,
+			       info_snapshot_t *prev)
+{
+	/* Locks: Read config, job, part, federation */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
+	/* Locks: Read config, write node, read part */
+	slurmctld_lock_t node_write_lock = {
+		READ_LOCK, NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK };
+	uid_t pack_uid;
+	info_snapshot_t *snap = xmalloc(sizeof(*snap));
+
+	if (view == SNAP_VIEW_ALL)
+		pack_uid = 0;
+	else if (view == SNAP_VIEW_PUBLIC)
+		pack_uid = (uid_t) NO_VAL;
+	else
+		pack_uid = uid;
+
+	snap->protocol_version = protocol_version;
+	snap->show_flags = show_flags;
+	snap->uid = pack_uid;
+	snap->view = view;
+
+	if (type == INFO_SNAPSHOT_JOBS) {
+		lock_slurmctld(job_read_lock);
+		snap->update_time = last_job_update;
+		snap->part_update_time = last_part_update;
+		snap->build_time = time(NULL);
+		snap->write_cnt = lock_write_count(JOB_LOCK);
+		snap->part_write_cnt = lock_write_count(PART_LOCK);
+		pack_all_jobs_cached(&snap->data, &snap->data_size, show_flags,
+				     pack_uid, protocol_version,
+				     prev ? prev->job_cache : NULL,
+				     &snap->job_cache);
+		unlock_slurmctld(job_read_lock);
+	} else {
+		lock_slurmctld(node_write_lock);
+		select_g_select_nodeinfo_set_all();
+		snap->update_time = last_node_update;
+		snap->part_update_time = last_part_update;
+		snap->build_time = time(NULL);
+		snap->write_cnt = lock_write_count(NODE_LOCK);
+		snap->part_write_cnt = lock_write_count(PART_LOCK);
+		pack_all_node(&snap->data, &snap->data_size, show_flags,
+			      pack_uid, protocol_version);
+		unlock_slurmctld(node_write_lock);
+	}
+
+	return snap;
+}
+
+/* Drop stale snapshots which are no longer requested */
+static int _purge_stale(void *x, void *arg)
+{
+	info_snapshot_t *snap = (info_snapshot_t *) x;
+	purge_args_t *args = (purge_args_t *) arg;
+
+	if ((snap->use_time + SNAPSHOT_IDLE_TIME > args->now) ||
+	    _is_current(snap, args->state))
+		return 0;
+
+	_snapshot_unref(snap);
+	return 1;
+}
+
+static int _find_snapshot(void *x, void *key)
+{
+	return (x == key);
+}
+
+/* Drop the least recently used per-user snapshot if there are too many */
+static void _purge_user_lru(List snaps)
+{
+	info_snapshot_t *snap, *lru = NULL;
+	ListIterator iter;
+	int user_cnt = 0;
+
+	iter = list_iterator_create(snaps);
+	while ((snap = list_next(iter))) {
+		if (snap->view != SNAP_VIEW_USER)
+			continue;
+		user_cnt++;
+		if (!lru || (snap->use_time < lru->use_time))
+			lru = snap;
+	}
+	list_iterator_destroy(iter);
+
+	if (user_cnt < MAX_USER_SNAPSHOTS)
+		return;
+
+	list_remove_first(snaps, _find_snapshot, lru);
+	_snapshot_unref(lru);
+}
+
+/* Find the snapshot of the records requested. Call with snap_mutex. */
+static info_snapshot_t *_find_key(List snaps, uint16_t view,
+				  uint16_t show_flags, uid_t uid,
+				  uint16_t protocol_version)
+{
+	info_snapshot_t *snap;
+	ListIterator iter;
+
+	iter = list_iterator_create(snaps);
+	while ((snap = list_next(iter))) {
+		if ((snap->view == view) &&
+		    (snap->show_flags == show_flags) &&
+		    (snap->protocol_version == protocol_version) &&
+		    ((view != SNAP_VIEW_USER) || (snap->uid == uid)))
+			break;
+	}
+	list_iterator_destroy(iter);
+
+	return snap;
+}
+
+/* Bump the hit or miss counter reported by sdiag */
+static void _count_access(info_snapshot_type_t type, bool hit)
+{
+	if (type == INFO_SNAPSHOT_JOBS) {
+		if (hit)
+			slurmctld_diag_stats.job_info_cache_hits++;
+		else
+			slurmctld_diag_stats.job_info_cache_misses++;
+	} else {
+		if (hit)
+			slurmctld_diag_stats.node_info_cache_hits++;
+		else
+			slurmctld_diag_stats.node_info_cache_misses++;
+	}
+}
+
+extern info_snapshot_t *info_snapshot_get(info_snapshot_type_t type,
+					  uint16_t show_flags, uid_t uid,
+					  uint16_t protocol_version)
+{
+	info_snapshot_t *snap, *prev;
+	snap_state_t state;
+	purge_args_t purge_args = { .state = &state };
+	uint16_t view;
+
+	xassert(type < INFO_SNAPSHOT_TYPES);
+
+	if (!xstrcasestr(slurm_conf.slurmctld_params, "info_snapshots"))
+		return NULL;
+
+	_get_state(type, &state);
+	view = _get_view(type, show_flags, uid, &state);
+
+	slurm_mutex_lock(&snap_mutex);
+	if (!snap_list[type])
+		snap_list[type] = list_create(NULL);
+
+	prev = _find_key(snap_list[type], view, show_flags, uid,
+			 protocol_version);
+	if (prev && _is_current(prev, &state)) {
+		_count_access(type, true);
+		prev->ref_cnt++;
+		prev->use_time = time(NULL);
+		slurm_mutex_unlock(&snap_mutex);
+		return prev;
+	}
+	_count_access(type, false);
+	if (prev)
+		prev->ref_cnt++;	/* records are copied from it */
+	slurm_mutex_unlock(&snap_mutex);
+
+	/*
+	 * Readers needing the same snapshot may build it concurrently, the
+	 * last one built replaces the others.
+	 */
+	snap = _build(type, view, show_flags, uid, protocol_version, prev);
+	snap->ref_cnt = 2;	/* references held by snap_list and caller */
+	snap->use_time = time(NULL);
+
+	slurm_mutex_lock(&snap_mutex);
+	if (prev)
+		_snapshot_unref(prev);
+	if ((prev = _find_key(snap_list[type], view, show_flags, uid,
+			      protocol_version))) {
+		list_remove_first(snap_list[type], _find_snapshot, prev);
+		_snapshot_unref(prev);
+	}
+	/* Snapshots stale at state are still stale, the others may wait */
+	purge_args.now = time(NULL);
+	list_delete_all(snap_list[type], _purge_stale, &purge_args);
+	if (view == SNAP_VIEW_USER)
+		_purge_user_lru(snap_list[type]);
+	list_append(snap_list[type], snap);
+	slurm_mutex_unlock(&snap_mutex);
+
+	return snap;
+}
+
+extern void info_snapshot_release(info_snapshot_t *snap)
+{
+	if (!snap)
+		return;
+
+	slurm_mutex_lock(&snap_mutex);
+	_snapshot_unref(snap);
+	slurm_mutex_unlock(&snap_mutex);
+}
+
+extern void info_snapshot_fini(void)
+{
+	info_snapshot_t *snap;
+
+	slurm_mutex_lock(&snap_mutex);
+	for (int i = 0; i < INFO_SNAPSHOT_TYPES; i++) {
+		if (!snap_list[i])
+			continue;
+		while ((snap = list_pop(snap_list[i])))
+			_snapshot_unref(snap);
+		FREE_NULL_LIST(snap_list[i]);
+	}
+	slurm_mutex_unlock(&snap_mutex);
+}
@@ -0,0 +1,109 @@
+/*****************************************************************************\
+ *  info_snapshot.h - Immutable packed snapshots of job and node information
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURMCTLD_INFO_SNAPSHOT_H
+#define _SLURMCTLD_INFO_SNAPSHOT_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+/*
+ * An info snapshot is the packed body of a RESPONSE_JOB_INFO or
+ * RESPONSE_NODE_INFO message, as built by pack_all_jobs() or pack_all_node().
+ * Snapshots are immutable once built and reference counted, so any number of
+ * RPC threads can send one without holding any slurmctld locks. A snapshot is
+ * rebuilt by the first reader which finds it older than last_job_update (or
+ * last_node_update) or last_part_update, so writers never pay for it. The
+ * rebuild runs without blocking other readers, and copies the records of
+ * jobs which job_info_changed() was not called for from the previous
+ * snapshot instead of packing them again.
+ *
+ * Snapshots are cached by message type, show_flags, protocol version and the
+ * set of users which see the same records: root (or SHOW_ALL), any
+ * unprivileged user, or when hidden or AllowGroups partitions or PrivateData
+ * make the view depend on the requesting user, that user alone. Hits and
+ * misses are reported by sdiag.
+ *
+ * Enabled with SlurmctldParameters=info_snapshots.
+ */
+
+typedef enum {
+	INFO_SNAPSHOT_JOBS,
+	INFO_SNAPSHOT_NODES,
+	INFO_SNAPSHOT_TYPES
+} info_snapshot_type_t;
+
+typedef struct {
+	char *data;		/* packed message body */
+	int data_size;		/* size of data in bytes */
+	time_t update_time;	/* last_job/node_update reflected in data */
+
+	/* private to info_snapshot.c */
+	time_t build_time;
+	struct job_pack_cache *job_cache; /* from pack_all_jobs_cached() */
+	time_t part_update_time;
+	uint64_t part_write_cnt;	/* lock_write_count(PART_LOCK) */
+	uint16_t protocol_version;
+	int ref_cnt;
+	uint16_t show_flags;
+	uid_t uid;
+	time_t use_time;
+	uint16_t view;
+	uint64_t write_cnt;	/* lock_write_count() of the records */
+} info_snapshot_t;
+
+/*
+ * Get a reference to a current snapshot of all job or node records, building
+ * it if needed. Must be called without any slurmctld locks held.
+ * IN type - INFO_SNAPSHOT_JOBS or INFO_SNAPSHOT_NODES
+ * IN show_flags - show_flags from the info request
+ * IN uid - uid of the user making the request
+ * IN protocol_version - protocol version of the request
+ * RET snapshot to be released with info_snapshot_release(), or NULL if
+ *     snapshots are disabled
+ */
+extern info_snapshot_t *info_snapshot_get(info_snapshot_type_t type,
+					  uint16_t show_flags, uid_t uid,
+					  uint16_t protocol_version);
+
+/* Release a reference obtained from info_snapshot_get() */
+extern void info_snapshot_release(info_snapshot_t *snap);
+
+/* Free all snapshots, called at slurmctld shutdown */
+extern void info_snapshot_fini(void);
+
+#endif
@@ -67,6 +67,7 @@
 #include "src/common/forward.h"
 #include "src/common/gres.h"
 #include "src/common/hostlist.h"
+#include "src/common/id_hash.h"
 #include "src/common/node_features.h"
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
@@ -113,10 +114,22 @@
 #define SLURM_CREATE_JOB_FLAG_NO_ALLOCATE_0 0
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 #define PURGE_OLD_JOB_IN_SEC 2592000 /* 30 days in seconds */
+#define JOB_DELTA_HISTORY 3600 /* seconds purged job ids are kept for
+				* SHOW_DELTA job info requests */
 
-#define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
-#define JOB_ARRAY_HASH_INX(_job_id, _task_id) \
-	((_job_id + _task_id) % hash_table_size)
+#define JOB_JOURNAL_MIN_SIZE (1024 * 1024) /* journal may always grow to this
+					     * size before compaction */
+
+#define JOB_DIGEST_INIT 0xcbf29ce484222325ULL /* FNV-1a 64 offset basis */
+
+#define JOB_HASH_MIN_SIZE 1024	/* initial job hash table size */
+#define JOB_ARRAY_TASK_KEY(_job_id, _task_id) \
+	(((uint64_t) (_job_id) << 32) | (_task_id))
+
+#define JOB_RECOVER_BATCH   64	/* job records claimed at once by a
+				 * job state recovery thread */
+#define JOB_RECOVER_MIN_CNT 256	/* unpack fewer job records serially */
+#define JOB_RECOVER_THREADS 8	/* default maximum recovery threads */
 
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
@@ -135,20 +148,73 @@ typedef struct {
 	bitstr_t **resp_array_task_id;
 } resp_array_struct_t;
 
+/* A job record packed by pack_all_jobs_cached() */
+typedef struct {
+	uint32_t job_id;
+	uint32_t offset;	/* offset of the record in the packed data */
+	uint32_t size;		/* size of the record in bytes */
+	uint32_t first_use;	/* str_dict_use_cnt() before the record */
+	uint64_t digest;	/* _job_info_digest() when packed */
+} job_pack_rec_t;
+
+struct job_pack_cache {
+	char *data;		/* packed message, owned by the caller */
+	uint64_t info_seq;	/* job_info_seq when packed */
+	uint64_t part_write_cnt; /* partition write locks when packed */
+	time_t pack_time;
+	uint16_t protocol_version;
+	uint32_t rec_cnt;	/* elements used in recs */
+	uint32_t rec_size;	/* elements allocated in recs */
+	job_pack_rec_t *recs;	/* records in the order packed */
+	id_hash_t *rec_hash;	/* recs by job id */
+	uint32_t reused_cnt;	/* records copied from the previous cache */
+	uint16_t show_flags;
+	str_dict_t *str_dict;	/* dictionary the records were packed with */
+	uid_t uid;
+};
+
 typedef struct {
 	Buf       buffer;
+	job_pack_cache_t *cache;	/* cache being filled, if any */
 	uint32_t  filter_uid;
+	uint32_t  hidden_cnt;	/* elements used in hidden_ids */
+	uint32_t *hidden_ids;	/* jobs changed since update_time, now hidden */
+	uint32_t  hidden_size;	/* elements allocated in hidden_ids */
 	uint32_t *jobs_packed;
+	job_pack_cache_t *prev_cache;	/* records which may be reused */
 	uint16_t  protocol_version;
 	uint16_t  show_flags;
 	uid_t     uid;
+	time_t    update_time;	/* pack only records changed since, if set */
 } _foreach_pack_job_info_t;
 
+typedef struct {
+	uint32_t job_id;
+	time_t   purge_time;
+} job_tombstone_t;
+
+typedef struct {
+	uint32_t bit_flags;	/* buffer offset of packed bit_flags */
+	uint32_t sched_eval;	/* buffer offset of packed last_sched_eval */
+} job_state_offsets_t;
+
 typedef struct {
 	bitstr_t *node_map;
 	int rc;
 } job_overlap_args_t;
 
+typedef struct {
+	Buf buffer;		/* job_state file contents */
+	uint16_t protocol_version;
+	uint32_t rec_cnt;
+	uint32_t *rec_start;	/* buffer offset of each job record */
+	uint32_t *rec_end;
+	job_record_t **job_ptrs; /* unpacked job records, in file order */
+	int *rc;
+	uint32_t next_rec;	/* next record to be claimed */
+	pthread_mutex_t mutex;
+} job_recover_args_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -160,12 +226,13 @@ static int      bf_min_age_reserve = 0;
 static uint32_t delay_boot = 0;
 static uint32_t highest_prio = 0;
 static uint32_t lowest_prio  = TOP_PRIORITY;
-static int      hash_table_size = 0;
 static int      job_count = 0;		/* job's in the system */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
-static struct   job_record **job_hash = NULL;
-static struct   job_record **job_array_hash_j = NULL;
-static struct   job_record **job_array_hash_t = NULL;
+static id_hash_t *job_hash = NULL;		/* by job_id */
+static id_hash_t *job_array_hash_j = NULL;	/* by array_job_id, first
+						 * job_array_next_j entry */
+static id_hash_t *job_array_hash_t = NULL;	/* by array_job_id and
+						 * array_task_id */
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
@@ -173,9 +240,35 @@ static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
 static bool     validate_cfgd_licenses = true;
 
+/* Job record change tracking for SHOW_DELTA job info requests */
+static pthread_mutex_t job_delta_mutex = PTHREAD_MUTEX_INITIALIZER;
+static time_t   job_delta_horizon = (time_t) 0; /* oldest usable delta */
+static job_tombstone_t *job_tombstones = NULL;	/* purged job ids */
+static int      job_tombstone_cnt = 0;
+static int      job_tombstone_size = 0;
+static uint64_t job_tombstone_base = 0;	/* sequence of job_tombstones[0] */
+
+/* Job record changes, see job_info_changed() */
+static uint64_t job_info_seq = 0;	/* count of changes */
+static uint64_t job_info_all_seq = 0;	/* last change to all jobs */
+static time_t   job_info_all_update = (time_t) 0;
+static uint64_t job_info_sweep_seq = 0;	/* job_info_seq at last sweep */
+
+/* Job state journal, see dump_all_job_state() */
+static bool     job_journal_valid = false; /* journal extends checkpoint */
+static uint64_t job_journal_mark = 0;	/* tombstone sequence journaled */
+static uint32_t job_journal_size = 0;
+static uint32_t job_ckpt_size = 0;
+
+/* Records replaced or purged during job state recovery */
+static job_record_t **retired_jobs = NULL;
+static int retired_job_cnt = 0, retired_job_size = 0;
+
 /* Local functions */
 static void _add_job_hash(job_record_t *job_ptr);
 static void _add_job_array_hash(job_record_t *job_ptr);
+static void _add_recovered_job(job_record_t *job_ptr);
+static job_record_t *_alloc_job_record(void);
 static void _clear_job_gres_details(job_record_t *job_ptr);
 static int  _copy_job_desc_to_file(job_desc_msg_t * job_desc,
 				   uint32_t job_id);
@@ -185,16 +278,19 @@ static int  _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
 					 bitstr_t ** req_bitmap);
 static char *_copy_nodelist_no_dup(char *node_list);
 static job_record_t *_create_job_record(uint32_t num_jobs);
-static void _delete_job_details(job_record_t *job_entry);
+static void _delete_job_common(job_record_t *job_ptr);
+static void _delete_job_details(job_record_t *job_entry, bool purge_files);
 static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	char *resv_name, slurmdb_assoc_rec_t *assoc_ptr,
 	bool operator, slurmdb_qos_rec_t *qos_rec, int *error_code,
 	bool locked, log_level_t log_lvl);
 static void _dump_job_details(struct job_details *detail_ptr, Buf buffer);
-static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer);
+static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer,
+			    job_state_offsets_t *offsets);
 static void _dump_job_fed_details(job_fed_details_t *fed_details_ptr,
 				  Buf buffer);
 static job_fed_details_t *_dup_job_fed_details(job_fed_details_t *src);
+static void _free_job_record(job_record_t *job_ptr, bool purge_files);
 static void _get_batch_job_dir_ids(List batch_dirs);
 static bool _get_whole_hetjob(void);
 static void _job_array_comp(job_record_t *job_ptr, bool was_running,
@@ -202,6 +298,7 @@ static void _job_array_comp(job_record_t *job_ptr, bool was_running,
 static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 			job_record_t **job_rec_ptr, uid_t submit_uid,
 			char **err_msg, uint16_t protocol_version);
+static int  _job_count_size(job_record_t *job_ptr);
 static void _job_timed_out(job_record_t *job_ptr, bool preempted);
 static void _kill_dependent(job_record_t *job_ptr);
 static void _list_delete_job(void *job_entry);
@@ -223,7 +320,10 @@ static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      Buf buffer,
 				      uint16_t protocol_version);
 static bool _parse_array_tok(char *tok, bitstr_t *array_bitmap, uint32_t max);
+static void _purge_missing_job(job_record_t *job_ptr, int node_inx,
+			       time_t now);
 static void _purge_missing_jobs(int node_inx, time_t now);
+static void _purge_retired_jobs(void);
 static int  _read_data_array_from_file(int fd, char *file_name, char ***data,
 				       uint32_t *size, job_record_t *job_ptr);
 static void _remove_defunct_batch_dirs(List batch_dirs);
@@ -238,15 +338,19 @@ static void _resp_array_free(resp_array_struct_t *resp);
 static job_array_resp_msg_t *_resp_array_xlate(resp_array_struct_t *resp,
 					       uint32_t job_id);
 static int  _resume_job_nodes(job_record_t *job_ptr, bool indf_susp);
+static void _retire_job_record(job_record_t *job_ptr);
 static void _send_job_kill(job_record_t *job_ptr);
 static int  _set_job_id(job_record_t *job_ptr);
 static void _set_job_requeue_exit_value(job_record_t *job_ptr);
 static void _signal_batch_job(job_record_t *job_ptr, uint16_t signal,
 			      uint16_t flags);
 static void _signal_job(job_record_t *job_ptr, int signal, uint16_t flags);
+static void _sub_job_count(job_record_t *job_ptr);
 static void _suspend_job(job_record_t *job_ptr, uint16_t op, bool indf_susp);
 static int  _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp);
 static bool _top_priority(job_record_t *job_ptr, uint32_t het_job_offset);
+static int  _unpack_job_state(Buf buffer, uint16_t protocol_version,
+			      job_record_t **job_pptr);
 static int  _valid_job_part(job_desc_msg_t *job_desc, uid_t submit_uid,
 			    bitstr_t *req_bitmap, part_record_t *part_ptr,
 			    List part_ptr_list,
@@ -582,6 +686,32 @@ static job_array_resp_msg_t *_resp_array_xlate(resp_array_struct_t *resp,
 	return msg;
 }
 
+/*
+ * _alloc_job_record - allocate an empty job_record including job_details
+ *	without adding it to job_list or job_count
+ * RET pointer to the record
+ */
+static job_record_t *_alloc_job_record(void)
+{
+	job_record_t *job_ptr = xmalloc(sizeof(*job_ptr));
+	struct job_details *detail_ptr = xmalloc(sizeof(*detail_ptr));
+
+	job_ptr->magic = JOB_MAGIC;
+	job_ptr->array_task_id = NO_VAL;
+	job_ptr->details = detail_ptr;
+	job_ptr->prio_factors = xmalloc(sizeof(priority_factors_object_t));
+	job_ptr->site_factor = NICE_OFFSET;
+	job_ptr->step_list = list_create(free_step_record);
+
+	detail_ptr->magic = DETAILS_MAGIC;
+	detail_ptr->submit_time = time(NULL);
+	job_ptr->requid = -1; /* force to -1 for sacct to know this
+			       * hasn't been set yet  */
+	job_ptr->billable_tres = (double)NO_VAL;
+
+	return job_ptr;
+}
+
 /*
  * _create_job_record - create an empty job_record including job_details.
  *	load its values with defaults (zeros, nulls, and magic cookie)
@@ -594,8 +724,7 @@ static job_array_resp_msg_t *_resp_array_xlate(resp_array_struct_t *resp,
  */
 static job_record_t *_create_job_record(uint32_t num_jobs)
 {
-	job_record_t *job_ptr = xmalloc(sizeof(*job_ptr));
-	struct job_details *detail_ptr = xmalloc(sizeof(*detail_ptr));
+	job_record_t *job_ptr;
 
 	if ((job_count + num_jobs) >= slurm_conf.max_job_cnt) {
 		error("%s: MaxJobCount limit from slurm.conf reached (%u)",
@@ -603,20 +732,9 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 	}
 
 	job_count += num_jobs;
-	last_job_update = time(NULL);
 
-	job_ptr->magic = JOB_MAGIC;
-	job_ptr->array_task_id = NO_VAL;
-	job_ptr->details = detail_ptr;
-	job_ptr->prio_factors = xmalloc(sizeof(priority_factors_object_t));
-	job_ptr->site_factor = NICE_OFFSET;
-	job_ptr->step_list = list_create(free_step_record);
-
-	detail_ptr->magic = DETAILS_MAGIC;
-	detail_ptr->submit_time = time(NULL);
-	job_ptr->requid = -1; /* force to -1 for sacct to know this
-			       * hasn't been set yet  */
-	job_ptr->billable_tres = (double)NO_VAL;
+	job_ptr = _alloc_job_record();
+	job_info_changed(job_ptr, time(NULL));
 	(void) list_append(job_list, job_ptr);
 
 	return job_ptr;
@@ -626,8 +744,10 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 /*
  * _delete_job_details - delete a job's detail record and clear it's pointer
  * IN job_entry - pointer to job_record to clear the record of
+ * IN purge_files - queue the batch script and environment of a finished job
+ *	for deletion
  */
-static void _delete_job_details(job_record_t *job_entry)
+static void _delete_job_details(job_record_t *job_entry, bool purge_files)
 {
 	int i;
 
@@ -641,7 +761,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	 * This is handled by a separate thread to limit the amount of
 	 * time purge_old_job needs to spend holding locks.
 	 */
-	if (IS_JOB_FINISHED(job_entry)) {
+	if (purge_files && IS_JOB_FINISHED(job_entry)) {
 		uint32_t *job_id = xmalloc(sizeof(uint32_t));
 		*job_id = job_entry->job_id;
 		list_enqueue(purge_files_list, job_id);
@@ -791,8 +911,255 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+/* FNV-1a 64 hash of size bytes at buf, continuing from digest */
+static uint64_t _hash_job_data(uint64_t digest, char *buf, uint32_t size)
+{
+	unsigned char *data = (unsigned char *) buf;
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		digest ^= data[i];
+		digest *= 0x100000001b3ULL;
+	}
+
+	return digest;
+}
+
+/*
+ * Hash the record written by _dump_job_state() from rec_offset to the end of
+ * buffer. Values refreshed by every scheduling pass (last_sched_eval, the
+ * expected start time of a pending job and the scheduler's test flags) are
+ * masked out so that they alone never cause the record to be journaled again.
+ */
+static uint64_t _job_state_digest(job_record_t *job_ptr, Buf buffer,
+				  uint32_t rec_offset,
+				  job_state_offsets_t *offsets)
+{
+	char *data = get_buf_data(buffer);
+	char save_times[24], save_flags[4];
+	uint32_t bit_flags;
+	uint64_t digest;
+
+	/* last_sched_eval, preempt_time, start_time are 8 bytes each */
+	memcpy(save_times, data + offsets->sched_eval, sizeof(save_times));
+	memset(data + offsets->sched_eval, 0, 8);
+	if (IS_JOB_PENDING(job_ptr))
+		memset(data + offsets->sched_eval + 16, 0, 8);
+	memcpy(save_flags, data + offsets->bit_flags, sizeof(save_flags));
+	memcpy(&bit_flags, save_flags, sizeof(bit_flags));
+	bit_flags = htonl(ntohl(bit_flags) & ~(BACKFILL_TEST | TEST_NOW_ONLY));
+	memcpy(data + offsets->bit_flags, &bit_flags, sizeof(bit_flags));
+
+	digest = _hash_job_data(JOB_DIGEST_INIT, data + rec_offset,
+				get_buf_offset(buffer) - rec_offset);
+
+	memcpy(data + offsets->sched_eval, save_times, sizeof(save_times));
+	memcpy(data + offsets->bit_flags, save_flags, sizeof(save_flags));
+
+	return digest;
+}
+
+/* Write the full contents of buffer to fd, RET 0 or errno */
+static int _write_job_state_buf(int fd, Buf buffer, char *file_name)
+{
+	int pos = 0, nwrite, amount;
+	char *data;
+
+	nwrite = get_buf_offset(buffer);
+	data = (char *)get_buf_data(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file_name);
+			return errno;
+		}
+		nwrite -= amount;
+		pos    += amount;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* Overwrite the value packed at offset of buffer with a new 32 bit value */
+static void _repack32(uint32_t val, uint32_t offset, Buf buffer)
+{
+	uint32_t end_offset = get_buf_offset(buffer);
+
+	set_buf_offset(buffer, offset);
+	pack32(val, buffer);
+	set_buf_offset(buffer, end_offset);
+}
+
+/*
+ * Start a new, empty job state journal extending the checkpoint written at
+ *	ckpt_time. Call with lock_state_files() held.
+ */
+static void _create_job_journal(time_t ckpt_time)
+{
+	char *journal_file, *new_file;
+	int fd, error_code;
+	Buf buffer = init_buf(BUF_SIZE);
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	new_file = xstrdup_printf("%s.new", journal_file);
+
+	packstr(JOB_STATE_VERSION, buffer);
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack_time(ckpt_time, buffer);
+
+	fd = open(new_file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0600);
+	if (fd < 0) {
+		error("Can't create job state journal %s: %m", new_file);
+		error_code = errno;
+	} else {
+		error_code = _write_job_state_buf(fd, buffer, new_file);
+		if (!error_code)
+			error_code = fsync_and_close(fd, "job journal");
+		else
+			(void) close(fd);
+	}
+	if (!error_code && rename(new_file, journal_file)) {
+		error("Can't rename %s to %s: %m", new_file, journal_file);
+		error_code = errno;
+	}
+	if (error_code) {
+		(void) unlink(new_file);
+		job_journal_valid = false;
+	} else {
+		job_journal_valid = true;
+		job_journal_size = get_buf_offset(buffer);
+	}
+
+	xfree(journal_file);
+	xfree(new_file);
+	free_buf(buffer);
+}
+
+/*
+ * Append one batch to the job state journal holding the records of jobs
+ *	whose saved state changed since the last dump and the ids of jobs
+ *	purged since then.
+ * IN now - time stamp of the batch
+ * OUT compact - set if a full checkpoint must be written instead
+ * RET 0 or error code
+ */
+static int _append_job_journal(time_t now, bool *compact)
+{
+	/* Locks: Read config and job */
+	slurmctld_lock_t job_read_lock =
+		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+	static int high_buffer_size = BUF_SIZE;
+	uint32_t update_cnt = 0, update_offset, rec_offset, rec_len;
+	job_state_offsets_t offsets;
+	uint32_t purge_cnt, batch_len;
+	uint64_t journal_mark, digest;
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	char *journal_file;
+	int i, fd, error_code = SLURM_SUCCESS;
+	Buf buffer;
+
+	lock_slurmctld(job_read_lock);
+	slurm_mutex_lock(&job_delta_mutex);
+	if (job_journal_mark < job_tombstone_base) {
+		/* Purged job ids not yet journaled have been discarded */
+		slurm_mutex_unlock(&job_delta_mutex);
+		unlock_slurmctld(job_read_lock);
+		*compact = true;
+		return SLURM_SUCCESS;
+	}
+
+	buffer = init_buf(high_buffer_size);
+	pack32(0, buffer);	/* batch length, filled in below */
+	pack_time(now, buffer);
+	pack32(job_id_sequence, buffer);
+
+	journal_mark = job_tombstone_base + job_tombstone_cnt;
+	purge_cnt = journal_mark - job_journal_mark;
+	pack32(purge_cnt, buffer);
+	for (i = job_journal_mark - job_tombstone_base;
+	     i < job_tombstone_cnt; i++)
+		pack32(job_tombstones[i].job_id, buffer);
+	slurm_mutex_unlock(&job_delta_mutex);
+
+	update_offset = get_buf_offset(buffer);
+	pack32(update_cnt, buffer);	/* filled in below */
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if (job_ptr->job_id == NO_VAL)
+			continue;
+		rec_offset = get_buf_offset(buffer);
+		pack32(job_ptr->job_id, buffer);
+		pack32(0, buffer);	/* record length, filled in below */
+		_dump_job_state(job_ptr, buffer, &offsets);
+		rec_len = get_buf_offset(buffer) - rec_offset - 8;
+		digest = _job_state_digest(job_ptr, buffer, rec_offset + 8,
+					   &offsets);
+		if (digest == job_ptr->state_digest) {
+			/* Unchanged since last saved, drop the record */
+			set_buf_offset(buffer, rec_offset);
+			continue;
+		}
+		job_ptr->state_digest = digest;
+		_repack32(rec_len, rec_offset + 4, buffer);
+		update_cnt++;
+	}
+	list_iterator_destroy(job_iterator);
+	unlock_slurmctld(job_read_lock);
+
+	if (!purge_cnt && !update_cnt) {
+		free_buf(buffer);
+		return SLURM_SUCCESS;
+	}
+	_repack32(update_cnt, update_offset, buffer);
+	batch_len = get_buf_offset(buffer) - 4;
+	_repack32(batch_len, 0, buffer);
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	lock_state_files();
+	fd = open(journal_file, O_WRONLY|O_APPEND|O_CLOEXEC);
+	if (fd < 0) {
+		error("Can't append to job state journal %s: %m",
+		      journal_file);
+		error_code = errno;
+	} else {
+		error_code = _write_job_state_buf(fd, buffer, journal_file);
+		if (!error_code)
+			error_code = fsync_and_close(fd, "job journal");
+		else
+			(void) close(fd);
+	}
+	unlock_state_files();
+
+	if (error_code) {
+		/* A partial batch is ignored on recovery, start over */
+		job_journal_valid = false;
+		*compact = true;
+	} else {
+		debug3("Appended %u job records and %u purged job ids to job state journal",
+		       update_cnt, purge_cnt);
+		job_journal_mark = journal_mark;
+		job_journal_size += get_buf_offset(buffer);
+		/* Compact into a new checkpoint on the next dump */
+		if (job_journal_size > MAX(job_ckpt_size, JOB_JOURNAL_MIN_SIZE))
+			job_journal_valid = false;
+	}
+	xfree(journal_file);
+	free_buf(buffer);
+
+	return error_code;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
+ *	With SlurmctldParameters=job_state_journal only the records of jobs
+ *	changed since the last call are appended to the job_state.journal
+ *	file, which is compacted into a new checkpoint once it outgrows it.
  *	Changes here should be reflected in load_last_job_id() and
  *	load_all_job_state().
  * RET 0 or error code
@@ -809,9 +1176,12 @@ int dump_all_job_state(void)
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
-	Buf buffer = init_buf(high_buffer_size);
+	Buf buffer;
 	time_t now = time(NULL);
 	time_t last_state_file_time;
+	uint32_t rec_offset;
+	job_state_offsets_t offsets;
+	bool journal, compact = false;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -834,7 +1204,24 @@ int dump_all_job_state(void)
 		}
 	}
 
+	journal = xstrcasestr(slurm_conf.slurmctld_params, "job_state_journal");
+	if (journal && job_journal_valid) {
+		error_code = _append_job_journal(now, &compact);
+		if (!compact) {
+			END_TIMER2("dump_all_job_state");
+			return error_code;
+		}
+		error_code = SLURM_SUCCESS;
+	}
+	/*
+	 * The journal is matched to its checkpoint by time stamp, so never
+	 * reuse one.
+	 */
+	if (now <= last_file_write_time)
+		now = last_file_write_time + 1;
+
 	/* write header: version, time */
+	buffer = init_buf(high_buffer_size);
 	packstr(JOB_STATE_VERSION, buffer);
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
 	pack_time(now, buffer);
@@ -849,13 +1236,31 @@ int dump_all_job_state(void)
 	debug3("Writing job id %u to header record of job_state file",
 	       job_id_sequence);
 
-	/* write individual job records */
+	/*
+	 * write individual job records, each preceded by its length so they
+	 * can be unpacked in parallel by load_all_job_state()
+	 */
 	lock_slurmctld(job_read_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
-		_dump_job_state(job_ptr, buffer);
+		rec_offset = get_buf_offset(buffer);
+		pack32(0, buffer);	/* record length, filled in below */
+		_dump_job_state(job_ptr, buffer, &offsets);
+		if (get_buf_offset(buffer) == (rec_offset + 4)) {
+			/* "unlinked" job not saved */
+			set_buf_offset(buffer, rec_offset);
+			continue;
+		}
+		_repack32(get_buf_offset(buffer) - rec_offset - 4, rec_offset,
+			  buffer);
+		job_ptr->state_digest = _job_state_digest(job_ptr, buffer,
+							  rec_offset + 4,
+							  &offsets);
 	}
 	list_iterator_destroy(job_iterator);
+	slurm_mutex_lock(&job_delta_mutex);
+	job_journal_mark = job_tombstone_base + job_tombstone_cnt;
+	slurm_mutex_unlock(&job_delta_mutex);
 
 
 	/* write the buffer to file */
@@ -889,30 +1294,20 @@ int dump_all_job_state(void)
 		      new_file);
 		error_code = errno;
 	} else {
-		int pos = 0, nwrite, amount, rc;
-		char *data;
+		int rc;
 
-		nwrite = get_buf_offset(buffer);
-		data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
+		high_buffer_size = MAX(get_buf_offset(buffer),
+				       high_buffer_size);
+		error_code = _write_job_state_buf(log_fd, buffer, new_file);
 
 		rc = fsync_and_close(log_fd, "job");
 		if (rc && !error_code)
 			error_code = rc;
 	}
-	if (error_code)
+	if (error_code) {
 		(void) unlink(new_file);
-	else {			/* file shuffle */
+		job_journal_valid = false;
+	} else {			/* file shuffle */
 		(void) unlink(old_file);
 		if (link(reg_file, old_file))
 			debug4("unable to create link for %s -> %s: %m",
@@ -923,6 +1318,14 @@ int dump_all_job_state(void)
 			       new_file, reg_file);
 		(void) unlink(new_file);
 		last_file_write_time = now;
+		job_ckpt_size = get_buf_offset(buffer);
+		if (journal)
+			_create_job_journal(now);
+		else {
+			xstrcat(reg_file, ".journal");
+			(void) unlink(reg_file);
+			job_journal_valid = false;
+		}
 	}
 	xfree(old_file);
 	xfree(reg_file);
@@ -997,7 +1400,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
-			last_job_update = time(NULL);
+			job_info_changed(job_ptr, time(NULL));
 		}
 	}
 
@@ -1016,7 +1419,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 			      __func__, job_ptr, qos_rec.name, job_ptr->qos_id);
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
-			last_job_update = time(NULL);
+			job_info_changed(job_ptr, time(NULL));
 		}
 	}
 }
@@ -1068,6 +1471,7 @@ extern void set_job_tres_alloc_str(job_record_t *job_ptr,
 extern void backup_slurmctld_restart(void)
 {
 	last_file_write_time = (time_t) 0;
+	job_journal_valid = false;
 }
 
 /* Return the time stamp in the current job state save file, 0 is returned on
@@ -1102,6 +1506,266 @@ unpack_error:
 	return buf_time;
 }
 
+/*
+ * Replay the job state journal appended to the checkpoint written at
+ *	ckpt_time, see dump_all_job_state(). An incomplete trailing batch
+ *	(e.g. from a crash while appending) is ignored.
+ * IN ckpt_time - time stamp from the job_state file header
+ * IN load_jobs - if false only recover job_id_sequence
+ * RET count of job records recovered or -1 on error
+ */
+static int _load_job_journal(time_t ckpt_time, bool load_jobs)
+{
+	char *journal_file, *ver_str = NULL;
+	uint32_t ver_str_len, batch_len, batch_end, saved_job_id;
+	uint32_t purge_cnt, update_cnt, job_id, rec_len, rec_end, i;
+	uint16_t protocol_version = NO_VAL16;
+	time_t journal_time = 0, batch_time;
+	int rec_cnt = 0, batch_cnt = 0;
+	job_record_t *job_ptr;
+	Buf buffer;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	lock_state_files();
+	buffer = create_mmap_buf(journal_file);
+	unlock_state_files();
+	if (!buffer) {
+		debug("No job state journal (%s) to recover", journal_file);
+		xfree(journal_file);
+		return 0;
+	}
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+		safe_unpack16(&protocol_version, buffer);
+	safe_unpack_time(&journal_time, buffer);
+	if ((protocol_version == NO_VAL16) || (journal_time != ckpt_time)) {
+		info("Ignoring job state journal %s, it does not extend the job state file",
+		     journal_file);
+		goto fini;
+	}
+
+	while (remaining_buf(buffer) > 0) {
+		if ((unpack32(&batch_len, buffer) != SLURM_SUCCESS) ||
+		    (batch_len > remaining_buf(buffer))) {
+			error("Ignoring incomplete batch at end of job state journal %s",
+			      journal_file);
+			break;
+		}
+		batch_end = get_buf_offset(buffer) + batch_len;
+		safe_unpack_time(&batch_time, buffer);
+		safe_unpack32(&saved_job_id, buffer);
+		if (saved_job_id <= slurm_conf.max_job_id)
+			job_id_sequence = MAX(saved_job_id, job_id_sequence);
+		batch_cnt++;
+		if (!load_jobs) {
+			set_buf_offset(buffer, batch_end);
+			continue;
+		}
+
+		safe_unpack32(&purge_cnt, buffer);
+		for (i = 0; i < purge_cnt; i++) {
+			safe_unpack32(&job_id, buffer);
+			if ((job_ptr = find_job_record(job_id)))
+				_retire_job_record(job_ptr);
+		}
+		safe_unpack32(&update_cnt, buffer);
+		for (i = 0; i < update_cnt; i++) {
+			safe_unpack32(&job_id, buffer);
+			safe_unpack32(&rec_len, buffer);
+			rec_end = get_buf_offset(buffer) + rec_len;
+			if (rec_end > batch_end)
+				goto unpack_error;
+			/* Replaces any record recovered earlier */
+			if ((_load_job_state(buffer, protocol_version) !=
+			     SLURM_SUCCESS) ||
+			    (get_buf_offset(buffer) != rec_end))
+				goto unpack_error;
+			rec_cnt++;
+		}
+		if (get_buf_offset(buffer) != batch_end)
+			goto unpack_error;
+		debug3("Replayed job state journal batch from %ld",
+		       (long) batch_time);
+	}
+	if (load_jobs)
+		info("Recovered %d job records from %d job state journal batches",
+		     rec_cnt, batch_cnt);
+
+fini:
+	xfree(ver_str);
+	xfree(journal_file);
+	free_buf(buffer);
+	return rec_cnt;
+
+unpack_error:
+	if (!ignore_state_errors)
+		fatal("Invalid job state journal %s, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.",
+		      journal_file);
+	error("Invalid job state journal %s", journal_file);
+	xfree(ver_str);
+	xfree(journal_file);
+	free_buf(buffer);
+	return -1;
+}
+
+/* Unpack one length prefixed job record from the job_state file */
+static void _unpack_job_record(job_recover_args_t *args, uint32_t inx)
+{
+	Buf rec_buf;
+
+	/* View into the file contents, not to be freed with the record */
+	rec_buf = create_buf(get_buf_data(args->buffer), args->rec_end[inx]);
+	set_buf_offset(rec_buf, args->rec_start[inx]);
+	args->rc[inx] = _unpack_job_state(rec_buf, args->protocol_version,
+					  &args->job_ptrs[inx]);
+	if ((args->rc[inx] == SLURM_SUCCESS) &&
+	    (get_buf_offset(rec_buf) != args->rec_end[inx])) {
+		error("Job state record %u has bad length", inx);
+		if (args->job_ptrs[inx]) {
+			_free_job_record(args->job_ptrs[inx], false);
+			args->job_ptrs[inx] = NULL;
+		}
+		args->rc[inx] = SLURM_ERROR;
+	}
+	rec_buf->head = NULL;
+	free_buf(rec_buf);
+}
+
+/* Job state recovery thread, unpacks batches of records until none remain */
+static void *_unpack_job_records(void *arg)
+{
+	job_recover_args_t *args = arg;
+	uint32_t first, last;
+
+	while (true) {
+		slurm_mutex_lock(&args->mutex);
+		first = args->next_rec;
+		last = MIN(first + JOB_RECOVER_BATCH, args->rec_cnt);
+		args->next_rec = last;
+		slurm_mutex_unlock(&args->mutex);
+		if (first >= last)
+			break;
+		for (uint32_t i = first; i < last; i++)
+			_unpack_job_record(args, i);
+	}
+
+	return NULL;
+}
+
+/*
+ * Number of threads to use to unpack rec_cnt job records, set with
+ *	SlurmctldParameters=recover_threads=#
+ */
+static int _recover_thread_cnt(uint32_t rec_cnt)
+{
+	char *tmp_ptr;
+	long thread_cnt;
+
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "recover_threads="))) {
+		thread_cnt = strtol(tmp_ptr + strlen("recover_threads="),
+				    NULL, 10);
+		if (thread_cnt < 1) {
+			error("Invalid SlurmctldParameters recover_threads: %s",
+			      tmp_ptr);
+			thread_cnt = 1;
+		}
+	} else {
+		thread_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_cnt = MIN(thread_cnt, JOB_RECOVER_THREADS);
+	}
+	if (rec_cnt < JOB_RECOVER_MIN_CNT)
+		thread_cnt = 1;
+	thread_cnt = MIN(thread_cnt, (rec_cnt / JOB_RECOVER_BATCH) + 1);
+
+	return MAX(thread_cnt, 1);
+}
+
+/*
+ * Recover the length prefixed job records of a job_state file. Records are
+ *	unpacked by several threads, then added to job_list in file order.
+ * IN buffer - job_state file contents, positioned after the header
+ * IN protocol_version - version the file was saved with
+ * OUT job_cnt - count of job records recovered
+ * RET SLURM_SUCCESS or SLURM_ERROR if any record could not be recovered
+ */
+static int _load_job_records(Buf buffer, uint16_t protocol_version,
+			     int *job_cnt)
+{
+	job_recover_args_t args;
+	pthread_t *thread_ids = NULL;
+	uint32_t rec_len, rec_size = 1024;
+	int i, thread_cnt, error_code = SLURM_SUCCESS;
+	DEF_TIMERS;
+
+	START_TIMER;
+	memset(&args, 0, sizeof(args));
+	args.buffer = buffer;
+	args.protocol_version = protocol_version;
+	args.rec_start = xcalloc(rec_size, sizeof(uint32_t));
+	args.rec_end = xcalloc(rec_size, sizeof(uint32_t));
+	while (remaining_buf(buffer) > 0) {
+		if ((unpack32(&rec_len, buffer) != SLURM_SUCCESS) ||
+		    (rec_len > remaining_buf(buffer))) {
+			error("Incomplete job record");
+			error_code = SLURM_ERROR;
+			break;
+		}
+		if (args.rec_cnt >= rec_size) {
+			rec_size *= 2;
+			xrecalloc(args.rec_start, rec_size, sizeof(uint32_t));
+			xrecalloc(args.rec_end, rec_size, sizeof(uint32_t));
+		}
+		args.rec_start[args.rec_cnt] = get_buf_offset(buffer);
+		args.rec_end[args.rec_cnt] = get_buf_offset(buffer) + rec_len;
+		set_buf_offset(buffer, args.rec_end[args.rec_cnt]);
+		args.rec_cnt++;
+	}
+	args.job_ptrs = xcalloc(args.rec_cnt + 1, sizeof(job_record_t *));
+	args.rc = xcalloc(args.rec_cnt + 1, sizeof(int));
+	slurm_mutex_init(&args.mutex);
+
+	/* This thread unpacks records too */
+	thread_cnt = _recover_thread_cnt(args.rec_cnt);
+	if (thread_cnt > 1)
+		thread_ids = xcalloc(thread_cnt - 1, sizeof(pthread_t));
+	for (i = 0; i < (thread_cnt - 1); i++)
+		slurm_thread_create(&thread_ids[i], _unpack_job_records, &args);
+	_unpack_job_records(&args);
+	for (i = 0; i < (thread_cnt - 1); i++)
+		pthread_join(thread_ids[i], NULL);
+	xfree(thread_ids);
+	slurm_mutex_destroy(&args.mutex);
+	END_TIMER;
+	info("Unpacked %u job records using %d threads in %s",
+	     args.rec_cnt, thread_cnt, TIME_STR);
+
+	START_TIMER;
+	for (uint32_t j = 0; j < args.rec_cnt; j++) {
+		if (args.rc[j] != SLURM_SUCCESS) {
+			if (!ignore_state_errors)
+				fatal("Incomplete job state save file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
+			error_code = SLURM_ERROR;
+			continue;
+		}
+		if (!args.job_ptrs[j])
+			continue;	/* "unlinked" job */
+		_add_recovered_job(args.job_ptrs[j]);
+		(*job_cnt)++;
+	}
+	END_TIMER;
+	info("Added %d recovered job records in %s", *job_cnt, TIME_STR);
+
+	xfree(args.rec_start);
+	xfree(args.rec_end);
+	xfree(args.job_ptrs);
+	xfree(args.rc);
+
+	return error_code;
+}
+
 /*
  * load_all_job_state - load the job state from file, recover from last
  *	checkpoint. Execute this after loading the configuration file data.
@@ -1119,6 +1783,7 @@ extern int load_all_job_state(void)
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	DEF_TIMERS;
 
 	/* read the file */
 	lock_state_files();
@@ -1160,24 +1825,39 @@ extern int load_all_job_state(void)
 	 * out that created a double lock when steps were being loaded during
 	 * the calls to jobacctinfo_create() which also locks the read lock.
 	 * It ended up being much easier to move the locks for the assoc_mgr
-	 * into the _load_job_state function than any other option.
+	 * into the _add_recovered_job function than any other option.
 	 */
-	while (remaining_buf(buffer) > 0) {
-		error_code = _load_job_state(buffer, protocol_version);
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+		error_code = _load_job_records(buffer, protocol_version,
+					       &job_cnt);
 		if (error_code != SLURM_SUCCESS)
-			goto unpack_error;
-		job_cnt++;
+			error("Incomplete job state save file");
+	} else {
+		while (remaining_buf(buffer) > 0) {
+			error_code = _load_job_state(buffer, protocol_version);
+			if (error_code != SLURM_SUCCESS)
+				goto unpack_error;
+			job_cnt++;
+		}
 	}
+	free_buf(buffer);
+
+	START_TIMER;
+	if (_load_job_journal(buf_time, true) < 0)
+		error_code = SLURM_ERROR;
+	_purge_retired_jobs();
+	END_TIMER;
+	debug("Recovered job state journal in %s", TIME_STR);
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
-	free_buf(buffer);
-	info("Recovered information about %d jobs", job_cnt);
+	info("Recovered information about %d jobs", list_count(job_list));
 	return error_code;
 
 unpack_error:
 	if (!ignore_state_errors)
 		fatal("Incomplete job state save file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
 	error("Incomplete job state save file");
+	_purge_retired_jobs();
 	info("Recovered information about %d jobs", job_cnt);
 	free_buf(buffer);
 	return SLURM_ERROR;
@@ -1232,6 +1912,7 @@ extern int load_last_job_id( void )
 
 	xfree(ver_str);
 	free_buf(buffer);
+	(void) _load_job_journal(buf_time, false);
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -1288,7 +1969,8 @@ unpack_error:
  * IN dump_job_ptr - pointer to job for which information is requested
  * IN/OUT buffer - location to store data, pointers automatically advanced
  */
-static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
+static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer,
+			    job_state_offsets_t *offsets)
 {
 	struct job_details *detail_ptr;
 	uint32_t tmp_32;
@@ -1353,6 +2035,8 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	pack32(dump_job_ptr->profile, buffer);
 	pack32(dump_job_ptr->db_flags, buffer);
 
+	if (offsets)
+		offsets->sched_eval = get_buf_offset(buffer);
 	pack_time(dump_job_ptr->last_sched_eval, buffer);
 	pack_time(dump_job_ptr->preempt_time, buffer);
 	pack_time(dump_job_ptr->start_time, buffer);
@@ -1443,6 +2127,8 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	list_for_each(dump_job_ptr->step_list, dump_job_step_state, buffer);
 
 	pack16((uint16_t) 0, buffer);	/* no step flag */
+	if (offsets)
+		offsets->bit_flags = get_buf_offset(buffer);
 	pack32(dump_job_ptr->bit_flags, buffer);
 	packstr(dump_job_ptr->tres_alloc_str, buffer);
 	packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
@@ -1464,10 +2150,18 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	packstr(dump_job_ptr->tres_per_task, buffer);
 }
 
-/* Unpack a job's state information from a buffer */
-/* NOTE: assoc_mgr qos, tres and assoc read lock must be unlocked before
- * calling */
-static int _load_job_state(Buf buffer, uint16_t protocol_version)
+/*
+ * Unpack a job's state information from a buffer into a new job record which
+ *	is not yet in job_list or the job hash tables, see _add_recovered_job().
+ *	Only touches global state that is safe to access from several recovery
+ *	threads at once.
+ * IN/OUT buffer - location to read the record from
+ * IN protocol_version - version the record was saved with
+ * OUT job_pptr - the job record, NULL if the record is to be skipped
+ * RET SLURM_SUCCESS or error code
+ */
+static int _unpack_job_state(Buf buffer, uint16_t protocol_version,
+			     job_record_t **job_pptr)
 {
 	uint64_t db_index;
 	uint32_t job_id, user_id, group_id, time_limit, priority, alloc_sid;
@@ -1509,24 +2203,18 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	List gres_list = NULL, part_ptr_list = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
-	int error_code, i, qos_error, rc;
+	int error_code, i, rc;
 	dynamic_plugin_data_t *select_jobinfo = NULL;
 	job_resources_t *job_resources = NULL;
-	slurmdb_assoc_rec_t assoc_rec;
-	slurmdb_qos_rec_t qos_rec;
-	bool job_finished = false;
 	double billable_tres = (double)NO_VAL;
 	char *tres_alloc_str = NULL, *tres_fmt_alloc_str = NULL,
 		*tres_req_str = NULL, *tres_fmt_req_str = NULL;
 	uint32_t pelog_env_size = 0;
 	char **pelog_env = (char **) NULL;
 	job_fed_details_t *job_fed_details = NULL;
-	assoc_mgr_lock_t locks = { .assoc = READ_LOCK,
-				   .qos = READ_LOCK,
-				   .tres = READ_LOCK,
-				   .user = READ_LOCK };
 	char *tmp_ptr = NULL;
 
+	*job_pptr = NULL;
 	memset(&limit_set, 0, sizeof(limit_set));
 	limit_set.tres = xcalloc(slurmctld_tres_cnt, sizeof(uint16_t));
 
@@ -1560,18 +2248,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -1783,18 +2463,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -2011,18 +2683,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -2250,11 +2914,6 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 		goto unpack_error;
 	}
 
-	if ((priority > 1) && (direct_set_prio == 0)) {
-		highest_prio = MAX(highest_prio, priority);
-		lowest_prio  = MIN(lowest_prio,  priority);
-	}
-
 #if 0
 	/*
 	 * This is not necessary since the job_id_sequence is checkpointed and
@@ -2423,9 +3082,6 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			job_ptr->array_recs->task_cnt =
 				bit_set_count(job_ptr->array_recs->
 					      task_id_bitmap);
-
-			if (job_ptr->array_recs->task_cnt > 1)
-				job_count += (job_ptr->array_recs->task_cnt-1);
 		} else
 			xfree(task_id_str);
 		job_ptr->array_recs->array_flags    = array_flags;
@@ -2471,6 +3127,153 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	job_ptr->best_switch     = true;
 	job_ptr->start_protocol_ver = start_protocol_ver;
 
+	gres_build_job_details(job_ptr->gres_list,
+			       &job_ptr->gres_detail_cnt,
+			       &job_ptr->gres_detail_str,
+			       &job_ptr->gres_used);
+	job_ptr->clusters     = clusters;
+	job_ptr->fed_details  = job_fed_details;
+	*job_pptr = job_ptr;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("Incomplete job record");
+	rc = SLURM_ERROR;
+
+free_it:
+	xfree(alloc_node);
+	xfree(account);
+	xfree(admin_comment);
+	xfree(batch_features);
+	xfree(batch_host);
+	xfree(burst_buffer);
+	xfree(clusters);
+	xfree(comment);
+	xfree(gres_used);
+	xfree(het_job_id_set);
+	free_job_fed_details(&job_fed_details);
+	free_job_resources(&job_resources);
+	xfree(resp_host);
+	xfree(licenses);
+	xfree(limit_set.tres);
+	xfree(mail_user);
+	xfree(mcs_label);
+	xfree(name);
+	xfree(nodes);
+	xfree(nodes_completing);
+	xfree(partition);
+	FREE_NULL_LIST(part_ptr_list);
+	xfree(resv_name);
+	for (i = 0; i < spank_job_env_size; i++)
+		xfree(spank_job_env[i]);
+	xfree(spank_job_env);
+	xfree(state_desc);
+	xfree(system_comment);
+	xfree(task_id_str);
+	xfree(tres_alloc_str);
+	xfree(tres_fmt_alloc_str);
+	xfree(tres_fmt_req_str);
+	xfree(tres_req_str);
+	xfree(user_name);
+	xfree(wckey);
+	select_g_select_jobinfo_free(select_jobinfo);
+	if (job_ptr)
+		_free_job_record(job_ptr, false);
+	for (i = 0; i < pelog_env_size; i++)
+		xfree(pelog_env[i]);
+	xfree(pelog_env);
+
+	return rc;
+}
+
+/*
+ * Remove a job record from the job hash tables and job_count, to be removed
+ *	from job_list by _purge_retired_jobs() once job state recovery is
+ *	complete. Unlike purge_job_record() this is O(1) and keeps the job's
+ *	files, as the record is being replaced or its job purged earlier.
+ */
+static void _retire_job_record(job_record_t *job_ptr)
+{
+	_delete_job_common(job_ptr);
+	_sub_job_count(job_ptr);
+	if (retired_job_cnt >= retired_job_size) {
+		retired_job_size = MAX(1024, retired_job_size * 2);
+		xrealloc(retired_jobs, sizeof(job_record_t *) *
+			 retired_job_size);
+	}
+	retired_jobs[retired_job_cnt++] = job_ptr;
+}
+
+static int _cmp_job_ptr(const void *x, const void *y)
+{
+	uintptr_t a = (uintptr_t) *(job_record_t **) x;
+	uintptr_t b = (uintptr_t) *(job_record_t **) y;
+
+	return (a > b) - (a < b);
+}
+
+/* Remove the records passed to _retire_job_record() from job_list */
+static void _purge_retired_jobs(void)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+
+	if (!retired_job_cnt)
+		return;
+
+	qsort(retired_jobs, retired_job_cnt, sizeof(job_record_t *),
+	      _cmp_job_ptr);
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if (!bsearch(&job_ptr, retired_jobs, retired_job_cnt,
+			     sizeof(job_record_t *), _cmp_job_ptr))
+			continue;
+		list_remove(job_iterator);
+		job_ptr->magic = 0;
+		_free_job_record(job_ptr, false);
+	}
+	list_iterator_destroy(job_iterator);
+	last_job_update = time(NULL);
+
+	xfree(retired_jobs);
+	retired_job_cnt = retired_job_size = 0;
+}
+
+/*
+ * Add a job record built by _unpack_job_state() to job_list and the job hash
+ *	tables, replacing any record recovered earlier for the same job, and
+ *	validate its association and QOS.
+ * NOTE: assoc_mgr qos, tres and assoc read lock must be unlocked before
+ *	calling
+ */
+static void _add_recovered_job(job_record_t *job_ptr)
+{
+	job_record_t *old_job_ptr;
+	slurmdb_assoc_rec_t assoc_rec;
+	slurmdb_qos_rec_t qos_rec;
+	bool job_finished = false;
+	int qos_error;
+	assoc_mgr_lock_t locks = { .assoc = READ_LOCK,
+				   .qos = READ_LOCK,
+				   .tres = READ_LOCK,
+				   .user = READ_LOCK };
+
+	if ((old_job_ptr = find_job_record(job_ptr->job_id)))
+		_retire_job_record(old_job_ptr);
+
+	if ((job_ptr->priority > 1) && (job_ptr->direct_set_prio == 0)) {
+		highest_prio = MAX(highest_prio, job_ptr->priority);
+		lowest_prio  = MIN(lowest_prio,  job_ptr->priority);
+	}
+
+	if ((job_count + _job_count_size(job_ptr)) >= slurm_conf.max_job_cnt) {
+		error("%s: MaxJobCount limit from slurm.conf reached (%u)",
+		      __func__, slurm_conf.max_job_cnt);
+	}
+
+	job_count += _job_count_size(job_ptr);
+	job_info_changed(job_ptr, time(NULL));
+	(void) list_append(job_list, job_ptr);
 	_add_job_hash(job_ptr);
 	_add_job_array_hash(job_ptr);
 
@@ -2569,63 +3372,19 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	assoc_mgr_unlock(&locks);
 
 	build_node_details(job_ptr, false);	/* set node_addr */
-	gres_build_job_details(job_ptr->gres_list,
-			       &job_ptr->gres_detail_cnt,
-			       &job_ptr->gres_detail_str,
-			       &job_ptr->gres_used);
-	job_ptr->clusters     = clusters;
-	job_ptr->fed_details  = job_fed_details;
-	return SLURM_SUCCESS;
+}
 
-unpack_error:
-	error("Incomplete job record");
-	rc = SLURM_ERROR;
+/* Unpack a job's state information from a buffer and add it to job_list */
+/* NOTE: assoc_mgr qos, tres and assoc read lock must be unlocked before
+ * calling */
+static int _load_job_state(Buf buffer, uint16_t protocol_version)
+{
+	job_record_t *job_ptr = NULL;
+	int rc;
 
-free_it:
-	xfree(alloc_node);
-	xfree(account);
-	xfree(admin_comment);
-	xfree(batch_features);
-	xfree(batch_host);
-	xfree(burst_buffer);
-	xfree(clusters);
-	xfree(comment);
-	xfree(gres_used);
-	xfree(het_job_id_set);
-	free_job_fed_details(&job_fed_details);
-	free_job_resources(&job_resources);
-	xfree(resp_host);
-	xfree(licenses);
-	xfree(limit_set.tres);
-	xfree(mail_user);
-	xfree(mcs_label);
-	xfree(name);
-	xfree(nodes);
-	xfree(nodes_completing);
-	xfree(partition);
-	FREE_NULL_LIST(part_ptr_list);
-	xfree(resv_name);
-	for (i = 0; i < spank_job_env_size; i++)
-		xfree(spank_job_env[i]);
-	xfree(spank_job_env);
-	xfree(state_desc);
-	xfree(system_comment);
-	xfree(task_id_str);
-	xfree(tres_alloc_str);
-	xfree(tres_fmt_alloc_str);
-	xfree(tres_fmt_req_str);
-	xfree(tres_req_str);
-	xfree(user_name);
-	xfree(wckey);
-	select_g_select_jobinfo_free(select_jobinfo);
-	if (job_ptr) {
-		if (job_ptr->job_id == 0)
-			job_ptr->job_id = NO_VAL;
-		purge_job_record(job_ptr->job_id);
-	}
-	for (i = 0; i < pelog_env_size; i++)
-		xfree(pelog_env[i]);
-	xfree(pelog_env);
+	rc = _unpack_job_state(buffer, protocol_version, &job_ptr);
+	if ((rc == SLURM_SUCCESS) && job_ptr)
+		_add_recovered_job(job_ptr);
 
 	return rc;
 }
@@ -2990,11 +3749,7 @@ unpack_error:
  */
 static void _add_job_hash(job_record_t *job_ptr)
 {
-	int inx;
-
-	inx = JOB_HASH_INX(job_ptr->job_id);
-	job_ptr->job_next = job_hash[inx];
-	job_hash[inx] = job_ptr;
+	id_hash_add(job_hash, job_ptr->job_id, job_ptr);
 }
 
 /* _remove_job_hash - remove a job hash entry for given job record, job_id must
@@ -3005,80 +3760,54 @@ static void _add_job_hash(job_record_t *job_ptr)
  */
 static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 {
-	job_record_t *job_ptr, **job_pptr;
+	job_record_t *job_next;
 
 	xassert(job_entry);
 
 	switch (type) {
 	case JOB_HASH_JOB:
-		job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
+		if (id_hash_remove(job_hash, job_entry->job_id, job_entry) ||
+		    (job_entry->job_id == NO_VAL))
+			return;
+		error("%s: Could not find hash entry for JobId=%u",
+		      __func__, job_entry->job_id);
 		break;
 	case JOB_HASH_ARRAY_JOB:
-		job_pptr = &job_array_hash_j[
-			JOB_HASH_INX(job_entry->array_job_id)];
-		break;
-	case JOB_HASH_ARRAY_TASK:
-		job_pptr = &job_array_hash_t[
-			JOB_ARRAY_HASH_INX(job_entry->array_job_id,
-					   job_entry->array_task_id)];
-		break;
-	default:
-		fatal("%s: unknown job_hash_type_t %d", __func__, type);
-		return;
-	}
-
-	while ((job_pptr != NULL) && (*job_pptr != NULL) &&
-	       ((job_ptr = *job_pptr) != job_entry)) {
-		xassert(job_ptr->magic == JOB_MAGIC);
-		switch (type) {
-		case JOB_HASH_JOB:
-			job_pptr = &job_ptr->job_next;
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			job_pptr = &job_ptr->job_array_next_j;
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			job_pptr = &job_ptr->job_array_next_t;
-			break;
-		}
-	}
-
-	if (job_pptr == NULL || *job_pptr == NULL) {
-		if (job_entry->job_id == NO_VAL)
+		job_next = job_entry->job_array_next_j;
+		if (job_entry->job_array_prev_j) {
+			job_entry->job_array_prev_j->job_array_next_j =
+				job_next;
+		} else if (id_hash_remove(job_array_hash_j,
+					  job_entry->array_job_id,
+					  job_entry)) {
+			if (job_next)
+				id_hash_add(job_array_hash_j,
+					    job_entry->array_job_id, job_next);
+		} else {
+			if (job_entry->job_id != NO_VAL)
+				error("%s: job array hash error %u", __func__,
+				      job_entry->array_job_id);
 			return;
-
-		switch (type) {
-		case JOB_HASH_JOB:
-			error("%s: Could not find hash entry for JobId=%u",
-			      __func__, job_entry->job_id);
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			error("%s: job array hash error %u", __func__,
-			      job_entry->array_job_id);
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			error("%s: job array, task ID hash error %u_%u",
-			      __func__,
-			      job_entry->array_job_id,
-			      job_entry->array_task_id);
-			break;
 		}
-		return;
-	}
-
-	switch (type) {
-	case JOB_HASH_JOB:
-		*job_pptr = job_entry->job_next;
-		job_entry->job_next = NULL;
-		break;
-	case JOB_HASH_ARRAY_JOB:
-		*job_pptr = job_entry->job_array_next_j;
+		if (job_next)
+			job_next->job_array_prev_j =
+				job_entry->job_array_prev_j;
 		job_entry->job_array_next_j = NULL;
+		job_entry->job_array_prev_j = NULL;
 		break;
 	case JOB_HASH_ARRAY_TASK:
-		*job_pptr = job_entry->job_array_next_t;
-		job_entry->job_array_next_t = NULL;
+		if (id_hash_remove(job_array_hash_t,
+				   JOB_ARRAY_TASK_KEY(job_entry->array_job_id,
+						      job_entry->array_task_id),
+				   job_entry) ||
+		    (job_entry->job_id == NO_VAL))
+			return;
+		error("%s: job array, task ID hash error %u_%u",
+		      __func__, job_entry->array_job_id,
+		      job_entry->array_task_id);
 		break;
+	default:
+		fatal("%s: unknown job_hash_type_t %d", __func__, type);
 	}
 }
 
@@ -3089,18 +3818,26 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
  */
 void _add_job_array_hash(job_record_t *job_ptr)
 {
-	int inx;
+	job_record_t *job_head;
 
 	if (job_ptr->array_task_id == NO_VAL)
 		return;	/* Not a job array */
 
-	inx = JOB_HASH_INX(job_ptr->array_job_id);
-	job_ptr->job_array_next_j = job_array_hash_j[inx];
-	job_array_hash_j[inx] = job_ptr;
-
-	inx = JOB_ARRAY_HASH_INX(job_ptr->array_job_id,job_ptr->array_task_id);
-	job_ptr->job_array_next_t = job_array_hash_t[inx];
-	job_array_hash_t[inx] = job_ptr;
+	/* New record becomes the head of this job array's list */
+	job_head = id_hash_find(job_array_hash_j, job_ptr->array_job_id);
+	if (job_head) {
+		id_hash_remove(job_array_hash_j, job_ptr->array_job_id,
+			       job_head);
+		job_head->job_array_prev_j = job_ptr;
+	}
+	job_ptr->job_array_next_j = job_head;
+	job_ptr->job_array_prev_j = NULL;
+	id_hash_add(job_array_hash_j, job_ptr->array_job_id, job_ptr);
+
+	id_hash_add(job_array_hash_t,
+		    JOB_ARRAY_TASK_KEY(job_ptr->array_job_id,
+				       job_ptr->array_task_id),
+		    job_ptr);
 }
 
 /* For the job array data structure, build the string representation of the
@@ -3144,7 +3881,6 @@ extern void build_array_str(job_record_t *job_ptr)
 extern bool test_job_array_complete(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3155,8 +3891,7 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_COMPLETE(job_ptr))
@@ -3171,7 +3906,6 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 extern bool test_job_array_completed(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3180,8 +3914,7 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_COMPLETED(job_ptr))
@@ -3199,7 +3932,6 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 extern bool _test_job_array_purged(uint32_t array_job_id)
 {
 	job_record_t *job_ptr, *head_job_ptr;
-	int inx;
 
 	head_job_ptr = find_job_record(array_job_id);
 	if (head_job_ptr) {
@@ -3208,8 +3940,7 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if ((job_ptr->array_job_id == array_job_id) &&
 		    (job_ptr != head_job_ptr)) {
@@ -3224,7 +3955,6 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 extern bool test_job_array_finished(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3233,8 +3963,7 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_FINISHED(job_ptr))
@@ -3250,7 +3979,6 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 extern bool test_job_array_pending(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3261,8 +3989,7 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (IS_JOB_PENDING(job_ptr))
@@ -3278,10 +4005,9 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 extern int num_pending_job_array_tasks(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int count = 0, inx;
+	int count = 0;
 
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 	while (job_ptr) {
 		if ((job_ptr->array_job_id == array_job_id) &&
 		    IS_JOB_PENDING(job_ptr))
@@ -3317,8 +4043,7 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 		    (job_ptr->array_job_id == array_job_id))
 			return job_ptr;
 
-		inx = JOB_HASH_INX(array_job_id);
-		job_ptr = job_array_hash_j[inx];
+		job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 		while (job_ptr) {
 			if (job_ptr->array_job_id == array_job_id) {
 				match_job_ptr = job_ptr;
@@ -3330,15 +4055,11 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 		}
 		return match_job_ptr;
 	} else {		/* Find specific task ID */
-		inx = JOB_ARRAY_HASH_INX(array_job_id, array_task_id);
-		job_ptr = job_array_hash_t[inx];
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == array_job_id) &&
-			    (job_ptr->array_task_id == array_task_id)) {
-				return job_ptr;
-			}
-			job_ptr = job_ptr->job_array_next_t;
-		}
+		job_ptr = id_hash_find(job_array_hash_t,
+				       JOB_ARRAY_TASK_KEY(array_job_id,
+							  array_task_id));
+		if (job_ptr)
+			return job_ptr;
 		/* Look for job record with all of the pending tasks */
 		job_ptr = find_job_record(array_job_id);
 		if (job_ptr && job_ptr->array_recs &&
@@ -3365,12 +4086,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
 	job_record_t *het_job_leader, *het_job;
 	ListIterator iter;
 
-	het_job_leader = job_hash[JOB_HASH_INX(job_id)];
-	while (het_job_leader) {
-		if (het_job_leader->job_id == job_id)
-			break;
-		het_job_leader = het_job_leader->job_next;
-	}
+	het_job_leader = find_job_record(job_id);
 	if (!het_job_leader)
 		return NULL;
 	if (het_job_leader->het_job_offset == het_job_id)
@@ -3400,16 +4116,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
  */
 extern job_record_t *find_job_record(uint32_t job_id)
 {
-	job_record_t *job_ptr;
-
-	job_ptr = job_hash[JOB_HASH_INX(job_id)];
-	while (job_ptr) {
-		if (job_ptr->job_id == job_id)
-			return job_ptr;
-		job_ptr = job_ptr->job_next;
-	}
-
-	return NULL;
+	return id_hash_find(job_hash, job_id);
 }
 
 /* rebuild a job's partition name list based upon the contents of its
@@ -3424,7 +4131,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 
 	if (!job_ptr->part_ptr_list) {
 		job_ptr->partition = xstrdup(job_ptr->part_ptr->name);
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 		return;
 	}
 
@@ -3448,7 +4155,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 		xstrcat(job_ptr->partition, part_ptr->name);
 	}
 	list_iterator_destroy(part_iterator);
-	last_job_update = time(NULL);
+	job_info_changed(job_ptr, time(NULL));
 }
 
 /*
@@ -3687,7 +4394,7 @@ extern int kill_job_by_part_name(char *part_name)
 	list_iterator_destroy(job_iterator);
 
 	if (kill_job_cnt)
-		last_job_update = now;
+		job_info_changed(NULL, now);
 	return kill_job_cnt;
 }
 
@@ -3845,7 +4552,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 	list_iterator_destroy(job_iterator);
 
 	if (kill_job_cnt)
-		last_job_update = now;
+		job_info_changed(NULL, now);
 	return kill_job_cnt;
 #else
 	return 0;
@@ -4114,7 +4821,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 	}
 	list_iterator_destroy(job_iterator);
 	if (kill_job_cnt)
-		last_job_update = now;
+		job_info_changed(NULL, now);
 
 	return kill_job_cnt;
 }
@@ -4415,7 +5122,9 @@ int init_job_conf(void)
 		job_list = list_create(_list_delete_job);
 	}
 
-	last_job_update = time(NULL);
+	job_info_changed(NULL, time(NULL));
+	if (!job_delta_horizon)
+		job_delta_horizon = last_job_update;
 
 	if (!purge_files_list) {
 		purge_files_list = list_create(xfree_ptr);
@@ -4432,20 +5141,11 @@ extern void rehash_jobs(void)
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
 
+	/* The tables grow as needed, MaxJobCount changes need no rebuild */
 	if (job_hash == NULL) {
-		hash_table_size = slurm_conf.max_job_cnt;
-		job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
-		job_array_hash_j = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-		job_array_hash_t = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-	} else if (hash_table_size < (slurm_conf.max_job_cnt / 2)) {
-		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurm_conf.max_job_cnt = hash_table_size;
+		job_hash = id_hash_init(JOB_HASH_MIN_SIZE);
+		job_array_hash_j = id_hash_init(JOB_HASH_MIN_SIZE);
+		job_array_hash_t = id_hash_init(JOB_HASH_MIN_SIZE);
 	}
 }
 
@@ -4492,6 +5192,9 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->db_flags = 0;
 	job_ptr_pend->step_list = save_step_list;
 	job_ptr_pend->db_index = save_db_index;
+	/* Both records change job id */
+	job_info_changed(job_ptr, time(NULL));
+	job_info_changed(job_ptr_pend, time(NULL));
 
 	job_ptr_pend->prio_factors = save_prio_factors;
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
@@ -4542,8 +5245,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	memcpy(job_ptr_pend->limit_set.tres, job_ptr->limit_set.tres,
 	       sizeof(uint16_t) * slurmctld_tres_cnt);
 
-	_add_job_hash(job_ptr);		/* Sets job_next */
-	_add_job_hash(job_ptr_pend);	/* Sets job_next */
+	_add_job_hash(job_ptr);
+	_add_job_hash(job_ptr_pend);
 	_add_job_array_hash(job_ptr);
 	job_ptr_pend->job_resrcs = NULL;
 
@@ -5160,7 +5863,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 
 	error_code = _select_nodes_parts(job_ptr, no_alloc, NULL, err_msg);
 	if (!test_only) {
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 	}
 
 	if (held_user)
@@ -5283,7 +5986,7 @@ static int _job_fail(job_record_t *job_ptr, uint32_t job_state)
 				difftime(now, job_ptr->suspend_time);
 		} else
 			job_ptr->end_time       = now;
-		last_job_update                 = now;
+		job_info_changed(job_ptr, now);
 		job_ptr->job_state = job_state | JOB_COMPLETING;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_LAUNCH;
@@ -5411,7 +6114,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 
 	/* let node select plugin do any state-dependent signaling actions */
 	select_g_job_signal(job_ptr, signal);
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 
 	/* save user ID of the one who requested the job be cancelled */
 	if (signal == SIGKILL)
@@ -5431,7 +6134,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 		job_ptr->bit_flags |= JOB_KILL_HURRY;
 
 	if (IS_JOB_CONFIGURING(job_ptr) && (signal == SIGKILL)) {
-		last_job_update         = now;
+		job_info_changed(job_ptr, now);
 		job_ptr->end_time       = now;
 		job_ptr->job_state      = JOB_CANCELLED | JOB_COMPLETING;
 		if (flags & KILL_FED_REQUEUE)
@@ -5476,7 +6179,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 	else
 		job_term_state = JOB_CANCELLED;
 	if (IS_JOB_SUSPENDED(job_ptr) && (signal == SIGKILL)) {
-		last_job_update         = now;
+		job_info_changed(job_ptr, now);
 		job_ptr->end_time       = job_ptr->suspend_time;
 		job_ptr->tot_sus_time  += difftime(now, job_ptr->suspend_time);
 		job_ptr->job_state      = job_term_state | JOB_COMPLETING;
@@ -5512,7 +6215,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 			 */
 			job_ptr->time_last_active	= now;
 			job_ptr->end_time		= now;
-			last_job_update			= now;
+			job_info_changed(job_ptr, now);
 			job_ptr->job_state = job_term_state | JOB_COMPLETING;
 			if (flags & KILL_FED_REQUEUE)
 				job_ptr->job_state |= JOB_REQUEUE;
@@ -5732,7 +6435,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 		}
 
 		/* Signal all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		if (!job_ptr && !job_ptr_done) {
 			info("%s(3): invalid JobId=%u", __func__, job_id);
 			return ESLURM_INVALID_JOB_ID;
@@ -5785,7 +6488,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 	/* Find some job record and validate the user signaling the job */
 	job_ptr = find_job_record(job_id);
 	if (job_ptr == NULL) {
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		while (job_ptr) {
 			if (job_ptr->array_job_id == job_id)
 				break;
@@ -5834,7 +6537,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 			new_task_count = bit_set_count(job_ptr->array_recs->
 						       task_id_bitmap);
 			if (!new_task_count) {
-				last_job_update		= now;
+				job_info_changed(job_ptr, now);
 				job_ptr->job_state	= JOB_CANCELLED;
 				job_ptr->start_time	= now;
 				job_ptr->end_time	= now;
@@ -6182,7 +6885,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		job_completion_logger(job_ptr, false);
 	}
 
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 	job_ptr->time_last_active = now;   /* Timer for resending kill RPC */
 	if (job_comp_flag) {	/* job was running */
 		build_cg_bitmap(job_ptr);
@@ -8043,6 +8746,17 @@ static uint16_t _default_wait_all_nodes(job_desc_msg_t *job_desc)
 	return default_batch_wait;
 }
 
+/* Move an array of strings unpacked into the arena of an RPC to the heap */
+static void _keep_str_array(char ***array, uint32_t cnt)
+{
+	if (!*array)
+		return;
+
+	for (int i = 0; i < cnt; i++)
+		xkeep((*array)[i]);
+	xkeep(*array);
+}
+
 /* _copy_job_desc_to_job_record - copy the job descriptor from the RPC
  *	structure into the actual slurmctld job record */
 static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
@@ -8170,6 +8884,8 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	job_ptr->bit_flags = job_desc->bitflags;
 	job_ptr->bit_flags &= ~BACKFILL_TEST;
 	job_ptr->bit_flags &= ~BF_WHOLE_NODE_TEST;
+	_keep_str_array(&job_desc->spank_job_env,
+			job_desc->spank_job_env_size);
 	job_ptr->spank_job_env = job_desc->spank_job_env;
 	job_ptr->spank_job_env_size = job_desc->spank_job_env_size;
 	job_desc->spank_job_env = (char **) NULL; /* nothing left to free */
@@ -8195,6 +8911,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	job_ptr->warn_time   = job_desc->warn_time;
 
 	detail_ptr = job_ptr->details;
+	_keep_str_array(&job_desc->argv, job_desc->argc);
 	detail_ptr->argc = job_desc->argc;
 	detail_ptr->argv = job_desc->argv;
 	job_desc->argv   = (char **) NULL; /* nothing left to free */
@@ -8640,7 +9357,7 @@ extern void job_config_fini(job_record_t *job_ptr)
 {
 	time_t now = time(NULL);
 
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 	job_ptr->job_state &= ~JOB_CONFIGURING;
 	if (IS_JOB_POWER_UP_NODE(job_ptr)) {
 		info("Resetting %pJ start time for node power up", job_ptr);
@@ -8807,7 +9524,7 @@ void job_time_limit(void)
 		    IS_JOB_PENDING(job_ptr) && (job_ptr->priority == 0)) {
 			job_ptr->state_reason = WAIT_NO_REASON;
 			set_job_prio(job_ptr);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		}
 
 		/* Don't enforce time limits for configuring hetjobs */
@@ -8885,7 +9602,7 @@ void job_time_limit(void)
 			else
 				over_run = now - (over_time_limit  * 60);
 			if (job_ptr->end_time <= over_run) {
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 				info("Time limit exhausted for %pJ", job_ptr);
 				_job_timed_out(job_ptr, false);
 				job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8897,7 +9614,7 @@ void job_time_limit(void)
 		if (job_ptr->resv_ptr &&
 		    !(job_ptr->resv_ptr->flags & RESERVE_FLAG_FLEX) &&
 		    (job_ptr->resv_ptr->end_time + resv_over_run) < time(NULL)){
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			info("Reservation ended for %pJ", job_ptr);
 			_job_timed_out(job_ptr, false);
 			job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8916,7 +9633,7 @@ void job_time_limit(void)
 		acct_policy_job_time_out(job_ptr);
 
 		if (job_ptr->state_reason == FAIL_TIMEOUT) {
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			_job_timed_out(job_ptr, false);
 			xfree(job_ptr->state_desc);
 			goto time_check;
@@ -9359,8 +10076,55 @@ extern void free_null_array_recs(job_record_t *job_ptr)
 	xfree(job_ptr->array_recs);
 }
 
+/*
+ * Discard purged job ids older than JOB_DELTA_HISTORY.
+ * job_delta_mutex must be locked by the caller.
+ */
+static void _prune_job_tombstones(time_t now)
+{
+	int i;
+
+	for (i = 0; i < job_tombstone_cnt; i++) {
+		if (job_tombstones[i].purge_time >= (now - JOB_DELTA_HISTORY))
+			break;
+		job_delta_horizon = job_tombstones[i].purge_time;
+	}
+	if (i) {
+		job_tombstone_cnt -= i;
+		job_tombstone_base += i;
+		memmove(job_tombstones, job_tombstones + i,
+			sizeof(job_tombstone_t) * job_tombstone_cnt);
+	}
+}
+
+/*
+ * Remember a purged job id for SHOW_DELTA job info requests and the job
+ * state journal
+ */
+static void _add_job_tombstone(uint32_t job_id)
+{
+	slurm_mutex_lock(&job_delta_mutex);
+	if (job_tombstone_cnt >= job_tombstone_size) {
+		_prune_job_tombstones(time(NULL));
+		/* Grow unless pruning freed a good share, keep memmove rare */
+		if (job_tombstone_cnt >= (job_tombstone_size / 2)) {
+			job_tombstone_size = MAX(1024, job_tombstone_size * 2);
+			xrealloc(job_tombstones,
+				 sizeof(job_tombstone_t) * job_tombstone_size);
+		}
+	}
+	job_tombstones[job_tombstone_cnt].job_id = job_id;
+	job_tombstones[job_tombstone_cnt].purge_time = time(NULL);
+	job_tombstone_cnt++;
+	slurm_mutex_unlock(&job_delta_mutex);
+}
+
 static void _delete_job_common(job_record_t *job_ptr)
 {
+	/* Job id already recorded by unlink_job_record() if NO_VAL */
+	if (job_ptr->job_id != NO_VAL)
+		_add_job_tombstone(job_ptr->job_id);
+
 	/* Remove record from fed_job_list */
 	fed_mgr_remove_fed_job_info(job_ptr->job_id);
 
@@ -9382,21 +10146,48 @@ static void _delete_job_common(job_record_t *job_ptr)
 static void _list_delete_job(void *job_entry)
 {
 	job_record_t *job_ptr = (job_record_t *) job_entry;
-	int job_array_size, i;
 
 	xassert(job_entry);
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
 	_delete_job_common(job_ptr);
+	_sub_job_count(job_ptr);
+	_free_job_record(job_ptr, true);
+}
 
-	if (job_ptr->array_recs) {
-		job_array_size = MAX(1, job_ptr->array_recs->task_cnt);
+/* Return the number of jobs a job record counts for in job_count */
+static int _job_count_size(job_record_t *job_ptr)
+{
+	if (job_ptr->array_recs)
+		return MAX(1, job_ptr->array_recs->task_cnt);
+	return 1;
+}
+
+/* Remove the jobs represented by a job record from job_count */
+static void _sub_job_count(job_record_t *job_ptr)
+{
+	int job_array_size = _job_count_size(job_ptr);
+
+	if (job_array_size > job_count) {
+		error("job_count underflow");
+		job_count = 0;
 	} else {
-		job_array_size = 1;
+		job_count -= job_array_size;
 	}
+}
+
+/*
+ * _free_job_record - free a job record which is no longer in job_list
+ * IN job_ptr - pointer to job_record to free
+ * IN purge_files - queue the batch script and environment of a finished job
+ *	for deletion
+ */
+static void _free_job_record(job_record_t *job_ptr, bool purge_files)
+{
+	int i;
 
-	_delete_job_details(job_ptr);
+	_delete_job_details(job_ptr, purge_files);
 	xfree(job_ptr->account);
 	xfree(job_ptr->admin_comment);
 	xfree(job_ptr->alias_list);
@@ -9470,12 +10261,6 @@ static void _list_delete_job(void *job_entry)
 	select_g_select_jobinfo_free(job_ptr->select_jobinfo);
 	xfree(job_ptr->user_name);
 	xfree(job_ptr->wckey);
-	if (job_array_size > job_count) {
-		error("job_count underflow");
-		job_count = 0;
-	} else {
-		job_count -= job_array_size;
-	}
 	job_ptr->job_id = 0;
 	xfree(job_ptr);
 }
@@ -9639,6 +10424,125 @@ static bool _hide_job(job_record_t *job_ptr, uid_t uid, uint16_t show_flags)
 	return false;
 }
 
+#define _HASH_JOB_FIELD(digest, field) \
+	_hash_job_data(digest, (char *) &(field), sizeof(field))
+
+static uint64_t _hash_job_str(uint64_t digest, char *str)
+{
+	if (!str)
+		return _hash_job_data(digest, "", 1);
+	return _hash_job_data(digest, str, strlen(str) + 1);
+}
+
+/*
+ * Hash the job record fields which the scheduling passes change, so that a
+ * change is detected even where job_info_changed() was not called for it.
+ * The scheduler's test flags are left out, as _job_state_digest() does.
+ */
+static uint64_t _job_info_digest(job_record_t *job_ptr)
+{
+	uint64_t digest = JOB_DIGEST_INIT;
+	uint32_t bit_flags = job_ptr->bit_flags &
+			     ~(BACKFILL_TEST | TEST_NOW_ONLY);
+
+	digest = _HASH_JOB_FIELD(digest, job_ptr->job_state);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->state_reason);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->priority);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->time_limit);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->time_min);
+	digest = _HASH_JOB_FIELD(digest, bit_flags);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->restart_cnt);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->start_time);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->end_time);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->last_sched_eval);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->suspend_time);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->preempt_time);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->resize_time);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->part_ptr);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->node_cnt);
+	digest = _HASH_JOB_FIELD(digest, job_ptr->total_cpus);
+	digest = _hash_job_str(digest, job_ptr->state_desc);
+	digest = _hash_job_str(digest, job_ptr->sched_nodes);
+	digest = _hash_job_str(digest, job_ptr->nodes);
+
+	return digest;
+}
+
+/*
+ * Find the record of job_ptr in cache, if it is still what pack_job() would
+ * pack. As with the update_time of job info requests, a job is considered
+ * unchanged until job_info_changed() is called for it, unless one of the
+ * fields hashed by _job_info_digest() differs from when it was packed.
+ */
+static job_pack_rec_t *_find_job_pack_rec(job_pack_cache_t *cache,
+					  job_record_t *job_ptr,
+					  uint64_t digest, time_t now)
+{
+	job_record_t *array_head;
+	job_pack_rec_t *rec;
+
+	if (!cache || (job_ptr->info_seq > cache->info_seq))
+		return NULL;
+
+	/* Tasks of a job array report the head's max_run_tasks */
+	if (job_ptr->array_job_id && !job_ptr->array_recs &&
+	    (array_head = find_job_record(job_ptr->array_job_id)) &&
+	    (array_head->info_seq > cache->info_seq))
+		return NULL;
+
+	/* Expected start times are packed as no earlier than the present */
+	if (!IS_JOB_STARTED(job_ptr)) {
+		if (job_ptr->start_time && (job_ptr->start_time < now))
+			return NULL;
+		if (!job_ptr->start_time && job_ptr->details &&
+		    (job_ptr->details->begin_time > cache->pack_time) &&
+		    (job_ptr->details->begin_time <= now))
+			return NULL;
+	}
+
+	if (!(rec = id_hash_find(cache->rec_hash, job_ptr->job_id)) ||
+	    (rec->digest != digest))
+		return NULL;
+
+	return rec;
+}
+
+/*
+ * Pack job_ptr into pack_info->cache, copying its record from the previous
+ * cache if it did not change since.
+ */
+static void _pack_job_cached(job_record_t *job_ptr,
+			     _foreach_pack_job_info_t *pack_info)
+{
+	job_pack_cache_t *cache = pack_info->cache;
+	job_pack_cache_t *prev = pack_info->prev_cache;
+	Buf buffer = pack_info->buffer;
+	job_pack_rec_t *rec, *prev_rec;
+
+	if (cache->rec_cnt >= cache->rec_size) {
+		cache->rec_size = MAX(cache->rec_size * 2, 1024);
+		xrecalloc(cache->recs, cache->rec_size,
+			  sizeof(job_pack_rec_t));
+	}
+	rec = &cache->recs[cache->rec_cnt++];
+	rec->job_id = job_ptr->job_id;
+	rec->offset = get_buf_offset(buffer);
+	rec->first_use = str_dict_use_cnt(cache->str_dict);
+	rec->digest = _job_info_digest(job_ptr);
+
+	if ((prev_rec = _find_job_pack_rec(prev, job_ptr, rec->digest,
+					   cache->pack_time))) {
+		packstr_dict_copy(prev->data, prev_rec->offset, prev_rec->size,
+				  prev->str_dict, prev_rec->first_use, buffer);
+		cache->reused_cnt++;
+	} else {
+		pack_job(job_ptr, pack_info->show_flags, buffer,
+			 pack_info->protocol_version, pack_info->uid);
+	}
+
+	rec->size = get_buf_offset(buffer) - rec->offset;
+}
+
 static int _pack_job(void *object, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *)object;
@@ -9650,16 +10554,34 @@ static int _pack_job(void *object, void *arg)
 	    (pack_info->filter_uid != job_ptr->user_id))
 		return SLURM_SUCCESS;
 
-	if (((pack_info->show_flags & SHOW_ALL) == 0) &&
-	    (pack_info->uid != 0) &&
-	    _all_parts_hidden(job_ptr, pack_info->uid))
+	if (pack_info->update_time &&
+	    (job_ptr->info_update < pack_info->update_time))
 		return SLURM_SUCCESS;
 
-	if (_hide_job(job_ptr, pack_info->uid, pack_info->show_flags))
+	if ((((pack_info->show_flags & SHOW_ALL) == 0) &&
+	     (pack_info->uid != 0) &&
+	     _all_parts_hidden(job_ptr, pack_info->uid)) ||
+	    _hide_job(job_ptr, pack_info->uid, pack_info->show_flags)) {
+		/* The client may still hold a record from before the change */
+		if (pack_info->update_time) {
+			if (pack_info->hidden_cnt >= pack_info->hidden_size) {
+				pack_info->hidden_size =
+					MAX(pack_info->hidden_size * 2, 64);
+				xrecalloc(pack_info->hidden_ids,
+					  pack_info->hidden_size,
+					  sizeof(uint32_t));
+			}
+			pack_info->hidden_ids[pack_info->hidden_cnt++] =
+				job_ptr->job_id;
+		}
 		return SLURM_SUCCESS;
+	}
 
-	pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
-		 pack_info->protocol_version, pack_info->uid);
+	if (pack_info->cache)
+		_pack_job_cached(job_ptr, pack_info);
+	else
+		pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
+			 pack_info->protocol_version, pack_info->uid);
 
 	(*pack_info->jobs_packed)++;
 
@@ -9678,6 +10600,152 @@ static int _foreach_pack_jobid(void *object, void *arg)
 	return _pack_job(job_ptr, info);
 }
 
+/*
+ * pack_all_jobs_cached - dump all job information for all jobs in
+ *	machine independent form (for network transmission), copying the
+ *	records of jobs unchanged since prev_cache was filled
+ */
+extern void pack_all_jobs_cached(char **buffer_ptr, int *buffer_size,
+				 uint16_t show_flags, uid_t uid,
+				 uint16_t protocol_version,
+				 job_pack_cache_t *prev_cache,
+				 job_pack_cache_t **cache_ptr)
+{
+	uint32_t jobs_packed = 0, tmp_offset;
+	_foreach_pack_job_info_t pack_info = {0};
+	job_pack_cache_t *cache = xmalloc(sizeof(*cache));
+	Buf buffer;
+
+	cache->info_seq = job_info_seq;
+	cache->part_write_cnt = lock_write_count(PART_LOCK);
+	cache->pack_time = time(NULL);
+	cache->protocol_version = protocol_version;
+	cache->show_flags = show_flags;
+	cache->uid = uid;
+
+	/* Partition changes and changes to all jobs affect any record */
+	if (prev_cache &&
+	    ((prev_cache->protocol_version != protocol_version) ||
+	     (prev_cache->show_flags != show_flags) ||
+	     (prev_cache->uid != uid) ||
+	     (prev_cache->part_write_cnt != cache->part_write_cnt) ||
+	     (prev_cache->info_seq < job_info_all_seq)))
+		prev_cache = NULL;
+
+	buffer = init_buf(BUF_SIZE);
+	/* strings repeated across the jobs are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+		cache->str_dict = str_dict_create();
+		str_dict_log_uses(cache->str_dict);
+		set_buf_str_dict(buffer, cache->str_dict);
+	}
+
+	/* write message body header : size and time */
+	/* put in a place holder job record count of 0 for now */
+	pack32(jobs_packed, buffer);
+	pack_time(cache->pack_time, buffer);
+
+	/* write individual job records */
+	pack_info.buffer           = buffer;
+	pack_info.cache            = cache;
+	pack_info.filter_uid       = NO_VAL;
+	pack_info.jobs_packed      = &jobs_packed;
+	pack_info.prev_cache       = prev_cache;
+	pack_info.protocol_version = protocol_version;
+	pack_info.show_flags       = show_flags;
+	pack_info.uid              = uid;
+
+	list_for_each(job_list, _pack_job, &pack_info);
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	cache->rec_hash = id_hash_init(cache->rec_cnt);
+	for (int i = 0; i < cache->rec_cnt; i++)
+		id_hash_add(cache->rec_hash, cache->recs[i].job_id,
+			    &cache->recs[i]);
+	debug2("%s: packed %u job records, %u copied from previous pack",
+	       __func__, jobs_packed, cache->reused_cnt);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = cache->data = xfer_buf_data(buffer);
+	*cache_ptr = cache;
+}
+
+/* job_pack_cache_free - free a cache filled by pack_all_jobs_cached() */
+extern void job_pack_cache_free(job_pack_cache_t *cache)
+{
+	if (!cache)
+		return;
+
+	str_dict_destroy(cache->str_dict);
+	id_hash_free(cache->rec_hash);
+	xfree(cache->recs);
+	xfree(cache);
+}
+
+/*
+ * job_info_changed - note a change to a job record visible to job
+ *	information requests
+ */
+extern void job_info_changed(job_record_t *job_ptr, time_t now)
+{
+	last_job_update = now;
+	job_info_seq++;
+	if (job_ptr) {
+		job_ptr->info_seq = job_info_seq;
+		job_ptr->info_update = now;
+	} else {
+		job_info_all_seq = job_info_seq;
+		job_info_all_update = now;
+	}
+}
+
+/*
+ * job_info_refreshed - note a change made to a job record by a scheduling
+ *	pass. Unlike job_info_changed(), last_job_update is left alone so the
+ *	change does not trigger another pass.
+ */
+extern void job_info_refreshed(job_record_t *job_ptr, time_t now)
+{
+	job_info_seq++;
+	job_ptr->info_seq = job_info_seq;
+	job_ptr->info_update = now;
+}
+
+static int _sweep_job_info(void *x, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) x;
+	time_t now = *(time_t *) arg;
+	uint64_t digest = _job_info_digest(job_ptr);
+
+	if (digest == job_ptr->info_digest)
+		return 0;
+
+	job_ptr->info_digest = digest;
+	/* Already noted since the last sweep */
+	if (job_ptr->info_seq > job_info_sweep_seq)
+		return 0;
+
+	job_info_refreshed(job_ptr, now);
+	return 0;
+}
+
+/*
+ * job_info_sweep - note changes to job records which were made without
+ *	calling job_info_changed(), so SHOW_DELTA requests still report them
+ */
+extern void job_info_sweep(void)
+{
+	time_t now = time(NULL);
+
+	list_for_each(job_list, _sweep_job_info, &now);
+	job_info_sweep_seq = job_info_seq;
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -9703,6 +10771,9 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	*buffer_size = 0;
 
 	buffer = init_buf(BUF_SIZE);
+	/* strings repeated across the jobs are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
@@ -9725,6 +10796,103 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	pack32(jobs_packed, buffer);
 	set_buf_offset(buffer, tmp_offset);
 
+	str_dict_destroy(buffer->str_dict);
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+/*
+ * pack_delta_jobs - dump job information for jobs changed since update_time
+ *	in machine independent form (for network transmission)
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN update_time - last_update of the client's copy of the job table
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * global: job_list - global list of job records
+ * NOTE: All jobs are packed and the delta flag cleared if update_time
+ *	predates the purged job ids still held
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ * NOTE: change _unpack_job_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ */
+extern void pack_delta_jobs(char **buffer_ptr, int *buffer_size,
+			    time_t update_time, uint16_t show_flags, uid_t uid,
+			    uint16_t protocol_version)
+{
+	uint32_t jobs_packed = 0, purged_cnt = 0, tmp_offset;
+	_foreach_pack_job_info_t pack_info = {0};
+	time_t now = time(NULL);
+	uint16_t delta;
+	Buf buffer;
+	int i;
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	buffer = init_buf(BUF_SIZE);
+	/* strings repeated across the jobs are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
+
+	slurm_mutex_lock(&job_delta_mutex);
+
+	_prune_job_tombstones(now);
+	/*
+	 * Changes to all jobs or to partitions may change any record, or hide
+	 * it from uid, so send the full table for the client to replace its own
+	 */
+	delta = ((update_time > job_delta_horizon) &&
+		 (update_time > job_info_all_update) &&
+		 (update_time > last_part_update));
+
+	/* write message body header : size and time */
+	/* put in a place holder job record count of 0 for now */
+	pack32(jobs_packed, buffer);
+	pack_time(now, buffer);
+
+	/* write individual job records */
+	pack_info.buffer           = buffer;
+	pack_info.filter_uid       = NO_VAL;
+	pack_info.jobs_packed      = &jobs_packed;
+	pack_info.protocol_version = protocol_version;
+	pack_info.show_flags       = show_flags;
+	pack_info.uid              = uid;
+	if (delta)
+		pack_info.update_time = update_time;
+
+	list_for_each(job_list, _pack_job, &pack_info);
+
+	/*
+	 * write ids of jobs purged since update_time, and of jobs changed
+	 * since then which uid may no longer see
+	 */
+	pack16(delta, buffer);
+	if (delta) {
+		for (i = 0; i < job_tombstone_cnt; i++) {
+			if (job_tombstones[i].purge_time >= update_time)
+				break;
+		}
+		purged_cnt = job_tombstone_cnt - i + pack_info.hidden_cnt;
+		pack32(purged_cnt, buffer);
+		for ( ; i < job_tombstone_cnt; i++)
+			pack32(job_tombstones[i].job_id, buffer);
+		for (i = 0; i < pack_info.hidden_cnt; i++)
+			pack32(pack_info.hidden_ids[i], buffer);
+	} else
+		pack32(purged_cnt, buffer);
+
+	slurm_mutex_unlock(&job_delta_mutex);
+	xfree(pack_info.hidden_ids);
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	str_dict_destroy(buffer->str_dict);
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
@@ -9757,6 +10925,9 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	*buffer_size = 0;
 
 	buffer = init_buf(BUF_SIZE);
+	/* strings repeated across the jobs are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
@@ -9779,6 +10950,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	pack32(jobs_packed, buffer);
 	set_buf_offset(buffer, tmp_offset);
 
+	str_dict_destroy(buffer->str_dict);
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
@@ -9830,6 +11002,9 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	*buffer_size = 0;
 
 	buffer = init_buf(BUF_SIZE);
+	/* strings repeated across the jobs are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
@@ -9865,7 +11040,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			}
 		}
 
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		while (job_ptr) {
 			if ((job_ptr->job_id == job_id) && packed_head) {
 				;	/* Already packed */
@@ -9881,6 +11056,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	}
 
 	if (jobs_packed == 0) {
+		str_dict_destroy(buffer->str_dict);
 		free_buf(buffer);
 		return ESLURM_INVALID_JOB_ID;
 	}
@@ -9891,6 +11067,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	pack32(jobs_packed, buffer);
 	set_buf_offset(buffer, tmp_offset);
 
+	str_dict_destroy(buffer->str_dict);
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
 
@@ -10028,43 +11205,44 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		pack32(dump_job_ptr->priority, buffer);
 		packdouble(dump_job_ptr->billable_tres, buffer);
 
-		packstr(slurm_conf.cluster_name, buffer);
+		packstr_dict(slurm_conf.cluster_name, buffer);
 		/* Only send the allocated nodelist since we are only sending
 		 * the number of cpus and nodes that are currently allocated. */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
-			packstr(dump_job_ptr->nodes, buffer);
+			packstr_dict(dump_job_ptr->nodes, buffer);
 		else {
 			nodelist =
 				bitmap2node_name(dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
+			packstr_dict(nodelist, buffer);
 			xfree(nodelist);
 		}
 
 		packstr(dump_job_ptr->sched_nodes, buffer);
 
 		if (!IS_JOB_PENDING(dump_job_ptr) && dump_job_ptr->part_ptr)
-			packstr(dump_job_ptr->part_ptr->name, buffer);
+			packstr_dict(dump_job_ptr->part_ptr->name, buffer);
 		else
-			packstr(dump_job_ptr->partition, buffer);
-		packstr(dump_job_ptr->account, buffer);
+			packstr_dict(dump_job_ptr->partition, buffer);
+		packstr_dict(dump_job_ptr->account, buffer);
 		packstr(dump_job_ptr->admin_comment, buffer);
 		pack32(dump_job_ptr->site_factor, buffer);
 		packstr(dump_job_ptr->network, buffer);
 		packstr(dump_job_ptr->comment, buffer);
 		packstr(dump_job_ptr->batch_features, buffer);
-		packstr(dump_job_ptr->batch_host, buffer);
+		packstr_dict(dump_job_ptr->batch_host, buffer);
 		packstr(dump_job_ptr->burst_buffer, buffer);
 		packstr(dump_job_ptr->burst_buffer_state, buffer);
 		packstr(dump_job_ptr->system_comment, buffer);
 
 		assoc_mgr_lock(&locks);
 		if (dump_job_ptr->qos_ptr)
-			packstr(dump_job_ptr->qos_ptr->name, buffer);
+			packstr_dict(dump_job_ptr->qos_ptr->name, buffer);
 		else {
 			if (assoc_mgr_qos_list) {
-				packstr(slurmdb_qos_str(assoc_mgr_qos_list,
-							dump_job_ptr->qos_id),
-					buffer);
+				packstr_dict(slurmdb_qos_str(
+						assoc_mgr_qos_list,
+						dump_job_ptr->qos_id),
+					     buffer);
 			} else
 				packnull(buffer);
 		}
@@ -10099,12 +11277,12 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		}
 
 		packstr(dump_job_ptr->name, buffer);
-		packstr(dump_job_ptr->user_name, buffer);
-		packstr(dump_job_ptr->wckey, buffer);
+		packstr_dict(dump_job_ptr->user_name, buffer);
+		packstr_dict(dump_job_ptr->wckey, buffer);
 		pack32(dump_job_ptr->req_switch, buffer);
 		pack32(dump_job_ptr->wait4switch, buffer);
 
-		packstr(dump_job_ptr->alloc_node, buffer);
+		packstr_dict(dump_job_ptr->alloc_node, buffer);
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			pack_bit_str_hex(dump_job_ptr->node_bitmap, buffer);
 		else
@@ -10126,8 +11304,8 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, Buf buffer,
 			_pack_pending_job_details(NULL, buffer,
 						  protocol_version);
 		pack32(dump_job_ptr->bit_flags, buffer);
-		packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
-		packstr(dump_job_ptr->tres_fmt_req_str, buffer);
+		packstr_dict(dump_job_ptr->tres_fmt_alloc_str, buffer);
+		packstr_dict(dump_job_ptr->tres_fmt_req_str, buffer);
 		pack16(dump_job_ptr->start_protocol_ver, buffer);
 
 		if (dump_job_ptr->fed_details) {
@@ -10153,7 +11331,7 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		packstr(dump_job_ptr->tres_bind, buffer);
 		packstr(dump_job_ptr->tres_freq, buffer);
 		packstr(dump_job_ptr->tres_per_job, buffer);
-		packstr(dump_job_ptr->tres_per_node, buffer);
+		packstr_dict(dump_job_ptr->tres_per_node, buffer);
 		packstr(dump_job_ptr->tres_per_socket, buffer);
 		packstr(dump_job_ptr->tres_per_task, buffer);
 
@@ -10994,7 +12172,7 @@ void reset_job_bitmaps(void)
 	}
 	list_iterator_destroy(job_iterator);
 
-	last_job_update = now;
+	job_info_changed(NULL, now);
 }
 
 static int _reset_detail_bitmaps(job_record_t *job_ptr)
@@ -11563,7 +12741,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 		if (IS_JOB_COMPLETED(job_ptr) && operator &&
 		    (job_specs->burst_buffer[0] == '\0')) {
 			xfree(job_ptr->burst_buffer);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		} else {
 			error_code = ESLURM_NOT_SUPPORTED;
 		}
@@ -11663,7 +12841,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 	detail_ptr = job_ptr->details;
 	if (detail_ptr)
 		mc_ptr = detail_ptr->mc_ptr;
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 
 	/*
 	 * Check to see if the new requested job_specs exceeds any
@@ -13976,7 +15154,7 @@ extern int update_job_str(slurm_msg_t *msg, uid_t uid)
 		}
 
 		/* Update all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		if (!job_ptr && !job_ptr_done) {
 			info("%s: invalid JobId=%u", __func__, job_id);
 			rc = ESLURM_INVALID_JOB_ID;
@@ -14294,9 +15472,12 @@ extern void job_post_resize_acctg(job_record_t *job_ptr)
  *	are actually running, if not clean up the job records and/or node
  *	records.
  * IN reg_msg - node registration message
+ * IN/OUT purge_node_bitmap - if set, record the node here for a later
+ *	purge_missing_jobs() call rather than walking the job list now
  */
 extern void
-validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
+validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+		      bitstr_t *purge_node_bitmap)
 {
 	int i, node_inx, jobs_on_node;
 	node_record_t *node_ptr;
@@ -14424,7 +15605,9 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
 	}
 
 	jobs_on_node = node_ptr->run_job_cnt + node_ptr->comp_job_cnt;
-	if (jobs_on_node)
+	if (jobs_on_node && purge_node_bitmap)
+		bit_set(purge_node_bitmap, node_inx);
+	else if (jobs_on_node)
 		_purge_missing_jobs(node_inx, now);
 
 	if (jobs_on_node != reg_msg->job_count) {
@@ -14448,10 +15631,9 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
  *
  * Also notify srun if any job steps should be active on this node
  * but are not found. */
-static void _purge_missing_jobs(int node_inx, time_t now)
+static void _purge_missing_job(job_record_t *job_ptr, int node_inx,
+			       time_t now)
 {
-	ListIterator job_iterator;
-	job_record_t *job_ptr;
 	node_record_t *node_ptr = node_record_table_ptr + node_inx;
 	time_t batch_startup_time, node_boot_time = (time_t) 0, startup_time;
 
@@ -14463,39 +15645,82 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 	batch_startup_time  = now - slurm_conf.batch_start_timeout;
 	batch_startup_time -= MIN(DEFAULT_MSG_TIMEOUT, slurm_conf.msg_timeout);
 
+	if ((job_ptr->batch_flag != 0)			&&
+	    (slurm_conf.suspend_time != 0) /* power mgmt on */	&&
+	    (job_ptr->start_time < node_boot_time)) {
+		startup_time = batch_startup_time -
+			slurm_conf.resume_timeout;
+	} else
+		startup_time = batch_startup_time;
+
+	if ((job_ptr->batch_flag != 0)			&&
+	    (job_ptr->het_job_offset == 0)		&&
+	    (job_ptr->time_last_active < startup_time)	&&
+	    (job_ptr->start_time       < startup_time)	&&
+	    (node_ptr == find_node_record(job_ptr->batch_host))) {
+		bool requeue = false;
+		char *requeue_msg = "";
+		if (job_ptr->details && job_ptr->details->requeue) {
+			requeue = true;
+			requeue_msg = ", Requeuing job";
+		}
+		info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
+		     job_ptr, job_ptr->batch_host, requeue_msg);
+		job_ptr->exit_code = 1;
+		job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
+		             requeue, true, NO_VAL);
+	} else {
+		_notify_srun_missing_step(job_ptr, node_inx,
+					  now, node_boot_time);
+	}
+}
+
+static bool _purge_missing_test(job_record_t *job_ptr)
+{
+	return (!IS_JOB_CONFIGURING(job_ptr) &&
+		(IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr)));
+}
+
+static void _purge_missing_jobs(int node_inx, time_t now)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
-		if ((IS_JOB_CONFIGURING(job_ptr) ||
-		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) ||
-		    (!bit_test(job_ptr->node_bitmap, node_inx)))
+		if (!_purge_missing_test(job_ptr) ||
+		    !bit_test(job_ptr->node_bitmap, node_inx))
 			continue;
-		if ((job_ptr->batch_flag != 0)			&&
-		    (slurm_conf.suspend_time != 0) /* power mgmt on */	&&
-		    (job_ptr->start_time < node_boot_time)) {
-			startup_time = batch_startup_time -
-				slurm_conf.resume_timeout;
-		} else
-			startup_time = batch_startup_time;
-
-		if ((job_ptr->batch_flag != 0)			&&
-		    (job_ptr->het_job_offset == 0)		&&
-		    (job_ptr->time_last_active < startup_time)	&&
-		    (job_ptr->start_time       < startup_time)	&&
-		    (node_ptr == find_node_record(job_ptr->batch_host))) {
-			bool requeue = false;
-			char *requeue_msg = "";
-			if (job_ptr->details && job_ptr->details->requeue) {
-				requeue = true;
-				requeue_msg = ", Requeuing job";
-			}
-			info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
-			     job_ptr, job_ptr->batch_host, requeue_msg);
-			job_ptr->exit_code = 1;
-			job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
-			             requeue, true, NO_VAL);
-		} else {
-			_notify_srun_missing_step(job_ptr, node_inx,
-						  now, node_boot_time);
+		_purge_missing_job(job_ptr, node_inx, now);
+	}
+	list_iterator_destroy(job_iterator);
+}
+
+extern void purge_missing_jobs(bitstr_t *node_bitmap)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	int i, i_first, i_last;
+	time_t now = time(NULL);
+
+	i_first = bit_ffs(node_bitmap);
+	if (i_first == -1)
+		return;
+	i_last = bit_fls(node_bitmap);
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if (!_purge_missing_test(job_ptr) ||
+		    !bit_overlap_any(job_ptr->node_bitmap, node_bitmap))
+			continue;
+		for (i = i_first; i <= i_last; i++) {
+			/* A purge on an earlier node may have ended the job */
+			if (!_purge_missing_test(job_ptr))
+				break;
+			if (!bit_test(node_bitmap, i) ||
+			    !bit_test(job_ptr->node_bitmap, i))
+				continue;
+			_purge_missing_job(job_ptr, i, now);
 		}
 	}
 	list_iterator_destroy(job_iterator);
@@ -14789,7 +16014,7 @@ extern int job_alloc_info_ptr(uint32_t uid, job_record_t *job_ptr)
 	if (job_ptr->alias_list && !xstrcmp(job_ptr->alias_list, "TBD") &&
 	    (prolog == 0) && job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 		set_job_alias_list(job_ptr);
 	}
 
@@ -14940,7 +16165,7 @@ static void _validate_job_files(List batch_dirs)
 		}
 		if (job_ptr && job_ptr->array_recs) { /* Update all tasks */
 			array_job_id = job_ptr->array_job_id;
-			job_ptr = job_array_hash_j[JOB_HASH_INX(array_job_id)];
+			job_ptr = id_hash_find(job_array_hash_j, array_job_id);
 			while (job_ptr) {
 				if (job_ptr->array_job_id == array_job_id)
 					job_ptr->bit_flags |= HAS_STATE_DIR;
@@ -15239,12 +16464,17 @@ void batch_requeue_fini(job_record_t *job_ptr)
 void job_fini (void)
 {
 	FREE_NULL_LIST(job_list);
-	xfree(job_hash);
-	xfree(job_array_hash_j);
-	xfree(job_array_hash_t);
+	id_hash_free(job_hash);
+	job_hash = NULL;
+	id_hash_free(job_array_hash_j);
+	job_array_hash_j = NULL;
+	id_hash_free(job_array_hash_t);
+	job_array_hash_t = NULL;
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
+	xfree(job_tombstones);
+	job_tombstone_cnt = job_tombstone_size = 0;
 }
 
 /* Record the start of one job array task */
@@ -15562,7 +16792,7 @@ extern int job_node_ready(uint32_t job_id, int *ready)
 	    job_ptr->alias_list && !xstrcmp(job_ptr->alias_list, "TBD") &&
 	    job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 		set_job_alias_list(job_ptr);
 	}
 
@@ -15814,7 +17044,8 @@ static int _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp)
 			node_ptr->last_idle  = now;
 		}
 	}
-	last_job_update = last_node_update = now;
+	last_node_update = now;
+	job_info_changed(job_ptr, now);
 	return rc;
 }
 
@@ -15874,7 +17105,8 @@ static int _resume_job_nodes(job_record_t *job_ptr, bool indf_susp)
 		node_flags = node_ptr->node_state & NODE_STATE_FLAGS;
 		node_ptr->node_state = NODE_STATE_ALLOCATED | node_flags;
 	}
-	last_job_update = last_node_update = time(NULL);
+	last_node_update = time(NULL);
+	job_info_changed(job_ptr, last_node_update);
 	return rc;
 }
 
@@ -16198,7 +17430,7 @@ extern int job_suspend2(suspend_msg_t *sus_ptr, uid_t uid,
 		}
 
 		/* Suspend all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		if (!job_ptr && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
@@ -16358,7 +17590,7 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 			return SLURM_SUCCESS;
 	}
 
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 
 	/*
 	 * In the job is in the process of completing
@@ -16663,7 +17895,7 @@ extern int job_requeue2(uid_t uid, requeue_msg_t *req_ptr, slurm_msg_t *msg,
 		}
 
 		/* Requeue all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = id_hash_find(job_array_hash_j, job_id);
 		if (!job_ptr && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
@@ -16905,7 +18137,7 @@ static int _set_top(List top_job_list, uid_t uid)
 	}
 	FREE_NULL_LIST(other_job_list);
 
-	last_job_update = time(NULL);
+	job_info_changed(NULL, time(NULL));
 
 	return rc;
 }
@@ -17182,7 +18414,7 @@ extern int update_job_wckey(char *module, job_record_t *job_ptr,
 		info("%s: cleared wckey for %pJ", module, job_ptr);
 	}
 
-	last_job_update = time(NULL);
+	job_info_changed(job_ptr, time(NULL));
 
 	return SLURM_SUCCESS;
 }
@@ -17742,7 +18974,7 @@ static void _kill_dependent(job_record_t *job_ptr)
 	job_ptr->start_time = now;
 	job_ptr->end_time = now;
 	job_completion_logger(job_ptr, false);
-	last_job_update = now;
+	job_info_changed(job_ptr, now);
 	srun_allocate_abort(job_ptr);
 }
 
@@ -58,6 +58,7 @@
 #include "src/common/env.h"
 #include "src/common/gres.h"
 #include "src/common/group_cache.h"
+#include "src/common/id_hash.h"
 #include "src/common/list.h"
 #include "src/common/macros.h"
 #include "src/common/node_features.h"
@@ -98,12 +99,41 @@
 #endif
 #define BUILD_TIMEOUT 2000000	/* Max build_job_queue() run time in usec */
 #define MAX_FAILED_RESV 10
+#define QUEUE_ORDER_MAX_AGE 300	/* Fully re-sort job queue order this often */
 
 typedef struct wait_boot_arg {
 	uint32_t job_id;
 	bitstr_t *node_bitmap;
 } wait_boot_arg_t;
 
+/*
+ * Identity of a job queue record and the values sort_job_queue2() orders
+ * it by, as of the last sort_job_queue_incr() call.
+ */
+typedef struct {
+	job_record_t *job_ptr;
+	uint32_t job_id;
+	part_record_t *part_ptr;
+	slurmctld_resv_t *resv_ptr;
+	bool has_resv;
+	uint32_t priority;
+	uint32_t priority_tier;
+	time_t submit_time;
+	uint32_t het_job_id;
+	bool het_any_resv;
+	uint32_t het_priority;
+	uint32_t het_priority_tier;
+	void *qos_ptr;
+} job_queue_key_t;
+
+struct job_queue_order {
+	job_queue_key_t *keys;	/* queue records in priority order */
+	uint32_t key_cnt;
+	time_t conf_update;	/* slurm_conf.last_update when sorted */
+	time_t part_update;	/* last_part_update when sorted */
+	time_t sort_time;	/* time of last full sort */
+};
+
 static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 						     uint16_t protocol_version);
 static void	_job_queue_append(List job_queue, job_record_t *job_ptr,
@@ -121,6 +151,7 @@ static void *	_wait_boot(void *arg);
 #endif
 static int	build_queue_timeout = BUILD_TIMEOUT;
 static int	save_last_part_update = 0;
+static job_queue_order_t *sched_queue_order = NULL;
 
 static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int sched_pend_thread = 0;
@@ -308,7 +339,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 	if (job_ptr->state_reason == WAIT_FRONT_END) {
 		job_ptr->state_reason = WAIT_NO_REASON;
 		xfree(job_ptr->state_desc);
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 	}
 #endif
 
@@ -324,7 +355,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 		    && job_ptr->state_reason != WAIT_MAX_REQUEUE) {
 			job_ptr->state_reason = WAIT_HELD;
 			xfree(job_ptr->state_desc);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		}
 		sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 			     job_ptr,
@@ -587,7 +618,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 			    (job_ptr->state_reason != WAIT_RESOURCES))
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		}
 		if (!_job_runnable_test1(job_ptr, clear_start))
 			continue;
@@ -603,7 +634,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 				    (reason != job_ptr->state_reason)) {
 					job_ptr->state_reason = reason;
 					xfree(job_ptr->state_desc);
-					last_job_update = now;
+					job_info_changed(job_ptr, now);
 				}
 				/* priority_array index matches part_ptr_list
 				 * position: increment inx */
@@ -933,7 +964,7 @@ extern bool deadline_ok(job_record_t *job_ptr, char *func)
 		}
 	}
 	if (fail_job) {
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		job_ptr->job_state = JOB_DEADLINE;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_DEADLINE;
@@ -1364,7 +1395,7 @@ static int _schedule(bool full_queue)
 	} else {
 		job_queue = build_job_queue(false, false);
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
-		sort_job_queue(job_queue);
+		sort_job_queue_incr(job_queue, &sched_queue_order);
 	}
 
 	job_ptr = NULL;
@@ -1393,7 +1424,7 @@ static int _schedule(bool full_queue)
 			if (!avail_front_end(job_ptr)) {
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 				continue;
 			}
 			if (!_job_runnable_test1(job_ptr, false))
@@ -1439,7 +1470,7 @@ next_part:
 			if (!avail_front_end(job_ptr)) {
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 				continue;
 			}
 			if ((job_ptr->array_task_id != array_task_id) &&
@@ -1593,7 +1624,7 @@ next_task:
 					     job_ptr->state_desc,
 					     job_ptr->priority);
 			}
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 
 			continue;
 		} else if (wait_on_resv &&
@@ -1621,12 +1652,12 @@ next_task:
 				assoc_mgr_unlock(&locks);
 				sched_debug("%pJ has invalid QOS", job_ptr);
 				job_fail_qos(job_ptr, __func__);
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
-				last_job_update = now;
+				job_info_changed(job_ptr, now);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -1683,7 +1714,7 @@ next_task:
 			job_ptr->state_reason = WAIT_RESOURCES;
 			xfree(job_ptr->state_desc);
 			job_ptr->state_desc = xstrdup("Nodes required for job are DOWN, DRAINED or reserved for jobs in higher priority partitions");
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1696,7 +1727,7 @@ next_task:
 		    SLURM_SUCCESS) {
 			job_ptr->state_reason = WAIT_LICENSES;
 			xfree(job_ptr->state_desc);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1713,7 +1744,7 @@ next_task:
 			 * the time we consider running it. It should be
 			 * very rare. */
 			sched_info("%pJ has invalid account", job_ptr);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			job_ptr->state_reason = FAIL_ACCOUNT;
 			xfree(job_ptr->state_desc);
 			continue;
@@ -1796,7 +1827,7 @@ skip_start:
 		} else if (error_code == ESLURM_FED_JOB_LOCK) {
 			job_ptr->state_reason = WAIT_FED_JOB_LOCK;
 			xfree(job_ptr->state_desc);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1806,7 +1837,7 @@ skip_start:
 		} else if (error_code == SLURM_SUCCESS) {
 			/* job initiated */
 			sched_debug3("%pJ initiated", job_ptr);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 
 			/* Clear assumed rejected array status */
 			reject_array_job = NULL;
@@ -1849,7 +1880,7 @@ skip_start:
 			   (error_code != ESLURM_INVALID_BURST_BUFFER_REQUEST)){
 			sched_info("schedule: %pJ non-runnable: %s",
 				   job_ptr, slurm_strerror(error_code));
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			job_ptr->job_state = JOB_PENDING;
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
@@ -1940,6 +1971,7 @@ fail_this_part:	if (fail_by_part) {
 	}
 	xfree(sched_part_ptr);
 	xfree(sched_part_jobs);
+	job_info_sweep();
 	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
 	if ((slurmctld_config.server_thread_count >= 150) &&
 	    (defer_rpc_cnt == 0)) {
@@ -1971,6 +2003,180 @@ extern void sort_job_queue(List job_queue)
 	list_sort(job_queue, sort_job_queue2);
 }
 
+static void _set_job_queue_key(job_queue_key_t *key,
+			       job_queue_rec_t *job_queue_rec)
+{
+	job_record_t *job_ptr = job_queue_rec->job_ptr;
+
+	key->job_ptr = job_ptr;
+	key->job_id = job_queue_rec->job_id;
+	key->part_ptr = job_queue_rec->part_ptr;
+	key->resv_ptr = job_queue_rec->resv_ptr;
+	key->has_resv = (job_ptr->resv_id != 0) || job_queue_rec->resv_ptr;
+	if (job_ptr->part_ptr_list && job_ptr->priority_array)
+		key->priority = job_queue_rec->priority;
+	else
+		key->priority = job_ptr->priority;
+	key->priority_tier = job_queue_rec->part_ptr ?
+			     job_queue_rec->part_ptr->priority_tier : 0;
+	key->submit_time = job_ptr->details ?
+			   job_ptr->details->submit_time : 0;
+	key->het_job_id = job_ptr->het_job_id;
+	key->het_any_resv = false;
+	key->het_priority = 0;
+	key->het_priority_tier = 0;
+	if (job_ptr->het_details) {
+		key->het_any_resv = job_ptr->het_details->any_resv;
+		key->het_priority = job_ptr->het_details->priority;
+		key->het_priority_tier = job_ptr->het_details->priority_tier;
+	}
+	key->qos_ptr = job_ptr->qos_ptr;
+}
+
+static bool _job_queue_key_equal(job_queue_key_t *key1,
+				 job_queue_key_t *key2)
+{
+	return ((key1->job_ptr == key2->job_ptr) &&
+		(key1->job_id == key2->job_id) &&
+		(key1->part_ptr == key2->part_ptr) &&
+		(key1->resv_ptr == key2->resv_ptr) &&
+		(key1->has_resv == key2->has_resv) &&
+		(key1->priority == key2->priority) &&
+		(key1->priority_tier == key2->priority_tier) &&
+		(key1->submit_time == key2->submit_time) &&
+		(key1->het_job_id == key2->het_job_id) &&
+		(key1->het_any_resv == key2->het_any_resv) &&
+		(key1->het_priority == key2->het_priority) &&
+		(key1->het_priority_tier == key2->het_priority_tier) &&
+		(key1->qos_ptr == key2->qos_ptr));
+}
+
+static uint64_t _job_queue_key_hash(job_queue_key_t *key)
+{
+	uint64_t ptrs = ((uintptr_t) key->part_ptr >> 4) ^
+			((uintptr_t) key->resv_ptr >> 4);
+
+	return ((uint64_t) key->job_id << 32) ^ (ptrs & 0xffffffff);
+}
+
+static void _job_queue_order_sort(List job_queue, job_queue_order_t *order)
+{
+	ListIterator iter;
+	job_queue_rec_t *job_queue_rec;
+	uint32_t i = 0;
+
+	list_sort(job_queue, sort_job_queue2);
+
+	xfree(order->keys);
+	order->key_cnt = list_count(job_queue);
+	order->keys = xcalloc(order->key_cnt + 1, sizeof(job_queue_key_t));
+	iter = list_iterator_create(job_queue);
+	while ((job_queue_rec = list_next(iter)))
+		_set_job_queue_key(&order->keys[i++], job_queue_rec);
+	list_iterator_destroy(iter);
+
+	order->conf_update = slurm_conf.last_update;
+	order->part_update = last_part_update;
+	order->sort_time = time(NULL);
+}
+
+/*
+ * sort_job_queue_incr - sort job_queue in descending priority order, reusing
+ *	the order found by the previous call with the same order state.
+ *	Records whose job, partition, reservation and sort values are
+ *	unchanged keep their previous relative order; only new or changed
+ *	records are sorted and then merged in, so a typical scheduling pass
+ *	costs O(n + k log k) for k changed records rather than O(n log n).
+ * IN/OUT job_queue - job queue made by build_job_queue()
+ * IN/OUT order_pptr - order state, created on first use, free with
+ *	job_queue_order_free()
+ */
+extern void sort_job_queue_incr(List job_queue, job_queue_order_t **order_pptr)
+{
+	job_queue_order_t *order;
+	job_queue_rec_t *job_queue_rec, **kept, **changed, **merged;
+	job_queue_key_t *keys, *old_key;
+	id_hash_t *key_hash;
+	uint32_t i, j, k, rec_cnt, kept_cnt, changed_cnt = 0;
+	time_t now = time(NULL);
+
+	if (!*order_pptr)
+		*order_pptr = xmalloc(sizeof(job_queue_order_t));
+	order = *order_pptr;
+
+	rec_cnt = list_count(job_queue);
+	if (!order->keys || !rec_cnt ||
+	    (order->conf_update != slurm_conf.last_update) ||
+	    (order->part_update != last_part_update) ||
+	    (difftime(now, order->sort_time) >= QUEUE_ORDER_MAX_AGE)) {
+		_job_queue_order_sort(job_queue, order);
+		return;
+	}
+
+	/* Match records to the previous order, popping them off job_queue */
+	key_hash = id_hash_init(order->key_cnt);
+	for (i = 0; i < order->key_cnt; i++) {
+		id_hash_add(key_hash, _job_queue_key_hash(&order->keys[i]),
+			    &order->keys[i]);
+	}
+	kept = xcalloc(order->key_cnt + 1, sizeof(job_queue_rec_t *));
+	changed = xcalloc(rec_cnt + 1, sizeof(job_queue_rec_t *));
+	keys = xcalloc(rec_cnt + 1, sizeof(job_queue_key_t));
+	for (i = 0; (job_queue_rec = list_pop(job_queue)); i++) {
+		_set_job_queue_key(&keys[i], job_queue_rec);
+		old_key = id_hash_find(key_hash, _job_queue_key_hash(&keys[i]));
+		if (old_key && _job_queue_key_equal(old_key, &keys[i]) &&
+		    !kept[old_key - order->keys])
+			kept[old_key - order->keys] = job_queue_rec;
+		else
+			changed[changed_cnt++] = job_queue_rec;
+	}
+	id_hash_free(key_hash);
+	xfree(keys);
+
+	/* Records still in the previous order are already sorted */
+	for (i = 0, kept_cnt = 0; i < order->key_cnt; i++) {
+		if (kept[i])
+			kept[kept_cnt++] = kept[i];
+	}
+	qsort(changed, changed_cnt, sizeof(job_queue_rec_t *),
+	      (int (*)(const void *, const void *)) sort_job_queue2);
+
+	merged = xcalloc(rec_cnt + 1, sizeof(job_queue_rec_t *));
+	for (i = 0, j = 0, k = 0; (i < kept_cnt) || (j < changed_cnt); k++) {
+		if ((j >= changed_cnt) ||
+		    ((i < kept_cnt) &&
+		     (sort_job_queue2(&kept[i], &changed[j]) <= 0)))
+			merged[k] = kept[i++];
+		else
+			merged[k] = changed[j++];
+	}
+
+	xfree(order->keys);
+	order->key_cnt = rec_cnt;
+	order->keys = xcalloc(rec_cnt + 1, sizeof(job_queue_key_t));
+	for (i = 0; i < rec_cnt; i++) {
+		list_append(job_queue, merged[i]);
+		_set_job_queue_key(&order->keys[i], merged[i]);
+	}
+	debug3("%s: %u of %u job queue records re-sorted",
+	       __func__, changed_cnt, rec_cnt);
+
+	xfree(kept);
+	xfree(changed);
+	xfree(merged);
+}
+
+/* job_queue_order_free - free order state from sort_job_queue_incr() */
+extern void job_queue_order_free(job_queue_order_t **order_pptr)
+{
+	if (!*order_pptr)
+		return;
+
+	xfree((*order_pptr)->keys);
+	xfree(*order_pptr);
+}
+
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
  * in order of decreasing priority then submit time and the by increasing
  * job id */
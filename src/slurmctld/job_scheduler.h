@@ -56,6 +56,9 @@ typedef struct job_queue_rec {
 					 * in without requesting */
 } job_queue_rec_t;
 
+/* Priority order of a job queue kept between sort_job_queue_incr() calls */
+typedef struct job_queue_order job_queue_order_t;
+
 /* Use as return values for test_job_dependency. */
 enum {
 	NO_DEPEND = 0,
@@ -240,6 +243,18 @@ extern void set_job_elig_time(void);
  */
 extern void sort_job_queue(List job_queue);
 
+/*
+ * sort_job_queue_incr - sort job_queue in decending priority order, only
+ *	sorting the records changed since the previous call with the same
+ *	order state
+ * IN/OUT job_queue - sorted job queue previously made by build_job_queue()
+ * IN/OUT order_pptr - order state, created on first use
+ */
+extern void sort_job_queue_incr(List job_queue, job_queue_order_t **order_pptr);
+
+/* job_queue_order_free - free order state from sort_job_queue_incr() */
+extern void job_queue_order_free(job_queue_order_t **order_pptr);
+
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
  *	in order of decreasing priority */
 extern int sort_job_queue2(void *x, void *y);
@@ -48,6 +48,7 @@
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_rwlock_t slurmctld_locks[ENTITY_COUNT];
+static uint64_t write_cnt[ENTITY_COUNT];	/* see lock_write_count() */
 
 #ifndef NDEBUG
 /*
@@ -116,28 +117,38 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 
 	if (lock_levels.conf == READ_LOCK)
 		slurm_rwlock_rdlock(&slurmctld_locks[CONF_LOCK]);
-	else if (lock_levels.conf == WRITE_LOCK)
+	else if (lock_levels.conf == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&slurmctld_locks[CONF_LOCK]);
+		write_cnt[CONF_LOCK]++;
+	}
 
 	if (lock_levels.job == READ_LOCK)
 		slurm_rwlock_rdlock(&slurmctld_locks[JOB_LOCK]);
-	else if (lock_levels.job == WRITE_LOCK)
+	else if (lock_levels.job == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&slurmctld_locks[JOB_LOCK]);
+		write_cnt[JOB_LOCK]++;
+	}
 
 	if (lock_levels.node == READ_LOCK)
 		slurm_rwlock_rdlock(&slurmctld_locks[NODE_LOCK]);
-	else if (lock_levels.node == WRITE_LOCK)
+	else if (lock_levels.node == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&slurmctld_locks[NODE_LOCK]);
+		write_cnt[NODE_LOCK]++;
+	}
 
 	if (lock_levels.part == READ_LOCK)
 		slurm_rwlock_rdlock(&slurmctld_locks[PART_LOCK]);
-	else if (lock_levels.part == WRITE_LOCK)
+	else if (lock_levels.part == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&slurmctld_locks[PART_LOCK]);
+		write_cnt[PART_LOCK]++;
+	}
 
 	if (lock_levels.fed == READ_LOCK)
 		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
-	else if (lock_levels.fed == WRITE_LOCK)
+	else if (lock_levels.fed == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+		write_cnt[FED_LOCK]++;
+	}
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
@@ -162,6 +173,11 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 		slurm_rwlock_unlock(&slurmctld_locks[CONF_LOCK]);
 }
 
+extern uint64_t lock_write_count(lock_datatype_t datatype)
+{
+	return write_cnt[datatype];
+}
+
 /*
  * _report_lock_set - report whether the read or write lock is set
  */
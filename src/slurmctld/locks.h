@@ -91,6 +91,7 @@
 #ifndef _SLURMCTLD_LOCKS_H
 #define _SLURMCTLD_LOCKS_H
 
+#include <inttypes.h>
 #include <stdbool.h>
 
 /* levels of locking required for each data structure */
@@ -135,6 +136,13 @@ extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
 extern int report_locks_set(void);
 
+/*
+ * lock_write_count - return how many times the write lock of an entity was
+ *	taken. The count is raised as the lock is taken, so it is stable and
+ *	current while the caller holds at least the entity's read lock.
+ */
+extern uint64_t lock_write_count(lock_datatype_t datatype);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
@@ -732,6 +732,9 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	*buffer_size = 0;
 
 	buffer = init_buf (BUF_SIZE*16);
+	/* strings repeated across the nodes are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
@@ -784,6 +787,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	pack32  (nodes_packed, buffer);
 	set_buf_offset (buffer, tmp_offset);
 
+	str_dict_destroy(buffer->str_dict);
 	*buffer_size = get_buf_offset (buffer);
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
@@ -819,6 +823,9 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	*buffer_size = 0;
 
 	buffer = init_buf (BUF_SIZE);
+	/* strings repeated across the nodes are sent once */
+	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION)
+		set_buf_str_dict(buffer, str_dict_create());
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
@@ -862,6 +869,7 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	pack32  (nodes_packed, buffer);
 	set_buf_offset (buffer, tmp_offset);
 
+	str_dict_destroy(buffer->str_dict);
 	*buffer_size = get_buf_offset (buffer);
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
@@ -892,7 +900,7 @@ static void _pack_node(node_record_t *dump_node_ptr, Buf buffer,
 		pack16(dump_node_ptr->port, buffer);
 		pack32(dump_node_ptr->next_state, buffer);
 		pack32(dump_node_ptr->node_state, buffer);
-		packstr(dump_node_ptr->version, buffer);
+		packstr_dict(dump_node_ptr->version, buffer);
 
 		/* Only data from config_record used for scheduling */
 		pack16(dump_node_ptr->config_ptr->cpus, buffer);
@@ -903,7 +911,7 @@ static void _pack_node(node_record_t *dump_node_ptr, Buf buffer,
 		pack64(dump_node_ptr->config_ptr->real_memory, buffer);
 		pack32(dump_node_ptr->config_ptr->tmp_disk, buffer);
 
-		packstr(dump_node_ptr->mcs_label, buffer);
+		packstr_dict(dump_node_ptr->mcs_label, buffer);
 		pack32(dump_node_ptr->owner, buffer);
 		pack16(dump_node_ptr->core_spec_cnt, buffer);
 		pack32(dump_node_ptr->cpu_bind, buffer);
@@ -922,13 +930,13 @@ static void _pack_node(node_record_t *dump_node_ptr, Buf buffer,
 		select_g_select_nodeinfo_pack(dump_node_ptr->select_nodeinfo,
 					      buffer, protocol_version);
 
-		packstr(dump_node_ptr->arch, buffer);
-		packstr(dump_node_ptr->features, buffer);
-		packstr(dump_node_ptr->features_act, buffer);
+		packstr_dict(dump_node_ptr->arch, buffer);
+		packstr_dict(dump_node_ptr->features, buffer);
+		packstr_dict(dump_node_ptr->features_act, buffer);
 		if (dump_node_ptr->gres)
-			packstr(dump_node_ptr->gres, buffer);
+			packstr_dict(dump_node_ptr->gres, buffer);
 		else
-			packstr(dump_node_ptr->config_ptr->gres, buffer);
+			packstr_dict(dump_node_ptr->config_ptr->gres, buffer);
 
 		/* Gathering GRES details is slow, so don't by default */
 		if (show_flags & SHOW_DETAIL) {
@@ -942,8 +950,8 @@ static void _pack_node(node_record_t *dump_node_ptr, Buf buffer,
 		xfree(gres_drain);
 		xfree(gres_used);
 
-		packstr(dump_node_ptr->os, buffer);
-		packstr(dump_node_ptr->reason, buffer);
+		packstr_dict(dump_node_ptr->os, buffer);
+		packstr_dict(dump_node_ptr->reason, buffer);
 		acct_gather_energy_pack(dump_node_ptr->energy, buffer,
 					protocol_version);
 		ext_sensors_data_pack(dump_node_ptr->ext_sensors, buffer,
@@ -951,7 +959,7 @@ static void _pack_node(node_record_t *dump_node_ptr, Buf buffer,
 		power_mgmt_data_pack(dump_node_ptr->power, buffer,
 				     protocol_version);
 
-		packstr(dump_node_ptr->tres_fmt_str, buffer);
+		packstr_dict(dump_node_ptr->tres_fmt_str, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		packstr (dump_node_ptr->name, buffer);
 		packstr (dump_node_ptr->node_hostname, buffer);
@@ -3798,7 +3806,7 @@ void make_node_idle(node_record_t *node_ptr, job_record_t *job_ptr)
 	xassert(node_ptr);
 	if (node_bitmap && (bit_test(node_bitmap, inx))) {
 		/* Not a replay */
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		bit_clear(node_bitmap, inx);
 
 		if (!IS_JOB_FINISHED(job_ptr))
@@ -2308,7 +2308,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		    (job_ptr->state_reason == FAIL_BURST_BUFFER_OP))
 			return ESLURM_BURST_BUFFER_WAIT; /* Fatal BB event */
 		xfree(job_ptr->state_desc);
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		if (bb == 0)
 			job_ptr->state_reason = WAIT_BURST_BUFFER_STAGING;
 		else
@@ -2468,7 +2468,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			       __func__, job_ptr);
 			job_ptr->state_reason = WAIT_PART_NODE_LIMIT;
 			xfree(job_ptr->state_desc);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 
 		/* Non-fatal errors for job below */
 		} else if (error_code == ESLURM_NODE_NOT_AVAIL) {
@@ -2507,15 +2507,18 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 					   "for other job");
 			}
 			xfree(unavail_node);
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 		} else if (error_code == ESLURM_RESERVATION_MAINT) {
 			error_code = ESLURM_RESERVATION_BUSY;	/* All reserved */
 			job_ptr->state_reason = WAIT_NODE_NOT_AVAIL;
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc,
 				   "ReqNodeNotAvail, Reserved for maintenance");
+			job_info_changed(job_ptr, now);
 		} else if ((error_code == ESLURM_RESERVATION_NOT_USABLE) ||
 			   (error_code == ESLURM_RESERVATION_BUSY)) {
+			if (job_ptr->state_reason != WAIT_RESERVATION)
+				job_info_refreshed(job_ptr, now);
 			job_ptr->state_reason = WAIT_RESERVATION;
 			xfree(job_ptr->state_desc);
 		} else if ((job_ptr->state_reason == WAIT_BLOCK_MAX_ERR) ||
@@ -2525,6 +2528,8 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			   (job_ptr->priority == 0)) {
 			/* Held by select plugin due to some failure */
 		} else {
+			if (job_ptr->state_reason != WAIT_RESOURCES)
+				job_info_refreshed(job_ptr, now);
 			job_ptr->state_reason = WAIT_RESOURCES;
 			xfree(job_ptr->state_desc);
 		}
@@ -2583,7 +2588,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->priority = 0;
 		job_ptr->state_reason = WAIT_HELD;
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		goto cleanup;
 	}
 	if (select_g_job_begin(job_ptr) != SLURM_SUCCESS) {
@@ -2598,7 +2603,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->time_last_active = 0;
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		goto cleanup;
 	}
 
@@ -2621,7 +2626,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->time_last_active = 0;
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
-		last_job_update = now;
+		job_info_changed(job_ptr, now);
 		goto cleanup;
 	}
 
@@ -2649,7 +2654,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			job_ptr->end_time = 0;
 			job_ptr->state_reason = WAIT_RESOURCES;
 			job_ptr->job_state = JOB_PENDING;
-			last_job_update = now;
+			job_info_changed(job_ptr, now);
 			goto cleanup;
 		}
 	}
@@ -2065,7 +2065,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
@@ -2089,7 +2089,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
@@ -2120,7 +2120,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
@@ -2156,7 +2156,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
@@ -2175,7 +2175,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
@@ -2201,7 +2201,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
-				last_job_update = time(NULL);
+				job_info_changed(job_ptr, time(NULL));
 			} else {
 				xfree(tmp_err);
 			}
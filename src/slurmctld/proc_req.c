@@ -63,6 +63,7 @@
 #include "src/common/hostlist.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/node_features.h"
 #include "src/common/node_select.h"
 #include "src/common/pack.h"
@@ -89,13 +90,16 @@
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
+#include "src/slurmctld/info_snapshot.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/power_save.h"
 #include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rate_limit.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
@@ -112,6 +116,7 @@ static uint64_t rpc_type_time[RPC_TYPE_SIZE] = { 0 };
 static uint32_t rpc_user_id[RPC_USER_SIZE] = { 0 };
 static uint32_t rpc_user_cnt[RPC_USER_SIZE] = { 0 };
 static uint64_t rpc_user_time[RPC_USER_SIZE] = { 0 };
+static uint32_t rpc_user_rejected[RPC_USER_SIZE] = { 0 };
 
 static config_response_msg_t *config_for_slurmd = NULL;
 static config_response_msg_t *config_for_clients = NULL;
@@ -176,6 +181,20 @@ extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 	slurm_mutex_unlock(&rpc_mutex);
 }
 
+extern void record_rpc_rejected(slurm_msg_t *msg)
+{
+	slurm_mutex_lock(&rpc_mutex);
+	for (int i = 0; i < RPC_USER_SIZE; i++) {
+		if ((rpc_user_id[i] == 0) && (i != 0))
+			rpc_user_id[i] = msg->auth_uid;
+		else if (rpc_user_id[i] != msg->auth_uid)
+			continue;
+		rpc_user_rejected[i]++;
+		break;
+	}
+	slurm_mutex_unlock(&rpc_mutex);
+}
+
 /* These functions prevent certain RPCs from keeping the slurmctld write locks
  * constantly set, which can prevent other RPCs and system functions from being
  * processed. For example, a steady stream of batch submissions can prevent
@@ -1463,6 +1482,31 @@ static void _slurm_rpc_dump_conf(slurm_msg_t * msg)
 	}
 }
 
+/*
+ * Send a job or node information response from a snapshot without holding
+ * any slurmctld locks, then release the snapshot.
+ */
+static void _send_info_snapshot(slurm_msg_t *msg, info_snapshot_t *snap,
+				uint16_t msg_type, time_t last_update)
+{
+	slurm_msg_t response_msg;
+
+	if ((last_update - 1) >= snap->update_time) {
+		info_snapshot_release(snap);
+		debug3("%s: %s, no change", __func__, rpc_num2string(msg_type));
+		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		return;
+	}
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = msg_type;
+	response_msg.data = snap->data;
+	response_msg.data_size = snap->data_size;
+
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	info_snapshot_release(snap);
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 {
@@ -1476,8 +1520,25 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
+	info_snapshot_t *snap;
+	bool delta = false;
 
 	START_TIMER;
+	if (!job_info_request_msg->job_ids &&
+	    (job_info_request_msg->show_flags & SHOW_DELTA) &&
+	    (msg->protocol_version >= SLURM_20_11_PROTOCOL_VERSION))
+		delta = true;
+
+	if (!job_info_request_msg->job_ids && !delta &&
+	    (snap = info_snapshot_get(INFO_SNAPSHOT_JOBS,
+				      job_info_request_msg->show_flags, uid,
+				      msg->protocol_version))) {
+		_send_info_snapshot(msg, snap, RESPONSE_JOB_INFO,
+				    job_info_request_msg->last_update);
+		END_TIMER2("_slurm_rpc_dump_jobs");
+		return;
+	}
+
 	lock_slurmctld(job_read_lock);
 
 	if ((job_info_request_msg->last_update - 1) >= last_job_update) {
@@ -1490,6 +1551,11 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 				       job_info_request_msg->job_ids,
 				       job_info_request_msg->show_flags, uid,
 				       NO_VAL, msg->protocol_version);
+		} else if (delta) {
+			pack_delta_jobs(&dump, &dump_size,
+					job_info_request_msg->last_update,
+					job_info_request_msg->show_flags, uid,
+					msg->protocol_version);
 		} else {
 			pack_all_jobs(&dump, &dump_size,
 				      job_info_request_msg->show_flags, uid,
@@ -1502,7 +1568,8 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 #endif
 
 		response_init(&response_msg, msg);
-		response_msg.msg_type = RESPONSE_JOB_INFO;
+		response_msg.msg_type = delta ? RESPONSE_JOB_INFO_DELTA :
+						RESPONSE_JOB_INFO;
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 
@@ -1736,6 +1803,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	slurmctld_lock_t node_write_lock = {
 		READ_LOCK, NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
+	info_snapshot_t *snap;
 
 	START_TIMER;
 	if ((slurm_conf.private_data & PRIVATE_DATA_NODES) &&
@@ -1746,6 +1814,15 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		return;
 	}
 
+	if ((snap = info_snapshot_get(INFO_SNAPSHOT_NODES,
+				      node_req_msg->show_flags, uid,
+				      msg->protocol_version))) {
+		_send_info_snapshot(msg, snap, RESPONSE_NODE_INFO,
+				    node_req_msg->last_update);
+		END_TIMER2("_slurm_rpc_dump_nodes");
+		return;
+	}
+
 	lock_slurmctld(node_write_lock);
 
 	select_g_select_nodeinfo_set_all();
@@ -2066,9 +2143,12 @@ static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
 }
 
 /* _slurm_rpc_complete_batch - process RPC from slurmstepd to note the
- *	completion of a batch script */
+ *	completion of a batch script
+ * OUT save_job, save_node - if not NULL, set when job or node state must be
+ *	saved, which the caller then schedules once for a batch of RPCs */
 static void _slurm_rpc_complete_batch_script(slurm_msg_t *msg,
 					     bool *run_scheduler,
+					     bool *save_job, bool *save_node,
 					     bool running_composite)
 {
 	static int active_rpc_cnt = 0;
@@ -2255,9 +2335,13 @@ static void _slurm_rpc_complete_batch_script(slurm_msg_t *msg,
 	/* If running composite lets not call this to avoid deadlock */
 	if (!running_composite && *run_scheduler)
 		(void) schedule(0);		/* Has own locking */
-	if (dump_job)
+	if (save_job)
+		*save_job |= dump_job;
+	else if (dump_job)
 		(void) schedule_job_save();	/* Has own locking */
-	if (dump_node)
+	if (save_node)
+		*save_node |= dump_node;
+	else if (dump_node)
 		(void) schedule_node_save();	/* Has own locking */
 }
 
@@ -2704,8 +2788,10 @@ static void _find_avail_future_node(slurm_msg_t *msg)
 }
 
 /* _slurm_rpc_node_registration - process RPC to determine if a node's
- *	actual configuration satisfies the configured specification */
+ *	actual configuration satisfies the configured specification
+ *	purge_node_bitmap - see validate_jobs_on_node() */
 static void _slurm_rpc_node_registration(slurm_msg_t * msg,
+					 bitstr_t *purge_node_bitmap,
 					 bool running_composite)
 {
 	/* init */
@@ -2759,7 +2845,7 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 							  msg->protocol_version,
 							  &newly_up);
 #else
-		validate_jobs_on_node(node_reg_stat_msg);
+		validate_jobs_on_node(node_reg_stat_msg, purge_node_bitmap);
 		error_code = validate_node_specs(msg, &newly_up);
 #endif
 		if (!running_composite)
@@ -3192,6 +3278,7 @@ static void _slurm_rpc_reconfigure_controller(slurm_msg_t * msg)
 		}
 		in_progress = false;
 		gs_reconfig();
+		rate_limit_init();
 		unlock_slurmctld(config_write_lock);
 		xcgroup_reconfig_slurm_cgroup_conf();
 		assoc_mgr_set_missing_uids();
@@ -5310,13 +5397,31 @@ static void _clear_rpc_stats(void)
 	memset(rpc_user_cnt, 0, sizeof(rpc_user_cnt));
 	memset(rpc_user_id, 0, sizeof(rpc_user_id));
 	memset(rpc_user_time, 0, sizeof(rpc_user_time));
+	memset(rpc_user_rejected, 0, sizeof(rpc_user_rejected));
 	slurm_mutex_unlock(&rpc_mutex);
 }
 
+static void _pack_list_cache_stats(buf_t *buffer)
+{
+	list_cache_stats_t node_stats, itr_stats;
+
+	list_cache_stats(&node_stats, &itr_stats);
+	pack64(node_stats.alloc_cnt, buffer);
+	pack64(node_stats.malloc_cnt, buffer);
+	pack64(node_stats.free_cnt, buffer);
+	pack64(node_stats.depot_cnt, buffer);
+	pack32(node_stats.cached_cnt, buffer);
+	pack64(itr_stats.alloc_cnt, buffer);
+	pack64(itr_stats.malloc_cnt, buffer);
+	pack64(itr_stats.free_cnt, buffer);
+	pack64(itr_stats.depot_cnt, buffer);
+	pack32(itr_stats.cached_cnt, buffer);
+}
+
 static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 			    uint16_t protocol_version)
 {
-	uint32_t i;
+	uint32_t i, user_cnt;
 	Buf buffer;
 
 	slurm_mutex_lock(&rpc_mutex);
@@ -5337,6 +5442,7 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 			if (rpc_user_id[i] == 0)
 				break;
 		}
+		user_cnt = i;
 		pack32(i, buffer);
 		pack32_array(rpc_user_id,   i, buffer);
 		pack32_array(rpc_user_cnt,  i, buffer);
@@ -5344,6 +5450,12 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 
 		agent_pack_pending_rpc_stats(buffer);
 
+		if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+			rpc_queue_pack_stats(buffer);
+			pack32_array(rpc_user_rejected, user_cnt, buffer);
+			msg_compress_pack_stats(buffer);
+			_pack_list_cache_stats(buffer);
+		}
 	}
 
 	slurm_mutex_unlock(&rpc_mutex);
@@ -5399,6 +5511,9 @@ static void _slurm_rpc_dump_stats(slurm_msg_t *msg)
 	if (request_msg->command_id == STAT_COMMAND_RESET) {
 		reset_stats(1);
 		_clear_rpc_stats();
+		rpc_queue_clear_stats();
+		msg_compress_clear_stats();
+		list_cache_clear_stats();
 		pack_all_stat(0, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(0, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
@@ -6037,7 +6152,8 @@ void slurmctld_req(slurm_msg_t *msg)
 		_slurm_rpc_complete_prolog(msg);
 		break;
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
-		_slurm_rpc_complete_batch_script(msg, &run_scheduler, 0);
+		_slurm_rpc_complete_batch_script(msg, &run_scheduler, NULL,
+						 NULL, 0);
 		break;
 	case REQUEST_JOB_STEP_CREATE:
 		_slurm_rpc_job_step_create(msg);
@@ -6058,7 +6174,7 @@ void slurmctld_req(slurm_msg_t *msg)
 		_proc_multi_msg(msg);
 		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
-		_slurm_rpc_node_registration(msg, 0);
+		_slurm_rpc_node_registration(msg, NULL, 0);
 		break;
 	case REQUEST_JOB_ALLOCATION_INFO:
 		_slurm_rpc_job_alloc_info(msg);
@@ -6226,3 +6342,89 @@ void slurmctld_req(slurm_msg_t *msg)
 	END_TIMER;
 	record_rpc_stats(msg, DELTA_TIMER);
 }
+
+extern void slurmctld_req_batch(slurm_msg_t **msgs, int msg_cnt)
+{
+	DEF_TIMERS;
+	/* Locks: Read config, write job, write node, read federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+	bool run_scheduler = false, save_job = false, save_node = false;
+	bool defer_sched;
+	bitstr_t *purge_node_bitmap = NULL;
+
+	lock_slurmctld(job_write_lock);
+	/* Several rpc_queue threads may run this, read config under the lock */
+	defer_sched = xstrcasestr(slurm_conf.sched_params, "defer");
+	for (int i = 0; i < msg_cnt; i++) {
+		slurm_msg_t *msg = msgs[i];
+
+		if (!msg->auth_uid_set)
+			fatal("%s: received message without previously validated auth",
+			      __func__);
+		if (msg->conn_fd >= 0)
+			fd_set_nonblocking(msg->conn_fd);
+		debug2("Processing RPC: %s from UID=%u",
+		       rpc_num2string(msg->msg_type), msg->auth_uid);
+
+		/* Collect the reply to send after the locks are released */
+		msg->msg_index = 1;
+		msg->ret_list = list_create(NULL);
+
+		START_TIMER;
+		if (msg->msg_type == REQUEST_COMPLETE_BATCH_SCRIPT) {
+			_slurm_rpc_complete_batch_script(msg, &run_scheduler,
+							 &save_job, &save_node,
+							 true);
+		} else if (msg->msg_type == MESSAGE_EPILOG_COMPLETE) {
+			_slurm_rpc_epilog_complete(msg, &run_scheduler, true);
+		} else if (msg->msg_type == MESSAGE_NODE_REGISTRATION_STATUS) {
+			if (!purge_node_bitmap)
+				purge_node_bitmap =
+					bit_alloc(node_record_count);
+			_slurm_rpc_node_registration(msg, purge_node_bitmap,
+						     true);
+		} else {
+			error("%s: invalid RPC msg_type=%u",
+			      __func__, msg->msg_type);
+			slurm_send_rc_msg(msg, EINVAL);
+		}
+		END_TIMER;
+		record_rpc_stats(msg, DELTA_TIMER);
+	}
+	/* One pass over the job list for all of the registered nodes */
+	if (purge_node_bitmap) {
+		purge_missing_jobs(purge_node_bitmap);
+		FREE_NULL_BITMAP(purge_node_bitmap);
+	}
+	unlock_slurmctld(job_write_lock);
+
+	for (int i = 0; i < msg_cnt; i++) {
+		slurm_msg_t *msg = msgs[i], *resp_msg;
+
+		while ((resp_msg = list_dequeue(msg->ret_list))) {
+			if ((msg->conn_fd >= 0) &&
+			    (slurm_send_node_msg(msg->conn_fd, resp_msg) < 0))
+				error("%s: send %s: %m", __func__,
+				      rpc_num2string(resp_msg->msg_type));
+			slurm_free_msg_data(resp_msg->msg_type,
+					    resp_msg->data);
+			xfree(resp_msg);
+		}
+		FREE_NULL_LIST(msg->ret_list);
+		msg->msg_index = 0;
+	}
+
+	/* Functions below provide their own locking */
+	if (run_scheduler) {
+		/* As in _slurm_rpc_epilog_complete(), honor defer mode */
+		if (!LOTS_OF_AGENTS && !defer_sched)
+			(void) schedule(0);
+		save_node = true;
+		save_job = true;
+	}
+	if (save_node)
+		schedule_node_save();
+	if (save_job)
+		schedule_job_save();
+}
@@ -42,6 +42,7 @@
 #include <sys/time.h>
 
 #include "src/common/slurm_protocol_api.h"
+#include "src/slurmctld/slurmctld.h"
 
 
 /*
@@ -50,11 +51,26 @@
  */
 void slurmctld_req(slurm_msg_t *msg);
 
+/*
+ * slurmctld_req_batch - Process a batch of REQUEST_COMPLETE_BATCH_SCRIPT,
+ *	MESSAGE_EPILOG_COMPLETE or MESSAGE_NODE_REGISTRATION_STATUS RPCs under
+ *	one acquisition of the job and node write locks. Replies are sent once
+ *	the locks are released.
+ * IN/OUT msgs - the request messages, data associated with them is freed
+ * IN msg_cnt - count of msgs
+ */
+extern void slurmctld_req_batch(slurm_msg_t **msgs, int msg_cnt);
+
 /*
  * Update slurmctld stats structure with time spent processing an rpc.
  */
 extern void record_rpc_stats(slurm_msg_t *msg, long delta);
 
+/*
+ * Count an rpc rejected by the rate limit in its user's stats.
+ */
+extern void record_rpc_rejected(slurm_msg_t *msg);
+
 /*
  * Initialize a response slurm_msg_t to an inbound msg,
  * first by calling slurm_msg_t_init(), then by copying
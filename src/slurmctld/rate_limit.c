@@ -0,0 +1,254 @@
+/*****************************************************************************\
+ *  rate_limit.c - per user RPC rate limiting
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/uid.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rate_limit.h"
+#include "src/slurmctld/slurmctld.h"
+
+#define RL_DEFAULT_BUCKET_SIZE	30
+#define RL_DEFAULT_REFILL_RATE	2
+#define RL_DEFAULT_REFILL_PERIOD 1
+#define RL_DEFAULT_TABLE_SIZE	8192
+
+typedef struct {
+	uint32_t uid;
+	bool used;
+	uint32_t tokens;
+	time_t last_refill;
+} rl_bucket_t;
+
+/* Protects all of the variables below */
+static pthread_mutex_t rl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rl_bucket_t *rl_table = NULL;
+static uint32_t rl_table_size = RL_DEFAULT_TABLE_SIZE;
+static uint32_t rl_bucket_size = RL_DEFAULT_BUCKET_SIZE;
+static uint32_t rl_refill_rate = RL_DEFAULT_REFILL_RATE;
+static uint32_t rl_refill_period = RL_DEFAULT_REFILL_PERIOD;
+static uid_t *rl_exempt_uids = NULL;
+static int rl_exempt_cnt = 0;
+static bool rl_table_full_logged = false;
+
+static uint32_t _get_param(const char *name, uint32_t def_value)
+{
+	char *tmp_ptr;
+	long value;
+
+	if (!(tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params, name)))
+		return def_value;
+
+	value = strtol(tmp_ptr + strlen(name), NULL, 10);
+	if (value < 1) {
+		error("SlurmctldParameters=%s%ld invalid, using %u",
+		      name, value, def_value);
+		return def_value;
+	}
+
+	return value;
+}
+
+/* Parse rl_exempt_users=, a colon separated list of user names or IDs */
+static void _get_exempt_uids(uid_t **uids_ptr, int *cnt_ptr)
+{
+	char *tmp_ptr, *names, *name, *save_ptr = NULL;
+	uid_t *uids = NULL, uid;
+	int cnt = 0;
+
+	if (!(tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				    "rl_exempt_users=")))
+		goto end;
+
+	names = xstrdup(tmp_ptr + strlen("rl_exempt_users="));
+	if ((tmp_ptr = strchr(names, ',')))
+		tmp_ptr[0] = '\0';
+	name = strtok_r(names, ":", &save_ptr);
+	while (name) {
+		if (uid_from_string(name, &uid) < 0) {
+			error("SlurmctldParameters=rl_exempt_users: invalid user %s",
+			      name);
+		} else {
+			xrecalloc(uids, cnt + 1, sizeof(uid_t));
+			uids[cnt++] = uid;
+		}
+		name = strtok_r(NULL, ":", &save_ptr);
+	}
+	xfree(names);
+
+end:
+	*uids_ptr = uids;
+	*cnt_ptr = cnt;
+}
+
+extern void rate_limit_init(void)
+{
+	uint32_t bucket_size, refill_rate, refill_period, table_size;
+	uid_t *exempt_uids = NULL;
+	int exempt_cnt = 0;
+
+	if (!xstrcasestr(slurm_conf.slurmctld_params, "rl_enable")) {
+		rate_limit_shutdown();
+		return;
+	}
+
+	bucket_size = _get_param("rl_bucket_size=", RL_DEFAULT_BUCKET_SIZE);
+	refill_rate = _get_param("rl_refill_rate=", RL_DEFAULT_REFILL_RATE);
+	refill_period = _get_param("rl_refill_period=",
+				   RL_DEFAULT_REFILL_PERIOD);
+	table_size = _get_param("rl_table_size=", RL_DEFAULT_TABLE_SIZE);
+	_get_exempt_uids(&exempt_uids, &exempt_cnt);
+
+	slurm_mutex_lock(&rl_mutex);
+	/* On reconfigure, buckets are kept unless the table is resized */
+	if (!rl_table || (table_size != rl_table_size)) {
+		xfree(rl_table);
+		rl_table = xcalloc(table_size, sizeof(*rl_table));
+		rl_table_full_logged = false;
+	} else if (bucket_size < rl_bucket_size) {
+		for (uint32_t i = 0; i < table_size; i++)
+			rl_table[i].tokens = MIN(rl_table[i].tokens,
+						 bucket_size);
+	}
+	rl_table_size = table_size;
+	rl_bucket_size = bucket_size;
+	rl_refill_rate = refill_rate;
+	rl_refill_period = refill_period;
+	xfree(rl_exempt_uids);
+	rl_exempt_uids = exempt_uids;
+	rl_exempt_cnt = exempt_cnt;
+	slurm_mutex_unlock(&rl_mutex);
+
+	verbose("%s: bucket_size=%u refill_rate=%u refill_period=%u table_size=%u exempt_users=%d",
+		__func__, bucket_size, refill_rate, refill_period, table_size,
+		exempt_cnt);
+}
+
+extern void rate_limit_shutdown(void)
+{
+	slurm_mutex_lock(&rl_mutex);
+	xfree(rl_table);
+	xfree(rl_exempt_uids);
+	rl_exempt_cnt = 0;
+	slurm_mutex_unlock(&rl_mutex);
+}
+
+static bool _exempt(uint32_t uid)
+{
+	if (!uid || (uid == slurm_conf.slurm_user_id))
+		return true;
+
+	for (int i = 0; i < rl_exempt_cnt; i++) {
+		if (rl_exempt_uids[i] == uid)
+			return true;
+	}
+
+	return false;
+}
+
+/* Find or add the bucket for uid, NULL if the table is full */
+static rl_bucket_t *_find_bucket(uint32_t uid, time_t now)
+{
+	uint32_t start = uid % rl_table_size;
+
+	for (uint32_t i = 0; i < rl_table_size; i++) {
+		rl_bucket_t *bucket = &rl_table[(start + i) % rl_table_size];
+
+		if (!bucket->used) {
+			bucket->used = true;
+			bucket->uid = uid;
+			bucket->tokens = rl_bucket_size;
+			bucket->last_refill = now;
+			return bucket;
+		}
+		if (bucket->uid == uid)
+			return bucket;
+	}
+
+	return NULL;
+}
+
+extern bool rate_limit_exceeded(slurm_msg_t *msg)
+{
+	rl_bucket_t *bucket;
+	time_t now = time(NULL);
+	bool exceeded = false;
+
+	slurm_mutex_lock(&rl_mutex);
+	if (!rl_table || _exempt(msg->auth_uid)) {
+		slurm_mutex_unlock(&rl_mutex);
+		return false;
+	}
+
+	if (!(bucket = _find_bucket(msg->auth_uid, now))) {
+		if (!rl_table_full_logged) {
+			error("%s: table of %u users full, not limiting uid %u",
+			      __func__, rl_table_size, msg->auth_uid);
+			rl_table_full_logged = true;
+		}
+		slurm_mutex_unlock(&rl_mutex);
+		return false;
+	}
+
+	if (now >= (bucket->last_refill + rl_refill_period)) {
+		time_t periods = (now - bucket->last_refill) / rl_refill_period;
+		uint64_t tokens = bucket->tokens +
+				  ((uint64_t) periods * rl_refill_rate);
+
+		bucket->tokens = MIN(tokens, rl_bucket_size);
+		bucket->last_refill += periods * rl_refill_period;
+	}
+
+	if (bucket->tokens)
+		bucket->tokens--;
+	else
+		exceeded = true;
+	slurm_mutex_unlock(&rl_mutex);
+
+	if (exceeded) {
+		debug("%s: uid %u over rate limit, rejecting %s",
+		      __func__, msg->auth_uid, rpc_num2string(msg->msg_type));
+		record_rpc_rejected(msg);
+	}
+
+	return exceeded;
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************\
+ *  rate_limit.h - per user RPC rate limiting
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _RATE_LIMIT_H_
+#define _RATE_LIMIT_H_
+
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * rate_limit_init - read the rl_* options of SlurmctldParameters and build
+ *	the per user token bucket table if rl_enable is configured. Called
+ *	again on reconfigure.
+ */
+extern void rate_limit_init(void);
+
+/* rate_limit_shutdown - free the token bucket table */
+extern void rate_limit_shutdown(void);
+
+/*
+ * rate_limit_exceeded - take a token from the bucket of the user sending msg
+ * RET true if the bucket is empty and msg should be rejected with
+ *	SLURMCTLD_COMMUNICATIONS_BACKOFF. Always false for SlurmUser, root and
+ *	users listed in rl_exempt_users.
+ */
+extern bool rate_limit_exceeded(slurm_msg_t *msg);
+
+#endif
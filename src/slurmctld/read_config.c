@@ -113,6 +113,7 @@ static int  _compare_hostnames(node_record_t *old_node_table,
 static void _gres_reconfig(bool reconfig);
 static int  _init_all_slurm_conf(void);
 static void _list_delete_feature(void *feature_entry);
+static void _phase_time(char **phases, char *name, struct timeval *phase_tv);
 static int _preserve_select_type_param(slurm_conf_t *ctl_conf_ptr,
                                        uint16_t old_select_type_p);
 static void _purge_old_node_state(node_record_t *old_node_table_ptr,
@@ -170,6 +171,17 @@ extern void cluster_rec_free(void)
 	}
 }
 
+/*
+ * Append the time spent in a phase of read_slurm_conf() to a breakdown
+ *	string and start timing the next phase
+ */
+static void _phase_time(char **phases, char *name, struct timeval *phase_tv)
+{
+	xstrfmtcat(*phases, "%s%s=%dms", *phases ? " " : "", name,
+		   slurm_delta_tv(phase_tv) / 1000);
+	(void) gettimeofday(phase_tv, NULL);
+}
+
 /* Verify that Slurm directories are secure, not world writable */
 static void _stat_slurm_dirs(void)
 {
@@ -1110,9 +1122,12 @@ int read_slurm_conf(int recover, bool reconfig)
 	char *state_save_dir = xstrdup(slurm_conf.state_save_location);
 	uint16_t old_select_type_p = slurm_conf.select_type_param;
 	bool cgroup_mem_confinement = false;
+	struct timeval phase_tv = { 0, 0 };
+	char *phases = NULL;
 
 	/* initialization */
 	START_TIMER;
+	(void) gettimeofday(&phase_tv, NULL);
 
 	if (reconfig) {
 		/*
@@ -1258,6 +1273,7 @@ int read_slurm_conf(int recover, bool reconfig)
 	_set_slurmd_addr();
 
 	_stat_slurm_dirs();
+	_phase_time(&phases, "config", &phase_tv);
 
 	/*
 	 * Set standard features and preserve the plugin controlled ones.
@@ -1290,6 +1306,7 @@ int read_slurm_conf(int recover, bool reconfig)
 		load_last_job_id();
 		reset_first_job_id();
 		(void) slurm_sched_g_reconfig();
+		_phase_time(&phases, "restore_state", &phase_tv);
 	} else if (recover == 0) {	/* Build everything from slurm.conf */
 		_set_features(node_record_table_ptr, node_record_count,
 			      recover);
@@ -1300,17 +1317,24 @@ int read_slurm_conf(int recover, bool reconfig)
 		(void) load_all_node_state(true);
 		_set_features(node_record_table_ptr, node_record_count,
 			      recover);
+		_phase_time(&phases, "node_state", &phase_tv);
 		(void) load_all_front_end_state(true);
+		_phase_time(&phases, "front_end_state", &phase_tv);
 		load_job_ret = load_all_job_state();
 		sync_job_priorities();
+		_phase_time(&phases, "job_state", &phase_tv);
 	} else if (recover > 1) {	/* Load node, part & job state files */
 		(void) load_all_node_state(false);
 		_set_features(old_node_table_ptr, old_node_record_count,
 			      recover);
+		_phase_time(&phases, "node_state", &phase_tv);
 		(void) load_all_front_end_state(false);
+		_phase_time(&phases, "front_end_state", &phase_tv);
 		(void) load_all_part_state();
+		_phase_time(&phases, "part_state", &phase_tv);
 		load_job_ret = load_all_job_state();
 		sync_job_priorities();
+		_phase_time(&phases, "job_state", &phase_tv);
 	}
 
 	_sync_part_prio();
@@ -1327,12 +1351,15 @@ int read_slurm_conf(int recover, bool reconfig)
 			      "Clean start required.");
 		}
 	}
+	_phase_time(&phases, "select_init", &phase_tv);
 
 	_gres_reconfig(reconfig);
 	reset_job_bitmaps();		/* must follow select_g_job_init() */
+	_phase_time(&phases, "job_bitmaps", &phase_tv);
 
 	(void) _sync_nodes_to_jobs(reconfig);
 	(void) sync_job_files();
+	_phase_time(&phases, "sync_nodes", &phase_tv);
 	_purge_old_node_state(old_node_table_ptr, old_node_record_count);
 	_purge_old_part_state(old_part_list, old_def_part_name);
 
@@ -1384,6 +1411,7 @@ int read_slurm_conf(int recover, bool reconfig)
 	_validate_het_jobs();
 	(void) _sync_nodes_to_comp_job();/* must follow select_g_node_init() */
 	load_part_uid_allow_list(1);
+	_phase_time(&phases, "node_features", &phase_tv);
 
 	/* NOTE: Run load_all_resv_state() before _restore_job_accounting */
 	if (reconfig) {
@@ -1395,10 +1423,12 @@ int read_slurm_conf(int recover, bool reconfig)
 			(void) slurm_sched_g_reconfig();
 		}
 	}
+	_phase_time(&phases, "resv_state", &phase_tv);
 	 if (test_config)
 		goto end_it;
 
 	_restore_job_accounting();
+	_phase_time(&phases, "job_accounting", &phase_tv);
 
 	/* sort config_list by weight for scheduling */
 	list_sort(config_list, &list_compare_config);
@@ -1500,6 +1530,7 @@ int read_slurm_conf(int recover, bool reconfig)
 		fatal("Failed to reconfigure mcs plugin");
 
 	_set_response_cluster_rec();
+	_phase_time(&phases, "plugins", &phase_tv);
 
 	slurm_conf.last_update = time(NULL);
 end_it:
@@ -1513,6 +1544,13 @@ end_it:
 	xfree(state_save_dir);
 
 	END_TIMER2("read_slurm_conf");
+	if (phases) {
+		if (reconfig)
+			debug("%s: %s total %s", __func__, phases, TIME_STR);
+		else
+			info("%s: %s total %s", __func__, phases, TIME_STR);
+		xfree(phases);
+	}
 	return error_code;
 
 }
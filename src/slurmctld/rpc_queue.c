@@ -33,3 +33,328 @@
  *  with Slurm; if not, write to the Free Software Foundation, Inc.,
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
+
+#include "config.h"
+
+#if HAVE_SYS_PRCTL_H
+#  include <sys/prctl.h>
+#endif
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rpc_queue.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* Queued messages beyond this count are processed by the receiving thread */
+#define RPC_QUEUE_MAX_DEPTH 256
+/* Most RPCs processed together under one lock by a batching queue */
+#define RPC_QUEUE_MAX_BATCH 64
+
+typedef struct {
+	slurm_msg_t *msg;
+	struct timeval arrival;
+} rpc_queue_item_t;
+
+typedef struct {
+	uint16_t msg_type;
+	uint16_t thread_cnt;
+	bool batch;		/* see slurmctld_req_batch() */
+
+	pthread_t *threads;
+	List items;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool shutdown;
+
+	uint32_t depth_max;
+	uint32_t cnt;
+	uint32_t batch_cnt;
+	uint64_t wait_time;	/* usec spent queued by the cnt RPCs */
+} rpc_queue_t;
+
+/*
+ * Each message type gets its own worker threads, so a flood of one type
+ * (e.g. squeue) can only delay other RPCs of the same type. Completion
+ * RPCs arrive in bursts when many jobs end together, and registrations when
+ * many slurmd restart together. Each needs the job and node write locks, so
+ * they are drained in batches under one lock.
+ */
+static rpc_queue_t rpc_queues[] = {
+	{ .msg_type = REQUEST_JOB_INFO, .thread_cnt = 4 },
+	{ .msg_type = REQUEST_JOB_USER_INFO, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_JOB_INFO_SINGLE, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_NODE_INFO, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_PARTITION_INFO, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_COMPLETE_BATCH_SCRIPT, .thread_cnt = 2,
+	  .batch = true },
+	{ .msg_type = MESSAGE_EPILOG_COMPLETE, .thread_cnt = 2, .batch = true },
+	{ .msg_type = REQUEST_COMPLETE_PROLOG, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_COMPLETE_JOB_ALLOCATION, .thread_cnt = 2 },
+	{ .msg_type = MESSAGE_NODE_REGISTRATION_STATUS, .thread_cnt = 2,
+	  .batch = true },
+	{ .msg_type = REQUEST_SUBMIT_BATCH_JOB, .thread_cnt = 2 },
+	{ .msg_type = REQUEST_STEP_COMPLETE, .thread_cnt = 2 },
+};
+
+static const int rpc_queue_cnt = ARRAY_SIZE(rpc_queues);
+/* Protects rpc_queue_enabled, the queues exist only while it is set */
+static pthread_rwlock_t rpc_queue_lock = PTHREAD_RWLOCK_INITIALIZER;
+static bool rpc_queue_enabled = false;
+
+static rpc_queue_t *_find_queue(uint16_t msg_type)
+{
+	for (int i = 0; i < rpc_queue_cnt; i++) {
+		if (rpc_queues[i].msg_type == msg_type)
+			return &rpc_queues[i];
+	}
+
+	return NULL;
+}
+
+static void _record_wait(rpc_queue_t *q, rpc_queue_item_t **items,
+			 int item_cnt)
+{
+	struct timeval now;
+	uint64_t wait_time = 0;
+
+	gettimeofday(&now, NULL);
+	for (int i = 0; i < item_cnt; i++) {
+		wait_time += (now.tv_sec - items[i]->arrival.tv_sec) * 1000000;
+		wait_time += now.tv_usec - items[i]->arrival.tv_usec;
+	}
+
+	slurm_mutex_lock(&q->mutex);
+	q->cnt += item_cnt;
+	q->batch_cnt++;
+	q->wait_time += wait_time;
+	slurm_mutex_unlock(&q->mutex);
+}
+
+static void _process_msgs(rpc_queue_t *q, rpc_queue_item_t **items,
+			  int item_cnt)
+{
+	slurm_msg_t *msgs[RPC_QUEUE_MAX_BATCH];
+
+	_record_wait(q, items, item_cnt);
+
+	for (int i = 0; i < item_cnt; i++)
+		msgs[i] = items[i]->msg;
+
+	if (q->batch)
+		slurmctld_req_batch(msgs, item_cnt);
+	else
+		slurmctld_req(msgs[0]);
+
+	for (int i = 0; i < item_cnt; i++) {
+		slurm_msg_t *msg = msgs[i];
+
+		if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
+			error("close(%d): %m", msg->conn_fd);
+		slurm_free_msg(msg);
+		xfree(items[i]);
+	}
+}
+
+static void *_rpc_queue_worker(void *arg)
+{
+	rpc_queue_t *q = arg;
+	rpc_queue_item_t *items[RPC_QUEUE_MAX_BATCH];
+	int item_cnt, max_cnt = q->batch ? RPC_QUEUE_MAX_BATCH : 1;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "rpcq", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "rpcq");
+	}
+#endif
+
+	while (true) {
+		item_cnt = 0;
+		slurm_mutex_lock(&q->mutex);
+		while (!list_count(q->items) && !q->shutdown)
+			slurm_cond_wait(&q->cond, &q->mutex);
+		while ((item_cnt < max_cnt) &&
+		       (items[item_cnt] = list_dequeue(q->items)))
+			item_cnt++;
+		slurm_mutex_unlock(&q->mutex);
+
+		/* The queue is drained before the threads exit */
+		if (!item_cnt)
+			break;
+
+		server_thread_incr();
+		_process_msgs(q, items, item_cnt);
+		server_thread_decr();
+	}
+
+	return NULL;
+}
+
+extern void rpc_queue_init(void)
+{
+	if (!xstrcasestr(slurm_conf.slurmctld_params, "enable_rpc_queue"))
+		return;
+
+	for (int i = 0; i < rpc_queue_cnt; i++) {
+		rpc_queue_t *q = &rpc_queues[i];
+
+		q->items = list_create(NULL);
+		slurm_mutex_init(&q->mutex);
+		slurm_cond_init(&q->cond, NULL);
+		q->shutdown = false;
+		q->threads = xcalloc(q->thread_cnt, sizeof(pthread_t));
+		for (int j = 0; j < q->thread_cnt; j++)
+			slurm_thread_create(&q->threads[j], _rpc_queue_worker,
+					    q);
+	}
+
+	slurm_rwlock_wrlock(&rpc_queue_lock);
+	rpc_queue_enabled = true;
+	slurm_rwlock_unlock(&rpc_queue_lock);
+	verbose("%s: queueing %d RPC types", __func__, rpc_queue_cnt);
+}
+
+extern void rpc_queue_shutdown(void)
+{
+	/* New RPCs are processed inline once no enqueue can be in progress */
+	slurm_rwlock_wrlock(&rpc_queue_lock);
+	if (!rpc_queue_enabled) {
+		slurm_rwlock_unlock(&rpc_queue_lock);
+		return;
+	}
+	rpc_queue_enabled = false;
+	slurm_rwlock_unlock(&rpc_queue_lock);
+
+	for (int i = 0; i < rpc_queue_cnt; i++) {
+		rpc_queue_t *q = &rpc_queues[i];
+
+		slurm_mutex_lock(&q->mutex);
+		q->shutdown = true;
+		slurm_cond_broadcast(&q->cond);
+		slurm_mutex_unlock(&q->mutex);
+	}
+
+	for (int i = 0; i < rpc_queue_cnt; i++) {
+		rpc_queue_t *q = &rpc_queues[i];
+
+		for (int j = 0; j < q->thread_cnt; j++)
+			pthread_join(q->threads[j], NULL);
+		xfree(q->threads);
+		FREE_NULL_LIST(q->items);
+		slurm_mutex_destroy(&q->mutex);
+		slurm_cond_destroy(&q->cond);
+	}
+}
+
+extern int rpc_enqueue(slurm_msg_t *msg)
+{
+	rpc_queue_t *q;
+	rpc_queue_item_t *item;
+	int rc = SLURM_ERROR;
+
+	slurm_rwlock_rdlock(&rpc_queue_lock);
+	if (!rpc_queue_enabled || !(q = _find_queue(msg->msg_type))) {
+		slurm_rwlock_unlock(&rpc_queue_lock);
+		return SLURM_ERROR;
+	}
+
+	item = xmalloc(sizeof(*item));
+	item->msg = msg;
+	gettimeofday(&item->arrival, NULL);
+
+	slurm_mutex_lock(&q->mutex);
+	if (!q->shutdown && (list_count(q->items) < RPC_QUEUE_MAX_DEPTH)) {
+		list_enqueue(q->items, item);
+		q->depth_max = MAX(q->depth_max, list_count(q->items));
+		slurm_cond_signal(&q->cond);
+		rc = SLURM_SUCCESS;
+	}
+	slurm_mutex_unlock(&q->mutex);
+	slurm_rwlock_unlock(&rpc_queue_lock);
+
+	if (rc != SLURM_SUCCESS) {
+		debug2("%s: %s queue full, processing inline",
+		       __func__, rpc_num2string(msg->msg_type));
+		xfree(item);
+	}
+
+	return rc;
+}
+
+extern void rpc_queue_pack_stats(Buf buffer)
+{
+	uint32_t cnt;
+	uint16_t *type_id;
+	uint32_t *threads, *depth, *depth_max, *rpc_cnt, *batch_cnt;
+	uint64_t *wait_time;
+
+	slurm_rwlock_rdlock(&rpc_queue_lock);
+	cnt = rpc_queue_enabled ? rpc_queue_cnt : 0;
+	type_id = xcalloc(cnt, sizeof(uint16_t));
+	threads = xcalloc(cnt, sizeof(uint32_t));
+	depth = xcalloc(cnt, sizeof(uint32_t));
+	depth_max = xcalloc(cnt, sizeof(uint32_t));
+	rpc_cnt = xcalloc(cnt, sizeof(uint32_t));
+	batch_cnt = xcalloc(cnt, sizeof(uint32_t));
+	wait_time = xcalloc(cnt, sizeof(uint64_t));
+
+	for (int i = 0; i < cnt; i++) {
+		rpc_queue_t *q = &rpc_queues[i];
+
+		slurm_mutex_lock(&q->mutex);
+		type_id[i] = q->msg_type;
+		threads[i] = q->thread_cnt;
+		depth[i] = list_count(q->items);
+		depth_max[i] = q->depth_max;
+		rpc_cnt[i] = q->cnt;
+		batch_cnt[i] = q->batch_cnt;
+		wait_time[i] = q->wait_time;
+		slurm_mutex_unlock(&q->mutex);
+	}
+	slurm_rwlock_unlock(&rpc_queue_lock);
+
+	pack16_array(type_id, cnt, buffer);
+	pack32_array(threads, cnt, buffer);
+	pack32_array(depth, cnt, buffer);
+	pack32_array(depth_max, cnt, buffer);
+	pack32_array(rpc_cnt, cnt, buffer);
+	pack32_array(batch_cnt, cnt, buffer);
+	pack64_array(wait_time, cnt, buffer);
+
+	xfree(type_id);
+	xfree(threads);
+	xfree(depth);
+	xfree(depth_max);
+	xfree(rpc_cnt);
+	xfree(batch_cnt);
+	xfree(wait_time);
+}
+
+extern void rpc_queue_clear_stats(void)
+{
+	slurm_rwlock_rdlock(&rpc_queue_lock);
+	if (!rpc_queue_enabled) {
+		slurm_rwlock_unlock(&rpc_queue_lock);
+		return;
+	}
+
+	for (int i = 0; i < rpc_queue_cnt; i++) {
+		rpc_queue_t *q = &rpc_queues[i];
+
+		slurm_mutex_lock(&q->mutex);
+		q->depth_max = list_count(q->items);
+		q->cnt = 0;
+		q->batch_cnt = 0;
+		q->wait_time = 0;
+		slurm_mutex_unlock(&q->mutex);
+	}
+	slurm_rwlock_unlock(&rpc_queue_lock);
+}
@@ -37,5 +37,33 @@
 #ifndef _RPC_QUEUE_H_
 #define _RPC_QUEUE_H_
 
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * rpc_queue_init - start the worker threads of each queued RPC type if
+ *	SlurmctldParameters=enable_rpc_queue is configured
+ */
+extern void rpc_queue_init(void);
+
+/*
+ * rpc_queue_shutdown - stop queueing RPCs, process those already queued and
+ *	wait for the worker threads to exit
+ */
+extern void rpc_queue_shutdown(void);
+
+/*
+ * rpc_enqueue - queue a received RPC for the worker threads of its type
+ * IN msg - RPC received on msg->conn_fd. If queued, the worker processing it
+ *	closes the connection and frees msg.
+ * RET SLURM_SUCCESS if queued, otherwise the caller must process msg
+ */
+extern int rpc_enqueue(slurm_msg_t *msg);
+
+/* rpc_queue_pack_stats - pack per RPC type queue statistics for sdiag */
+extern void rpc_queue_pack_stats(Buf buffer);
+
+/* rpc_queue_clear_stats - reset the statistics packed above */
+extern void rpc_queue_clear_stats(void);
 
 #endif
@@ -153,6 +153,9 @@ typedef struct slurmctld_config {
 	pthread_t thread_id_rpc;
 } slurmctld_config_t;
 
+/* Maximum count of backfill evaluation threads (SchedulerParameters) */
+#define MAX_BF_THREADS 64
+
 /* Job scheduling statistics */
 typedef struct diag_stats {
 	int proc_req_threads;
@@ -193,6 +196,16 @@ typedef struct diag_stats {
 	uint32_t bf_table_size_sum;
 	time_t   bf_when_last_cycle;
 
+	uint32_t bf_eval_thread_cnt;
+	uint32_t bf_eval_jobs[MAX_BF_THREADS];
+	uint64_t bf_eval_time[MAX_BF_THREADS];
+	uint32_t bf_eval_skipped;
+
+	uint32_t job_info_cache_hits;
+	uint32_t job_info_cache_misses;
+	uint32_t node_info_cache_hits;
+	uint32_t node_info_cache_misses;
+
 	uint32_t latency;
 } diag_stats_t;
 
@@ -731,10 +744,13 @@ struct job_record {
 	uint32_t het_job_offset;	/* HetJob component index */
 	List het_job_list;		/* List of job pointers to all
 					 * components */
+	uint64_t info_seq;		/* job_info_changed() sequence of the
+					 * last change to the job */
+	time_t info_update;		/* time of the last change to the job */
+	uint64_t info_digest;		/* job fields at job_info_sweep() */
 	uint32_t job_id;		/* job ID */
-	job_record_t *job_next;		/* next entry with same hash index */
-	job_record_t *job_array_next_j;	/* job array linked list by job_id */
-	job_record_t *job_array_next_t;	/* job array linked list by task_id */
+	job_record_t *job_array_next_j;	/* next record of same job array */
+	job_record_t *job_array_prev_j;	/* previous record of same job array */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint32_t job_state;		/* state of the job */
@@ -830,6 +846,8 @@ struct job_record {
 	time_t start_time;		/* time execution begins,
 					 * actual or expected */
 	char *state_desc;		/* optional details for state_reason */
+	uint64_t state_digest;		/* hash of saved job state, used by
+					 * dump_all_job_state() */
 	uint32_t state_reason;		/* reason job still pending or failed
 					 * see slurm.h:enum job_state_reason */
 	uint32_t state_reason_prev_db;	/* Previous state_reason that isn't
@@ -1526,6 +1544,31 @@ extern int job_fail(uint32_t job_id, uint32_t job_state);
  */
 extern bool job_hold_requeue(job_record_t *job_ptr);
 
+/*
+ * job_info_changed - note a change to a job record visible to job
+ *	information requests, for SHOW_DELTA requests and info snapshots
+ * IN job_ptr - job changed, or NULL if any job may have changed
+ * IN now - time of the change, also set in last_job_update
+ * NOTE: Call with the job write lock
+ */
+extern void job_info_changed(job_record_t *job_ptr, time_t now);
+
+/*
+ * job_info_refreshed - note a change made to a job record by a scheduling
+ *	pass, without setting last_job_update
+ * IN job_ptr - job changed
+ * IN now - time of the change
+ * NOTE: Call with the job write lock
+ */
+extern void job_info_refreshed(job_record_t *job_ptr, time_t now);
+
+/*
+ * job_info_sweep - note changes to job records made by a scheduling pass
+ *	without calling job_info_changed() or job_info_refreshed()
+ * NOTE: Call with the job write lock
+ */
+extern void job_info_sweep(void);
+
 /*
  * determine if job is ready to execute per the node select plugin
  * IN job_id - job to test
@@ -1935,6 +1978,51 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			  uint16_t protocol_version);
 
+/* Job records packed by pack_all_jobs_cached() */
+typedef struct job_pack_cache job_pack_cache_t;
+
+/*
+ * pack_all_jobs_cached - as pack_all_jobs() without filter_uid, but copy
+ *	the records of jobs unchanged since prev_cache was filled from the
+ *	data packed then, instead of packing them again
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * IN prev_cache - cache filled by an earlier call, or NULL
+ * OUT cache_ptr - set to a cache of the records packed, for a later call
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller, and not
+ *	before the cache is freed with job_pack_cache_free()
+ * NOTE: Call with read locks on the job and partition records
+ */
+extern void pack_all_jobs_cached(char **buffer_ptr, int *buffer_size,
+				 uint16_t show_flags, uid_t uid,
+				 uint16_t protocol_version,
+				 job_pack_cache_t *prev_cache,
+				 job_pack_cache_t **cache_ptr);
+
+/* job_pack_cache_free - free a cache filled by pack_all_jobs_cached() */
+extern void job_pack_cache_free(job_pack_cache_t *cache);
+
+/*
+ * pack_delta_jobs - dump job information for jobs changed since update_time
+ *	in machine independent form (for network transmission), followed by
+ *	the ids of jobs purged or hidden from uid since update_time. The full
+ *	table is sent instead if partitions or all jobs changed since then.
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN update_time - last_update of the client's copy of the job table
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * global: job_list - global list of job records
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern void pack_delta_jobs(char **buffer_ptr, int *buffer_size,
+			    time_t update_time, uint16_t show_flags, uid_t uid,
+			    uint16_t protocol_version);
+
 /*
  * pack_spec_jobs - dump job information for specified jobs in
  *	machine independent form (for network transmission)
@@ -2154,6 +2242,16 @@ extern void handle_invalid_dependency(job_record_t *job_ptr);
  */
 void purge_old_job(void);
 
+/*
+ * purge_missing_jobs - Purge batch jobs and notify srun of job steps that
+ *	should be running on the nodes in node_bitmap but are not, as deferred
+ *	by validate_jobs_on_node(). One pass over the job list covers all of
+ *	the nodes.
+ * IN node_bitmap - nodes which registered
+ * NOTE: READ lock slurmctld config and WRITE lock jobs and nodes before entry
+ */
+extern void purge_missing_jobs(bitstr_t *node_bitmap);
+
 /* Convert a comma delimited list of QOS names into a bitmap */
 extern void qos_list_build(char *qos, bitstr_t **qos_bits);
 
@@ -2547,8 +2645,11 @@ extern int validate_job_create_req(job_desc_msg_t * job_desc, uid_t submit_uid,
  *	records, call this function after validate_node_specs() sets the node
  *	state properly
  * IN reg_msg - node registration message
+ * IN/OUT purge_node_bitmap - if set, record the node here for a later
+ *	purge_missing_jobs() call rather than walking the job list now
  */
-extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg);
+extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+				  bitstr_t *purge_node_bitmap);
 
 /*
  * validate_node_specs - validate the node's specifications as valid,
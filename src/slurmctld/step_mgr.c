@@ -86,12 +86,15 @@ typedef struct {
 	uid_t uid;
 } step_signal_t;
 
+static pthread_mutex_t switch_recover_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void _build_pending_step(job_record_t *job_ptr,
 				job_step_create_request_msg_t *step_specs);
 static int  _count_cpus(job_record_t *job_ptr, bitstr_t *bitmap,
 			uint32_t *usable_cpu_cnt);
 static step_record_t *_create_step_record(job_record_t *job_ptr,
-					  uint16_t protocol_version);
+					  uint16_t protocol_version,
+					  bool recover);
 static void _dump_step_layout(step_record_t *step_ptr);
 static bool _is_mem_resv(void);
 static int  _opt_cpu_cnt(uint32_t step_min_cpus, bitstr_t *node_bitmap,
@@ -172,11 +175,14 @@ static int _opt_node_cnt(uint32_t step_min_nodes, uint32_t step_max_nodes,
  * _create_step_record - create an empty step_record for the specified job.
  * IN job_ptr - pointer to job table entry to have step record added
  * IN protocol_version - slurm protocol version of client
+ * IN recover - true if recovering state, job_info_changed() is then called by
+ *	the caller once the job record is added to job_list
  * RET a pointer to the record or NULL if error
  * NOTE: allocates memory that should be xfreed with delete_step_record
  */
 static step_record_t *_create_step_record(job_record_t *job_ptr,
-					  uint16_t protocol_version)
+					  uint16_t protocol_version,
+					  bool recover)
 {
 	step_record_t *step_ptr;
 
@@ -192,7 +198,8 @@ static step_record_t *_create_step_record(job_record_t *job_ptr,
 
 	step_ptr = xmalloc(sizeof(*step_ptr));
 
-	last_job_update = time(NULL);
+	if (!recover)
+		job_info_changed(job_ptr, time(NULL));
 	step_ptr->job_ptr    = job_ptr;
 	step_ptr->exit_code  = NO_VAL;
 	step_ptr->time_limit = INFINITE;
@@ -259,7 +266,7 @@ static void _build_pending_step(job_record_t *job_ptr,
 	if ((step_specs->host == NULL) || (step_specs->port == 0))
 		return;
 
-	step_ptr = _create_step_record(job_ptr, 0);
+	step_ptr = _create_step_record(job_ptr, 0, false);
 	if (step_ptr == NULL)
 		return;
 
@@ -403,7 +410,7 @@ extern void delete_step_records(job_record_t *job_ptr)
 
 	xassert(job_ptr);
 
-	last_job_update = time(NULL);
+	job_info_changed(job_ptr, time(NULL));
 	step_iterator = list_iterator_create(job_ptr->step_list);
 	while ((step_ptr = list_next(step_iterator))) {
 		/* Only check if not a pending step */
@@ -485,7 +492,7 @@ void delete_step_record(job_record_t *job_ptr, step_record_t *step_ptr)
 	xassert(job_ptr->step_list);
 	xassert(step_ptr);
 
-	last_job_update = time(NULL);
+	job_info_changed(job_ptr, time(NULL));
 	select_g_select_jobinfo_get(step_ptr->select_jobinfo,
 				    SELECT_JOBDATA_CLEANING,
 				    &cleaning);
@@ -2462,7 +2469,7 @@ extern int step_create(job_step_create_request_msg_t *step_specs,
 		return ESLURM_BAD_TASK_COUNT;
 	}
 
-	step_ptr = _create_step_record(job_ptr, protocol_version);
+	step_ptr = _create_step_record(job_ptr, protocol_version, false);
 	if (step_ptr == NULL) {
 		FREE_NULL_LIST(step_gres_list);
 		FREE_NULL_BITMAP(nodeset);
@@ -3551,7 +3558,7 @@ extern int step_partial_comp(step_complete_msg_t *req, uid_t uid, bool finish,
 
 		_internal_step_complete(job_ptr, step_ptr);
 
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 	}
 
 	return SLURM_SUCCESS;
@@ -4151,7 +4158,8 @@ extern int load_step_state(job_record_t *job_ptr, Buf buffer,
 
 	step_ptr = find_step_record(job_ptr, &step_id);
 	if (step_ptr == NULL)
-		step_ptr = _create_step_record(job_ptr, start_protocol_ver);
+		step_ptr = _create_step_record(job_ptr, start_protocol_ver,
+					       true);
 	if (step_ptr == NULL)
 		goto unpack_error;
 
@@ -4247,9 +4255,13 @@ extern int load_step_state(job_record_t *job_ptr, Buf buffer,
 		core_bitmap_job = NULL;
 	}
 
-	if (step_ptr->step_layout && switch_tmp)
+	if (step_ptr->step_layout && switch_tmp) {
+		/* Job state may be recovered by several threads at once */
+		slurm_mutex_lock(&switch_recover_mutex);
 		switch_g_job_step_allocated(switch_tmp,
 					    step_ptr->step_layout->node_list);
+		slurm_mutex_unlock(&switch_recover_mutex);
+	}
 
 	info("recovered %pS", step_ptr);
 	return SLURM_SUCCESS;
@@ -4528,7 +4540,7 @@ extern int update_step(step_update_request_msg_t *req, uid_t uid)
 		}
 	}
 	if (mod_cnt)
-		last_job_update = time(NULL);
+		job_info_changed(job_ptr, time(NULL));
 	if (new_step) {
 		/*
 		 * This was a temporary step record, never linked to the job,
@@ -4641,7 +4653,7 @@ extern int post_job_step(step_record_t *step_ptr)
 
 extern step_record_t *build_extern_step(job_record_t *job_ptr)
 {
-	step_record_t *step_ptr = _create_step_record(job_ptr, 0);
+	step_record_t *step_ptr = _create_step_record(job_ptr, 0, false);
 	char *node_list;
 	uint32_t node_cnt;
 
@@ -4691,7 +4703,7 @@ extern step_record_t *build_batch_step(job_record_t *job_ptr_in)
 	} else
 		job_ptr = job_ptr_in;
 
-	step_ptr = _create_step_record(job_ptr, 0);
+	step_ptr = _create_step_record(job_ptr, 0, false);
 
 #ifdef HAVE_FRONT_END
 	front_end_record_t *front_end_ptr =
@@ -4753,7 +4765,7 @@ static step_record_t *_build_interactive_step(
 	} else
 		job_ptr = job_ptr_in;
 
-	step_ptr = _create_step_record(job_ptr, protocol_version);
+	step_ptr = _create_step_record(job_ptr, protocol_version, false);
 
 #ifdef HAVE_FRONT_END
 	front_end_record_t *front_end_ptr =
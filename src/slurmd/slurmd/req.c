@@ -162,6 +162,7 @@ static void _rpc_timelimit(slurm_msg_t *);
 static void _rpc_reattach_tasks(slurm_msg_t *);
 static void _rpc_suspend_job(slurm_msg_t *msg);
 static void _rpc_terminate_job(slurm_msg_t *);
+static void _rpc_multi_msg(slurm_msg_t *msg);
 static void _rpc_shutdown(slurm_msg_t *msg);
 static void _rpc_reconfig(slurm_msg_t *msg);
 static void _rpc_reconfig_with_config(slurm_msg_t *msg);
@@ -314,6 +315,10 @@ slurmd_req(slurm_msg_t *msg)
 		last_slurmctld_msg = time(NULL);
 		_rpc_terminate_job(msg);
 		break;
+	case REQUEST_SLURMD_MULT_MSG:
+		last_slurmctld_msg = time(NULL);
+		_rpc_multi_msg(msg);
+		break;
 	case REQUEST_SHUTDOWN:
 		_rpc_shutdown(msg);
 		break;
@@ -5292,6 +5297,207 @@ done:
 	_epilog_complete(req->step_id.job_id, rc);
 }
 
+typedef struct {
+	bool done;
+	pthread_cond_t *cond;
+	pthread_mutex_t *mutex;
+	slurm_msg_t *msg;
+	pthread_t tid;
+} multi_msg_part_t;
+
+static void *_multi_msg_thread(void *arg)
+{
+	multi_msg_part_t *part = arg;
+
+	slurmd_req(part->msg);
+
+	slurm_mutex_lock(part->mutex);
+	part->done = true;
+	slurm_cond_signal(part->cond);
+	slurm_mutex_unlock(part->mutex);
+
+	return NULL;
+}
+
+static int _find_msg_index(void *x, void *key)
+{
+	slurm_msg_t *msg = x;
+	uint16_t *msg_index = key;
+
+	return (msg->msg_index == *msg_index);
+}
+
+/*
+ * Only requests which reply through slurm_send_rc_msg() can have their
+ * reply collected into a RESPONSE_SLURMD_MULT_MSG.
+ */
+static bool _multi_msg_type_ok(uint16_t msg_type)
+{
+	return ((msg_type == REQUEST_ABORT_JOB)		||
+		(msg_type == REQUEST_KILL_PREEMPTED)	||
+		(msg_type == REQUEST_KILL_TIMELIMIT)	||
+		(msg_type == REQUEST_SIGNAL_TASKS)	||
+		(msg_type == REQUEST_TERMINATE_JOB));
+}
+
+static slurm_msg_t *_multi_msg_rc(uint16_t msg_index, int rc)
+{
+	slurm_msg_t *resp_msg = xmalloc(sizeof(slurm_msg_t));
+	return_code_msg_t *rc_msg = xmalloc(sizeof(return_code_msg_t));
+
+	slurm_msg_t_init(resp_msg);
+	rc_msg->return_code = rc;
+	resp_msg->msg_type = RESPONSE_SLURM_RC;
+	resp_msg->msg_index = msg_index;
+	resp_msg->data = rc_msg;
+
+	return resp_msg;
+}
+
+/*
+ * Process the requests merged by slurmctld into one REQUEST_SLURMD_MULT_MSG. Each
+ * runs in its own thread as if it came on its own connection, but its reply
+ * is queued by slurm_send_rc_msg() to our ret_list. One RESPONSE_SLURMD_MULT_MSG
+ * is sent once every request has replied or finished, or after half of
+ * MessageTimeout.
+ */
+static void _rpc_multi_msg(slurm_msg_t *msg)
+{
+	composite_msg_t *req = msg->data;
+	composite_msg_t resp;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+	multi_msg_part_t *parts;
+	List reply_list;
+	ListIterator itr;
+	slurm_msg_t resp_msg, *sub_msg;
+	struct timespec ts;
+	struct timeval now;
+	time_t deadline;
+	uint16_t msg_index;
+	int i, cnt, pending;
+
+	if (!_slurm_authorized_user(uid)) {
+		error("Security violation: multi_msg req from uid %d", uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	cnt = list_count(req->msg_list);
+	parts = xcalloc(cnt, sizeof(multi_msg_part_t));
+	reply_list = list_create(slurm_free_comp_msg_list);
+	memset(&resp, 0, sizeof(resp));
+	resp.msg_list = list_create(slurm_free_comp_msg_list);
+
+	i = 0;
+	itr = list_iterator_create(req->msg_list);
+	while ((sub_msg = list_next(itr))) {
+		parts[i].cond = &cond;
+		parts[i].mutex = &mutex;
+		parts[i].msg = sub_msg;
+		msg_index = i + 1;
+		i++;
+
+		if (!_multi_msg_type_ok(sub_msg->msg_type)) {
+			error("%s: %s can not be part of %s", __func__,
+			      rpc_num2string(sub_msg->msg_type),
+			      rpc_num2string(msg->msg_type));
+			list_append(reply_list,
+				    _multi_msg_rc(msg_index,
+						  ESLURM_NOT_SUPPORTED));
+			parts[i - 1].done = true;
+			continue;
+		}
+
+		sub_msg->address = msg->address;
+		sub_msg->orig_addr = msg->orig_addr;
+		sub_msg->auth_cred = msg->auth_cred;
+		sub_msg->auth_index = msg->auth_index;
+		sub_msg->auth_uid = msg->auth_uid;
+		sub_msg->auth_uid_set = msg->auth_uid_set;
+		sub_msg->flags = msg->flags;
+		sub_msg->protocol_version = msg->protocol_version;
+		sub_msg->msg_index = msg_index;
+		sub_msg->ret_list = reply_list;
+		/* handlers close their connection once they replied */
+		if (msg->conn_fd >= 0)
+			sub_msg->conn_fd = dup(msg->conn_fd);
+		slurm_thread_create(&parts[i - 1].tid, _multi_msg_thread,
+				    &parts[i - 1]);
+	}
+	list_iterator_destroy(itr);
+
+	deadline = time(NULL) + MAX(slurm_conf.msg_timeout / 2, 1);
+	slurm_mutex_lock(&mutex);
+	while (1) {
+		pending = 0;
+		for (i = 0; i < cnt; i++) {
+			msg_index = i + 1;
+			if (!parts[i].done &&
+			    !list_find_first(reply_list, _find_msg_index,
+					     &msg_index))
+				pending++;
+		}
+		if (!pending || (time(NULL) >= deadline))
+			break;
+
+		/* replies are queued without a signal, poll for them */
+		gettimeofday(&now, NULL);
+		ts.tv_sec = now.tv_sec;
+		ts.tv_nsec = (now.tv_usec + 10000) * 1000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		slurm_cond_timedwait(&cond, &mutex, &ts);
+	}
+	slurm_mutex_unlock(&mutex);
+
+	for (i = 0; i < cnt; i++) {
+		msg_index = i + 1;
+		if ((sub_msg = list_remove_first(reply_list, _find_msg_index,
+						 &msg_index)))
+			list_append(resp.msg_list, sub_msg);
+		else if (parts[i].done)
+			list_append(resp.msg_list,
+				    _multi_msg_rc(msg_index, SLURM_SUCCESS));
+		else
+			list_append(resp.msg_list,
+				    _multi_msg_rc(msg_index,
+						  SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT));
+	}
+	if (pending)
+		debug("%s: %d of %d requests did not reply in time",
+		      __func__, pending, cnt);
+
+	if (msg->conn_fd >= 0) {
+		slurm_msg_t_copy(&resp_msg, msg);
+		resp_msg.auth_index = msg->auth_index;
+		resp_msg.msg_type = RESPONSE_SLURMD_MULT_MSG;
+		resp_msg.data = &resp;
+		slurm_send_node_msg(msg->conn_fd, &resp_msg);
+		if (close(msg->conn_fd) < 0)
+			error("%s: close(%d): %m", __func__, msg->conn_fd);
+		msg->conn_fd = -1;
+	}
+	FREE_NULL_LIST(resp.msg_list);
+
+	for (i = 0; i < cnt; i++) {
+		if (parts[i].tid)
+			pthread_join(parts[i].tid, NULL);
+		sub_msg = parts[i].msg;
+		if (sub_msg->conn_fd >= 0)
+			close(sub_msg->conn_fd);
+		sub_msg->conn_fd = -1;
+		/* owned by msg */
+		sub_msg->auth_cred = NULL;
+		sub_msg->ret_list = NULL;
+	}
+	FREE_NULL_LIST(reply_list);
+	xfree(parts);
+}
+
 /* On a parallel job, every slurmd may send the EPILOG_COMPLETE
  * message to the slurmctld at the same time, resulting in lost
  * messages. We add a delay here to spead out the message traffic
@@ -47,6 +47,7 @@
 #include "src/common/slurm_auth.h"
 #include "src/common/gres.h"
 #include "src/common/macros.h"
+#include "src/common/msg_compress.h"
 #include "src/common/pack.h"
 #include "src/common/slurmdbd_defs.h"
 #include "src/common/slurmdbd_pack.h"
@@ -754,10 +755,16 @@ static int _unpack_persist_init(slurmdbd_conn_t *slurmdbd_conn,
 	if (rc != SLURM_SUCCESS)
 		comment = slurm_strerror(rc);
 
+	/* Agree on which compressed messages each side can take */
+	slurmdbd_conn->conn->flags |= msg_compress_accept2persist(smsg->flags);
+
 	*out_buffer = slurm_persist_make_rc_msg_flags(
 		slurmdbd_conn->conn, rc, comment,
-		slurmdbd_conf->persist_conn_rc_flags,
+		slurmdbd_conf->persist_conn_rc_flags |
+		msg_compress_accept2persist(msg_compress_accept_flags()),
 		req_msg->version);
+	if (rc == SLURM_SUCCESS)
+		slurmdbd_conn->conn->flags |= PERSIST_FLAG_DECOMPRESS;
 
 	return rc;
 }
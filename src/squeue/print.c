@@ -434,18 +434,20 @@ static int _print_job_from_format(void *x, void *arg)
 	bitstr_t *bitmap;
 	squeue_job_rec_t *job_rec_ptr = (squeue_job_rec_t *) x;
 	List list = (List) arg;
+	char *partition;
 
 	if (!job_rec_ptr) {
 		_print_one_job_from_format(NULL, list);
 		return SLURM_SUCCESS;
 	}
 
-	if (job_rec_ptr->part_name) {
-		xfree(job_rec_ptr->job_ptr->partition);
-		job_rec_ptr->job_ptr->partition = xstrdup(job_rec_ptr->
-							  part_name);
-
-	}
+	/*
+	 * Print the partition of this record, the job's own string may be
+	 * shared with other jobs so it is only swapped out while printing.
+	 */
+	partition = job_rec_ptr->job_ptr->partition;
+	if (job_rec_ptr->part_name)
+		job_rec_ptr->job_ptr->partition = job_rec_ptr->part_name;
 	if (job_rec_ptr->job_ptr->array_task_str && params.array_flag) {
 		char *p;
 
@@ -469,6 +471,7 @@ static int _print_job_from_format(void *x, void *arg)
 	} else {
 		_print_one_job_from_format(job_rec_ptr->job_ptr, list);
 	}
+	job_rec_ptr->job_ptr->partition = partition;
 
 	return SLURM_SUCCESS;
 }
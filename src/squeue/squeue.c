@@ -202,11 +202,18 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
+			else if (old_job_ptr->last_update)
+				show_flags |= SHOW_DELTA;
 			error_code = slurm_load_jobs(
 				old_job_ptr->last_update,
 				&new_job_ptr, show_flags);
 		}
-		if (error_code ==  SLURM_SUCCESS)
+		if ((error_code == SLURM_SUCCESS) &&
+		    (show_flags & SHOW_DELTA)) {
+			/* Only changed records were sent, apply to old copy */
+			slurm_merge_job_info_msg(old_job_ptr, new_job_ptr);
+			new_job_ptr = old_job_ptr;
+		} else if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
 		else if (slurm_get_errno () == SLURM_NO_CHANGE_IN_DATA) {
 			error_code = SLURM_SUCCESS;
@@ -0,0 +1,212 @@
+/* Benchmark of each of the SIMD kernels of src/common/bitstring.c which the
+ * CPU supports against the portable word at a time ones, which also tests
+ * that all of them give the same results.
+ *
+ * Usage: bitstring-bench [scale]
+ *   scale - multiplies the number of iterations of each operation (default 1)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+#include <src/common/bitstring.h>
+#include <src/common/macros.h>
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* About this many bits are processed per operation and path timed */
+#define BENCH_BITS (1 << 28)
+
+typedef enum {
+	OP_AND,
+	OP_OR,
+	OP_SET_COUNT,
+	OP_OVERLAP,
+	OP_OVERLAP_ANY,
+	OP_SUPER_SET,
+	OP_FFS,
+	OP_CNT
+} bench_op_t;
+
+static char *op_names[] = {
+	"bit_and", "bit_or", "bit_set_count", "bit_overlap",
+	"bit_overlap_any", "bit_super_set", "bit_ffs"
+};
+
+/*
+ * A 50k node cluster: one bit per core of a node, per node, and per core
+ * of the cluster. 50001 exercises the partial last word.
+ */
+static struct {
+	char *desc;
+	bitoff_t nbits;
+} sizes[] = {
+	{ "node core bitmap", 128 },
+	{ "node bitmap", 50000 },
+	{ "node bitmap", 50001 },
+	{ "cluster core bitmap", 50000 * 128 },
+};
+
+/* Kernels as named by bit_simd_name(), the word ones are the reference */
+static char *simd_names[] = { "word", "avx2", "avx512" };
+
+static volatile int64_t sink;
+
+static void _fill(bitstr_t *b, int pct)
+{
+	bitoff_t nbits = bit_size(b);
+
+	bit_clear_all(b);
+	for (bitoff_t i = 0; i < nbits; i++) {
+		if ((random() % 100) < pct)
+			bit_set(b, i);
+	}
+}
+
+static int64_t _run(bench_op_t op, bitstr_t *b1, bitstr_t *b2)
+{
+	switch (op) {
+	case OP_AND:
+		bit_and(b1, b2);
+		return bit_ffs(b1);
+	case OP_OR:
+		bit_or(b1, b2);
+		return bit_ffs(b1);
+	case OP_SET_COUNT:
+		return bit_set_count(b1);
+	case OP_OVERLAP:
+		return bit_overlap(b1, b2);
+	case OP_OVERLAP_ANY:
+		return bit_overlap_any(b1, b2);
+	case OP_SUPER_SET:
+		return bit_super_set(b1, b2);
+	case OP_FFS:
+		return bit_ffs(b1);
+	default:
+		return -1;
+	}
+}
+
+/* Return nsec per call of op, result set to the result of the last call */
+static double _time(bench_op_t op, bitstr_t *b1, bitstr_t *b2, long iters,
+		    int64_t *result)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < iters; i++)
+		sink += *result = _run(op, b1, b2);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return ((end.tv_sec - start.tv_sec) * 1e9 +
+		(end.tv_nsec - start.tv_nsec)) / iters;
+}
+
+/*
+ * Set up the operands of op so that the early exit operations have to scan
+ * the whole bitmap: no overlap, a super set, and a single bit set at the end.
+ */
+static void _setup(bench_op_t op, bitstr_t *b1, bitstr_t *b2)
+{
+	bitoff_t nbits = bit_size(b1);
+
+	_fill(b1, 50);
+	_fill(b2, 50);
+	if (op == OP_OVERLAP_ANY) {
+		bit_copybits(b2, b1);
+		bit_not(b2);
+	} else if (op == OP_SUPER_SET) {
+		bit_copybits(b2, b1);
+		bit_set(b2, 0);
+	} else if (op == OP_FFS) {
+		bit_clear_all(b1);
+		bit_set(b1, nbits - 1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	bool avail[ARRAY_SIZE(simd_names)];
+	long scale = 1;
+
+	if (argc > 1)
+		scale = MAX(atol(argv[1]), 1);
+
+	TEST(bit_simd_set("none") == -1, "bit_simd_set unknown kernels");
+	for (int k = 0; k < ARRAY_SIZE(simd_names); k++) {
+		avail[k] = !bit_simd_set(simd_names[k]);
+		if (avail[k])
+			TEST(!xstrcmp(bit_simd_name(), simd_names[k]),
+			     "bit_simd_set");
+		else
+			note("%s kernels not supported, skipped",
+			     simd_names[k]);
+	}
+	TEST(avail[0], "word kernels always available");
+
+	for (int s = 0; s < ARRAY_SIZE(sizes); s++) {
+		bitoff_t nbits = sizes[s].nbits;
+		long iters = MAX(BENCH_BITS / nbits, 1) * scale;
+		bitstr_t *b1 = bit_alloc(nbits), *b2 = bit_alloc(nbits);
+		bitstr_t *b1_word = bit_alloc(nbits);
+		bitstr_t *b1_simd = bit_alloc(nbits);
+
+		note("%s, %"BITSTR_FMT" bits, %ld iterations",
+		     sizes[s].desc, nbits, iters);
+		for (bench_op_t op = 0; op < OP_CNT; op++) {
+			int64_t rc_word, rc_simd, rc_time;
+			double ns_word, ns_simd;
+			char *line = NULL;
+
+			/* One call on the same operands to compare */
+			srandom(s * OP_CNT + op);
+			_setup(op, b1, b2);
+			bit_copybits(b1_word, b1);
+			bit_simd_set("word");
+			rc_word = _run(op, b1_word, b2);
+			ns_word = _time(op, b1, b2, iters, &rc_time);
+			xstrfmtcat(line, "  %-16s word %10.1f ns",
+				   op_names[op], ns_word);
+
+			for (int k = 1; k < ARRAY_SIZE(simd_names); k++) {
+				char msg[128];
+
+				if (!avail[k])
+					continue;
+
+				srandom(s * OP_CNT + op);
+				_setup(op, b1, b2);
+				bit_copybits(b1_simd, b1);
+				bit_simd_set(simd_names[k]);
+				rc_simd = _run(op, b1_simd, b2);
+				snprintf(msg, sizeof(msg),
+					 "%s %s %"BITSTR_FMT" bits",
+					 simd_names[k], op_names[op], nbits);
+				TEST((rc_word == rc_simd) &&
+				     bit_equal(b1_word, b1_simd), msg);
+
+				ns_simd = _time(op, b1, b2, iters, &rc_time);
+				xstrfmtcat(line, "  %-6s %10.1f ns x%.2f",
+					   simd_names[k], ns_simd,
+					   ns_word / ns_simd);
+			}
+			note("%s", line);
+			xfree(line);
+		}
+		bit_free(b1);
+		bit_free(b2);
+		bit_free(b1_word);
+		bit_free(b1_simd);
+	}
+	bit_simd_set(NULL);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,154 @@
+/*
+ * Test and lookup benchmark of src/common/id_hash.c
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdlib.h>
+#include <src/common/id_hash.h>
+#include <src/common/xmalloc.h>
+#include <sys/time.h>
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define JOB_CNT		1000000
+#define ARRAY_CNT	1000
+#define TASK_CNT	(JOB_CNT / ARRAY_CNT)
+#define TASK_KEY(_job_id, _task_id) \
+	(((uint64_t) (_job_id) << 32) | (_task_id))
+
+typedef struct {
+	uint32_t job_id;
+	uint32_t array_job_id;
+	uint32_t array_task_id;
+} rec_t;
+
+static long _usec_since(struct timeval *start)
+{
+	struct timeval end;
+
+	gettimeofday(&end, NULL);
+	return ((end.tv_sec - start->tv_sec) * 1000000L) +
+		(end.tv_usec - start->tv_usec);
+}
+
+static void _bench(id_hash_t *table, uint64_t *keys, int cnt, char *what)
+{
+	struct timeval start;
+	long usec;
+	int i, found = 0;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < cnt; i++) {
+		if (id_hash_find(table, keys[i]))
+			found++;
+	}
+	usec = _usec_since(&start);
+	TEST(found == cnt, what);
+	note("%s: %d lookups in %ld usec, %.1f nsec per lookup",
+	     what, cnt, usec, (usec * 1000.0) / cnt);
+}
+
+int
+main(int argc, char *argv[])
+{
+	id_hash_t *job_table, *task_table;
+	rec_t *recs, dup;
+	uint64_t *keys;
+	struct timeval start;
+	int i, bad;
+
+	recs = xcalloc(JOB_CNT, sizeof(rec_t));
+	keys = xcalloc(JOB_CNT, sizeof(uint64_t));
+	for (i = 0; i < JOB_CNT; i++) {
+		recs[i].job_id = i + 1;
+		recs[i].array_job_id = ((i / TASK_CNT) * TASK_CNT) + 1;
+		recs[i].array_task_id = i % TASK_CNT;
+	}
+
+	note("Testing id_hash growth from minimum size to %d jobs", JOB_CNT);
+	job_table = id_hash_init(0);
+	task_table = id_hash_init(0);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < JOB_CNT; i++)
+		id_hash_add(job_table, recs[i].job_id, &recs[i]);
+	note("%d job id inserts in %ld usec", JOB_CNT, _usec_since(&start));
+	for (i = 0; i < JOB_CNT; i++) {
+		id_hash_add(task_table, TASK_KEY(recs[i].array_job_id,
+						 recs[i].array_task_id),
+			    &recs[i]);
+	}
+	TEST(id_hash_count(job_table) == JOB_CNT, "job table count");
+	TEST(id_hash_count(task_table) == JOB_CNT, "task table count");
+
+	for (i = 0, bad = 0; i < JOB_CNT; i++) {
+		if (id_hash_find(job_table, recs[i].job_id) != &recs[i])
+			bad++;
+		if (id_hash_find(task_table,
+				 TASK_KEY(recs[i].array_job_id,
+					  recs[i].array_task_id)) != &recs[i])
+			bad++;
+	}
+	TEST(bad == 0, "all records found");
+	TEST(id_hash_find(job_table, 0) == NULL, "job id 0 not found");
+	TEST(id_hash_find(job_table, JOB_CNT + 1) == NULL,
+	     "job id past end not found");
+	TEST(id_hash_find(task_table, TASK_KEY(1, TASK_CNT)) == NULL,
+	     "task id past end not found");
+
+	note("Benchmarking lookups with %d jobs", JOB_CNT);
+	for (i = 0; i < JOB_CNT; i++)
+		keys[i] = i + 1;
+	_bench(job_table, keys, JOB_CNT, "sequential job id lookup");
+	srandom(1);
+	for (i = 0; i < JOB_CNT; i++)
+		keys[i] = (random() % JOB_CNT) + 1;
+	_bench(job_table, keys, JOB_CNT, "random job id lookup");
+	for (i = 0; i < JOB_CNT; i++) {
+		rec_t *rec = &recs[random() % JOB_CNT];
+		keys[i] = TASK_KEY(rec->array_job_id, rec->array_task_id);
+	}
+	_bench(task_table, keys, JOB_CNT, "random array task lookup");
+
+	note("Testing id_hash_remove");
+	for (i = 0; i < JOB_CNT; i += 2)
+		id_hash_remove(job_table, recs[i].job_id, &recs[i]);
+	TEST(id_hash_count(job_table) == (JOB_CNT / 2), "count after remove");
+	for (i = 0, bad = 0; i < JOB_CNT; i++) {
+		rec_t *rec = id_hash_find(job_table, recs[i].job_id);
+		if ((i % 2) ? (rec != &recs[i]) : (rec != NULL))
+			bad++;
+	}
+	TEST(bad == 0, "remaining records found after remove");
+	TEST(!id_hash_remove(job_table, recs[0].job_id, &recs[0]),
+	     "remove of missing record fails");
+	TEST(!id_hash_remove(job_table, recs[1].job_id, &recs[3]),
+	     "remove of wrong record fails");
+
+	note("Testing duplicate keys");
+	dup = recs[1];
+	id_hash_add(job_table, dup.job_id, &dup);
+	TEST(id_hash_remove(job_table, dup.job_id, &recs[1]),
+	     "remove first duplicate");
+	TEST(id_hash_find(job_table, dup.job_id) == &dup,
+	     "second duplicate found");
+	TEST(id_hash_remove(job_table, dup.job_id, &dup),
+	     "remove second duplicate");
+	TEST(id_hash_find(job_table, dup.job_id) == NULL,
+	     "no duplicate left");
+
+	id_hash_free(job_table);
+	id_hash_free(task_table);
+	xfree(recs);
+	xfree(keys);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,134 @@
+/*
+ * Test of src/common/list.c and of its caches of list nodes and iterators
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <src/common/list.h>
+#include <src/common/xmalloc.h>
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define ITEM_CNT 10000
+#define THREAD_CNT 8
+#define ROUND_CNT 20
+
+static int _cmp_int(void *x, void *y)
+{
+	return **(int **) x - **(int **) y;
+}
+
+/* Fill a list with ITEM_CNT integers in reverse order */
+static List _fill(void)
+{
+	List l = list_create(xfree_ptr);
+
+	for (int i = ITEM_CNT - 1; i >= 0; i--) {
+		int *x = xmalloc(sizeof(*x));
+		*x = i;
+		list_append(l, x);
+	}
+
+	return l;
+}
+
+/* Return true if l holds 0 to ITEM_CNT - 1 in order */
+static bool _sorted(List l)
+{
+	ListIterator itr = list_iterator_create(l);
+	int *x, i = 0;
+
+	while ((x = list_next(itr))) {
+		if (*x != i++)
+			break;
+	}
+	list_iterator_destroy(itr);
+
+	return (i == ITEM_CNT) && !x;
+}
+
+/*
+ * Move the nodes of lists created by this thread through a list shared
+ * with the other threads, so nodes are freed by another thread than the
+ * one which allocated them.
+ */
+static void *_thread(void *arg)
+{
+	List shared = arg;
+
+	for (int r = 0; r < ROUND_CNT; r++) {
+		List l = _fill();
+		ListIterator itr = list_iterator_create(l);
+		void *x;
+
+		while ((x = list_next(itr)))
+			list_enqueue(shared, list_remove(itr));
+		list_iterator_destroy(itr);
+		list_destroy(l);
+
+		for (int i = 0; i < ITEM_CNT; i++)
+			xfree_ptr(list_dequeue(shared));
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	list_cache_stats_t node_stats, itr_stats;
+	uint64_t malloc_cnt;
+	pthread_t threads[THREAD_CNT];
+	List l, shared;
+
+	l = _fill();
+	TEST(list_count(l) == ITEM_CNT, "list_append");
+	list_sort(l, _cmp_int);
+	TEST(_sorted(l), "list_sort");
+	list_destroy(l);
+
+	/* The nodes freed are cached and used again */
+	list_cache_stats(&node_stats, &itr_stats);
+	TEST(node_stats.cached_cnt > 0, "list nodes cached");
+	malloc_cnt = node_stats.malloc_cnt;
+	l = _fill();
+	list_cache_stats(&node_stats, &itr_stats);
+	TEST(node_stats.malloc_cnt == malloc_cnt, "list nodes reused");
+	list_destroy(l);
+
+	/* Allocations of exited threads are all counted */
+	list_cache_clear_stats();
+	shared = list_create(NULL);
+	for (int i = 0; i < THREAD_CNT; i++)
+		pthread_create(&threads[i], NULL, _thread, shared);
+	for (int i = 0; i < THREAD_CNT; i++)
+		pthread_join(threads[i], NULL);
+	TEST(list_is_empty(shared), "list nodes passed between threads");
+	list_destroy(shared);
+
+	list_cache_stats(&node_stats, &itr_stats);
+	note("list nodes: allocs:%"PRIu64" mallocs:%"PRIu64" frees:%"PRIu64" depot_exchanges:%"PRIu64" cached:%u",
+	     node_stats.alloc_cnt, node_stats.malloc_cnt,
+	     node_stats.free_cnt, node_stats.depot_cnt,
+	     node_stats.cached_cnt);
+	TEST(node_stats.alloc_cnt ==
+	     (uint64_t) THREAD_CNT * ROUND_CNT * ITEM_CNT * 2,
+	     "list node allocations counted");
+	TEST(itr_stats.alloc_cnt == THREAD_CNT * ROUND_CNT,
+	     "list iterator allocations counted");
+	TEST(node_stats.malloc_cnt < node_stats.alloc_cnt / 10,
+	     "list node cache hits");
+
+	totals();
+	return failed;
+}
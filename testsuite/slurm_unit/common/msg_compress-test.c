@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include <src/common/msg_compress.h>
+#include <src/common/pack.h>
+#include <src/common/slurm_protocol_common.h>
+#include <src/common/slurm_protocol_interface.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* From read_config.h, which clashes with the wait() of dejagnu.h */
+extern slurm_conf_t slurm_conf;
+
+/* Pack a message looking like a job info response */
+static buf_t *_pack_msg(buf_t *buffer, int cnt)
+{
+	char name[64];
+
+	for (int i = 0; i < cnt; i++) {
+		pack32(1000 + i, buffer);
+		snprintf(name, sizeof(name), "job_%d", i);
+		packstr(name, buffer);
+		packstr("/home/user/work/run.sh", buffer);
+		packstr("debug", buffer);
+	}
+
+	return buffer;
+}
+
+/* Compress buffer with type, decompress and compare */
+static void _test_round_trip(buf_t *buffer, uint16_t type, char *desc)
+{
+	uint32_t size = get_buf_len(buffer);
+	char *orig = flatten_buf(buffer), *data, msg[128];
+	buf_t *out = msg_compress(buffer, type);
+	int rc;
+
+	snprintf(msg, sizeof(msg), "%s compressed", desc);
+	TEST(out && (get_buf_offset(out) < size), msg);
+	if (!out)
+		goto end;
+
+	size = get_buf_offset(out);
+	data = xfer_buf_data(out);
+	rc = msg_decompress(&data, &size, msg_compress_accept_flags(),
+			    1024 * 1024 * 1024);
+	snprintf(msg, sizeof(msg), "%s decompressed", desc);
+	TEST((rc == SLURM_SUCCESS) && (size == get_buf_len(buffer)) &&
+	     !memcmp(data, orig, size), msg);
+	xfree(data);
+
+end:
+	if (orig != get_buf_data(buffer))
+		xfree(orig);
+}
+
+static void _test_type(uint16_t type, char *name)
+{
+	buf_t *buffer, *seg_buffer, *out;
+	char *data, desc[64];
+	uint32_t size;
+	int rc;
+
+	/* Flat buffer */
+	buffer = _pack_msg(init_buf(BUF_SIZE), 10000);
+	snprintf(desc, sizeof(desc), "%s flat", name);
+	_test_round_trip(buffer, type, desc);
+
+	/* Segmented buffer, the first message referenced from the second */
+	seg_buffer = init_seg_buf();
+	pack32(0xdeadbeef, seg_buffer);
+	packmem_seg(get_buf_data(buffer), get_buf_offset(buffer), seg_buffer);
+	_pack_msg(seg_buffer, 100);
+	TEST(seg_buffer->seg_cnt == 1, "packmem_seg segment");
+	snprintf(desc, sizeof(desc), "%s segmented", name);
+	_test_round_trip(seg_buffer, type, desc);
+	free_buf(seg_buffer);
+
+	/* Corrupted or truncated data must be rejected */
+	out = msg_compress(buffer, type);
+	size = get_buf_offset(out) / 2;
+	data = xfer_buf_data(out);
+	rc = msg_decompress(&data, &size, msg_compress_accept_flags(),
+			    1024 * 1024 * 1024);
+	snprintf(desc, sizeof(desc), "%s truncated", name);
+	TEST((rc != SLURM_SUCCESS) && !data, desc);
+
+	/* As must messages larger than the limit */
+	out = msg_compress(buffer, type);
+	size = get_buf_offset(out);
+	data = xfer_buf_data(out);
+	rc = msg_decompress(&data, &size, msg_compress_accept_flags(),
+			    get_buf_offset(buffer) - 1);
+	snprintf(desc, sizeof(desc), "%s too large", name);
+	TEST((rc == SLURM_PROTOCOL_INSANE_MSG_LENGTH) && !data, desc);
+
+	/* And types the receiver did not advertise */
+	out = msg_compress(buffer, type);
+	size = get_buf_offset(out);
+	data = xfer_buf_data(out);
+	rc = msg_decompress(&data, &size, 0, 1024 * 1024 * 1024);
+	snprintf(desc, sizeof(desc), "%s not accepted", name);
+	TEST((rc != SLURM_SUCCESS) && !data, desc);
+
+	free_buf(buffer);
+}
+
+/* Compressed messages are only taken by receivers which advertised so */
+static void _test_recv(uint16_t accept)
+{
+	buf_t *buffer = _pack_msg(init_buf(BUF_SIZE), 10000);
+	uint16_t type = msg_compress_type(accept);
+	char *data = NULL;
+	size_t len = 0;
+	int fds[2];
+
+	slurm_conf.msg_timeout = 10;
+	socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+	slurm_msg_sendto_buf(fds[0], buffer, type);
+	TEST((slurm_msg_recvfrom_timeout(fds[1], &data, &len, 0, 1000) < 0) &&
+	     !data, "compressed message not accepted");
+
+	/* The rejected message was left unread */
+	close(fds[0]);
+	close(fds[1]);
+	socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	slurm_msg_sendto_buf(fds[0], buffer, type);
+	TEST((slurm_msg_recvfrom_timeout(fds[1], &data, &len, accept, 1000) ==
+	      get_buf_offset(buffer)) &&
+	     !memcmp(data, get_buf_data(buffer), len),
+	     "compressed message accepted");
+	xfree(data);
+
+	close(fds[0]);
+	close(fds[1]);
+	free_buf(buffer);
+}
+
+int main(int argc, char *argv[])
+{
+	uint16_t accept = msg_compress_accept_flags();
+	buf_t *buffer;
+
+	msg_compress_conf("MsgCompressMinSize=1024");
+
+	/* Small messages and random data are sent as is */
+	buffer = _pack_msg(init_buf(BUF_SIZE), 10);
+	TEST(!msg_compress(buffer, MSG_COMPRESS_ZLIB), "small message");
+	free_buf(buffer);
+	buffer = init_buf(BUF_SIZE);
+	for (int i = 0; i < 16384; i++)
+		pack32(random(), buffer);
+	TEST(!msg_compress(buffer, MSG_COMPRESS_ZLIB) &&
+	     !msg_compress(buffer, MSG_COMPRESS_LZ4), "random data");
+	free_buf(buffer);
+
+	/* Compress only with what the peer accepts, if configured */
+	TEST(msg_compress_type(accept) == MSG_COMPRESS_NONE, "not configured");
+	if (accept & SLURM_MSG_ACCEPT_ZLIB) {
+		msg_compress_conf("MsgCompress=zlib");
+		TEST(msg_compress_type(accept) == MSG_COMPRESS_ZLIB,
+		     "zlib configured");
+		TEST(msg_compress_type(accept & ~SLURM_MSG_ACCEPT_ZLIB) ==
+		     MSG_COMPRESS_NONE, "zlib not accepted");
+		_test_type(MSG_COMPRESS_ZLIB, "zlib");
+	}
+	if (accept & SLURM_MSG_ACCEPT_LZ4) {
+		msg_compress_conf("MsgCompress=lz4");
+		TEST(msg_compress_type(accept) == MSG_COMPRESS_LZ4,
+		     "lz4 configured");
+		_test_type(MSG_COMPRESS_LZ4, "lz4");
+	}
+	if (accept)
+		_test_recv(accept);
+
+	totals();
+	return failed;
+}
@@ -1,10 +1,18 @@
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include "slurm/slurm.h"
+
+#include <src/common/msg_compress.h>
 #include <src/common/pack.h>
+#include <src/common/slurm_protocol_interface.h>
 #include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
 
 #include <testsuite/dejagnu.h>
 
@@ -17,6 +25,32 @@
 		pass( _msg );       \
 } while (0)
 
+/* From read_config.h, which clashes with the wait() of dejagnu.h */
+extern slurm_conf_t slurm_conf;
+
+/* Read a message as slurm_msg_sendto_buf() sends it, a little at a time */
+static void *_recv_msg(void *arg)
+{
+	int fd = *(int *) arg;
+	uint32_t len, pos = 0;
+	char *data;
+	ssize_t rc;
+
+	if (read(fd, &len, sizeof(len)) != sizeof(len))
+		return NULL;
+	len = ntohl(len);
+	data = xmalloc(len);
+	while (pos < len) {
+		if ((rc = read(fd, data + pos, MIN(len - pos, 1000))) <= 0) {
+			xfree(data);
+			return NULL;
+		}
+		pos += rc;
+	}
+
+	return data;
+}
+
 int main (int argc, char *argv[])
 {
 	Buf buffer;
@@ -83,6 +117,239 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	note("Testing segmented buffers");
+	{
+		uint32_t big_len = 4 * BUF_SIZE, big2_len = BUF_SIZE + 13;
+		char *big = xmalloc(big_len), *big2 = xmalloc(big2_len), *flat;
+		char *recv_data = NULL;
+		uint32_t len;
+		ssize_t sent;
+		pthread_t reader;
+		int fds[2], sndbuf = 4096;
+
+		/* Bytes which differ by position show misplaced data */
+		for (int i = 0; i < big_len; i++)
+			big[i] = i % 251;
+		for (int i = 0; i < big2_len; i++)
+			big2[i] = i % 241;
+		buffer = init_seg_buf();
+		pack32(test32, buffer);
+		packmem_seg(testbytes, sizeof(testbytes), buffer);
+		packmem_seg(big, big_len, buffer);
+		pack16(test16, buffer);
+		packmem_seg(big2, big2_len, buffer);
+		packmem_seg(big2, big2_len, buffer);
+		TEST(buffer->seg_cnt != 3, "small data copied, large referenced");
+		TEST(get_buf_len(buffer) !=
+		     (4 + sizeof(testbytes) + big_len + 2 + 2 * big2_len),
+		     "get_buf_len");
+
+		/*
+		 * With a small socket buffer each sendmsg() writes part of
+		 * the message, often ending inside a segment
+		 */
+		slurm_conf.msg_timeout = 10;
+		socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+		setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf,
+			   sizeof(sndbuf));
+		pthread_create(&reader, NULL, _recv_msg, &fds[1]);
+		sent = slurm_msg_sendto_buf(fds[0], buffer, MSG_COMPRESS_NONE);
+		pthread_join(reader, (void **) &recv_data);
+		close(fds[0]);
+		close(fds[1]);
+		TEST(sent != get_buf_len(buffer), "slurm_msg_sendto_buf");
+
+		len = get_buf_len(buffer);
+		flat = flatten_buf(buffer);
+		TEST(!recv_data || (xsize(recv_data) != len) ||
+		     memcmp(recv_data, flat, len),
+		     "slurm_msg_sendto_buf partial writes");
+		xfree(recv_data);
+		free_buf(buffer);
+
+		buffer = create_buf(flat, len);
+		unpack32(&out32, buffer);
+		TEST(out32 != test32, "unpack32 before segments");
+		TEST(memcmp(buffer->head + 4, testbytes, sizeof(testbytes)),
+		     "copied data");
+		TEST(memcmp(buffer->head + 4 + sizeof(testbytes), big, big_len),
+		     "referenced data");
+		set_buf_offset(buffer, 4 + sizeof(testbytes) + big_len);
+		unpack16(&out16, buffer);
+		TEST(out16 != test16, "unpack16 after segments");
+		free_buf(buffer);
+		xfree(big);
+		xfree(big2);
+	}
+
+	note("Testing string dictionaries");
+	{
+		char *strs[] = { "debug", "alice", "debug", NULL, "bob",
+				 "alice", "debug" }, *out[7], *plain;
+		str_dict_t *dict = str_dict_create();
+		uint32_t dict_len, plain_len;
+		int rc = 0;
+
+		/* The same strings with and without a dictionary */
+		buffer = init_buf(0);
+		for (int i = 0; i < 7; i++)
+			packstr_dict(strs[i], buffer);
+		plain_len = get_buf_offset(buffer);
+		plain = xfer_buf_data(buffer);
+
+		buffer = init_buf(0);
+		set_buf_str_dict(buffer, dict);
+		for (int i = 0; i < 7; i++)
+			packstr_dict(strs[i], buffer);
+		str_dict_destroy(dict);
+		dict_len = get_buf_offset(buffer);
+		TEST(dict_len >= plain_len, "repeated strings packed once");
+
+		/* Unpack into a dictionary, repeated strings are shared */
+		dict = str_dict_create();
+		set_buf_offset(buffer, 0);
+		set_buf_str_dict(buffer, dict);
+		for (int i = 0; i < 7; i++)
+			rc |= unpackstr_dict(&out[i], buffer);
+		TEST(rc || (get_buf_offset(buffer) != dict_len),
+		     "unpackstr_dict");
+		for (int i = 0; i < 7; i++) {
+			if (xstrcmp(strs[i], out[i]))
+				rc = 1;
+		}
+		TEST(rc, "unpackstr_dict strings");
+		TEST((out[0] != out[2]) || (out[0] != out[6]) ||
+		     (out[1] != out[5]), "unpackstr_dict shared strings");
+		TEST(str_dict_intern(dict, "debug") != out[0],
+		     "str_dict_intern existing string");
+		TEST(xstrcmp(str_dict_intern(dict, "carol"), "carol"),
+		     "str_dict_intern new string");
+
+		/* References are invalid without the dictionary */
+		set_buf_offset(buffer, 0);
+		set_buf_str_dict(buffer, NULL);
+		for (int i = 0; i < 7; i++) {
+			if (unpackstr_dict(&out[i], buffer))
+				break;
+			xfree(out[i]);
+			if (i == 6)
+				rc = 1;
+		}
+		TEST(rc, "reference without dictionary");
+		free_buf(buffer);
+		str_dict_destroy(dict);
+
+		/* Plain strings unpack with or without a dictionary */
+		dict = str_dict_create();
+		buffer = create_buf(plain, plain_len);
+		set_buf_str_dict(buffer, dict);
+		for (int i = 0; i < 7; i++)
+			rc |= unpackstr_dict(&out[i], buffer);
+		TEST(rc || xstrcmp(out[6], "debug"),
+		     "unpackstr_dict plain strings");
+		free_buf(buffer);
+		str_dict_destroy(dict);
+	}
+
+	note("Testing copies of data packed with a dictionary");
+	{
+		str_dict_t *src = str_dict_create(), *dst = str_dict_create();
+		uint32_t a_off, a_use, b_off, b_use, end, copy_len, x, y;
+		char *s1, *s2, *s3, *s4;
+		Buf copy;
+		int rc = 0;
+
+		/* Two records, the second referencing the first's string */
+		buffer = init_buf(0);
+		str_dict_log_uses(src);
+		set_buf_str_dict(buffer, src);
+		a_off = get_buf_offset(buffer);
+		a_use = str_dict_use_cnt(src);
+		packstr_dict("debug", buffer);
+		pack32(7, buffer);
+		packstr_dict("alice", buffer);
+		b_off = get_buf_offset(buffer);
+		b_use = str_dict_use_cnt(src);
+		packstr_dict("debug", buffer);
+		packstr_dict("bob", buffer);
+		pack32(9, buffer);
+		end = get_buf_offset(buffer);
+
+		/* Copied alone and out of order, they still unpack */
+		copy = init_buf(0);
+		set_buf_str_dict(copy, dst);
+		packstr_dict_copy(get_buf_data(buffer), b_off, end - b_off,
+				  src, b_use, copy);
+		packstr_dict_copy(get_buf_data(buffer), a_off, b_off - a_off,
+				  src, a_use, copy);
+		str_dict_destroy(dst);
+		copy_len = get_buf_offset(copy);
+
+		dst = str_dict_create();
+		set_buf_offset(copy, 0);
+		set_buf_str_dict(copy, dst);
+		rc |= unpackstr_dict(&s1, copy);
+		rc |= unpackstr_dict(&s2, copy);
+		rc |= unpack32(&x, copy);
+		rc |= unpackstr_dict(&s3, copy);
+		rc |= unpack32(&y, copy);
+		rc |= unpackstr_dict(&s4, copy);
+		TEST(rc || xstrcmp(s1, "debug") || xstrcmp(s2, "bob") ||
+		     (x != 9) || (s3 != s1) || (y != 7) ||
+		     xstrcmp(s4, "alice") ||
+		     (get_buf_offset(copy) != copy_len),
+		     "packstr_dict_copy");
+
+		free_buf(copy);
+		free_buf(buffer);
+		str_dict_destroy(dst);
+		str_dict_destroy(src);
+	}
+
+	note("Testing arenas");
+	{
+		char *strs[] = { "debug", "alice", "/home/alice/run.sh" };
+		char *big = xmalloc(1024 * 1024), *out, *kept, **out_array;
+		xarena_t *arena = xarena_create();
+		uint32_t cnt, *out32_array, in32_array[] = { 1, 2, 3 };
+		int rc = 0;
+
+		buffer = init_buf(0);
+		packstr("debug", buffer);
+		packstr_array(strs, 3, buffer);
+		pack32_array(in32_array, 3, buffer);
+		packmem(big, 1024 * 1024, buffer);
+
+		set_buf_offset(buffer, 0);
+		set_buf_arena(buffer, arena);
+		rc |= unpackstr_xmalloc(&out, &cnt, buffer);
+		rc |= unpackstr_array(&out_array, &cnt, buffer);
+		rc |= unpack32_array(&out32_array, &cnt, buffer);
+		TEST(rc || xstrcmp(out, "debug") ||
+		     xstrcmp(out_array[2], strs[2]) || out_array[3] ||
+		     (out32_array[2] != 3) || (xsize(out32_array) != 12),
+		     "unpack into arena");
+		xfree(big);
+		rc |= unpackmem_xmalloc(&big, &cnt, buffer);
+		TEST(rc || (cnt != 1024 * 1024) || big[cnt - 1],
+		     "unpack large block into arena");
+		xfree(big);
+		TEST(big, "xfree arena memory");
+
+		/* Growing or keeping memory moves it to the heap */
+		xstrcat(out, ",alice");
+		kept = out_array[0];
+		xkeep(kept);
+		xfree(out_array);
+		xarena_destroy(arena);
+		TEST(xstrcmp(out, "debug,alice"), "xrealloc arena memory");
+		TEST(xstrcmp(kept, "debug"), "xkeep arena memory");
+		xfree(out);
+		xfree(kept);
+		free_buf(buffer);
+	}
+
 	totals();
 	return failed;
 
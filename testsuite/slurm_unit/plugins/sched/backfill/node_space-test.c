@@ -0,0 +1,182 @@
+/*
+ * Test of the backfill scheduler's node_space table and its search tree
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <src/common/bitstring.h>
+#include <src/common/macros.h>
+#include <src/common/xmalloc.h>
+#include <src/plugins/sched/backfill/node_space.h>
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NODE_CNT 64
+#define WINDOW 2000
+#define RESV_CNT 400
+#define RESV_TIME 200
+#define THREAD_CNT 4
+#define QUERY_CNT 2000
+
+static node_space_map_t *node_space;
+static bitstr_t *model[WINDOW];	/* nodes available in each second */
+
+/* Make a reservation as the backfill scheduler's _add_reservation() does */
+static void _reserve(time_t start, time_t end, bitstr_t *res_bitmap,
+		     int *recs)
+{
+	int i, j;
+
+	node_space_split(node_space, recs, start);
+	node_space_split(node_space, recs, end);
+	node_space_reserve(node_space, start, end - 1, res_bitmap);
+
+	if ((i = node_space_find(node_space, start - 1)) < 0)
+		i = 0;
+	while ((j = node_space[i].next) &&
+	       (node_space[j].begin_time <= end)) {
+		if (!bit_equal(node_space[i].avail_bitmap,
+			       node_space[j].avail_bitmap)) {
+			i = j;
+			continue;
+		}
+		node_space_remove(node_space, j);
+		node_space[i].end_time = node_space[j].end_time;
+		node_space[i].next = node_space[j].next;
+		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
+	}
+
+	for (i = start; i < end; i++)
+		bit_and(model[i], res_bitmap);
+}
+
+/* Return true if every record matches the model for each of its seconds */
+static bool _records_valid(void)
+{
+	int i = 0, t;
+
+	for (t = 0; t < WINDOW; t++) {
+		while (node_space[i].end_time <= t) {
+			if ((i = node_space[i].next) == 0)
+				return false;
+		}
+		if ((node_space[i].begin_time > t) ||
+		    !bit_equal(node_space[i].avail_bitmap, model[t]))
+			return false;
+	}
+	return true;
+}
+
+/* Return true if node_space_and() matches a walk of the records */
+static bool _query_valid(unsigned int *seed)
+{
+	time_t first = rand_r(seed) % WINDOW;
+	time_t last = first + rand_r(seed) % (WINDOW - first);
+	bitstr_t *tree_bitmap = bit_alloc(NODE_CNT);
+	bitstr_t *walk_bitmap = bit_alloc(NODE_CNT);
+	bool rc;
+	int i;
+
+	bit_set_all(tree_bitmap);
+	bit_set_all(walk_bitmap);
+	node_space_and(node_space, first, last, tree_bitmap);
+	for (i = 0; ; ) {
+		if ((node_space[i].begin_time >= first) &&
+		    (node_space[i].begin_time <= last))
+			bit_and(walk_bitmap, node_space[i].avail_bitmap);
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+	rc = bit_equal(tree_bitmap, walk_bitmap);
+	FREE_NULL_BITMAP(tree_bitmap);
+	FREE_NULL_BITMAP(walk_bitmap);
+	return rc;
+}
+
+/* Search the table concurrently with the other threads */
+static void *_thread(void *arg)
+{
+	unsigned int seed = *(int *) arg;
+	intptr_t bad = 0;
+
+	for (int i = 0; i < QUERY_CNT; i++) {
+		if (!_query_valid(&seed))
+			bad++;
+	}
+	return (void *) bad;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int seed = 1;
+	bitstr_t *res_bitmap = bit_alloc(NODE_CNT);
+	pthread_t threads[THREAD_CNT];
+	int seeds[THREAD_CNT];
+	int i, recs = 1, bad = 0;
+	void *thread_bad;
+
+	node_space = xcalloc(RESV_CNT * 2 + 1, sizeof(node_space_map_t));
+	node_space[0].begin_time = 0;
+	node_space[0].end_time = WINDOW;
+	node_space[0].avail_bitmap = bit_alloc(NODE_CNT);
+	bit_set_all(node_space[0].avail_bitmap);
+	node_space[0].next = 0;
+	node_space_init(node_space);
+	for (i = 0; i < WINDOW; i++) {
+		model[i] = bit_alloc(NODE_CNT);
+		bit_set_all(model[i]);
+	}
+
+	for (i = 0; i < RESV_CNT; i++) {
+		time_t start = rand_r(&seed) % (WINDOW - 1);
+		time_t end = start + 1 + rand_r(&seed) % RESV_TIME;
+
+		/* Some reservations leave neighbouring records equal */
+		end = MIN(end, WINDOW - 1);
+		bit_set_all(res_bitmap);
+		bit_clear(res_bitmap, rand_r(&seed) % NODE_CNT);
+		_reserve(start, end, res_bitmap, &recs);
+		if (!_query_valid(&seed))
+			bad++;
+	}
+	TEST(_records_valid(), "node_space_reserve records");
+	TEST(!bad, "node_space_and after each reservation");
+
+	bad = 0;
+	for (i = 0; i < QUERY_CNT; i++) {
+		if (!_query_valid(&seed))
+			bad++;
+	}
+	TEST(!bad, "node_space_and");
+
+	bad = 0;
+	for (i = 0; i < THREAD_CNT; i++) {
+		seeds[i] = i + 2;
+		pthread_create(&threads[i], NULL, _thread, &seeds[i]);
+	}
+	for (i = 0; i < THREAD_CNT; i++) {
+		pthread_join(threads[i], &thread_bad);
+		bad += (intptr_t) thread_bad;
+	}
+	TEST(!bad, "node_space_and from concurrent threads");
+
+	node_space_fini(node_space);
+	xfree(node_space);
+	for (i = 0; i < WINDOW; i++)
+		FREE_NULL_BITMAP(model[i]);
+	FREE_NULL_BITMAP(res_bitmap);
+
+	totals();
+	return failed;
+}